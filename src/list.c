@@ -10,6 +10,7 @@
 #include <stddef.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
 #include "list.h"
 
 /** @brief Tworzy nowy węzeł listy numerów.
@@ -39,6 +40,7 @@ ListOfNumbers * newList() {
         result->first = NULL;
         result->last = NULL;
         result->list_size = 0;
+        result->sorted = NULL;
     }
     return result;
 }
@@ -99,6 +101,577 @@ bool addElement(ListOfNumbers *list, const char *num, size_t number_length) {
     }
 }
 
+/** @brief Dołącza węzeł na koniec listy.
+ * Nie alokuje pamięci.
+ * @param[in] list - wskaźnik na strukturę reprezentującą listę
+ * @param[in] element - wskaźnik na dołączany węzeł
+ */
+void appendElement(ListOfNumbers *list, OneNumber *element) {
+    element->next = NULL;
+    if (empty(list)) {
+        element->prev = NULL;
+        list->first = element;
+        list->last = element;
+    }
+    else {
+        element->prev = list->last;
+        (list->last)->next = element;
+        list->last = element;
+    }
+    ++(list->list_size);
+}
+
+/** @brief Porównuje numery zapisane w 2 węzłach list w postaci spakowanej.
+ * @param[in] element1 - wskaźnik na pierwszy węzeł
+ * @param[in] element2 - wskaźnik na drugi węzeł
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
+ */
+static int compareElements(OneNumber const *element1, OneNumber const *element2) {
+    return packedCompare(element1->digits, element1->number_length, element2->digits, element2->number_length);
+}
+
+/**
+ * To jest najmniejsza liczba wpisów bloku indeksu posortowanej listy, który nie jest korzeniem.
+ */
+#define SORTED_HALF (SORTED_CHUNK / 2)
+
+/** @brief Szacuje z góry liczbę bloków indeksu listy o podanej długości.
+ * Korzysta z tego, że każdy blok poza korzeniem jest wypełniony co najmniej w połowie.
+ * @param[in] count - liczba węzłów listy
+ * @return Największa liczba bloków indeksu.
+ */
+static size_t maxChunks(size_t count) {
+    size_t result = 0;
+    size_t level = count;
+    do {
+        level = level / SORTED_HALF + 1;
+        result += level;
+    } while (level > 1);
+    return result;
+}
+
+/** @brief Bierze blok przydzielony z góry i dołącza go do indeksu.
+ * @param[in,out] index - wskaźnik na indeks, który ma co najmniej jeden blok przydzielony z góry
+ * @return Wskaźnik na pusty blok.
+ */
+static SortedChunk * takeChunk(SortedIndex *index) {
+    SortedChunk *result = index->spare;
+    index->spare = result->children[0];
+    --(index->spares);
+    ++(index->chunks);
+    result->count = 0;
+    return result;
+}
+
+/** @brief Odłącza blok od indeksu.
+ * Dopóki nie nastąpiły wszystkie wstawienia przygotowane przez
+ * @ref reserveSorted, blok jest zachowywany na ich potrzeby. W przeciwnym
+ * przypadku jest zwalniany razem z pozostałymi blokami przydzielonymi z góry.
+ * @param[in,out] index - wskaźnik na indeks
+ * @param[in] chunk - wskaźnik na odłączany blok
+ */
+static void dropChunk(SortedIndex *index, SortedChunk *chunk) {
+    --(index->chunks);
+    chunk->children[0] = index->spare;
+    index->spare = chunk;
+    ++(index->spares);
+    if (index->pending > 0) {
+        return;
+    }
+    while (index->spare != NULL) {
+        chunk = index->spare;
+        index->spare = chunk->children[0];
+        free(chunk);
+    }
+    index->spares = 0;
+}
+
+/** @brief Zwalnia poddrzewo indeksu.
+ * @param[in] chunk - wskaźnik na korzeń poddrzewa
+ * @param[in] height - liczba poziomów poddrzewa nad liśćmi
+ */
+static void freeChunks(SortedChunk *chunk, size_t height) {
+    if (height > 0) {
+        for (size_t i = 0; i < chunk->count; ++i) {
+            freeChunks(chunk->children[i], height - 1);
+        }
+    }
+    free(chunk);
+}
+
+/** @brief Zwalnia indeks posortowanej listy.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] index - wskaźnik na indeks
+ */
+static void freeSortedIndex(SortedIndex *index) {
+    if (index != NULL) {
+        if (index->root != NULL) {
+            freeChunks(index->root, index->height);
+        }
+        while (index->spare != NULL) {
+            SortedChunk *chunk = index->spare;
+            index->spare = chunk->children[0];
+            free(chunk);
+        }
+        free(index);
+    }
+}
+
+/** @brief Porównuje 2 wpisy indeksu posortowanej listy.
+ * Sięga do węzłów listy tylko wtedy, gdy początki numerów są równe.
+ * @param[in] entry1 - wskaźnik na pierwszy wpis
+ * @param[in] entry2 - wskaźnik na drugi wpis
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
+ */
+static int compareEntries(SortedEntry const *entry1, SortedEntry const *entry2) {
+    if (entry1->head != entry2->head) {
+        return (entry1->head > entry2->head) ? 1 : -1;
+    }
+    return compareElements(entry1->key, entry2->key);
+}
+
+/** @brief Wyznacza pierwszy wpis bloku większy od podanego.
+ * @param[in] chunk - wskaźnik na blok
+ * @param[in] entry - wskaźnik na wpis
+ * @return Pozycja pierwszego wpisu większego od podanego lub liczba wpisów bloku.
+ */
+static size_t upperBound(SortedChunk const *chunk, SortedEntry const *entry) {
+    size_t low = 0;
+    size_t high = chunk->count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (compareEntries(&(chunk->entries[middle]), entry) <= 0) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/** @brief Wyznacza pierwszy wpis bloku nie mniejszy od podanego.
+ * @param[in] chunk - wskaźnik na blok
+ * @param[in] entry - wskaźnik na wpis
+ * @return Pozycja pierwszego wpisu nie mniejszego od podanego lub liczba wpisów bloku.
+ */
+static size_t lowerBound(SortedChunk const *chunk, SortedEntry const *entry) {
+    size_t low = 0;
+    size_t high = chunk->count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (compareEntries(&(chunk->entries[middle]), entry) < 0) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/** @brief Wstawia wpis do bloku, dzieląc blok na połowy, gdy jest pełny.
+ * @param[in,out] index - wskaźnik na indeks
+ * @param[in,out] chunk - wskaźnik na blok
+ * @param[in] position - pozycja wpisu w bloku
+ * @param[in] entry - wskaźnik na wstawiany wpis
+ * @param[in] child - blok niższego poziomu zapisywany we wpisie lub NULL, gdy blok jest liściem
+ * @param[out] where - adres zmiennej, na której zostaje zapisany blok z nowym wpisem
+ * @param[out] where_position - adres zmiennej, na której zostaje zapisana pozycja nowego wpisu
+ * @return Wskaźnik na blok z drugą połową wpisów lub NULL, gdy blok nie był dzielony.
+ */
+static SortedChunk * insertEntry(SortedIndex *index, SortedChunk *chunk, size_t position, SortedEntry const *entry,
+                                 SortedChunk *child, SortedChunk **where, size_t *where_position) {
+    SortedChunk *split = NULL;
+    if (chunk->count == SORTED_CHUNK) {
+        split = takeChunk(index);
+        memcpy(split->entries, chunk->entries + SORTED_HALF, SORTED_HALF * sizeof(*(chunk->entries)));
+        if (child != NULL) {
+            memcpy(split->children, chunk->children + SORTED_HALF, SORTED_HALF * sizeof(*(chunk->children)));
+        }
+        split->count = SORTED_HALF;
+        chunk->count = SORTED_HALF;
+        if (position > SORTED_HALF) {
+            chunk = split;
+            position -= SORTED_HALF;
+        }
+    }
+    size_t moved = chunk->count - position;
+    memmove(chunk->entries + position + 1, chunk->entries + position, moved * sizeof(*(chunk->entries)));
+    chunk->entries[position] = *entry;
+    if (child != NULL) {
+        memmove(chunk->children + position + 1, chunk->children + position, moved * sizeof(*(chunk->children)));
+        chunk->children[position] = child;
+    }
+    ++(chunk->count);
+    *where = chunk;
+    *where_position = position;
+    return split;
+}
+
+/** @brief Wstawia węzeł listy do poddrzewa indeksu, za węzłami mu równymi.
+ * @param[in,out] index - wskaźnik na indeks
+ * @param[in,out] chunk - wskaźnik na korzeń poddrzewa
+ * @param[in] height - liczba poziomów poddrzewa nad liśćmi
+ * @param[in] entry - wskaźnik na wpis wstawianego węzła listy
+ * @param[out] leaf - adres zmiennej, na której zostaje zapisany liść z węzłem
+ * @param[out] position - adres zmiennej, na której zostaje zapisana pozycja węzła w liściu
+ * @return Wskaźnik na blok powstały z podziału korzenia poddrzewa lub NULL.
+ */
+static SortedChunk * insertIntoChunk(SortedIndex *index, SortedChunk *chunk, size_t height, SortedEntry const *entry,
+                                     SortedChunk **leaf, size_t *position) {
+    size_t i = upperBound(chunk, entry);
+    if (height == 0) {
+        return insertEntry(index, chunk, i, entry, NULL, leaf, position);
+    }
+    i = (i > 0) ? i - 1 : 0;
+    SortedChunk *child = chunk->children[i];
+    SortedChunk *split = insertIntoChunk(index, child, height - 1, entry, leaf, position);
+    chunk->entries[i] = child->entries[0];
+    if (split == NULL) {
+        return NULL;
+    }
+    SortedChunk *where;
+    size_t where_position;
+    return insertEntry(index, chunk, i + 1, &(split->entries[0]), split, &where, &where_position);
+}
+
+/** @brief Wstawia węzeł listy do indeksu, za węzłami mu równymi.
+ * Indeks musi mieć dość bloków przydzielonych z góry.
+ * @param[in,out] index - wskaźnik na indeks
+ * @param[in] element - wskaźnik na wstawiany węzeł listy
+ * @return Wskaźnik na następny węzeł listy lub NULL, gdy wstawiony węzeł jest ostatni.
+ */
+static OneNumber * indexInsert(SortedIndex *index, OneNumber *element) {
+    SortedEntry entry = {packedHead(element->digits, element->number_length), element};
+    SortedChunk *leaf;
+    size_t position;
+    SortedChunk *split = insertIntoChunk(index, index->root, index->height, &entry, &leaf, &position);
+    if (split != NULL) {
+        SortedChunk *root = takeChunk(index);
+        root->entries[0] = index->root->entries[0];
+        root->children[0] = index->root;
+        root->entries[1] = split->entries[0];
+        root->children[1] = split;
+        root->count = 2;
+        index->root = root;
+        ++(index->height);
+    }
+    if (index->pending > 0) {
+        --(index->pending);
+    }
+    if (position + 1 < leaf->count) {
+        return leaf->entries[position + 1].key;
+    }
+    // Liść poza korzeniem ma co najmniej 2 wpisy, więc węzeł ma w nim poprzednika.
+    return (position > 0) ? leaf->entries[position - 1].key->next : NULL;
+}
+
+/** @brief Uzupełnia blok niższego poziomu, z którego usunięto wpis.
+ * Jeśli blok jest wypełniony mniej niż w połowie, przenosi do niego wpis
+ * z sąsiedniego bloku albo łączy go z sąsiednim blokiem.
+ * @param[in,out] index - wskaźnik na indeks
+ * @param[in,out] chunk - wskaźnik na blok wewnętrzny
+ * @param[in] i - pozycja zmienionego bloku niższego poziomu
+ * @param[in] leaves - czy bloki niższego poziomu są liśćmi
+ */
+static void fixChild(SortedIndex *index, SortedChunk *chunk, size_t i, bool leaves) {
+    SortedChunk *child = chunk->children[i];
+    if (child->count >= SORTED_HALF) {
+        chunk->entries[i] = child->entries[0];
+        return;
+    }
+    size_t left = (i > 0) ? i - 1 : i;
+    SortedChunk *a = chunk->children[left];
+    SortedChunk *b = chunk->children[left + 1];
+    if (a->count + b->count <= SORTED_CHUNK) { // Łączymy bloki.
+        memcpy(a->entries + a->count, b->entries, b->count * sizeof(*(a->entries)));
+        if (!leaves) {
+            memcpy(a->children + a->count, b->children, b->count * sizeof(*(a->children)));
+        }
+        a->count += b->count;
+        size_t moved = chunk->count - left - 2;
+        memmove(chunk->entries + left + 1, chunk->entries + left + 2, moved * sizeof(*(chunk->entries)));
+        memmove(chunk->children + left + 1, chunk->children + left + 2, moved * sizeof(*(chunk->children)));
+        --(chunk->count);
+        dropChunk(index, b);
+    }
+    else if (a->count < b->count) { // Przenosimy pierwszy wpis b na koniec a.
+        a->entries[a->count] = b->entries[0];
+        memmove(b->entries, b->entries + 1, (b->count - 1) * sizeof(*(b->entries)));
+        if (!leaves) {
+            a->children[a->count] = b->children[0];
+            memmove(b->children, b->children + 1, (b->count - 1) * sizeof(*(b->children)));
+        }
+        ++(a->count);
+        --(b->count);
+        chunk->entries[left + 1] = b->entries[0];
+    }
+    else { // Przenosimy ostatni wpis a na początek b.
+        memmove(b->entries + 1, b->entries, b->count * sizeof(*(b->entries)));
+        b->entries[0] = a->entries[a->count - 1];
+        if (!leaves) {
+            memmove(b->children + 1, b->children, b->count * sizeof(*(b->children)));
+            b->children[0] = a->children[a->count - 1];
+        }
+        --(a->count);
+        ++(b->count);
+        chunk->entries[left + 1] = b->entries[0];
+    }
+    chunk->entries[left] = a->entries[0];
+}
+
+/** @brief Usuwa węzeł listy z poddrzewa indeksu.
+ * @param[in,out] index - wskaźnik na indeks
+ * @param[in,out] chunk - wskaźnik na korzeń poddrzewa
+ * @param[in] height - liczba poziomów poddrzewa nad liśćmi
+ * @param[in] entry - wskaźnik na wpis usuwanego węzła listy
+ * @return Wartość @p true, jeśli węzeł był w poddrzewie; @p false w przeciwnym przypadku.
+ */
+static bool removeFromChunk(SortedIndex *index, SortedChunk *chunk, size_t height, SortedEntry const *entry) {
+    size_t i = lowerBound(chunk, entry);
+    if (height == 0) {
+        for (; (i < chunk->count) && (compareEntries(&(chunk->entries[i]), entry) == 0); ++i) {
+            if (chunk->entries[i].key == entry->key) {
+                memmove(chunk->entries + i, chunk->entries + i + 1, (chunk->count - i - 1) * sizeof(*(chunk->entries)));
+                --(chunk->count);
+                return true;
+            }
+        }
+        return false;
+    }
+    // Węzeł jest w bloku przed pierwszym nie mniejszym od niego albo, gdy są równe mu węzły, w dalszych.
+    for (size_t j = (i > 0) ? i - 1 : 0; (j < chunk->count) && ((j < i) || (compareEntries(&(chunk->entries[j]), entry) == 0)); ++j) {
+        if (removeFromChunk(index, chunk->children[j], height - 1, entry)) {
+            fixChild(index, chunk, j, height == 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @brief Usuwa węzeł listy z indeksu.
+ * @param[in,out] index - wskaźnik na indeks
+ * @param[in] element - wskaźnik na usuwany węzeł listy
+ */
+static void indexRemove(SortedIndex *index, OneNumber *element) {
+    SortedEntry entry = {packedHead(element->digits, element->number_length), element};
+    removeFromChunk(index, index->root, index->height, &entry);
+    if ((index->height > 0) && (index->root->count == 1)) {
+        SortedChunk *root = index->root;
+        index->root = root->children[0];
+        --(index->height);
+        dropChunk(index, root);
+    }
+}
+
+/** @brief Przygotowuje posortowaną listę na wstawienie kolejnych węzłów.
+ * Gdy lista będzie dłuższa niż @ref SORTED_INDEX_THRESHOLD, tworzy jej indeks
+ * i przydziela z góry tyle bloków indeksu, ile mogą potrzebować wstawienia.
+ * @param[in,out] list - wskaźnik na strukturę reprezentującą posortowaną listę
+ * @param[in] count - liczba węzłów, które zostaną wstawione
+ * @return Wartość @p true, gdy udało się alokować pamięć; @p false w przeciwnym przypadku.
+ */
+bool reserveSorted(ListOfNumbers *list, size_t count) {
+    size_t needed = list->list_size + count;
+    if ((list->sorted == NULL) && (needed <= SORTED_INDEX_THRESHOLD)) {
+        return true;
+    }
+    SortedIndex *index = list->sorted;
+    if (index == NULL) {
+        index = malloc(sizeof(*index));
+        if (index == NULL) {
+            return false;
+        }
+        index->root = NULL;
+        index->height = 0;
+        index->chunks = 0;
+        index->spare = NULL;
+        index->spares = 0;
+        index->pending = 0;
+    }
+    // Bloków nie ubywa przy wstawianiu, więc wystarczy ich tyle, ile może mieć indeks całej listy.
+    while (index->chunks + index->spares < maxChunks(needed)) {
+        SortedChunk *chunk = malloc(sizeof(*chunk));
+        if (chunk == NULL) {
+            if (list->sorted == NULL) {
+                freeSortedIndex(index);
+            }
+            return false;
+        }
+        chunk->children[0] = index->spare;
+        index->spare = chunk;
+        ++(index->spares);
+    }
+    index->pending = (count > index->pending) ? count : index->pending;
+    if (list->sorted == NULL) {
+        index->root = takeChunk(index);
+        for (OneNumber *help = list->first; help != NULL; help = help->next) {
+            indexInsert(index, help);
+        }
+        index->pending = count;
+        list->sorted = index;
+    }
+    return true;
+}
+
+/** @brief Wstawia węzeł ze spakowanym numerem do listy posortowanej rosnąco.
+ * Lista musi być przygotowana za pomocą funkcji @ref reserveSorted. Miejsce
+ * na węzeł jest szukane w indeksie listy w czasie logarytmicznym, a w liście
+ * bez indeksu od jej końca. Nie alokuje pamięci.
+ * @param[in,out] list - wskaźnik na strukturę reprezentującą posortowaną listę
+ * @param[in] element - wskaźnik na wstawiany węzeł
+ */
+void insertSortedElement(ListOfNumbers *list, OneNumber *element) {
+    OneNumber *after = NULL; // Pierwszy węzeł większy od wstawianego.
+    if (list->sorted != NULL) {
+        after = indexInsert(list->sorted, element);
+    }
+    else {
+        for (OneNumber *help = list->last; (help != NULL) && (compareElements(help, element) > 0); help = help->prev) {
+            after = help;
+        }
+    }
+
+    if (after == NULL) {
+        appendElement(list, element);
+        return;
+    }
+    element->next = after;
+    element->prev = after->prev;
+    if (after->prev == NULL) {
+        list->first = element;
+    }
+    else {
+        (after->prev)->next = element;
+    }
+    after->prev = element;
+    ++(list->list_size);
+}
+
+/** @brief Dodaje nowy element w postaci spakowanej na koniec listy.
+ * Dodaje nowy element na koniec listy, zapisując numer po dwie cyfry na bajt.
+ * @param[in] list - wskaźnik na strukturę reprezentującą listę
+ * @param[in] num - wskaźnik na ciąg znaków reprezentujący numer
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wartość @p true, gdy udało się alokować pamięć; @p false w przeciwnym przypadku.
+ */
+bool addPackedElement(ListOfNumbers *list, const char *num, size_t number_length) {
+    OneNumber *help = newPackedNumber(num, number_length);
+    if (help == NULL) {
+        return false;
+    }
+    appendElement(list, help);
+    return true;
+}
+
+/** @brief Tworzy węzeł listy ze spakowanym numerem, niedołączony do żadnej listy.
+ * @param[in] num - wskaźnik na ciąg znaków reprezentujący numer
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wskaźnik na utworzony węzeł lub NULL, gdy nie udało się alokować pamięci.
+ */
+OneNumber * newPackedNumber(const char *num, size_t number_length) {
+    OneNumber *help = malloc(sizeof(*help));
+    if (help == NULL) {
+        return NULL;
+    }
+    help->digits = packNumber(num, number_length);
+    if (help->digits == NULL) {
+        free(help);
+        return NULL;
+    }
+    help->number_length = number_length;
+    help->prev = NULL;
+    help->next = NULL;
+    return help;
+}
+
+/** @brief Tworzy węzeł listy ze spakowanym numerem zapisanym w słowie 64-bitowym.
+ * Działa tak samo jak @ref newPackedNumber dla numeru o co najwyżej 16 cyfrach,
+ * ale nie czyta napisu z numerem.
+ * @param[in] head - słowo reprezentujące numer, w postaci zwracanej przez @ref packedHead
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wskaźnik na utworzony węzeł lub NULL, gdy nie udało się alokować pamięci.
+ */
+OneNumber * newHeadNumber(uint64_t head, size_t number_length) {
+    OneNumber *help = malloc(sizeof(*help));
+    if (help == NULL) {
+        return NULL;
+    }
+    help->digits = malloc((number_length > 0) ? packedSize(number_length) : 1);
+    if (help->digits == NULL) {
+        free(help);
+        return NULL;
+    }
+    storeHead(help->digits, head, number_length);
+    help->number_length = number_length;
+    help->prev = NULL;
+    help->next = NULL;
+    return help;
+}
+
+/** @brief Usuwa węzeł listy, który nie został dołączony do żadnej listy.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] element - wskaźnik na usuwany węzeł
+ */
+void freeNumber(OneNumber *element) {
+    if (element != NULL) {
+        free(element->number);
+        free(element);
+    }
+}
+
+/** @brief Dodaje na koniec listy napis powstały z rozpakowania numeru.
+ * Dodaje nowy element na koniec listy, zapisując spakowany numer jako napis.
+ * @param[in] list - wskaźnik na strukturę reprezentującą listę
+ * @param[in] digits - wskaźnik na spakowane cyfry numeru
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wartość @p true, gdy udało się alokować pamięć; @p false w przeciwnym przypadku.
+ */
+bool addUnpackedElement(ListOfNumbers *list, unsigned char const *digits, size_t number_length) {
+    OneNumber *help = malloc(sizeof(*help));
+    if (help == NULL) {
+        return false;
+    }
+    help->number = malloc((number_length + 1) * sizeof(*(help->number)));
+    if (help->number == NULL) {
+        free(help);
+        return false;
+    }
+    unpackDigits(help->number, digits, number_length);
+    (help->number)[number_length] = '\0';
+    help->number_length = number_length;
+    appendElement(list, help);
+    return true;
+}
+
+/** @brief Odłącza element od listy bez zwalniania go.
+ * @param[in] list - wskaźnik na niepustą listę;
+ * @param[in] element- wskaźnik na odłączany element
+ */
+static void unlinkElement(ListOfNumbers *list, OneNumber *element) {
+    if (list->sorted != NULL) { // Usuwamy węzeł także z indeksu listy.
+        indexRemove(list->sorted, element);
+    }
+    if ((list->first != element) && (list->last != element)) { // Element jest w środku listy.
+        (element->prev)->next = element->next;
+        (element->next)->prev = element->prev;
+    }
+    if (list->first == element) {
+        list->first = element->next; // W przypadku listy jednoelementowej to będzie NULL.
+        if (list->first != NULL) {
+            (list->first)->prev = NULL;
+        }
+    }
+    if (list->last == element) {
+        list->last = element->prev; // W przypadku listy jednoelementowej to będzie NULL.
+        if (list->last != NULL) {
+            (list->last)->next = NULL;
+        }
+    }
+    --(list->list_size);
+}
+
 /** @brief Usuwa z listy element o podanym adresie.
  * Usuwa z listy element o podanym adresie.
  * @param[in] list - wskaźnik na strukturę reprezentującą listę;
@@ -107,25 +680,9 @@ bool addElement(ListOfNumbers *list, const char *num, size_t number_length) {
 void removeElement(ListOfNumbers *list, OneNumber *element) {
     if ((list != NULL) && (element != NULL)) {
         if(!empty(list)) {
+            unlinkElement(list, element);
             free(element->number);
-            if ((list->first != element) && (list->last != element)) { // Element jest w środku listy.
-                (element->prev)->next = element->next;
-                (element->next)->prev = element->prev;
-            }
-            if (list->first == element) {
-                list->first = element->next; // W przypadku listy jednoelementowej to będzie NULL.
-                if (list->first != NULL) {
-                    (list->first)->prev = NULL;
-                }
-            }
-            if (list->last == element) {
-                list->last = element->prev; // W przypadku listy jednoelementowej to będzie NULL.
-                if (list->last != NULL) {
-                    (list->last)->next = NULL;
-                }
-            }
             free(element);
-            --(list->list_size);
         }
     }
 
@@ -138,8 +695,198 @@ void removeElement(ListOfNumbers *list, OneNumber *element) {
  */
 void freeList(ListOfNumbers *list) {
     if (list != NULL) {
+        freeSortedIndex(list->sorted);
+        list->sorted = NULL;
         while(!empty(list)) {
             removeElement(list, list->last);
         }
     }
+}
+
+/** @brief Wyznacza klasę pamięci podręcznej węzła o danej długości numeru.
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Numer klasy lub 0, gdy numer jest za długi.
+ */
+static size_t numberClass(size_t number_length) {
+    size_t size = packedSize(number_length);
+    return (size <= NUMBER_CACHE_CLASSES) ? size : 0;
+}
+
+/** @brief Tworzy węzeł listy ze spakowanym numerem, korzystając z pamięci podręcznej.
+ * Działa tak samo jak @ref newPackedNumber, ale najpierw próbuje użyć
+ * zwolnionego węzła z tablicą cyfr odpowiedniego rozmiaru.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] num - wskaźnik na ciąg znaków reprezentujący numer
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wskaźnik na utworzony węzeł lub NULL, gdy nie udało się alokować pamięci.
+ */
+OneNumber * cachedPackedNumber(NumberCache *cache, const char *num, size_t number_length) {
+    size_t class = numberClass(number_length);
+    OneNumber *help = (cache->numbers)[class];
+    if ((class == 0) || (help == NULL)) {
+        help = (cache->numbers)[0];
+        if (help == NULL) {
+            return newPackedNumber(num, number_length);
+        }
+        help->digits = packNumber(num, number_length);
+        if (help->digits == NULL) {
+            return NULL; // Węzeł zostaje w pamięci podręcznej.
+        }
+        class = 0;
+    }
+    else {
+        packDigits(help->digits, num, number_length);
+    }
+    (cache->numbers)[class] = help->next;
+    --(cache->numbers_count);
+    if (cache->reserved > 0) {
+        --(cache->reserved);
+    }
+    help->number_length = number_length;
+    help->prev = NULL;
+    help->next = NULL;
+    return help;
+}
+
+/** @brief Dodaje nowy element w postaci spakowanej na koniec listy, korzystając z pamięci podręcznej.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] list - wskaźnik na strukturę reprezentującą listę
+ * @param[in] num - wskaźnik na ciąg znaków reprezentujący numer
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wartość @p true, gdy udało się alokować pamięć; @p false w przeciwnym przypadku.
+ */
+bool addCachedElement(NumberCache *cache, ListOfNumbers *list, const char *num, size_t number_length) {
+    OneNumber *help = cachedPackedNumber(cache, num, number_length);
+    if (help == NULL) {
+        return false;
+    }
+    appendElement(list, help);
+    return true;
+}
+
+/** @brief Oddaje do pamięci podręcznej węzeł listy ze spakowanym numerem.
+ * Węzeł nie może być dołączony do żadnej listy. Tablica cyfr za długiego
+ * numeru jest zwalniana, a sam węzeł trafia do klasy 0. Jeśli pamięć
+ * podręczna jest pełna, węzeł jest zwalniany.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] element - wskaźnik na oddawany węzeł
+ */
+void cacheNumber(NumberCache *cache, OneNumber *element) {
+    if ((element != NULL) && (cache->numbers_count >= NUMBER_CACHE_LIMIT + cache->reserved)) {
+        freeNumber(element);
+    }
+    else if (element != NULL) {
+        size_t class = numberClass(element->number_length);
+        if (class == 0) {
+            free(element->number);
+            element->number = NULL;
+        }
+        element->next = (cache->numbers)[class];
+        (cache->numbers)[class] = element;
+        ++(cache->numbers_count);
+    }
+}
+
+/** @brief Usuwa z listy element ze spakowanym numerem, oddając go do pamięci podręcznej.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] list - wskaźnik na strukturę reprezentującą listę
+ * @param[in] element - wskaźnik na usuwany element
+ */
+void removeCachedElement(NumberCache *cache, ListOfNumbers *list, OneNumber *element) {
+    if ((list != NULL) && (element != NULL) && !empty(list)) {
+        unlinkElement(list, element);
+        cacheNumber(cache, element);
+    }
+}
+
+/** @brief Tworzy nową listę numerów, korzystając z pamięci podręcznej.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+ListOfNumbers * cachedList(NumberCache *cache) {
+    ListOfNumbers *result = cache->lists;
+    if (result == NULL) {
+        return newList();
+    }
+    cache->lists = (ListOfNumbers *)result->first;
+    --(cache->lists_count);
+    result->first = NULL;
+    result->last = NULL;
+    result->list_size = 0;
+    return result;
+}
+
+/** @brief Oddaje do pamięci podręcznej listę razem z jej elementami ze spakowanymi numerami.
+ * Jeśli pamięć podręczna jest pełna, lista lub jej elementy są zwalniane.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] list - wskaźnik na oddawaną listę
+ */
+void releaseList(NumberCache *cache, ListOfNumbers *list) {
+    if (list != NULL) {
+        freeSortedIndex(list->sorted);
+        list->sorted = NULL;
+        while (!empty(list)) {
+            removeCachedElement(cache, list, list->last);
+        }
+        if (cache->lists_count >= NUMBER_CACHE_LIMIT) {
+            free(list);
+        }
+        else {
+            list->first = (OneNumber *)cache->lists;
+            cache->lists = list;
+            ++(cache->lists_count);
+        }
+    }
+}
+
+/** @brief Przydziela z góry węzły list bez tablic cyfr.
+ * Przydzielone węzły nie liczą się do limitu @ref NUMBER_CACHE_LIMIT,
+ * dopóki nie zostaną użyte.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] count - liczba przydzielanych węzłów
+ * @return Wartość @p true, gdy udało się alokować pamięć; @p false w przeciwnym przypadku.
+ *         Węzły przydzielone przed niepowodzeniem zostają w pamięci podręcznej.
+ */
+bool reserveNumbers(NumberCache *cache, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        OneNumber *help = newNumber();
+        if (help == NULL) {
+            return false;
+        }
+        help->next = (cache->numbers)[0];
+        (cache->numbers)[0] = help;
+        ++(cache->numbers_count);
+        ++(cache->reserved);
+    }
+    return true;
+}
+
+/** @brief Zwalnia wszystkie węzły i listy z pamięci podręcznej.
+ * Zapomina też o węzłach przydzielonych z góry.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @return Liczba zwolnionych bajtów.
+ */
+size_t trimNumberCache(NumberCache *cache) {
+    size_t result = 0;
+    for (size_t class = 0; class <= NUMBER_CACHE_CLASSES; ++class) {
+        while ((cache->numbers)[class] != NULL) {
+            OneNumber *help = (cache->numbers)[class];
+            (cache->numbers)[class] = help->next;
+            result += sizeof(*help) + class;
+            freeNumber(help);
+        }
+    }
+    while (cache->lists != NULL) {
+        ListOfNumbers *help = cache->lists;
+        cache->lists = (ListOfNumbers *)help->first;
+        result += sizeof(*help);
+        free(help);
+    }
+    cache->numbers_count = 0;
+    cache->lists_count = 0;
+    cache->reserved = 0;
+    return result;
 }
\ No newline at end of file
@@ -13,17 +13,64 @@
 #include <stddef.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include "packed_number.h"
 
 /**
  * To jest struktura reprezentująca węzeł listy numerów.
+ * Numery przechowywane w drzewach są zapisane w postaci spakowanej (pole @p digits),
+ * a numery zwracane użytkownikowi jako napisy (pole @p number).
  */
 typedef struct OneNumber {
-    char *number; ///< wskaźnik na początek tablicy, gdzie zapisany jest numer
+    union {
+        char *number; ///< wskaźnik na początek tablicy, gdzie zapisany jest numer
+        unsigned char *digits; ///< wskaźnik na spakowane cyfry numeru
+    };
     size_t number_length; ///< długość zapisanego w tym węźle listy numeru
     struct OneNumber *prev; ///< prev - wskaźnik na poprzedni węzeł listy
     struct OneNumber *next; ///< next - wskaźnik na kolejny węzeł listy
 } OneNumber;
 
+/**
+ * To jest największa liczba wpisów w jednym bloku indeksu posortowanej listy.
+ */
+#define SORTED_CHUNK 32
+
+/**
+ * To jest wpis indeksu posortowanej listy. Początek numeru pozwala porównywać
+ * wpisy bez sięgania do węzłów listy, dopóki numery różnią się na pierwszych
+ * 16 cyfrach.
+ */
+typedef struct SortedEntry {
+    uint64_t head; ///< początek numeru węzła w postaci zwróconej przez @ref packedHead
+    struct OneNumber *key; ///< węzeł listy
+} SortedEntry;
+
+/**
+ * To jest blok B+drzewa będącego indeksem posortowanej listy. Liście drzewa
+ * przechowują węzły listy w kolejności rosnącej, a bloki wewnętrzne bloki
+ * niższego poziomu razem z najmniejszym węzłem listy w każdym z nich.
+ * Każdy blok poza korzeniem jest wypełniony co najmniej w połowie.
+ */
+typedef struct SortedChunk {
+    size_t count; ///< liczba wpisów bloku
+    SortedEntry entries[SORTED_CHUNK]; ///< węzły listy (w liściu) lub najmniejsze węzły listy w blokach niższego poziomu
+    struct SortedChunk *children[SORTED_CHUNK]; ///< bloki niższego poziomu; nieużywane w liściu
+} SortedChunk;
+
+/**
+ * To jest indeks posortowanej listy. Wstawienie i usunięcie węzła listy
+ * zmienia najwyżej jeden blok na każdym poziomie drzewa i jego sąsiada, więc
+ * zajmuje czas logarytmiczny względem długości listy.
+ */
+typedef struct SortedIndex {
+    SortedChunk *root; ///< korzeń drzewa
+    size_t height; ///< liczba poziomów drzewa nad liśćmi
+    size_t chunks; ///< liczba bloków drzewa
+    SortedChunk *spare; ///< bloki przydzielone z góry, połączone przez pola children[0]
+    size_t spares; ///< liczba bloków przydzielonych z góry
+    size_t pending; ///< liczba wstawień, dla których przydzielono bloki, a które jeszcze nie nastąpiły
+} SortedIndex;
+
 /**
  * To jest struktura reprezentująca listę numerów.
  */
@@ -31,8 +78,44 @@ typedef struct ListOfNumbers {
     struct OneNumber *first; ///< first - wskaźnik na pierwszy węzeł listy
     struct OneNumber *last; ///< last - wskaźnik na ostatni węzeł listy
     size_t list_size; ///< ilość elementów listy
+    struct SortedIndex *sorted; ///< indeks posortowanej listy lub NULL, gdy lista nie ma indeksu
 } ListOfNumbers;
 
+/**
+ * To jest największa liczba węzłów posortowanej listy, przy której lista może
+ * nie mieć indeksu. W krótkiej liście miejsce na nowy węzeł jest szukane
+ * przez przejście od końca listy.
+ */
+#define SORTED_INDEX_THRESHOLD 8
+
+/**
+ * To jest liczba klas rozmiaru spakowanych numerów przechowywanych w pamięci
+ * podręcznej węzłów list. Dłuższe numery są zwalniane od razu.
+ */
+#define NUMBER_CACHE_CLASSES 16
+
+/**
+ * To jest największa liczba węzłów list, a osobno list, trzymanych w pamięci
+ * podręcznej poza węzłami przydzielonymi z góry. Nadmiarowe są zwalniane od
+ * razu, więc po usunięciu wielu przekierowań struktura nie trzyma pamięci
+ * zajmowanej przez wpisy w chwili największego zapełnienia.
+ */
+#define NUMBER_CACHE_LIMIT 16384
+
+/**
+ * To jest pamięć podręczna zwolnionych węzłów list i list numerów drzew.
+ * Węzły z klasy o numerze k mają tablicę cyfr o rozmiarze k bajtów, a węzły
+ * z klasy 0 nie mają tablicy cyfr. Węzły są połączone przez pola @p next,
+ * a listy przez pola @p first. Z pamięci podręcznej korzysta jeden wątek naraz.
+ */
+typedef struct NumberCache {
+    OneNumber *numbers[NUMBER_CACHE_CLASSES + 1]; ///< zwolnione węzły list kolejnych klas
+    ListOfNumbers *lists; ///< zwolnione listy
+    size_t numbers_count; ///< liczba węzłów list wszystkich klas
+    size_t lists_count; ///< liczba list
+    size_t reserved; ///< liczba węzłów przydzielonych z góry, które nie zostały jeszcze użyte
+} NumberCache;
+
 /** @brief Tworzy nowy węzeł listy numerów.
  * Tworzy nowy węzeł listy numerów.
  * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
@@ -61,6 +144,71 @@ bool empty(ListOfNumbers *list);
  */
 bool addElement(ListOfNumbers *list, const char *num, size_t number_length);
 
+/** @brief Tworzy węzeł listy ze spakowanym numerem, niedołączony do żadnej listy.
+ * @param[in] num - wskaźnik na ciąg znaków reprezentujący numer
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wskaźnik na utworzony węzeł lub NULL, gdy nie udało się alokować pamięci.
+ */
+OneNumber * newPackedNumber(const char *num, size_t number_length);
+
+/** @brief Tworzy węzeł listy ze spakowanym numerem zapisanym w słowie 64-bitowym.
+ * Działa tak samo jak @ref newPackedNumber dla numeru o co najwyżej 16 cyfrach,
+ * ale nie czyta napisu z numerem.
+ * @param[in] head - słowo reprezentujące numer, w postaci zwracanej przez @ref packedHead
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wskaźnik na utworzony węzeł lub NULL, gdy nie udało się alokować pamięci.
+ */
+OneNumber * newHeadNumber(uint64_t head, size_t number_length);
+
+/** @brief Dołącza węzeł na koniec listy.
+ * Nie alokuje pamięci.
+ * @param[in] list - wskaźnik na strukturę reprezentującą listę
+ * @param[in] element - wskaźnik na dołączany węzeł
+ */
+void appendElement(ListOfNumbers *list, OneNumber *element);
+
+/** @brief Przygotowuje posortowaną listę na wstawienie kolejnych węzłów.
+ * Gdy lista będzie dłuższa niż @ref SORTED_INDEX_THRESHOLD, tworzy jej indeks
+ * i przydziela z góry tyle bloków indeksu, ile mogą potrzebować wstawienia.
+ * @param[in,out] list - wskaźnik na strukturę reprezentującą posortowaną listę
+ * @param[in] count - liczba węzłów, które zostaną wstawione
+ * @return Wartość @p true, gdy udało się alokować pamięć; @p false w przeciwnym przypadku.
+ */
+bool reserveSorted(ListOfNumbers *list, size_t count);
+
+/** @brief Wstawia węzeł ze spakowanym numerem do listy posortowanej rosnąco.
+ * Lista musi być przygotowana za pomocą funkcji @ref reserveSorted. Miejsce
+ * na węzeł jest szukane w indeksie listy w czasie logarytmicznym, a w liście
+ * bez indeksu od jej końca. Nie alokuje pamięci.
+ * @param[in,out] list - wskaźnik na strukturę reprezentującą posortowaną listę
+ * @param[in] element - wskaźnik na wstawiany węzeł
+ */
+void insertSortedElement(ListOfNumbers *list, OneNumber *element);
+
+/** @brief Usuwa węzeł listy, który nie został dołączony do żadnej listy.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] element - wskaźnik na usuwany węzeł
+ */
+void freeNumber(OneNumber *element);
+
+/** @brief Dodaje nowy element w postaci spakowanej na koniec listy.
+ * Dodaje nowy element na koniec listy, zapisując numer po dwie cyfry na bajt.
+ * @param[in] list - wskaźnik na strukturę reprezentującą listę
+ * @param[in] num - wskaźnik na ciąg znaków reprezentujący numer
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wartość @p true, gdy udało się alokować pamięć; @p false w przeciwnym przypadku.
+ */
+bool addPackedElement(ListOfNumbers *list, const char *num, size_t number_length);
+
+/** @brief Dodaje na koniec listy napis powstały z rozpakowania numeru.
+ * Dodaje nowy element na koniec listy, zapisując spakowany numer jako napis.
+ * @param[in] list - wskaźnik na strukturę reprezentującą listę
+ * @param[in] digits - wskaźnik na spakowane cyfry numeru
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wartość @p true, gdy udało się alokować pamięć; @p false w przeciwnym przypadku.
+ */
+bool addUnpackedElement(ListOfNumbers *list, unsigned char const *digits, size_t number_length);
+
 /** @brief Usuwa z listy element o podanym adresie.
  * Usuwa z listy element o podanym adresie.
  * @param[in] list - wskaźnik na strukturę reprezentującą listę;
@@ -74,4 +222,71 @@ void removeElement(ListOfNumbers *list, OneNumber *element);
  */
 void freeList(ListOfNumbers *list);
 
+/** @brief Tworzy węzeł listy ze spakowanym numerem, korzystając z pamięci podręcznej.
+ * Działa tak samo jak @ref newPackedNumber, ale najpierw próbuje użyć
+ * zwolnionego węzła z tablicą cyfr odpowiedniego rozmiaru.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] num - wskaźnik na ciąg znaków reprezentujący numer
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wskaźnik na utworzony węzeł lub NULL, gdy nie udało się alokować pamięci.
+ */
+OneNumber * cachedPackedNumber(NumberCache *cache, const char *num, size_t number_length);
+
+/** @brief Dodaje nowy element w postaci spakowanej na koniec listy, korzystając z pamięci podręcznej.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] list - wskaźnik na strukturę reprezentującą listę
+ * @param[in] num - wskaźnik na ciąg znaków reprezentujący numer
+ * @param[in] number_length - liczba cyfr numeru
+ * @return Wartość @p true, gdy udało się alokować pamięć; @p false w przeciwnym przypadku.
+ */
+bool addCachedElement(NumberCache *cache, ListOfNumbers *list, const char *num, size_t number_length);
+
+/** @brief Oddaje do pamięci podręcznej węzeł listy ze spakowanym numerem.
+ * Węzeł nie może być dołączony do żadnej listy. Jeśli pamięć podręczna jest
+ * pełna, węzeł jest zwalniany.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] element - wskaźnik na oddawany węzeł
+ */
+void cacheNumber(NumberCache *cache, OneNumber *element);
+
+/** @brief Usuwa z listy element ze spakowanym numerem, oddając go do pamięci podręcznej.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] list - wskaźnik na strukturę reprezentującą listę
+ * @param[in] element - wskaźnik na usuwany element
+ */
+void removeCachedElement(NumberCache *cache, ListOfNumbers *list, OneNumber *element);
+
+/** @brief Tworzy nową listę numerów, korzystając z pamięci podręcznej.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+ListOfNumbers * cachedList(NumberCache *cache);
+
+/** @brief Oddaje do pamięci podręcznej listę razem z jej elementami ze spakowanymi numerami.
+ * Jeśli pamięć podręczna jest pełna, lista lub jej elementy są zwalniane.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] list - wskaźnik na oddawaną listę
+ */
+void releaseList(NumberCache *cache, ListOfNumbers *list);
+
+/** @brief Przydziela z góry węzły list bez tablic cyfr.
+ * Przydzielone węzły nie liczą się do limitu @ref NUMBER_CACHE_LIMIT,
+ * dopóki nie zostaną użyte.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @param[in] count - liczba przydzielanych węzłów
+ * @return Wartość @p true, gdy udało się alokować pamięć; @p false w przeciwnym przypadku.
+ *         Węzły przydzielone przed niepowodzeniem zostają w pamięci podręcznej.
+ */
+bool reserveNumbers(NumberCache *cache, size_t count);
+
+/** @brief Zwalnia wszystkie węzły i listy z pamięci podręcznej.
+ * Zapomina też o węzłach przydzielonych z góry.
+ * @param[in,out] cache - wskaźnik na pamięć podręczną
+ * @return Liczba zwolnionych bajtów.
+ */
+size_t trimNumberCache(NumberCache *cache);
+
 #endif /* __LIST_H__ */
\ No newline at end of file
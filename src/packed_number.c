@@ -0,0 +1,201 @@
+/** @file
+ * Implementacja klasy funkcji operujących na numerach zapisanych w postaci spakowanej
+ * (po dwie cyfry na bajt).
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "packed_number.h"
+#include "phfwd_simd.h"
+
+/**
+ * To jest liczba bajtów słowa, którym porównywane są spakowane numery.
+ */
+#define WORD_BYTES 8
+
+/** @brief Zwraca liczbę bajtów potrzebnych do zapisania numeru w postaci spakowanej.
+ * @param[in] length - liczba cyfr numeru
+ * @return Liczba bajtów potrzebnych do zapisania numeru.
+ */
+size_t packedSize(size_t length) {
+    return (length + 1) / 2;
+}
+
+/** @brief Zwraca znak reprezentujący cyfrę o danej wartości.
+ * @param[in] value - wartość cyfry z zakresu od 0 do 11
+ * @return Znak reprezentujący cyfrę.
+ */
+char digitCharacter(int value) {
+    static char const alphabet[] = "0123456789*#";
+    return alphabet[value];
+}
+
+/** @brief Zapisuje cyfrę na danej pozycji spakowanego numeru.
+ * @param[in,out] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] i - pozycja cyfry
+ * @param[in] value - wartość cyfry z zakresu od 0 do 11
+ */
+void setPackedDigit(unsigned char *digits, size_t i, int value) {
+    unsigned char code = (unsigned char)(value + 1);
+    if (i % 2 == 0) {
+        digits[i / 2] = (unsigned char)(code << 4); // Młodsza połowa bajtu zostaje wyzerowana.
+    }
+    else {
+        digits[i / 2] = (unsigned char)((digits[i / 2] & 0xF0) | code);
+    }
+}
+
+/** @brief Odczytuje wartość cyfry z danej pozycji spakowanego numeru.
+ * @param[in] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] i - pozycja cyfry
+ * @return Wartość cyfry z zakresu od 0 do 11.
+ */
+int packedDigitValue(unsigned char const *digits, size_t i) {
+    if (i % 2 == 0) {
+        return (digits[i / 2] >> 4) - 1;
+    }
+    else {
+        return (digits[i / 2] & 0x0F) - 1;
+    }
+}
+
+/** @brief Pakuje numer zapisany jako napis.
+ * Zapisuje @p length pierwszych cyfr napisu @p num w tablicy @p digits,
+ * która musi mieć co najmniej @ref packedSize(length) bajtów.
+ * @param[out] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - liczba pakowanych cyfr
+ */
+void packDigits(unsigned char *digits, char const *num, size_t length) {
+    encodePacked(digits, num, length); // Numer został już sprawdzony.
+}
+
+/** @brief Tworzy spakowaną kopię numeru zapisanego jako napis.
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - liczba cyfr numeru
+ * @return Wskaźnik na tablicę spakowanych cyfr lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+unsigned char * packNumber(char const *num, size_t length) {
+    size_t size = packedSize(length);
+    unsigned char *result = malloc((size > 0) ? size : 1); // Pusty numer też dostaje swój bajt.
+    if (result != NULL) {
+        packDigits(result, num, length);
+    }
+    return result;
+}
+
+/** @brief Rozpakowuje numer do napisu.
+ * Zapisuje cyfry spakowanego numeru jako znaki, bez kończącego znaku '\0'.
+ * @param[out] num - wskaźnik na tablicę znaków o długości co najmniej @p length
+ * @param[in] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] length - liczba cyfr numeru
+ */
+void unpackDigits(char *num, unsigned char const *digits, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        num[i] = digitCharacter(packedDigitValue(digits, i));
+    }
+}
+
+/** @brief Odczytuje słowo 64-bitowe tak, aby wcześniejsze bajty były bardziej znaczące.
+ * @param[in] bytes - wskaźnik na pierwszy bajt słowa
+ * @return Odczytane słowo.
+ */
+static uint64_t loadWord(unsigned char const *bytes) {
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+/** @brief Zwraca początek spakowanego numeru zapisany w słowie 64-bitowym.
+ * Słowo zawiera pierwsze 16 cyfr numeru, uzupełnione zerami, więc porządek
+ * słów zgadza się z porządkiem numerów na tych cyfrach.
+ * @param[in] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] length - liczba cyfr numeru
+ * @return Słowo reprezentujące początek numeru.
+ */
+uint64_t packedHead(unsigned char const *digits, size_t length) {
+    size_t bytes = packedSize(length);
+    if (bytes >= WORD_BYTES) {
+        return loadWord(digits);
+    }
+    unsigned char word[WORD_BYTES] = {0};
+    memcpy(word, digits, bytes);
+    return loadWord(word);
+}
+
+/** @brief Zapisuje spakowane cyfry numeru, którego początek jest zapisany w słowie 64-bitowym.
+ * Słowo ma postać zwracaną przez @ref packedHead, więc numer może mieć
+ * co najwyżej 16 cyfr.
+ * @param[out] digits - wskaźnik na tablicę o rozmiarze co najmniej @ref packedSize(length)
+ * @param[in] head - słowo reprezentujące numer
+ * @param[in] length - liczba cyfr numeru
+ */
+void storeHead(unsigned char *digits, uint64_t head, size_t length) {
+    for (size_t i = 0; i < packedSize(length); ++i) {
+        digits[i] = (unsigned char)(head >> (56 - 8 * i));
+    }
+}
+
+/** @brief Porównuje 2 spakowane numery.
+ * Porównuje numery po 16 cyfr (jedno słowo 64-bitowe) naraz.
+ * @param[in] digits1 - wskaźnik na spakowane cyfry pierwszego numeru
+ * @param[in] length1 - liczba cyfr pierwszego numeru
+ * @param[in] digits2 - wskaźnik na spakowane cyfry drugiego numeru
+ * @param[in] length2 - liczba cyfr drugiego numeru
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
+ */
+int packedCompare(unsigned char const *digits1, size_t length1, unsigned char const *digits2, size_t length2) {
+    size_t bytes1 = packedSize(length1);
+    size_t bytes2 = packedSize(length2);
+    size_t bytes = (bytes1 < bytes2) ? bytes1 : bytes2;
+    size_t i = 0;
+
+    while (i + WORD_BYTES <= bytes) {
+        uint64_t word1 = loadWord(digits1 + i);
+        uint64_t word2 = loadWord(digits2 + i);
+        if (word1 != word2) {
+            return (word1 > word2) ? 1 : -1;
+        }
+        i += WORD_BYTES;
+    }
+    while (i < bytes) {
+        if (digits1[i] != digits2[i]) {
+            return (digits1[i] > digits2[i]) ? 1 : -1;
+        }
+        ++i;
+    }
+
+    // Dzięki zerowemu dopełnieniu równe bajty oznaczają, że krótszy numer jest prefiksem dłuższego.
+    if (length1 == length2) {
+        return 0;
+    }
+    else if (length1 < length2) {
+        return -1;
+    }
+    else {
+        return 1;
+    }
+}
+
+/** @brief Porównuje 2 numery zapisane w strukturach @ref PackedNumber.
+ * Funkcja w postaci wymaganej przez qsort.
+ * @param[in] num1 - wskaźnik na strukturę reprezentującą pierwszy numer
+ * @param[in] num2 - wskaźnik na strukturę reprezentującą drugi numer
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
+ */
+int comparePackedNumbers(const void *num1, const void *num2) {
+    PackedNumber const *number1 = num1;
+    PackedNumber const *number2 = num2;
+    return packedCompare(number1->digits, number1->length, number2->digits, number2->length);
+}
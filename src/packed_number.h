@@ -0,0 +1,117 @@
+/** @file
+ * Interfejs klasy funkcji operujących na numerach zapisanych w postaci spakowanej
+ * (po dwie cyfry na bajt).
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PACKED_NUMBER_H__
+#define __PACKED_NUMBER_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * To jest struktura reprezentująca numer zapisany w postaci spakowanej.
+ * Każda cyfra zajmuje 4 bity i jest zapisana jako jej wartość (od 0 do 11)
+ * powiększona o 1. Starsza połowa bajtu przechowuje cyfrę wcześniejszą.
+ * Nieużywana połowa ostatniego bajtu ma wartość 0, dzięki czemu porównanie
+ * bajtów spakowanych numerów zgadza się z porządkiem leksykograficznym.
+ */
+typedef struct PackedNumber {
+    unsigned char *digits; ///< wskaźnik na tablicę spakowanych cyfr
+    size_t length; ///< liczba cyfr numeru
+} PackedNumber;
+
+/** @brief Zwraca liczbę bajtów potrzebnych do zapisania numeru w postaci spakowanej.
+ * @param[in] length - liczba cyfr numeru
+ * @return Liczba bajtów potrzebnych do zapisania numeru.
+ */
+size_t packedSize(size_t length);
+
+/** @brief Zwraca znak reprezentujący cyfrę o danej wartości.
+ * @param[in] value - wartość cyfry z zakresu od 0 do 11
+ * @return Znak reprezentujący cyfrę.
+ */
+char digitCharacter(int value);
+
+/** @brief Zapisuje cyfrę na danej pozycji spakowanego numeru.
+ * @param[in,out] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] i - pozycja cyfry
+ * @param[in] value - wartość cyfry z zakresu od 0 do 11
+ */
+void setPackedDigit(unsigned char *digits, size_t i, int value);
+
+/** @brief Odczytuje wartość cyfry z danej pozycji spakowanego numeru.
+ * @param[in] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] i - pozycja cyfry
+ * @return Wartość cyfry z zakresu od 0 do 11.
+ */
+int packedDigitValue(unsigned char const *digits, size_t i);
+
+/** @brief Pakuje numer zapisany jako napis.
+ * Zapisuje @p length pierwszych cyfr napisu @p num w tablicy @p digits,
+ * która musi mieć co najmniej @ref packedSize(length) bajtów.
+ * @param[out] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - liczba pakowanych cyfr
+ */
+void packDigits(unsigned char *digits, char const *num, size_t length);
+
+/** @brief Tworzy spakowaną kopię numeru zapisanego jako napis.
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - liczba cyfr numeru
+ * @return Wskaźnik na tablicę spakowanych cyfr lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+unsigned char * packNumber(char const *num, size_t length);
+
+/** @brief Rozpakowuje numer do napisu.
+ * Zapisuje cyfry spakowanego numeru jako znaki, bez kończącego znaku '\0'.
+ * @param[out] num - wskaźnik na tablicę znaków o długości co najmniej @p length
+ * @param[in] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] length - liczba cyfr numeru
+ */
+void unpackDigits(char *num, unsigned char const *digits, size_t length);
+
+/** @brief Zwraca początek spakowanego numeru zapisany w słowie 64-bitowym.
+ * Słowo zawiera pierwsze 16 cyfr numeru, uzupełnione zerami, więc porządek
+ * słów zgadza się z porządkiem numerów na tych cyfrach.
+ * @param[in] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] length - liczba cyfr numeru
+ * @return Słowo reprezentujące początek numeru.
+ */
+uint64_t packedHead(unsigned char const *digits, size_t length);
+
+/** @brief Zapisuje spakowane cyfry numeru, którego początek jest zapisany w słowie 64-bitowym.
+ * Słowo ma postać zwracaną przez @ref packedHead, więc numer może mieć
+ * co najwyżej 16 cyfr.
+ * @param[out] digits - wskaźnik na tablicę o rozmiarze co najmniej @ref packedSize(length)
+ * @param[in] head - słowo reprezentujące numer
+ * @param[in] length - liczba cyfr numeru
+ */
+void storeHead(unsigned char *digits, uint64_t head, size_t length);
+
+/** @brief Porównuje 2 spakowane numery.
+ * Porównuje numery po 16 cyfr (jedno słowo 64-bitowe) naraz.
+ * @param[in] digits1 - wskaźnik na spakowane cyfry pierwszego numeru
+ * @param[in] length1 - liczba cyfr pierwszego numeru
+ * @param[in] digits2 - wskaźnik na spakowane cyfry drugiego numeru
+ * @param[in] length2 - liczba cyfr drugiego numeru
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
+ */
+int packedCompare(unsigned char const *digits1, size_t length1, unsigned char const *digits2, size_t length2);
+
+/** @brief Porównuje 2 numery zapisane w strukturach @ref PackedNumber.
+ * Funkcja w postaci wymaganej przez qsort.
+ * @param[in] num1 - wskaźnik na strukturę reprezentującą pierwszy numer
+ * @param[in] num2 - wskaźnik na strukturę reprezentującą drugi numer
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
+ */
+int comparePackedNumbers(const void *num1, const void *num2);
+
+#endif /* __PACKED_NUMBER_H__ */
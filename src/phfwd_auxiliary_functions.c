@@ -5,113 +5,503 @@
  * @date 2022
  */
 
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include "phfwd_auxiliary_functions.h"
+#include "phfwd_simd.h"
 #include "phone_forward.h"
 #include "list.h"
 
-/** @brief Tworzy nowy węzeł drzewa przekierowań.
- * Tworzy nowy węzeł drzewa przekierowań.
- * @param[in] father - wskaźnik na węzeł, który jest ojcem tworzonego węzła
- * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+/** @brief Tworzy pustą pulę węzłów.
+ * @return Wskaźnik na utworzoną pulę lub NULL, gdy nie udało się
  *         alokować pamięci.
  */
-Node * newNode(Node *father) {
-    Node *result = malloc(sizeof(*result));
+NodePool * newNodePool(void) {
+    NodePool *result = calloc(1, sizeof(*result));
     if (result != NULL) {
-        result->parent = father;
-        result->list = NULL;
-        result->infoAboutMe = NULL;
-        result->imHere = NULL;
+        result->next = 1; // Indeks 0 oznacza brak węzła.
+    }
+    return result;
+}
 
-        result->sons = malloc(SONS * sizeof(*(result->sons)));
-        if (result->sons != NULL) {
-            for (int i = 0; i < SONS; ++i) {
-                (result->sons)[i] = NULL;
-            }
+/** @brief Usuwa pulę węzłów razem ze wszystkimi jej węzłami.
+ * Nie zwalnia list zapisanych w węzłach, ale zwalnia pamięć podręczną list.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] pool - wskaźnik na usuwaną pulę
+ */
+void deleteNodePool(NodePool *pool) {
+    if (pool != NULL) {
+        for (int i = 0; i < POOL_SEGMENTS; ++i) {
+            free(pool->memory[i]);
+        }
+        trimNumberCache(&pool->numbers);
+        free(pool);
+    }
+}
+
+/** @brief Wyznacza numer segmentu puli, w którym leży węzeł o danym indeksie.
+ * @param[in] index - indeks węzła
+ * @return Numer segmentu.
+ */
+static int segmentOf(uint64_t index) {
+    return 63 - __builtin_clzll(index + ((uint64_t)1 << POOL_FIRST_BITS)) - POOL_FIRST_BITS;
+}
+
+/** @brief Wyznacza indeks pierwszego węzła segmentu puli.
+ * @param[in] segment - numer segmentu
+ * @return Indeks pierwszego węzła segmentu.
+ */
+static uint64_t segmentStart(int segment) {
+    return ((uint64_t)1 << (POOL_FIRST_BITS + segment)) - ((uint64_t)1 << POOL_FIRST_BITS);
+}
+
+/** @brief Tworzy segment puli, jeśli jeszcze nie istnieje.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in] segment - numer segmentu
+ * @return Wartość @p true, jeśli segment istnieje.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci.
+ */
+static bool createSegment(NodePool *pool, int segment) {
+    if (pool->hot[segment] == NULL) {
+        size_t count = (size_t)1 << (POOL_FIRST_BITS + segment);
+        void *memory = malloc(count * (sizeof(Node) + sizeof(NodeCold)) + 63);
+        if (memory == NULL) {
+            return false;
+        }
+        pool->memory[segment] = memory;
+        pool->hot[segment] = (Node *)(((uintptr_t)memory + 63) & ~(uintptr_t)63);
+        pool->cold[segment] = (NodeCold *)(pool->hot[segment] + count);
+        adviseSegment(pool, segment);
+    }
+    return true;
+}
+
+/** @brief Przydziela indeks nowego węzła, tworząc w razie potrzeby segment.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @return Indeks węzła lub 0, gdy nie udało się alokować pamięci lub
+ *         skończyły się indeksy.
+ */
+static uint32_t takeIndex(NodePool *pool) {
+    if (pool->free_nodes != 0) {
+        uint32_t index = pool->free_nodes;
+        takeFreeNode(pool, index);
+        return index;
+    }
+    if (pool->next == 0) {
+        return 0; // Wszystkie indeksy 32-bitowe są zajęte.
+    }
+    if (!createSegment(pool, segmentOf(pool->next))) {
+        return 0;
+    }
+    ++(pool->changes);
+    return pool->next++;
+}
+
+/** @brief Zabiera zwolniony węzeł z listy węzłów do ponownego użycia.
+ * Węzeł pozostaje oznaczony jako zwolniony, dopóki nie zostanie nadpisany.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in] index - indeks zwolnionego węzła
+ */
+void takeFreeNode(NodePool *pool, uint32_t index) {
+    Node *n = nodeAt(pool, index);
+    uint32_t next = n->sons[0];
+    uint32_t previous = n->sons[1];
+    if (previous != 0) {
+        nodeAt(pool, previous)->sons[0] = next;
+    }
+    else {
+        pool->free_nodes = next;
+    }
+    if (next != 0) {
+        nodeAt(pool, next)->sons[1] = previous;
+    }
+    ++(pool->changes);
+}
+
+/** @brief Prosi system o trzymanie segmentu puli w dużych stronach pamięci.
+ * Przekazuje prośbę dla stron leżących w całości w segmencie.
+ * Nic nie robi, jeśli w puli nie włączono dużych stron.
+ * @param[in] pool - wskaźnik na pulę węzłów
+ * @param[in] segment - numer utworzonego segmentu
+ * @return Wartość @p true, jeśli system przyjął prośbę lub nie było jej do przekazania.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool adviseSegment(NodePool const *pool, int segment) {
+    if (!pool->huge_pages || (pool->memory[segment] == NULL)) {
+        return true;
+    }
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    size_t count = (size_t)1 << (POOL_FIRST_BITS + segment);
+    uintptr_t begin = ((uintptr_t)pool->memory[segment] + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t)pool->memory[segment] + count * (sizeof(Node) + sizeof(NodeCold))) & ~(page - 1);
+    return (end <= begin) || (madvise((void *)begin, end - begin, MADV_HUGEPAGE) == 0);
+}
+
+/** @brief Tworzy z góry segmenty puli dla nowych węzłów.
+ * Po wywołaniu pula ma miejsce na co najmniej @p count węzłów pod indeksami
+ * jeszcze nieużytymi, niezależnie od węzłów zwolnionych.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in] count - liczba węzłów
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci lub
+ *         zabrakłoby indeksów.
+ */
+bool reserveNodes(NodePool *pool, size_t count) {
+    if (count == 0) {
+        return true;
+    }
+    uint64_t last = (uint64_t)pool->next + count - 1;
+    bool result = (pool->next != 0) && (last <= UINT32_MAX);
+    for (int i = result ? segmentOf(pool->next) : POOL_SEGMENTS; result && (i <= segmentOf(last)); ++i) {
+        result = createSegment(pool, i);
+    }
+    return result;
+}
+
+/** @brief Oddaje systemowi strony leżące w całości w podanym zakresie pamięci.
+ * Zawartość tych stron jest tracona.
+ * @param[in] begin - wskaźnik na początek zakresu
+ * @param[in] end - wskaźnik za koniec zakresu
+ * @return Liczba bajtów oddanych systemowi.
+ */
+static size_t releasePages(void *begin, void *end) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t first = ((uintptr_t)begin + page - 1) & ~(page - 1);
+    uintptr_t last = (uintptr_t)end & ~(page - 1);
+    if ((last <= first) || (madvise((void *)first, last - first, MADV_DONTNEED) != 0)) {
+        return 0;
+    }
+    return last - first;
+}
+
+/** @brief Oddaje systemowi pamięć nieużywaną przez pulę.
+ * Skraca pulę o zwolnione węzły leżące za ostatnim używanym indeksem,
+ * zwalnia segmenty, w których nie ma już żadnego węzła, oddaje systemowi
+ * strony na końcu ostatniego segmentu i opróżnia pamięć podręczną list.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @return Liczba bajtów oddanych systemowi.
+ */
+size_t trimNodePool(NodePool *pool) {
+    size_t result = 0;
+    uint64_t end = (pool->next == 0) ? ((uint64_t)1 << 32) : pool->next;
+    while ((end > 1) && (nodeAt(pool, (uint32_t)(end - 1))->index == 0)) {
+        takeFreeNode(pool, (uint32_t)(end - 1));
+        --end;
+    }
+    pool->next = (uint32_t)end;
+    for (int i = segmentOf(end); i < POOL_SEGMENTS; ++i) {
+        if (pool->hot[i] == NULL) {
+            continue;
+        }
+        size_t count = (size_t)1 << (POOL_FIRST_BITS + i);
+        if (segmentStart(i) >= end) {
+            free(pool->memory[i]);
+            pool->memory[i] = NULL;
+            pool->hot[i] = NULL;
+            pool->cold[i] = NULL;
+            result += count * (sizeof(Node) + sizeof(NodeCold)) + 63;
+        }
+        else { // Węzły od indeksu end do końca segmentu nie są używane.
+            size_t used = end - segmentStart(i);
+            result += releasePages(pool->hot[i] + used, pool->hot[i] + count);
+            result += releasePages(pool->cold[i] + used, pool->cold[i] + count);
         }
-        else {
-            free(result);
-            result = NULL;
+    }
+    return result + trimNumberCache(&pool->numbers);
+}
+
+/** @brief Ustawia pola nowego węzła drzewa.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] index - indeks węzła lub 0
+ * @param[in] father - wskaźnik na węzeł, który jest ojcem tworzonego węzła
+ * @return Wskaźnik na węzeł lub NULL, gdy indeks ma wartość 0.
+ */
+static Node * initNode(NodePool const *pool, uint32_t index, Node *father) {
+    Node *result = nodeAt(pool, index);
+    if (result != NULL) {
+        result->list = NULL;
+        for (int i = 0; i < SONS; ++i) {
+            (result->sons)[i] = 0;
         }
+        result->index = index;
+
+        NodeCold *cold = coldOf(pool, result);
+        cold->parent = nodeIndex(father);
+        cold->infoAboutMe = 0;
+        cold->imHere = NULL;
+        cold->removed_sons = 0;
+        cold->dirty = false;
+        cold->changed = false;
     }
     
     return result;
 }
 
+/** @brief Tworzy nowy węzeł drzewa przekierowań.
+ * Tworzy nowy węzeł drzewa przekierowań.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] father - wskaźnik na węzeł, który jest ojcem tworzonego węzła
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+Node * newNode(NodePool *pool, Node *father) {
+    return initNode(pool, takeIndex(pool), father);
+}
+
+/** @brief Przydziela przedział nieużytych indeksów puli.
+ * Tworzy z góry segmenty dla wszystkich węzłów przedziału, więc węzły
+ * z różnych przedziałów mogą być tworzone przez kilka wątków jednocześnie.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in] count - liczba indeksów
+ * @param[out] range - wskaźnik na przydzielony przedział
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci lub
+ *         zabrakłoby indeksów.
+ */
+bool takeNodeRange(NodePool *pool, size_t count, NodeRange *range) {
+    if (!reserveNodes(pool, count)) {
+        return false;
+    }
+    range->next = pool->next;
+    range->end = (uint32_t)(pool->next + count); // Wartość 0 oznacza koniec indeksów.
+    pool->next = range->end;
+    ++(pool->changes);
+    return true;
+}
+
+/** @brief Tworzy nowy węzeł drzewa z przydzielonego przedziału indeksów.
+ * Nie zmienia puli, więc może być wywoływana jednocześnie przez wątki
+ * korzystające z różnych przedziałów.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] range - wskaźnik na przedział indeksów
+ * @param[in] father - wskaźnik na węzeł, który jest ojcem tworzonego węzła
+ * @return Wskaźnik na utworzony węzeł lub NULL, gdy przedział się wyczerpał.
+ */
+Node * newNodeInRange(NodePool const *pool, NodeRange *range, Node *father) {
+    if (range->next == range->end) {
+        return NULL;
+    }
+    return initNode(pool, range->next++, father);
+}
+
+/** @brief Oddaje puli nieużyte indeksy przedziału jako węzły zwolnione.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in,out] range - wskaźnik na przedział indeksów
+ */
+void returnNodeRange(NodePool *pool, NodeRange *range) {
+    while (range->next != range->end) {
+        freeNode(pool, initNode(pool, range->next++, NULL));
+    }
+}
+
+/** @brief Zwalnia węzeł, który może zostać użyty ponownie.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in] n - wskaźnik na zwalniany węzeł
+ */
+void freeNode(NodePool *pool, Node *n) {
+    if (pool->free_nodes != 0) {
+        nodeAt(pool, pool->free_nodes)->sons[1] = n->index;
+    }
+    n->sons[0] = pool->free_nodes;
+    n->sons[1] = 0;
+    pool->free_nodes = n->index;
+    n->index = 0;
+    ++(pool->changes);
+}
+
+/** @brief Usuwa wpis drzewa odwróceń odpowiadający węzłowi drzewa przekierowań.
+ * Usuwa z listy w drzewie odwróceń numer zapisany przy dodawaniu przekierowania
+ * z węzła @p n. Jeśli lista stała się pusta, usuwa ją i przycina pustą gałąź.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] n - wskaźnik na węzeł drzewa przekierowań
+ */
+void detachReverseEntry(NodePool *pool, Node *n) {
+    NodeCold *cold = coldOf(pool, n);
+    Node *reverse = nodeAt(pool, cold->infoAboutMe);
+    if (reverse == NULL) {
+        return;
+    }
+    removeCachedElement(&pool->numbers, reverse->list, cold->imHere);
+    if (empty(reverse->list)) {
+        releaseList(&pool->numbers, reverse->list);
+        reverse->list = NULL;
+        pruneEmptyBranch(pool, reverse);
+    }
+    cold->infoAboutMe = 0;
+    cold->imHere = NULL;
+}
+
+/** @brief Zwalnia węzeł ze szczytu stosu węzłów do zwolnienia.
+ * Stos węzłów do zwolnienia jest listą połączoną przez pola @p parent.
+ * Zdejmuje ze stosu węzeł, wkłada na stos jego synów i zwalnia go.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] stack - wskaźnik na węzeł na szczycie stosu
+ * @param[in] update_reverse - czy usuwać wpis drzewa odwróceń odpowiadający
+ *                             przekierowaniu zapisanemu w zwalnianym węźle
+ * @return Wskaźnik na nowy szczyt stosu lub NULL, gdy stos jest pusty.
+ */
+Node * freeStackTop(NodePool *pool, Node *stack, bool update_reverse) {
+    Node *help = stack;
+    uint32_t top = coldOf(pool, help)->parent;
+    for (int i = 0; i < SONS; ++i) {
+        if ((help->sons)[i] != 0) {
+            coldOf(pool, sonOf(pool, help, i))->parent = top;
+            top = (help->sons)[i];
+        }
+    }
+    releaseList(&pool->numbers, help->list); // Jeżli help->list == NULL, funkcja releaseList() nic nie zrobi.
+    help->list = NULL;
+    if (update_reverse) { // W węzłach drzewa reverse zawsze infoAboutMe == 0.
+        detachReverseEntry(pool, help);
+    }
+    freeNode(pool, help);
+    return nodeAt(pool, top);
+}
+
+/** @brief Oznacza węzeł i jego przodków jako zmienione.
+ * Zatrzymuje się na pierwszym już oznaczonym przodku, bo wtedy oznaczeni
+ * są też wszyscy dalsi przodkowie.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] n - wskaźnik na węzeł drzewa lub NULL
+ */
+void markDirty(NodePool const *pool, Node *n) {
+    while ((n != NULL) && !coldOf(pool, n)->dirty) {
+        coldOf(pool, n)->dirty = true;
+        n = parentOf(pool, n);
+    }
+}
+
+/** @brief Oznacza zmianę przekierowania zapisanego w węźle.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] n - wskaźnik na węzeł drzewa przekierowań
+ */
+void markChanged(NodePool const *pool, Node *n) {
+    coldOf(pool, n)->changed = true;
+    markDirty(pool, n);
+}
+
+/** @brief Oznacza usunięcie poddrzewa syna węzła.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] father - wskaźnik na ojca usuniętego poddrzewa
+ * @param[in] digit - cyfra syna, którego poddrzewo usunięto
+ */
+void markSonRemoved(NodePool const *pool, Node *father, int digit) {
+    coldOf(pool, father)->removed_sons |= (uint16_t)(1u << digit);
+    markDirty(pool, father);
+}
+
+/** @brief Odłącza węzeł od rodzica.
+ * Nic nie robi, jeśli węzeł jest korzeniem.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] n - wskaźnik na odłączany węzeł
+ */
+void detachNode(NodePool const *pool, Node *n) {
+    Node *father = parentOf(pool, n);
+    if (father != NULL) {
+        int digit = whichChild(pool, n);
+        (father->sons)[digit] = 0;
+        markSonRemoved(pool, father, digit);
+    }
+    coldOf(pool, n)->parent = 0;
+}
+
+/** @brief Usuwa poddrzewo.
+ * Odłącza węzeł @p n od rodzica i zwalnia całe jego poddrzewo w czasie
+ * liniowym względem liczby węzłów, bez dodatkowej pamięci: jako stos węzłów
+ * do zwolnienia służą pola @p parent zwalnianych węzłów.
+ * @param[in] n - wskaźnik na korzeń usuwanego poddrzewa
+ * @param[in] update_reverse - czy usuwać wpisy drzewa odwróceń odpowiadające
+ *                             usuwanym przekierowaniom
+ */
+static void subtreeDelete(NodePool *pool, Node *n, bool update_reverse) {
+    if (n == NULL) {
+        return;
+    }
+    detachNode(pool, n);
+    Node *stack = n;
+    while (stack != NULL) {
+        stack = freeStackTop(pool, stack, update_reverse);
+    }
+}
+
+/** @brief Sprawdza, czy wpis drzewa odwróceń odpowiada istniejącemu przekierowaniu.
+ * Wpis może być nieaktualny, jeśli przekierowanie zostało usunięte w trybie
+ * przyrostowym, a jego węzeł czeka na zwolnienie.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] forward - wskaźnik na korzeń drzewa przekierowań
+ * @param[in] reverse - wskaźnik na węzeł drzewa odwróceń, w którego liście jest wpis
+ * @param[in] element - wskaźnik na wpis
+ * @return Wartość @p true, jeśli wpis jest aktualny.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool reverseEntryAlive(NodePool const *pool, Node *forward, Node const *reverse, OneNumber const *element) {
+    Node *help = forward;
+    for (size_t i = 0; (help != NULL) && (i < element->number_length); ++i) {
+        help = sonOf(pool, help, packedDigitValue(element->digits, i));
+    }
+    return (help != NULL) && (coldOf(pool, help)->infoAboutMe == reverse->index) && (coldOf(pool, help)->imHere == element);
+}
+
 /** @brief Usuwa drzewo przekierowań.
  * Usuwa drzewo przekierowań, którego korzeń wskazywany jest przez @p n.
  * W szczególności może to być poddrzewo innego drzewa.
  * Nic nie robi, jeśli wskaźnik ten ma wartość NULL.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] n - wskaźnik na korzeń usuwanego drzewa.
  */
-void treeDelete(Node *n) {
-    if (n != NULL) {
-        Node *help1 = n;
-        Node *help2 = NULL;
-        Node *not_to_delete = (help1->parent);
-        int index;
-        while (help1 != not_to_delete) {
-            while (!isLeaf(help1)) {
-                help1 = leftChild(help1);
-            }
-            if (help1->parent != NULL) {
-                index = whichChild(help1);
-                help2 = (help1->parent);
-
-                freeList(help1->list); // Jeżli help1->list == NULL, funkcja freeList() nic nie zrobi.
-                free(help1->list);
-                help1->list = NULL;
-
-                if (help1->infoAboutMe != NULL) { // W węzłach drzewa reverse zawsze infoAboutMe == NULL.
-                    removeElement(help1->infoAboutMe->list, help1->imHere);
-                    if (empty(help1->infoAboutMe->list)) {
-                        freeList(help1->infoAboutMe->list);
-                        free(help1->infoAboutMe->list);
-                        help1->infoAboutMe->list = NULL;
-                        removeEmptyBranch(help1->infoAboutMe, help1->infoAboutMe->parent);
-                    }
-                }
-
-                free(help1->sons);
-                free(help1);
-                (help2->sons)[index] = NULL;
-                help1 = help2;
-            }
-            else {
-                help2 = (help1->parent);
-                free(help1->sons);
-                free(help1);
-                help1 = help2;
-            }
-        }
+void treeDelete(NodePool *pool, Node *n) {
+    subtreeDelete(pool, n, true);
+}
+
+/** @brief Zwalnia drzewo bez aktualizowania drzewa odwróceń.
+ * Używana, gdy oba drzewa są usuwane w całości.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] n - wskaźnik na korzeń zwalnianego drzewa.
+ */
+void treeFree(NodePool *pool, Node *n) {
+    subtreeDelete(pool, n, false);
+}
+
+/** @brief Przycina pustą gałąź drzewa.
+ * Usuwa kolejno węzeł @p n i jego przodków, dopóki są liśćmi bez listy
+ * numerów. Korzeń drzewa nigdy nie jest usuwany.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] n - wskaźnik na najgłębszy węzeł gałęzi
+ */
+void pruneEmptyBranch(NodePool *pool, Node *n) {
+    int digit = -1;
+    while ((n != NULL) && (parentOf(pool, n) != NULL) && (n->list == NULL) && isLeaf(n)) {
+        Node *father = parentOf(pool, n);
+        digit = whichChild(pool, n);
+        (father->sons)[digit] = 0;
+        freeNode(pool, n);
+        n = father;
+    }
+    if (digit >= 0) {
+        markSonRemoved(pool, n, digit);
     }
 }
 
 /** @brief Usuwa martwą gałąź drzewa.
  * Usuwa martwą gałąź drzewa.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] help - wskaźnik na liść gałęzi
  * @param[in] father - wskaźnik na ojca liścia gałęzi
  */
-void removeEmptyBranch(Node *help, Node *father) {
-    if (help == NULL) {
+void removeEmptyBranch(NodePool *pool, Node *help, Node *father) {
+    if ((help == NULL) || (father == NULL)) {
         return;
     }
-    bool keep_going = true;
-    while (keep_going && (father != NULL)) {
-            if (isLeaf(help) && (help->list == NULL)) {
-                treeDelete(help);
-                father = father->parent;
-                help = father;
-            }
-            else {
-                keep_going = false;
-            }
-    }
+    pruneEmptyBranch(pool, help);
 }
 
 /** @brief Sprawdza, czy węzeł drzewa jest liściem.
@@ -121,7 +511,7 @@ void removeEmptyBranch(Node *help, Node *father) {
  */
 bool isLeaf(Node *n) {
     for (int i = 0; i < SONS; ++i) {
-        if ((n->sons)[i] != NULL) {
+        if ((n->sons)[i] != 0) {
             return false;
         }
     }
@@ -133,28 +523,23 @@ bool isLeaf(Node *n) {
  * @return Liczba znaków będących cyframi, które zawiera dany numer.
  */
 size_t howLong(char const *num) {
-    char const *help = num;
-    size_t i = 0;
-    while (*help != '\0') {
-        ++i;
-        ++help;
-    }
-    return i;
+    return strlen(num);
 }
 
 /** @brief Wskazuje adres dziecka węzła danego jako argument, którego adres jest różny od NULL.
  * Wskazuje adres dziecka węzła danego jako argument, którego adres jest różny od NULL.
  * W przypadku kilkorga takich dzieci, wybiera to, które znajduje się w komórce tablicy o najmniejszym indeksie.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] n - wskaźnik na węzeł drzewa
  * @return Wskaźnik na wybrane dziecko. Jeśli nie ma już dzieci, NULL. Jednak tą funkcję wywołujemy
  * po sprawdzeniu, że argument nie jest liściem, więc w praktyce nie zwróci nigdy wartości NULL.
  */
-Node * leftChild(Node *n) {
+Node * leftChild(NodePool const *pool, Node *n) {
     Node *result = NULL;
     int i = 0;
     while ((result == NULL) && (i < SONS)) {
-        if ((n->sons)[i] != NULL) {
-            result = (n->sons)[i];
+        if ((n->sons)[i] != 0) {
+            result = sonOf(pool, n, i);
         }
         ++i;
     }
@@ -162,13 +547,14 @@ Node * leftChild(Node *n) {
 }
 
 /** @brief Sprawdza, którym dzieckiem swojego rodzica jest dany węzeł.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] child - wskaźnik na węzeł drzewa, o którym chcemy wiedzieć, którym dzieckiem swojego rodzica jest
  * @return Indeks dziecka w tablicy dzieci rodzica
  */
-int whichChild(Node *child) {
-    Node *parent = child->parent;
+int whichChild(NodePool const *pool, Node *child) {
+    Node *parent = parentOf(pool, child);
     for (int i = 0; i < SONS; ++i) {
-        if ((parent->sons)[i] == child) {
+        if ((parent->sons)[i] == child->index) {
             return i;
         }
     }
@@ -181,22 +567,7 @@ int whichChild(Node *child) {
  *         Wartość @p false, jeśli napis nie reprezentuje numeru.
  */
 bool onlyDigitsAndNotEmpty(char const *num) {
-    if (num == NULL) {
-        return false;
-    }
-    char const *help = num;
-    if (*help == '\0') {
-        return false;
-    }
-    while (isdigit((int)(*help)) || (*help == '*') || (*help == '#')) {
-        ++help;
-    }
-    if (*help == '\0') {
-        return true;
-    }
-    else {
-        return false;
-    }
+    return (num != NULL) && (validNumberLength(num) > 0);
 }
 
 /** @brief Zwraca wartość z zakresu od 0 do 11, reprezentowaną przez cyfrę.
@@ -223,28 +594,17 @@ int digitValue(char const *digit) {
  *
  */
 bool numbersDiffer(char const *num1, char const *num2) {
-    char const *help1 = num1;
-    char const *help2 = num2;
-
-    if ((*help1 == '\0') || (*help2 == '\0')) {
+    if ((*num1 == '\0') || (*num2 == '\0')) {
         return false;
     }
-
-    while((*help1 == *help2) && (*help1 != '\0') && (*help2 != '\0')) {
-        ++help1;
-        ++help2;
-    }
-    if ((*help1 == '\0') && (*help2 == '\0')) {
-        return false;
-    }
-    else {
-        return true;
-    }
+    size_t i = firstDifference(num1, num2);
+    return num1[i] != num2[i];
 }
 
 /** @brief Szuka węzła drzewa wyznaczanego przez daną ścieżkę.
  * Szuka węzła drzewa wyznaczanego przez daną ścieżkę.
  * Jeśli takiego węzła nie ma, tworzy go.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
  * @param[in,out] root - wskaźnik na węzeł drzewa
  * @param[in] num - wskaźnik na napis reprezentujący ścieżkę
  * @param[in, out] first_added - adres zmiennej, na której zostaje zapisany adres węzła, który został dodany jako pierwszy
@@ -252,21 +612,22 @@ bool numbersDiffer(char const *num1, char const *num2) {
  * @return Wartość @p true, jeśli udało się odnaleźć lub dodać węzeł.
  *         Wartość @p false, jeśli nie udało się alokować pamięci.
  */
-bool lookForANode(Node *root, char const *num, Node **first_added, Node **result) {
+bool lookForANode(NodePool *pool, Node *root, char const *num, Node **first_added, Node **result) {
     Node *help = root;
     char const *digit = num;
     while ((help != NULL) && (*digit != '\0')) {
-        if ((help->sons)[digitValue(digit)] == NULL) {
-            (help->sons)[digitValue(digit)] = newNode(help);
+        if ((help->sons)[digitValue(digit)] == 0) {
+            (help->sons)[digitValue(digit)] = nodeIndex(newNode(pool, help));
             if (*first_added == NULL) {
-                *first_added = (help->sons)[digitValue(digit)];
+                *first_added = sonOf(pool, help, digitValue(digit));
+                markDirty(pool, *first_added);
             }
         }
-        help = (help->sons)[digitValue(digit)];
+        help = sonOf(pool, help, digitValue(digit));
         ++digit;
     }
     if (help == NULL) {
-        treeDelete(*first_added);
+        treeDelete(pool, *first_added);
         return false;
     }
     else {
@@ -276,55 +637,36 @@ bool lookForANode(Node *root, char const *num, Node **first_added, Node **result
 }
 
 /** @brief Zmienia (dodaje lub zastępuje) przekierowanie danego numeru (i wszystkich numerów, których on jest prefiksem).
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] n - wskaźnik na węzeł drzewa, w którym będzie zapisywane przekierowanie
  * @param[in] num - wskaźnik na napis reprezentujący numer, na który jest tworzone przekierowanie
  * @return Wartość @p true, jeśli udało się alokować pamięć.
  *         Wartość @p false, jeśli nie udało się alokować pamięci.
  */
-bool changeForward(Node *n, char const *num) {
-    size_t i = howLong(num);
-    char *new_forward = malloc(i * sizeof(*num));
-    if (new_forward != NULL) {
-        if (n->list == NULL) {
-            n->list = newList();
-        }
-        if (n->list != NULL) {
-            for (size_t j = 0; j < i; ++j) {
-                new_forward[j] = num[j];
-            }
-            if (!empty(n->list)) {
-                removeElement(n->list, (n->list)->last);
-                removeElement(n->infoAboutMe->list, n->imHere);
-                if (empty(n->infoAboutMe->list)) {
-                    freeList(n->infoAboutMe->list);
-                    free(n->infoAboutMe->list);
-                    n->infoAboutMe->list = NULL;
-                    removeEmptyBranch(n->infoAboutMe, n->infoAboutMe->parent);
-                }
-            }
-            if (addElement(n->list, new_forward, i)) {
-                free(new_forward);
-                return true;
-            }
-            else {
-                free(new_forward);
-                return false;
-            }
-
-        }
-        else {
-            free(new_forward);
-            return false; // Nie udało się alokować pamięci.
-        }
-        
+bool changeForward(NodePool *pool, Node *n, char const *num) {
+    if (n->list == NULL) {
+        n->list = cachedList(&pool->numbers);
     }
-    else {
+    if (n->list == NULL) {
+        return false; // Nie udało się alokować pamięci.
+    }
+    if (!addCachedElement(&pool->numbers, n->list, num, howLong(num))) {
+        if (empty(n->list)) {
+            releaseList(&pool->numbers, n->list);
+            n->list = NULL;
+        }
         return false;
     }
+    if ((n->list)->first != (n->list)->last) { // Usuwamy poprzednie przekierowanie.
+        removeCachedElement(&pool->numbers, n->list, (n->list)->first);
+        detachReverseEntry(pool, n);
+    }
+    markChanged(pool, n);
     return true;
 }
 
 /** @brief Szuka najdłuższego prefiksu num, który ma przekierowanie inne niż na samego siebie.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] n - wskaźnik na korzeń drzewa przekierowań
  * @param[in, out] last_modification - wskaźnik na zmienną zawierającą adres węzła drzewa,
  * w którym znalezione zostało najbardziej aktualne przekierowanie
@@ -332,11 +674,11 @@ bool changeForward(Node *n, char const *num) {
  * jaka jest długość ścieżki od węzła o adresie n do węzła o adresie *last_modification
  * @param[in] num - wskaźnik na napis reprezentujący numer, którego przekierowanie jest odczytywane
  */
-void lookForModification(Node *n, Node **last_modification, size_t *how_many_digits_eaten, char const *num) {
+void lookForModification(NodePool const *pool, Node *n, Node **last_modification, size_t *how_many_digits_eaten, char const *num) {
     if (n != NULL) {
         char const *digit = num;
         Node *help = n;
-        help = (help->sons)[digitValue(digit)];
+        help = sonOf(pool, help, digitValue(digit));
         size_t how_many_steps_can_be_made = howLong(num);
         size_t how_many_steps_was_made = 1;
 
@@ -347,7 +689,7 @@ void lookForModification(Node *n, Node **last_modification, size_t *how_many_dig
             }
             ++digit;
             ++how_many_steps_was_made;
-            help = (help->sons)[digitValue(digit)];
+            help = sonOf(pool, help, digitValue(digit));
         }
         if (help != NULL) {
             if (help->list != NULL) {
@@ -358,6 +700,31 @@ void lookForModification(Node *n, Node **last_modification, size_t *how_many_dig
     }
 }
 
+/** @brief Szuka najdłuższego prefiksu spakowanego numeru, który ma przekierowanie.
+ * Działa tak samo jak @ref lookForModification, ale numer jest zapisany w postaci spakowanej.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] n - wskaźnik na korzeń drzewa przekierowań
+ * @param[in, out] last_modification - wskaźnik na zmienną zawierającą adres węzła drzewa,
+ * w którym znalezione zostało najbardziej aktualne przekierowanie
+ * @param[in, out] how_many_digits_eaten - wskaźnik na zmienną zawierającą informację o tym,
+ * jaka jest długość ścieżki od węzła o adresie n do węzła o adresie *last_modification
+ * @param[in] digits - wskaźnik na spakowane cyfry numeru
+ * @param[in] length - liczba cyfr numeru
+ */
+void lookForModificationPacked(NodePool const *pool, Node *n, Node **last_modification, size_t *how_many_digits_eaten,
+                               unsigned char const *digits, size_t length) {
+    Node *help = n;
+    size_t i = 0;
+    while ((help != NULL) && (i < length)) {
+        help = sonOf(pool, help, packedDigitValue(digits, i));
+        ++i;
+        if ((help != NULL) && (help->list != NULL)) {
+            *last_modification = help;
+            *how_many_digits_eaten = i;
+        }
+    }
+}
+
 /** @brief Zwraca liczbę około dwa razy większą od argumentu.
  * @param[in] argument - liczba całkowita
  * @return Liczba całkowita około dwa razy większa od argumentu
@@ -373,25 +740,5 @@ size_t more(size_t argument) {
  * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
  */
 int myCompare(const void *num1, const void *num2) {
-    char *number1 = *(char **)num1;
-    char *number2 = *(char **)num2;
-    while((*number1 != '\0') && (*number2 != '\0') && (*number1 == *number2)) {
-        ++number1;
-        ++number2;
-    }
-    if ((*number1 == '\0') && (*number2 == '\0')) {
-        return 0;
-    }
-    else if (*number1 == '\0') {
-        return -1;
-    }
-    else if (*number2 == '\0') {
-        return 1;
-    }
-    else if (digitValue(number1) > digitValue(number2)) {
-        return 1;
-    }
-    else {
-        return -1;
-    }
+    return compareNumberStrings(*(char const **)num1, *(char const **)num2);
 }
\ No newline at end of file
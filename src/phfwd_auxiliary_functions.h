@@ -13,42 +13,328 @@
 #include <stddef.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include "phone_forward.h"
 #include "list.h"
+#include "packed_number.h"
+
+/**
+ * To jest liczba bitów liczby węzłów pierwszego segmentu puli węzłów.
+ */
+#define POOL_FIRST_BITS 8
+
+/**
+ * To jest liczba segmentów puli węzłów. Segment @p k mieści
+ * 2^(@ref POOL_FIRST_BITS + k) węzłów, więc segmenty mieszczą wszystkie
+ * indeksy 32-bitowe.
+ */
+#define POOL_SEGMENTS (33 - POOL_FIRST_BITS)
+
+/**
+ * To jest struktura przechowująca dane węzła drzewa używane tylko przy zmianach drzewa.
+ * Wyszukiwanie ich nie czyta, więc są trzymane poza węzłem, aby nie zajmowały
+ * linii pamięci podręcznej czytanych przy przechodzeniu drzewa.
+ */
+typedef struct NodeCold {
+    struct OneNumber *imHere; ///< imHere - wskaźnik na węzeł listy w drzewie odwróceń
+    uint32_t parent; ///< parent - indeks węzła będącego rodzicem danego węzła
+    uint32_t infoAboutMe; ///< infoAboutMe - indeks węzła w drzewie odwróceń z informacją o węźle przekierowań
+    uint16_t removed_sons; ///< maska cyfr synów, których poddrzewa usunięto od ostatniego zapisu przyrostowego
+    bool dirty; ///< czy poddrzewo węzła zmieniło się od ostatniego zapisu przyrostowego
+    bool changed; ///< czy przekierowanie zapisane w węźle zmieniło się od ostatniego zapisu przyrostowego
+} NodeCold;
 
 /**
  * To jest struktura przechowująca zawartość węzła drzewa przekierowań.
+ * Zawiera tylko pola czytane przy przechodzeniu drzewa: listę i synów
+ * bezpośrednio w węźle, tak aby przejście do syna wymagało jednego odczytu
+ * zamiast dwóch. Węzły obu drzew struktury leżą w jednej puli i wskazują się
+ * 32-bitowymi indeksami w puli, w których 0 oznacza brak węzła, więc węzeł
+ * zajmuje dokładnie jedną linię pamięci podręcznej.
  */
 typedef struct Node {
-    struct Node **sons; ///< tablica wskaźników na węzły będące synami danego węzła
-    struct Node *parent; ///< parent - wskaźnik na węzeł będący rodzicem danego węzła
     struct ListOfNumbers *list; ///< lista przekierowań lub odwróceń zapisywanych w danym węźle
-    struct Node *infoAboutMe; ///< infoAboutMe - wskaźnik na węzeł w drzewie odwróceń z informacją o węźle przekierowań
-    struct OneNumber *imHere; ///< imHere - wskaźnik na węzeł listy w drzewie odwróceń
+    uint32_t sons[SONS]; ///< indeksy węzłów będących synami danego węzła
+    uint32_t index; ///< indeks danego węzła w puli
 } Node;
 
+/**
+ * To jest pula węzłów drzew jednej struktury.
+ * Węzły leżą w segmentach, które nigdy nie są przenoszone, więc wskaźniki
+ * na węzły pozostają ważne, dopóki węzły nie zostaną zwolnione. Dane
+ * używane przy zmianach drzewa węzła o danym indeksie leżą pod tym samym
+ * indeksem w osobnej tablicy segmentu. Zwolnione węzły mają indeks 0,
+ * tworzą listę dwukierunkową połączoną przez dwóch pierwszych synów i są
+ * używane ponownie. Pula nie jest chroniona blokadą: wątki budujące drzewo
+ * jednocześnie biorą węzły z przydzielonych im z góry przedziałów indeksów.
+ * Pula trzyma też pamięć podręczną zwolnionych list i ich węzłów, z której
+ * korzystają tylko funkcje zmieniające drzewa w jednym wątku.
+ */
+typedef struct NodePool {
+    Node *hot[POOL_SEGMENTS]; ///< węzły kolejnych segmentów, wyrównane do 64 bajtów, lub NULL dla segmentów jeszcze nieutworzonych
+    NodeCold *cold[POOL_SEGMENTS]; ///< dane używane przy zmianach drzewa węzłów kolejnych segmentów
+    void *memory[POOL_SEGMENTS]; ///< pamięć przydzielona dla kolejnych segmentów
+    uint32_t next; ///< najmniejszy indeks, który nie był jeszcze użyty
+    uint32_t free_nodes; ///< indeks pierwszego zwolnionego węzła lub 0, gdy ich nie ma
+    uint64_t changes; ///< liczba przydzieleń i zwolnień węzłów
+    bool huge_pages; ///< czy segmenty mają być trzymane w dużych stronach pamięci
+    size_t longest_entry; ///< górne ograniczenie długości numerów we wpisach list drzewa odwróceń
+    NumberCache numbers; ///< zwolnione listy i węzły list do ponownego użycia
+} NodePool;
+
+/**
+ * To jest przedział nieużytych indeksów puli węzłów przydzielony jednemu wątkowi.
+ * Wątek tworzy z niego węzły bez zmieniania samej puli.
+ */
+typedef struct NodeRange {
+    uint32_t next; ///< najmniejszy indeks przedziału, który nie został jeszcze użyty
+    uint32_t end; ///< indeks za końcem przedziału
+} NodeRange;
+
+/** @brief Zwraca węzeł o danym indeksie.
+ * @param[in] pool - wskaźnik na pulę węzłów
+ * @param[in] index - indeks węzła lub 0
+ * @return Wskaźnik na węzeł lub NULL, gdy indeks ma wartość 0.
+ */
+static inline Node * nodeAt(NodePool const *pool, uint32_t index) {
+    if (index == 0) {
+        return NULL;
+    }
+    uint64_t shifted = (uint64_t)index + ((uint64_t)1 << POOL_FIRST_BITS);
+    int segment = 63 - __builtin_clzll(shifted) - POOL_FIRST_BITS;
+    return pool->hot[segment] + (shifted - ((uint64_t)1 << (POOL_FIRST_BITS + segment)));
+}
+
+/** @brief Zwraca dane używane przy zmianach drzewa węzła o danym indeksie.
+ * @param[in] pool - wskaźnik na pulę węzłów
+ * @param[in] index - indeks węzła różny od 0
+ * @return Wskaźnik na dane węzła.
+ */
+static inline NodeCold * coldAt(NodePool const *pool, uint32_t index) {
+    uint64_t shifted = (uint64_t)index + ((uint64_t)1 << POOL_FIRST_BITS);
+    int segment = 63 - __builtin_clzll(shifted) - POOL_FIRST_BITS;
+    return pool->cold[segment] + (shifted - ((uint64_t)1 << (POOL_FIRST_BITS + segment)));
+}
+
+/** @brief Zwraca dane węzła używane przy zmianach drzewa.
+ * @param[in] pool - wskaźnik na pulę węzłów
+ * @param[in] n - wskaźnik na węzeł puli
+ * @return Wskaźnik na dane węzła.
+ */
+static inline NodeCold * coldOf(NodePool const *pool, Node const *n) {
+    return coldAt(pool, n->index);
+}
+
+/** @brief Zwraca syna węzła.
+ * @param[in] pool - wskaźnik na pulę węzłów
+ * @param[in] n - wskaźnik na węzeł puli
+ * @param[in] digit - wartość cyfry syna
+ * @return Wskaźnik na syna lub NULL, gdy go nie ma.
+ */
+static inline Node * sonOf(NodePool const *pool, Node const *n, int digit) {
+    return nodeAt(pool, n->sons[digit]);
+}
+
+/** @brief Zwraca rodzica węzła.
+ * @param[in] pool - wskaźnik na pulę węzłów
+ * @param[in] n - wskaźnik na węzeł puli
+ * @return Wskaźnik na rodzica lub NULL, gdy węzeł jest korzeniem.
+ */
+static inline Node * parentOf(NodePool const *pool, Node const *n) {
+    return nodeAt(pool, coldOf(pool, n)->parent);
+}
+
+/** @brief Zwraca indeks węzła.
+ * @param[in] n - wskaźnik na węzeł puli lub NULL
+ * @return Indeks węzła lub 0, gdy wskaźnik ma wartość NULL.
+ */
+static inline uint32_t nodeIndex(Node const *n) {
+    return (n == NULL) ? 0 : n->index;
+}
+
+/** @brief Tworzy pustą pulę węzłów.
+ * @return Wskaźnik na utworzoną pulę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+NodePool * newNodePool(void);
+
+/** @brief Usuwa pulę węzłów razem ze wszystkimi jej węzłami.
+ * Nie zwalnia list zapisanych w węzłach, ale zwalnia pamięć podręczną list.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] pool - wskaźnik na usuwaną pulę
+ */
+void deleteNodePool(NodePool *pool);
+
+/** @brief Zwalnia węzeł, który może zostać użyty ponownie.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in] n - wskaźnik na zwalniany węzeł
+ */
+void freeNode(NodePool *pool, Node *n);
+
+/** @brief Zabiera zwolniony węzeł z listy węzłów do ponownego użycia.
+ * Węzeł pozostaje oznaczony jako zwolniony, dopóki nie zostanie nadpisany.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in] index - indeks zwolnionego węzła
+ */
+void takeFreeNode(NodePool *pool, uint32_t index);
+
+/** @brief Prosi system o trzymanie segmentu puli w dużych stronach pamięci.
+ * Nic nie robi, jeśli w puli nie włączono dużych stron.
+ * @param[in] pool - wskaźnik na pulę węzłów
+ * @param[in] segment - numer utworzonego segmentu
+ * @return Wartość @p true, jeśli system przyjął prośbę lub nie było jej do przekazania.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool adviseSegment(NodePool const *pool, int segment);
+
+/** @brief Tworzy z góry segmenty puli dla nowych węzłów.
+ * Po wywołaniu pula ma miejsce na co najmniej @p count węzłów pod indeksami
+ * jeszcze nieużytymi, niezależnie od węzłów zwolnionych.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in] count - liczba węzłów
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci lub
+ *         zabrakłoby indeksów.
+ */
+bool reserveNodes(NodePool *pool, size_t count);
+
+/** @brief Oddaje systemowi pamięć nieużywaną przez pulę.
+ * Skraca pulę o zwolnione węzły leżące za ostatnim używanym indeksem,
+ * zwalnia segmenty, w których nie ma już żadnego węzła, oddaje systemowi
+ * strony na końcu ostatniego segmentu i opróżnia pamięć podręczną list.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @return Liczba bajtów oddanych systemowi.
+ */
+size_t trimNodePool(NodePool *pool);
+
 /** @brief Tworzy nowy węzeł drzewa przekierowań.
  * Tworzy nowy węzeł drzewa przekierowań.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] father - wskaźnik na węzeł, który jest ojcem tworzonego węzła
  * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
  *         alokować pamięci.
  */
-Node * newNode(Node *father);
+Node * newNode(NodePool *pool, Node *father);
+
+/** @brief Przydziela przedział nieużytych indeksów puli.
+ * Tworzy z góry segmenty dla wszystkich węzłów przedziału, więc węzły
+ * z różnych przedziałów mogą być tworzone przez kilka wątków jednocześnie.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in] count - liczba indeksów
+ * @param[out] range - wskaźnik na przydzielony przedział
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false, jeśli nie udało się alokować pamięci lub
+ *         zabrakłoby indeksów.
+ */
+bool takeNodeRange(NodePool *pool, size_t count, NodeRange *range);
+
+/** @brief Tworzy nowy węzeł drzewa z przydzielonego przedziału indeksów.
+ * Nie zmienia puli, więc może być wywoływana jednocześnie przez wątki
+ * korzystające z różnych przedziałów.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] range - wskaźnik na przedział indeksów
+ * @param[in] father - wskaźnik na węzeł, który jest ojcem tworzonego węzła
+ * @return Wskaźnik na utworzony węzeł lub NULL, gdy przedział się wyczerpał.
+ */
+Node * newNodeInRange(NodePool const *pool, NodeRange *range, Node *father);
+
+/** @brief Oddaje puli nieużyte indeksy przedziału jako węzły zwolnione.
+ * @param[in,out] pool - wskaźnik na pulę węzłów
+ * @param[in,out] range - wskaźnik na przedział indeksów
+ */
+void returnNodeRange(NodePool *pool, NodeRange *range);
 
 /** @brief Usuwa drzewo przekierowań.
  * Usuwa drzewo przekierowań, którego korzeń wskazywany jest przez @p n.
  * W szczególności może to być poddrzewo innego drzewa.
  * Nic nie robi, jeśli wskaźnik ten ma wartość NULL.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] n - wskaźnik na korzeń usuwanego drzewa.
  */
-void treeDelete(Node *n);
+void treeDelete(NodePool *pool, Node *n);
+
+/** @brief Zwalnia drzewo bez aktualizowania drzewa odwróceń.
+ * Używana, gdy oba drzewa są usuwane w całości.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] n - wskaźnik na korzeń zwalnianego drzewa.
+ */
+void treeFree(NodePool *pool, Node *n);
+
+/** @brief Zwalnia węzeł ze szczytu stosu węzłów do zwolnienia.
+ * Stos węzłów do zwolnienia jest listą połączoną przez pola @p parent.
+ * Zdejmuje ze stosu węzeł, wkłada na stos jego synów i zwalnia go.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] stack - wskaźnik na węzeł na szczycie stosu
+ * @param[in] update_reverse - czy usuwać wpis drzewa odwróceń odpowiadający
+ *                             przekierowaniu zapisanemu w zwalnianym węźle
+ * @return Wskaźnik na nowy szczyt stosu lub NULL, gdy stos jest pusty.
+ */
+Node * freeStackTop(NodePool *pool, Node *stack, bool update_reverse);
+
+/** @brief Oznacza węzeł i jego przodków jako zmienione.
+ * Zatrzymuje się na pierwszym już oznaczonym przodku, bo wtedy oznaczeni
+ * są też wszyscy dalsi przodkowie.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] n - wskaźnik na węzeł drzewa lub NULL
+ */
+void markDirty(NodePool const *pool, Node *n);
+
+/** @brief Oznacza zmianę przekierowania zapisanego w węźle.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] n - wskaźnik na węzeł drzewa przekierowań
+ */
+void markChanged(NodePool const *pool, Node *n);
+
+/** @brief Oznacza usunięcie poddrzewa syna węzła.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] father - wskaźnik na ojca usuniętego poddrzewa
+ * @param[in] digit - cyfra syna, którego poddrzewo usunięto
+ */
+void markSonRemoved(NodePool const *pool, Node *father, int digit);
+
+/** @brief Odłącza węzeł od rodzica.
+ * Nic nie robi, jeśli węzeł jest korzeniem.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] n - wskaźnik na odłączany węzeł
+ */
+void detachNode(NodePool const *pool, Node *n);
+
+/** @brief Sprawdza, czy wpis drzewa odwróceń odpowiada istniejącemu przekierowaniu.
+ * Wpis może być nieaktualny, jeśli przekierowanie zostało usunięte w trybie
+ * przyrostowym, a jego węzeł czeka na zwolnienie.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] forward - wskaźnik na korzeń drzewa przekierowań
+ * @param[in] reverse - wskaźnik na węzeł drzewa odwróceń, w którego liście jest wpis
+ * @param[in] element - wskaźnik na wpis
+ * @return Wartość @p true, jeśli wpis jest aktualny.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool reverseEntryAlive(NodePool const *pool, Node *forward, Node const *reverse, OneNumber const *element);
+
+/** @brief Usuwa wpis drzewa odwróceń odpowiadający węzłowi drzewa przekierowań.
+ * Usuwa z listy w drzewie odwróceń numer zapisany przy dodawaniu przekierowania
+ * z węzła @p n. Jeśli lista stała się pusta, usuwa ją i przycina pustą gałąź.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] n - wskaźnik na węzeł drzewa przekierowań
+ */
+void detachReverseEntry(NodePool *pool, Node *n);
+
+/** @brief Przycina pustą gałąź drzewa.
+ * Usuwa kolejno węzeł @p n i jego przodków, dopóki są liśćmi bez listy
+ * numerów. Korzeń drzewa nigdy nie jest usuwany.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] n - wskaźnik na najgłębszy węzeł gałęzi
+ */
+void pruneEmptyBranch(NodePool *pool, Node *n);
 
 /** @brief Usuwa martwą gałąź drzewa.
  * Usuwa martwą gałąź drzewa.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] help - wskaźnik na liść gałęzi
  * @param[in] father - wskaźnik na ojca liścia gałęzi
  */
-void removeEmptyBranch(Node *help, Node *father);
+void removeEmptyBranch(NodePool *pool, Node *help, Node *father);
 
 /** @brief Sprawdza, czy węzeł drzewa jest liściem.
  * @param[in] n - wskaźnik na węzeł drzewa
@@ -66,17 +352,19 @@ size_t howLong(char const *num);
 /** @brief Wskazuje adres dziecka węzła danego jako argument, którego adres jest różny od NULL.
  * Wskazuje adres dziecka węzła danego jako argument, którego adres jest różny od NULL.
  * W przypadku kilkorga takich dzieci, wybiera to, które znajduje się w komórce tablicy o najmniejszym indeksie.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] n - wskaźnik na węzeł drzewa
  * @return Wskaźnik na wybrane dziecko. Jeśli nie ma już dzieci, NULL. Jednak tą funkcję wywołujemy
  * po sprawdzeniu, że argument nie jest liściem, więc w praktyce nie zwróci nigdy wartości NULL.
  */
-Node * leftChild(Node *n);
+Node * leftChild(NodePool const *pool, Node *n);
 
 /** @brief Sprawdza, którym dzieckiem swojego rodzica jest dany węzeł.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] child - wskaźnik na węzeł drzewa, o którym chcemy wiedzieć, którym dzieckiem swojego rodzica jest
  * @return Indeks dziecka w tablicy dzieci rodzica
  */
-int whichChild(Node *child);
+int whichChild(NodePool const *pool, Node *child);
 
 /** @brief Sprawdza, czy napis reprezentuje numer.
  * @param[in] num - wskaźnik na napis potencjalnie reprezentujący numer
@@ -103,6 +391,7 @@ bool numbersDiffer(char const *num1, char const *num2);
 /** @brief Szuka węzła drzewa wyznaczanego przez daną ścieżkę.
  * Szuka węzła drzewa wyznaczanego przez daną ścieżkę.
  * Jeśli takiego węzła nie ma, tworzy go.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
  * @param[in,out] root - wskaźnik na węzeł drzewa
  * @param[in] num - wskaźnik na napis reprezentujący ścieżkę
  * @param[in, out] first_added - adres zmiennej, na której zostaje zapisany adres węzła, który został dodany jako pierwszy
@@ -110,17 +399,19 @@ bool numbersDiffer(char const *num1, char const *num2);
  * @return Wartość @p true, jeśli udało się odnaleźć lub dodać węzeł.
  *         Wartość @p false, jeśli nie udało się alokować pamięci.
  */
-bool lookForANode(Node *root, char const *num, Node **first_added, Node **result);
+bool lookForANode(NodePool *pool, Node *root, char const *num, Node **first_added, Node **result);
 
 /** @brief Zmienia (dodaje lub zastępuje) przekierowanie danego numeru (i wszystkich numerów, których on jest prefiksem).
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] n - wskaźnik na węzeł drzewa, w którym będzie zapisywane przekierowanie
  * @param[in] num - wskaźnik na napis reprezentujący numer, na który jest tworzone przekierowanie
  * @return Wartość @p true, jeśli udało się alokować pamięć.
  *         Wartość @p false, jeśli nie udało się alokować pamięci.
  */
-bool changeForward(Node *n, char const *num);
+bool changeForward(NodePool *pool, Node *n, char const *num);
 
 /** @brief Szuka najdłuższego prefiksu num, który ma przekierowanie inne niż na samego siebie.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
  * @param[in] n - wskaźnik na korzeń drzewa przekierowań
  * @param[in, out] last_modification - wskaźnik na zmienną zawierającą adres węzła drzewa,
  * w którym znalezione zostało najbardziej aktualne przekierowanie
@@ -128,7 +419,21 @@ bool changeForward(Node *n, char const *num);
  * jaka jest długość ścieżki od węzła o adresie n do węzła o adresie *last_modification
  * @param[in] num - wskaźnik na napis reprezentujący numer, którego przekierowanie jest odczytywane
  */
-void lookForModification(Node *n, Node **last_modification, size_t *how_many_digits_eaten, char const *num);
+void lookForModification(NodePool const *pool, Node *n, Node **last_modification, size_t *how_many_digits_eaten, char const *num);
+
+/** @brief Szuka najdłuższego prefiksu spakowanego numeru, który ma przekierowanie.
+ * Działa tak samo jak @ref lookForModification, ale numer jest zapisany w postaci spakowanej.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] n - wskaźnik na korzeń drzewa przekierowań
+ * @param[in, out] last_modification - wskaźnik na zmienną zawierającą adres węzła drzewa,
+ * w którym znalezione zostało najbardziej aktualne przekierowanie
+ * @param[in, out] how_many_digits_eaten - wskaźnik na zmienną zawierającą informację o tym,
+ * jaka jest długość ścieżki od węzła o adresie n do węzła o adresie *last_modification
+ * @param[in] digits - wskaźnik na spakowane cyfry numeru
+ * @param[in] length - liczba cyfr numeru
+ */
+void lookForModificationPacked(NodePool const *pool, Node *n, Node **last_modification, size_t *how_many_digits_eaten,
+                               unsigned char const *digits, size_t length);
 
 /** @brief Zwraca liczbę około dwa razy większą od argumentu.
  * @param[in] argument - liczba całkowita
@@ -0,0 +1,1121 @@
+/** @file
+ * Implementacja klasy funkcji wykonujących wiele operacji na przekierowaniach naraz
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phfwd_batch.h"
+#include "phone_forward.h"
+#include "phfwd_auxiliary_functions.h"
+#include "phfwd_traversal.h"
+#include "list.h"
+#include "phfwd_log.h"
+#include "phfwd_simd.h"
+#include "phfwd_direct.h"
+
+/**
+ * To jest struktura opisująca jedną operację paczki podczas jej porządkowania.
+ */
+typedef struct BatchRecord {
+    uint64_t head; ///< początek prefiksu w postaci zwróconej przez @ref numberHead
+    char const *key; ///< prefiks, którego dotyczy operacja (parametr num1 lub num)
+    size_t length; ///< długość prefiksu
+    size_t index; ///< pozycja operacji w paczce
+    bool is_remove; ///< czy operacja jest usunięciem
+    size_t newest_remove; ///< największa pozycja usunięcia o prefiksie będącym prefiksem klucza (na stosie)
+} BatchRecord;
+
+/**
+ * To jest struktura opisująca dodanie podczas porządkowania według parametru num2.
+ */
+typedef struct BatchTarget {
+    uint64_t head; ///< początek parametru num2 w postaci zwróconej przez @ref numberHead
+    BatchAdd *add; ///< wskaźnik na opis dodania
+} BatchTarget;
+
+/**
+ * To jest liczba cyfr mieszczących się w słowie zwracanym przez @ref numberHead.
+ */
+#define HEAD_DIGITS 16
+
+/**
+ * To jest struktura opisująca usunięcie poddrzewa, które można cofnąć.
+ */
+typedef struct BatchRemove {
+    char const *key; ///< usuwany prefiks
+    Node *node; ///< odłączony korzeń poddrzewa lub NULL, gdy nie było czego usuwać
+    Node *parent; ///< rodzic odłączonego węzła
+    int index; ///< indeks odłączonego węzła w tablicy synów rodzica
+} BatchRemove;
+
+/** @brief Porównuje 2 numery w porządku leksykograficznym wartości cyfr.
+ * Napisy muszą kończyć się znakiem '\0', ale nie wcześniej niż po podanej liczbie cyfr.
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] length1 - długość pierwszego numeru
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer
+ * @param[in] length2 - długość drugiego numeru
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
+ */
+int compareNumbers(char const *num1, size_t length1, char const *num2, size_t length2) {
+    size_t i = commonPrefix(num1, length1, num2, length2);
+    if ((i < length1) && (i < length2)) {
+        return (digitValue(num1 + i) > digitValue(num2 + i)) ? 1 : -1;
+    }
+    if (length1 == length2) {
+        return 0;
+    }
+    return (length1 < length2) ? -1 : 1;
+}
+
+/** @brief Zwraca długość najdłuższego wspólnego prefiksu dwóch numerów.
+ * Napisy muszą kończyć się znakiem '\0', ale nie wcześniej niż po podanej liczbie cyfr.
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] length1 - długość pierwszego numeru
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer
+ * @param[in] length2 - długość drugiego numeru
+ * @return Długość najdłuższego wspólnego prefiksu.
+ */
+size_t commonPrefix(char const *num1, size_t length1, char const *num2, size_t length2) {
+    size_t i = firstDifference(num1, num2);
+    if (i > length1) {
+        i = length1;
+    }
+    return (i < length2) ? i : length2;
+}
+
+/** @brief Zapisuje początek numeru w jednym słowie 64-bitowym.
+ * Cyfry zapisuje tak jak w postaci spakowanej, od najstarszych bitów, więc
+ * porządek słów zgadza się z porządkiem numerów, a równe słowa oznaczają
+ * numery równe na pierwszych @ref HEAD_DIGITS cyfrach i o tej samej długości,
+ * o ile jest ona mniejsza niż @ref HEAD_DIGITS.
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - długość numeru
+ * @return Słowo reprezentujące początek numeru.
+ */
+static uint64_t numberHead(char const *num, size_t length) {
+    uint64_t head = 0;
+    for (size_t i = 0; i < HEAD_DIGITS; ++i) {
+        head <<= 4;
+        if (i < length) {
+            head |= (uint64_t)(digitValue(num + i) + 1);
+        }
+    }
+    return head;
+}
+
+/** @brief Porównuje 2 numery, korzystając z ich początków zapisanych w słowach.
+ * @param[in] head1 - słowo reprezentujące początek pierwszego numeru
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] length1 - długość pierwszego numeru
+ * @param[in] head2 - słowo reprezentujące początek drugiego numeru
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer
+ * @param[in] length2 - długość drugiego numeru
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
+ */
+static int compareWithHeads(uint64_t head1, char const *num1, size_t length1,
+                            uint64_t head2, char const *num2, size_t length2) {
+    if (head1 != head2) {
+        return (head1 > head2) ? 1 : -1;
+    }
+    if ((length1 < HEAD_DIGITS) || (length2 < HEAD_DIGITS)) {
+        return 0;
+    }
+    return compareNumbers(num1 + HEAD_DIGITS, length1 - HEAD_DIGITS, num2 + HEAD_DIGITS, length2 - HEAD_DIGITS);
+}
+
+/** @brief Porównuje 2 operacje paczki.
+ * Porządkuje operacje według prefiksu, przy równych prefiksach usunięcia
+ * przed dodaniami, a dalej według pozycji w paczce.
+ * @param[in] record1 - wskaźnik na opis pierwszej operacji
+ * @param[in] record2 - wskaźnik na opis drugiej operacji
+ * @return Wartość ujemna, zero lub dodatnia, jak w funkcji porównującej dla qsort.
+ */
+static int compareRecords(const void *record1, const void *record2) {
+    BatchRecord const *r1 = record1;
+    BatchRecord const *r2 = record2;
+    int result = compareWithHeads(r1->head, r1->key, r1->length, r2->head, r2->key, r2->length);
+    if (result != 0) {
+        return result;
+    }
+    if (r1->is_remove != r2->is_remove) {
+        return r1->is_remove ? -1 : 1;
+    }
+    return (r1->index > r2->index) - (r1->index < r2->index);
+}
+
+/** @brief Porównuje 2 dodania według numeru, na który jest wykonywane przekierowanie, a dalej według numeru przekierowywanego.
+ * @param[in] target1 - wskaźnik na opis pierwszego dodania
+ * @param[in] target2 - wskaźnik na opis drugiego dodania
+ * @return Wartość ujemna, zero lub dodatnia, jak w funkcji porównującej dla qsort.
+ */
+static int compareTargets(const void *target1, const void *target2) {
+    BatchTarget const *t1 = target1;
+    BatchTarget const *t2 = target2;
+    int result = compareWithHeads(t1->head, t1->add->num2, t1->add->length2, t2->head, t2->add->num2, t2->add->length2);
+    if (result != 0) {
+        return result;
+    }
+    // Przy równych numerach docelowych wpisy drzewa odwróceń trafiają do listy w porządku rosnącym.
+    return compareWithHeads(t1->add->head1, t1->add->num1, t1->add->length1,
+                            t2->add->head1, t2->add->num1, t2->add->length1);
+}
+
+/** @brief Zwraca wartość cyfry numeru, korzystając z jego początku zapisanego w słowie.
+ * Cyfry spoza słowa odczytuje z napisu.
+ * @param[in] head - słowo reprezentujące początek numeru
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] d - pozycja cyfry
+ * @return Wartość cyfry.
+ */
+static int headDigit(uint64_t head, char const *num, size_t d) {
+    if (d < HEAD_DIGITS) {
+        return (int)((head >> (4 * (HEAD_DIGITS - 1 - d))) & 0xF) - 1;
+    }
+    return digitValue(num + d);
+}
+
+/** @brief Zwraca długość najdłuższego wspólnego prefiksu dwóch numerów, korzystając z ich początków zapisanych w słowach.
+ * Napisy są czytane tylko wtedy, gdy oba numery mają co najmniej @ref HEAD_DIGITS
+ * wspólnych cyfr.
+ * @param[in] head1 - słowo reprezentujące początek pierwszego numeru
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] length1 - długość pierwszego numeru
+ * @param[in] head2 - słowo reprezentujące początek drugiego numeru
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer
+ * @param[in] length2 - długość drugiego numeru
+ * @return Długość wspólnego prefiksu.
+ */
+static size_t sharedPrefix(uint64_t head1, char const *num1, size_t length1,
+                           uint64_t head2, char const *num2, size_t length2) {
+    size_t shorter = (length1 < length2) ? length1 : length2;
+    if (head1 != head2) {
+        size_t shared = (size_t)__builtin_clzll(head1 ^ head2) / 4;
+        return (shared < shorter) ? shared : shorter;
+    }
+    if (shorter < HEAD_DIGITS) {
+        return shorter;
+    }
+    return HEAD_DIGITS + commonPrefix(num1 + HEAD_DIGITS, length1 - HEAD_DIGITS, num2 + HEAD_DIGITS, length2 - HEAD_DIGITS);
+}
+
+/** @brief Tworzy węzeł listy ze spakowanym numerem, korzystając z jego początku zapisanego w słowie.
+ * @param[in] head - słowo reprezentujące początek numeru
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - długość numeru
+ * @return Wskaźnik na utworzony węzeł lub NULL, gdy nie udało się alokować pamięci.
+ */
+static OneNumber * newBatchNumber(uint64_t head, char const *num, size_t length) {
+    if (length <= HEAD_DIGITS) {
+        return newHeadNumber(head, length);
+    }
+    return newPackedNumber(num, length);
+}
+
+/** @brief Odczytuje początek numeru zapisany na początku elementu tablicy.
+ * @param[in] items - wskaźnik na tablicę
+ * @param[in] size - rozmiar jednego elementu
+ * @param[in] i - indeks elementu
+ * @return Słowo zwrócone przez @ref numberHead zapisane w elemencie.
+ */
+static uint64_t headAt(unsigned char const *items, size_t size, size_t i) {
+    uint64_t head;
+    memcpy(&head, items + i * size, sizeof(head));
+    return head;
+}
+
+/** @brief Sortuje tablicę elementów zaczynających się od początku numeru.
+ * Najpierw stabilnie sortuje elementy pozycyjnie według słów zwróconych przez
+ * @ref numberHead, pomijając bajty słowa równe we wszystkich elementach,
+ * a następnie porządkuje funkcją @p compare tylko ciągi elementów o równych
+ * słowach. Wynik jest taki sam jak wynik qsort z funkcją @p compare, która
+ * musi porządkować elementy najpierw według tych słów.
+ * @param[in,out] items - wskaźnik na tablicę elementów, z których każdy zaczyna się od słowa typu uint64_t
+ * @param[in] count - liczba elementów
+ * @param[in] size - rozmiar jednego elementu
+ * @param[in] compare - funkcja porównująca, jak dla qsort
+ * @return Wartość @p true, jeśli udało się alokować pamięć; wtedy tablica jest posortowana.
+ *         Wartość @p false w przeciwnym przypadku; wtedy tablica jest niezmieniona.
+ */
+static bool sortByHead(void *items, size_t count, size_t size, int (*compare)(const void *, const void *)) {
+    unsigned char *from = items;
+    unsigned char *to = malloc(count * size);
+    if (to == NULL) {
+        return false;
+    }
+    unsigned char *buffer = to;
+    uint64_t any = 0;
+    uint64_t all = UINT64_MAX;
+    for (size_t i = 0; i < count; ++i) {
+        any |= headAt(from, size, i);
+        all &= headAt(from, size, i);
+    }
+    for (int shift = 0; shift < 64; shift += 8) {
+        if ((((any ^ all) >> shift) & 0xFF) == 0) {
+            continue; // Ten bajt jest taki sam we wszystkich słowach.
+        }
+        size_t positions[256 + 1] = {0};
+        for (size_t i = 0; i < count; ++i) {
+            ++positions[((headAt(from, size, i) >> shift) & 0xFF) + 1];
+        }
+        for (int b = 0; b < 256; ++b) {
+            positions[b + 1] += positions[b];
+        }
+        for (size_t i = 0; i < count; ++i) {
+            memcpy(to + (positions[(headAt(from, size, i) >> shift) & 0xFF]++) * size, from + i * size, size);
+        }
+        unsigned char *help = from;
+        from = to;
+        to = help;
+    }
+    if (from != items) {
+        memcpy(items, from, count * size);
+    }
+    free(buffer);
+
+    unsigned char *sorted = items;
+    for (size_t i = 0; i < count; ) {
+        size_t j = i + 1;
+        while ((j < count) && (headAt(sorted, size, j) == headAt(sorted, size, i))) {
+            ++j;
+        }
+        if (j - i > 1) {
+            qsort(sorted + i * size, j - i, size, compare);
+        }
+        i = j;
+    }
+    return true;
+}
+
+/** @brief Schodzi ścieżką w drzewie, tworząc brakujące węzły.
+ * Korzysta z węzłów ścieżki poprzedniego klucza zapisanych w tablicy @p path
+ * do głębokości @p shared włącznie i zapisuje tam węzły nowej ścieżki.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] path - tablica węzłów ścieżki; path[0] jest korzeniem
+ * @param[in] shared - długość wspólnego prefiksu z poprzednim kluczem
+ * @param[in] head - słowo reprezentujące początek ścieżki, w postaci zwróconej przez @ref numberHead
+ * @param[in] key - wskaźnik na napis reprezentujący ścieżkę
+ * @param[in] length - długość ścieżki
+ * @param[out] first_created - adres zmiennej, na której zostaje zapisany pierwszy utworzony węzeł
+ * @return Wskaźnik na ostatni węzeł ścieżki lub NULL, gdy nie udało się alokować pamięci.
+ */
+static Node * walkCreating(NodePool *pool, Node **path, size_t shared, uint64_t head, char const *key, size_t length,
+                           Node **first_created) {
+    Node *n = path[shared];
+    for (size_t d = shared; d < length; ++d) {
+        int digit = headDigit(head, key, d);
+        if ((n->sons)[digit] == 0) {
+            Node *son = newNode(pool, n);
+            if (son == NULL) {
+                return NULL;
+            }
+            (n->sons)[digit] = son->index;
+            if (*first_created == NULL) {
+                *first_created = son;
+            }
+        }
+        n = sonOf(pool, n, digit);
+        path[d + 1] = n;
+    }
+    return n;
+}
+
+/** @brief Porządkuje operacje paczki.
+ * Wyznacza usunięcia, które trzeba wykonać na stanie sprzed paczki, oraz
+ * dodania, które przetrwają do końca paczki: dodanie przepada, jeśli później
+ * w paczce występuje usunięcie jego prefiksu albo dodanie z tym samym
+ * parametrem num1. Stos aktywnych usunięć zawiera usunięcia, których prefiksy
+ * są prefiksami bieżącego klucza.
+ * @param[in] records - posortowana tablica operacji
+ * @param[in] count - liczba operacji
+ * @param[out] stack - tablica na stos o rozmiarze co najmniej @p count
+ * @param[out] removes - tablica na usunięcia do wykonania
+ * @param[out] how_many_removes - liczba usunięć do wykonania
+ * @param[out] adds - tablica na dodania, które przetrwają
+ * @param[out] how_many_adds - liczba dodań, które przetrwają
+ * @param[in] operations - tablica operacji paczki
+ */
+static void sweepRecords(BatchRecord *records, size_t count, BatchRecord **stack,
+                         BatchRemove *removes, size_t *how_many_removes,
+                         BatchAdd *adds, size_t *how_many_adds,
+                         PhoneForwardOperation const *operations) {
+    size_t top = 0;
+    *how_many_removes = 0;
+    *how_many_adds = 0;
+    for (size_t i = 0; i < count; ++i) {
+        BatchRecord *record = &records[i];
+        while ((top > 0) && (sharedPrefix(stack[top - 1]->head, stack[top - 1]->key, stack[top - 1]->length,
+                                          record->head, record->key, record->length) != stack[top - 1]->length)) {
+            --top;
+        }
+        if (record->is_remove) {
+            if (top == 0) { // Usunięcia krótszych prefiksów obejmują dłuższe.
+                removes[*how_many_removes].key = record->key;
+                removes[*how_many_removes].node = NULL;
+                ++(*how_many_removes);
+            }
+            record->newest_remove = record->index;
+            if ((top > 0) && (stack[top - 1]->newest_remove > record->newest_remove)) {
+                record->newest_remove = stack[top - 1]->newest_remove;
+            }
+            stack[top] = record;
+            ++top;
+        }
+        else if ((top == 0) || (stack[top - 1]->newest_remove < record->index)) {
+            size_t n = *how_many_adds;
+            if ((n > 0) && (compareWithHeads(adds[n - 1].head1, adds[n - 1].num1, adds[n - 1].length1,
+                                             record->head, record->key, record->length) == 0)) {
+                --n; // Późniejsze dodanie z tym samym num1 zastępuje wcześniejsze.
+            }
+            memset(&adds[n], 0, sizeof(adds[n]));
+            adds[n].num1 = record->key;
+            adds[n].length1 = record->length;
+            adds[n].head1 = record->head;
+            adds[n].num2 = operations[record->index].num2;
+            adds[n].length2 = howLong(adds[n].num2);
+            adds[n].head2 = numberHead(adds[n].num2, adds[n].length2);
+            *how_many_adds = n + 1;
+        }
+    }
+}
+
+/** @brief Zwalnia pamięć przygotowaną dla dodań i cofa utworzenie węzłów.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzew
+ * @param[in,out] adds - tablica dodań
+ * @param[in] how_many_adds - liczba dodań
+ */
+static void rollbackAdds(NodePool *pool, BatchAdd *adds, size_t how_many_adds) {
+    for (size_t i = how_many_adds; i > 0; --i) {
+        BatchAdd *add = &adds[i - 1];
+        freeNumber(add->forward_entry);
+        freeNumber(add->reverse_entry);
+        free(add->forward_list);
+        freeList(add->reverse_list);
+        free(add->reverse_list);
+        // Węzły utworzone później leżą głębiej lub obok, więc usuwamy je od końca.
+        treeFree(pool, add->created_reverse);
+        treeFree(pool, add->created_forward);
+    }
+}
+
+/** @brief Przygotowuje dodania: tworzy brakujące węzły, alokuje wpisy list i miejsce w indeksach list drzewa odwróceń.
+ * Nie zmienia przekierowań widocznych w strukturze.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in,out] adds - tablica dodań posortowana według num1
+ * @param[in,out] by_target - tablica dodań posortowana według num2
+ * @param[in] how_many_adds - liczba dodań
+ * @param[in,out] path - tablica na ścieżkę o rozmiarze większym od długości najdłuższego numeru
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool prepareAdds(PhoneForward *pf, BatchAdd *adds, BatchTarget *by_target, size_t how_many_adds, Node **path) {
+    path[0] = pf->forward;
+    for (size_t i = 0; i < how_many_adds; ++i) {
+        BatchAdd *add = &adds[i];
+        size_t shared = (i == 0) ? 0 : sharedPrefix(adds[i - 1].head1, adds[i - 1].num1, adds[i - 1].length1,
+                                                    add->head1, add->num1, add->length1);
+        add->forward = walkCreating(pf->pool, path, shared, add->head1, add->num1, add->length1, &(add->created_forward));
+        add->forward_entry = newBatchNumber(add->head2, add->num2, add->length2);
+        if ((add->forward == NULL) || (add->forward_entry == NULL)) {
+            return false;
+        }
+        if ((pf->reverse != NULL)
+            && ((add->reverse_entry = newBatchNumber(add->head1, add->num1, add->length1)) == NULL)) {
+            return false;
+        }
+        if ((add->forward->list == NULL) && ((add->forward_list = newList()) == NULL)) {
+            return false;
+        }
+    }
+
+    if (pf->reverse == NULL) {
+        return true;
+    }
+    path[0] = pf->reverse;
+    ListOfNumbers *list = NULL;
+    size_t group = 0;
+    for (size_t i = 0; i < how_many_adds; ++i) {
+        BatchAdd *add = by_target[i].add;
+        size_t shared = 0;
+        if (i > 0) {
+            BatchAdd const *previous = by_target[i - 1].add;
+            shared = sharedPrefix(previous->head2, previous->num2, previous->length2,
+                                  add->head2, add->num2, add->length2);
+            if ((shared == add->length2) && (shared == previous->length2)) {
+                add->reverse = previous->reverse; // Ten sam węzeł, lista już przygotowana.
+                if (!reserveSorted(list, ++group)) {
+                    return false;
+                }
+                continue;
+            }
+        }
+        add->reverse = walkCreating(pf->pool, path, shared, add->head2, add->num2, add->length2,
+                                    &(add->created_reverse));
+        if (add->reverse == NULL) {
+            return false;
+        }
+        if ((add->reverse->list == NULL) && ((add->reverse_list = newList()) == NULL)) {
+            return false;
+        }
+        list = (add->reverse->list != NULL) ? add->reverse->list : add->reverse_list;
+        group = 1;
+        if (!reserveSorted(list, group)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Zatwierdza przygotowane dodania. Nie alokuje pamięci.
+ * Najpierw dołącza wszystkie nowe wpisy drzewa odwróceń, dzięki czemu
+ * usuwanie zastępowanych wpisów nie przytnie węzłów potrzebnych paczce.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzew
+ * @param[in,out] adds - tablica dodań posortowana według num1
+ * @param[in] by_target - tablica dodań posortowana według num2
+ * @param[in] how_many_adds - liczba dodań
+ */
+static void commitAdds(NodePool *pool, BatchAdd *adds, BatchTarget *by_target, size_t how_many_adds) {
+    for (size_t i = 0; i < how_many_adds; ++i) {
+        BatchAdd *add = by_target[i].add;
+        if (add->reverse == NULL) {
+            continue; // Struktura bez drzewa odwróceń.
+        }
+        if (add->reverse->list == NULL) {
+            add->reverse->list = add->reverse_list;
+            add->reverse_list = NULL;
+        }
+        insertSortedElement(add->reverse->list, add->reverse_entry);
+        if (add->length1 > pool->longest_entry) {
+            pool->longest_entry = add->length1;
+        }
+    }
+    for (size_t i = 0; i < how_many_adds; ++i) {
+        BatchAdd *add = &adds[i];
+        Node *n = add->forward;
+        if (n->list == NULL) {
+            n->list = add->forward_list;
+            add->forward_list = NULL;
+        }
+        appendElement(n->list, add->forward_entry);
+        if ((n->list)->first != (n->list)->last) { // Usuwamy poprzednie przekierowanie.
+            removeElement(n->list, (n->list)->first);
+            detachReverseEntry(pool, n);
+        }
+        coldOf(pool, n)->infoAboutMe = nodeIndex(add->reverse);
+        coldOf(pool, n)->imHere = add->reverse_entry;
+        markChanged(pool, n);
+        free(add->forward_list);
+        freeList(add->reverse_list);
+        free(add->reverse_list);
+    }
+}
+
+/** @brief Uaktualnia tablicę bezpośredniego dostępu po wykonaniu paczki.
+ * Wypełnia od nowa pozycje prefiksów operacji paczki, a gdy operacji jest
+ * tyle, że trwałoby to dłużej niż wypełnienie całej tablicy, całą tablicę.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in] records - tablica operacji paczki
+ * @param[in] count - liczba operacji
+ */
+static void refreshDirectIndex(PhoneForward *pf, BatchRecord const *records, size_t count) {
+    if (pf->direct == NULL) {
+        return;
+    }
+    if (count >= pf->direct->size / SONS) {
+        directIndexRebuild(pf->direct, pf->pool, pf->forward);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        directIndexRefresh(pf->direct, pf->pool, pf->forward, records[i].key, records[i].length);
+    }
+}
+
+/** @brief Wykonuje paczkę operacji dodawania i usuwania przekierowań.
+ * Wynik jest taki sam jak wykonanie kolejno operacji z tablicy @p operations
+ * funkcjami @ref phfwdAdd i @ref phfwdRemove, ale operacje są porządkowane
+ * według prefiksów i wykonywane jednym przejściem po drzewie przekierowań
+ * i jednym po drzewie odwróceń, z wykorzystaniem wspólnych prefiksów kolejnych
+ * numerów. Paczka jest niepodzielna: jeśli któreś dodanie ma niepoprawne
+ * parametry lub nie uda się alokować pamięci, struktura pozostaje niezmieniona.
+ * Usunięcia z niepoprawnym parametrem są pomijane, tak jak w @ref phfwdRemove.
+ * @param[in,out] pf         - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] operations     - wskaźnik na tablicę operacji;
+ * @param[in] count          - liczba operacji.
+ * @return Wartość @p true, jeśli wszystkie operacje zostały wykonane.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, któreś dodanie
+ *         ma niepoprawne parametry lub nie udało się alokować pamięci.
+ */
+bool phfwdApplyBatch(PhoneForward *pf, PhoneForwardOperation const *operations, size_t count) {
+    if ((pf == NULL) || (pf->engine != NULL) || ((operations == NULL) && (count > 0))) {
+        return false;
+    }
+    size_t how_many_records = 0;
+    size_t max_length = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (operations[i].type == PHFWD_ADD) {
+            if (!onlyDigitsAndNotEmpty(operations[i].num1) || !onlyDigitsAndNotEmpty(operations[i].num2)
+                || !numbersDiffer(operations[i].num1, operations[i].num2)) {
+                return false;
+            }
+            size_t length = howLong(operations[i].num2);
+            max_length = (length > max_length) ? length : max_length;
+        }
+        else if (!onlyDigitsAndNotEmpty(operations[i].num1)) {
+            continue;
+        }
+        size_t length = howLong(operations[i].num1);
+        max_length = (length > max_length) ? length : max_length;
+        ++how_many_records;
+    }
+    if (how_many_records == 0) {
+        return true;
+    }
+    if (pf->graveyard != NULL) {
+        phfwdReclaim(pf, pf->removal_budget);
+    }
+
+    BatchRecord *records = malloc(how_many_records * sizeof(*records));
+    BatchRecord **stack = malloc(how_many_records * sizeof(*stack));
+    BatchRemove *removes = malloc(how_many_records * sizeof(*removes));
+    BatchAdd *adds = malloc(how_many_records * sizeof(*adds));
+    BatchTarget *by_target = malloc(how_many_records * sizeof(*by_target));
+    Node **path = malloc((max_length + 1) * sizeof(*path));
+    bool result = (records != NULL) && (stack != NULL) && (removes != NULL)
+                  && (adds != NULL) && (by_target != NULL) && (path != NULL);
+    bool prepared = result;
+
+    if (result) {
+        size_t j = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if ((operations[i].type == PHFWD_ADD) || onlyDigitsAndNotEmpty(operations[i].num1)) {
+                records[j].key = operations[i].num1;
+                records[j].length = howLong(operations[i].num1);
+                records[j].head = numberHead(records[j].key, records[j].length);
+                records[j].index = i;
+                records[j].is_remove = (operations[i].type != PHFWD_ADD);
+                ++j;
+            }
+        }
+        if (!sortByHead(records, how_many_records, sizeof(*records), compareRecords)) {
+            qsort(records, how_many_records, sizeof(*records), compareRecords);
+        }
+
+        size_t how_many_removes = 0;
+        size_t how_many_adds = 0;
+        sweepRecords(records, how_many_records, stack, removes, &how_many_removes, adds, &how_many_adds, operations);
+        for (size_t i = 0; i < how_many_adds; ++i) {
+            by_target[i].add = &adds[i];
+            by_target[i].head = adds[i].head2;
+        }
+        if (!sortByHead(by_target, how_many_adds, sizeof(*by_target), compareTargets)) {
+            qsort(by_target, how_many_adds, sizeof(*by_target), compareTargets);
+        }
+
+        // Usunięcia odłączamy tak, aby dało się je cofnąć.
+        for (size_t i = 0; i < how_many_removes; ++i) {
+            Node *n = findNode(pf->pool, pf->forward, removes[i].key);
+            if (n != NULL) {
+                removes[i].node = n;
+                removes[i].parent = parentOf(pf->pool, n);
+                removes[i].index = whichChild(pf->pool, n);
+                detachNode(pf->pool, n);
+            }
+        }
+
+        if (prepareAdds(pf, adds, by_target, how_many_adds, path)) {
+            commitAdds(pf->pool, adds, by_target, how_many_adds);
+            for (size_t i = 0; i < how_many_removes; ++i) {
+                if (removes[i].node == NULL) {
+                    continue;
+                }
+                if (pf->removal_budget == 0) {
+                    treeDelete(pf->pool, removes[i].node);
+                }
+                else {
+                    coldOf(pf->pool, removes[i].node)->parent = nodeIndex(pf->graveyard);
+                    pf->graveyard = removes[i].node;
+                }
+            }
+            for (size_t i = 0; i < how_many_removes; ++i) {
+                // Rodzic mógł zostać przycięty razem z innym usunięciem, więc szukamy go od korzenia.
+                Node *n = pf->forward;
+                char const *digit = removes[i].key;
+                while ((*digit != '\0') && ((n->sons)[digitValue(digit)] != 0)) {
+                    n = sonOf(pf->pool, n, digitValue(digit));
+                    ++digit;
+                }
+                pruneEmptyBranch(pf->pool, n);
+            }
+        }
+        else {
+            rollbackAdds(pf->pool, adds, how_many_adds);
+            for (size_t i = how_many_removes; i > 0; --i) {
+                BatchRemove *remove = &removes[i - 1];
+                if (remove->node != NULL) {
+                    (remove->parent->sons)[remove->index] = remove->node->index;
+                    coldOf(pf->pool, remove->node)->parent = remove->parent->index;
+                }
+            }
+            result = false;
+        }
+    }
+
+    if (result && (pf->log != NULL)) {
+        for (size_t i = 0; i < count; ++i) {
+            if (operations[i].type == PHFWD_ADD) {
+                logAdd(pf->log, operations[i].num1, operations[i].num2);
+            }
+            else if (onlyDigitsAndNotEmpty(operations[i].num1)) {
+                logRemove(pf->log, operations[i].num1);
+            }
+        }
+    }
+
+    if (prepared) {
+        refreshDirectIndex(pf, records, how_many_records);
+    }
+    free(records);
+    free(stack);
+    free(removes);
+    free(adds);
+    free(by_target);
+    free(path);
+    return result;
+}
+
+/**
+ * To jest struktura opisująca jedno zapytanie wykonywane przez @ref phfwdGetBatch.
+ */
+typedef struct BatchQuery {
+    uint64_t head; ///< początek numeru w postaci zwróconej przez @ref numberHead
+    char const *num; ///< numer
+    size_t length; ///< długość numeru
+    size_t index; ///< pozycja numeru w tablicy zapytań
+} BatchQuery;
+
+/**
+ * To jest struktura opisująca węzeł na ścieżce zejścia wykonywanego przez @ref phfwdGetBatch.
+ */
+typedef struct BatchStep {
+    Node *node; ///< węzeł drzewa przekierowań odpowiadający prefiksowi numeru
+    Node *last_modification; ///< najgłębszy węzeł z przekierowaniem na ścieżce do węzła lub NULL
+    size_t eaten; ///< długość prefiksu odpowiadającego węzłowi last_modification
+} BatchStep;
+
+/** @brief Porównuje 2 zapytania paczki.
+ * Porządkuje zapytania według numerów, a przy równych numerach według pozycji.
+ * @param[in] query1 - wskaźnik na opis pierwszego zapytania
+ * @param[in] query2 - wskaźnik na opis drugiego zapytania
+ * @return Wartość ujemna, zero lub dodatnia, jak w funkcji porównującej dla qsort.
+ */
+static int compareQueries(const void *query1, const void *query2) {
+    BatchQuery const *q1 = query1;
+    BatchQuery const *q2 = query2;
+    int result = compareWithHeads(q1->head, q1->num, q1->length, q2->head, q2->num, q2->length);
+    if (result != 0) {
+        return result;
+    }
+    return (q1->index < q2->index) ? -1 : (q1->index > q2->index);
+}
+
+/** @brief Wyznacza przekierowania wielu numerów naraz.
+ * Wyznacza przekierowania numerów z tablicy @p nums, tak jak @ref phfwdGet,
+ * i przekazuje je funkcji @p visitor. Zapytania są porządkowane według
+ * numerów, a zejście w drzewie przekierowań zaczyna się od węzła wspólnego
+ * prefiksu z poprzednim numerem, więc funkcja @p visitor jest wywoływana
+ * w porządku numerów, a nie pozycji. Wyniki nie są alokowane osobno.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] nums - wskaźnik na tablicę napisów reprezentujących numery;
+ * @param[in] count - liczba numerów;
+ * @param[in] visitor - funkcja wywoływana dla każdego numeru;
+ * @param[in] data - wskaźnik przekazywany funkcji @p visitor.
+ * @return Wartość @p true, jeśli wyznaczono przekierowania wszystkich numerów.
+ *         Wartość @p false, jeśli parametr pf lub visitor ma wartość NULL,
+ *         funkcja @p visitor przerwała wyznaczanie lub nie udało się
+ *         alokować pamięci.
+ */
+bool phfwdGetBatch(PhoneForward const *pf, char const * const *nums, size_t count,
+                   PhoneForwardBatchVisitor visitor, void *data) {
+    if ((pf == NULL) || (pf->engine != NULL) || (visitor == NULL) || ((nums == NULL) && (count > 0))) {
+        return false;
+    }
+    BatchQuery *queries = malloc((count + 1) * sizeof(*queries));
+    if (queries == NULL) {
+        return false;
+    }
+    size_t how_many_queries = 0;
+    size_t max_length = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!onlyDigitsAndNotEmpty(nums[i])) {
+            if (!visitor(i, NULL, data)) {
+                free(queries);
+                return false;
+            }
+            continue;
+        }
+        BatchQuery *query = &(queries[how_many_queries++]);
+        query->num = nums[i];
+        query->length = howLong(nums[i]);
+        query->head = numberHead(query->num, query->length);
+        query->index = i;
+        max_length = (query->length > max_length) ? query->length : max_length;
+    }
+    qsort(queries, how_many_queries, sizeof(*queries), compareQueries);
+
+    BatchStep *steps = malloc((max_length + 1) * sizeof(*steps));
+    char *result = NULL;
+    size_t capacity = 0;
+    bool success = (steps != NULL);
+    if (success) {
+        steps[0].node = pf->forward;
+        steps[0].last_modification = NULL;
+        steps[0].eaten = 0;
+    }
+    size_t reached = 0;
+    for (size_t i = 0; success && (i < how_many_queries); ++i) {
+        BatchQuery const *query = &(queries[i]);
+        if (i > 0) {
+            size_t shared = commonPrefix(queries[i - 1].num, queries[i - 1].length, query->num, query->length);
+            reached = (shared < reached) ? shared : reached;
+        }
+        // Schodzimy od węzła, do którego doszło poprzednie zapytanie na wspólnym prefiksie.
+        while (reached < query->length) {
+            Node *son = sonOf(pf->pool, steps[reached].node, digitValue(query->num + reached));
+            if (son == NULL) {
+                break;
+            }
+            steps[reached + 1] = steps[reached];
+            ++reached;
+            steps[reached].node = son;
+            if (son->list != NULL) {
+                steps[reached].last_modification = son;
+                steps[reached].eaten = reached;
+            }
+        }
+        Node const *last_modification = steps[reached].last_modification;
+        size_t eaten = steps[reached].eaten;
+        size_t prefix_length = (last_modification == NULL) ? 0 : last_modification->list->first->number_length;
+        size_t result_length = prefix_length + query->length - eaten;
+        if (!reserveArray((void **)&result, &capacity, result_length + 1, sizeof(char))) {
+            success = false;
+            break;
+        }
+        if (last_modification != NULL) {
+            unpackDigits(result, last_modification->list->first->digits, prefix_length);
+        }
+        memcpy(result + prefix_length, query->num + eaten, query->length - eaten);
+        result[result_length] = '\0';
+        success = visitor(query->index, result, data);
+    }
+    free(result);
+    free(steps);
+    free(queries);
+    return success;
+}
+
+/** @brief Zapewnia, że tablica ma miejsce na co najmniej @p needed elementów.
+ * @param[in,out] array - adres wskaźnika na tablicę
+ * @param[in,out] capacity - adres zmiennej przechowującej liczbę elementów, na które jest miejsce
+ * @param[in] needed - wymagana liczba elementów
+ * @param[in] size - rozmiar jednego elementu
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool reserveArray(void **array, size_t *capacity, size_t needed, size_t size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    size_t new_capacity = more(*capacity);
+    if (new_capacity < needed) {
+        new_capacity = needed;
+    }
+    void *help = realloc(*array, new_capacity * size);
+    if (help == NULL) {
+        return false;
+    }
+    *array = help;
+    *capacity = new_capacity;
+    return true;
+}
+
+/** @brief Porównuje 2 wczytane przekierowania według numeru, na który są wykonywane, a dalej według numeru przekierowywanego.
+ * @param[in] entry1 - wskaźnik na opis pierwszego przekierowania
+ * @param[in] entry2 - wskaźnik na opis drugiego przekierowania
+ * @return Wartość ujemna, zero lub dodatnia, jak w funkcji porównującej dla qsort.
+ */
+static int compareBulkEntries(const void *entry1, const void *entry2) {
+    BulkEntry const *e1 = entry1;
+    BulkEntry const *e2 = entry2;
+    if (e1->head != e2->head) {
+        return (e1->head > e2->head) ? 1 : -1;
+    }
+    OneNumber const *t1 = e1->node->list->first;
+    OneNumber const *t2 = e2->node->list->first;
+    int result = packedCompare(t1->digits, t1->number_length, t2->digits, t2->number_length);
+    if (result != 0) {
+        return result;
+    }
+    return packedCompare(e1->source->digits, e1->source->number_length, e2->source->digits, e2->source->number_length);
+}
+
+/** @brief Wyznacza długość wspólnego prefiksu 2 spakowanych numerów.
+ * @param[in] number1 - wskaźnik na pierwszy spakowany numer
+ * @param[in] number2 - wskaźnik na drugi spakowany numer
+ * @return Liczba początkowych cyfr, na których numery się zgadzają.
+ */
+static size_t packedCommonPrefix(OneNumber const *number1, OneNumber const *number2) {
+    size_t result = 0;
+    while ((result < number1->number_length) && (result < number2->number_length)
+           && (packedDigitValue(number1->digits, result) == packedDigitValue(number2->digits, result))) {
+        ++result;
+    }
+    return result;
+}
+
+/** @brief Schodzi ścieżką spakowanego numeru w drzewie, tworząc brakujące węzły.
+ * Działa jak @ref walkCreating, ale dla numeru zapisanego w postaci spakowanej.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] range - wskaźnik na przedział indeksów, z którego są tworzone
+ *                        węzły, lub NULL, gdy węzły są brane wprost z puli
+ * @param[in,out] path - tablica węzłów ścieżki; path[0] jest korzeniem
+ * @param[in] shared - długość wspólnego prefiksu z poprzednim numerem
+ * @param[in] number - wskaźnik na spakowany numer
+ * @return Wskaźnik na ostatni węzeł ścieżki lub NULL, gdy nie udało się alokować pamięci.
+ */
+static Node * walkCreatingPacked(NodePool *pool, NodeRange *range, Node **path, size_t shared, OneNumber const *number) {
+    Node *n = path[shared];
+    for (size_t d = shared; d < number->number_length; ++d) {
+        int digit = packedDigitValue(number->digits, d);
+        if ((n->sons)[digit] == 0) {
+            Node *son = (range != NULL) ? newNodeInRange(pool, range, n) : newNode(pool, n);
+            if (son == NULL) {
+                return NULL;
+            }
+            (n->sons)[digit] = son->index;
+        }
+        n = sonOf(pool, n, digit);
+        path[d + 1] = n;
+    }
+    return n;
+}
+
+/** @brief Usuwa wszystkie węzły drzewa poza korzeniem.
+ * @param[in,out] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] root - wskaźnik na korzeń drzewa
+ */
+static void clearTree(NodePool *pool, Node *root) {
+    for (int i = 0; i < SONS; ++i) {
+        treeFree(pool, sonOf(pool, root, i));
+    }
+}
+
+/** @brief Buduje drzewo przekierowań z posortowanych par numerów.
+ * Wstawia numery w kolejności, w jakiej zwraca je @p iterator, schodząc
+ * w drzewie tylko od końca wspólnego prefiksu z poprzednim numerem.
+ * Wpisy drzewa odwróceń są przygotowywane i zapisywane w polach imHere węzłów.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in] iterator - funkcja zwracająca kolejne pary numerów
+ * @param[in] data - wskaźnik przekazywany funkcji @p iterator
+ * @param[out] entries - adres wskaźnika na tablicę wczytanych przekierowań
+ * @param[out] count - liczba wczytanych przekierowań
+ * @param[out] max_length - długość najdłuższego numeru, na który jest wykonywane przekierowanie
+ * @return Wartość @p true, jeśli wszystkie pary są poprawne, posortowane
+ *         i udało się alokować pamięć. Wartość @p false w przeciwnym przypadku.
+ */
+static bool bulkLoadForward(PhoneForward *pf, PhoneForwardPairIterator iterator, void *data,
+                            BulkEntry **entries, size_t *count, size_t *max_length) {
+    char *previous = NULL;
+    size_t previous_capacity = 0;
+    size_t previous_length = 0;
+    Node **path = NULL;
+    size_t path_capacity = 0;
+    size_t entries_capacity = 0;
+    char const *num1;
+    char const *num2;
+    bool result = true;
+
+    while (result && iterator(&num1, &num2, data)) {
+        if (!onlyDigitsAndNotEmpty(num1) || !onlyDigitsAndNotEmpty(num2) || !numbersDiffer(num1, num2)) {
+            result = false;
+            break;
+        }
+        size_t length1 = howLong(num1);
+        size_t length2 = howLong(num2);
+        if ((*count > 0) && (compareNumbers(previous, previous_length, num1, length1) >= 0)) {
+            result = false; // Numery nie są posortowane albo się powtarzają.
+            break;
+        }
+        if (!reserveArray((void **)&path, &path_capacity, length1 + 1, sizeof(*path))
+            || !reserveArray((void **)&previous, &previous_capacity, length1, sizeof(*previous))
+            || !reserveArray((void **)entries, &entries_capacity, *count + 1, sizeof(**entries))) {
+            result = false;
+            break;
+        }
+        size_t shared = commonPrefix(previous, previous_length, num1, length1);
+        if (*count == 0) {
+            path[0] = pf->forward;
+        }
+        Node *first_created = NULL;
+        Node *n = walkCreating(pf->pool, path, shared, numberHead(num1, length1), num1, length1, &first_created);
+        OneNumber *target = NULL;
+        if ((n == NULL) || ((n->list = newList()) == NULL)
+            || ((target = newPackedNumber(num2, length2)) == NULL)) {
+            result = false;
+            break;
+        }
+        appendElement(n->list, target);
+        markChanged(pf->pool, n);
+        if ((pf->reverse != NULL) && ((coldOf(pf->pool, n)->imHere = newPackedNumber(num1, length1)) == NULL)) {
+            result = false;
+            break;
+        }
+        if ((pf->reverse != NULL) && (length1 > pf->pool->longest_entry)) {
+            pf->pool->longest_entry = length1;
+        }
+        (*entries)[*count].node = n;
+        (*entries)[*count].source = coldOf(pf->pool, n)->imHere;
+        (*entries)[*count].head = packedHead(target->digits, length2);
+        ++(*count);
+        *max_length = (length2 > *max_length) ? length2 : *max_length;
+        memcpy(previous, num1, length1);
+        previous_length = length1;
+    }
+
+    free(previous);
+    free(path);
+    return result;
+}
+
+/** @brief Sortuje wczytane przekierowania według numerów, na które są wykonywane.
+ * Przy równych numerach rozstrzyga numer przekierowywany.
+ * @param[in,out] entries - tablica wczytanych przekierowań
+ * @param[in] count - liczba wczytanych przekierowań
+ * @return Liczba różnych niepustych prefiksów numerów, na które są wykonywane
+ *         przekierowania, czyli liczba węzłów, które @ref bulkLoadReverse
+ *         tworzy w pustych poddrzewach drzewa odwróceń.
+ */
+size_t sortReverseEntries(BulkEntry *entries, size_t count) {
+    if (count == 0) {
+        return 0; // Tablica może mieć wartość NULL.
+    }
+    qsort(entries, count, sizeof(*entries), compareBulkEntries);
+    size_t result = 0;
+    for (size_t i = 0; i < count; ++i) {
+        OneNumber const *target = (entries[i].node->list)->first;
+        size_t shared = 0;
+        if (i > 0) {
+            OneNumber const *previous = (entries[i - 1].node->list)->first;
+            shared = packedCommonPrefix(target, previous);
+        }
+        result += target->number_length - shared;
+    }
+    return result;
+}
+
+/** @brief Buduje drzewo odwróceń dla wczytanych przekierowań.
+ * Przechodzi przekierowania posortowane przez @ref sortReverseEntries,
+ * korzystając ze wspólnych prefiksów kolejnych numerów.
+ * Pola imHere węzłów i pola @p source przekierowań muszą wskazywać na
+ * przygotowane wpisy drzewa odwróceń. Wpisy trafiają do list węzłów w porządku
+ * rosnącym; górne ograniczenie ich długości w puli uaktualnia wywołujący.
+ * Zmienia jedynie poddrzewa korzenia drzewa odwróceń odpowiadające pierwszym
+ * cyfrom numerów z tablicy @p entries. Jeśli @p range nie ma wartości NULL,
+ * nie zmienia samej puli, więc wywołania dla rozłącznych poddrzew
+ * i rozłącznych przedziałów mogą działać jednocześnie.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in,out] range - wskaźnik na przedział indeksów, z którego są tworzone
+ *                        węzły, lub NULL, gdy węzły są brane wprost z puli
+ * @param[in] entries - posortowana tablica wczytanych przekierowań
+ * @param[in] count - liczba wczytanych przekierowań
+ * @param[in] max_length - długość najdłuższego numeru, na który jest wykonywane przekierowanie
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool bulkLoadReverse(PhoneForward *pf, NodeRange *range, BulkEntry const *entries, size_t count, size_t max_length) {
+    if (count == 0) {
+        return true;
+    }
+    Node **path = malloc((max_length + 1) * sizeof(*path));
+    if (path == NULL) {
+        return false;
+    }
+    path[0] = pf->reverse;
+    Node *r = NULL;
+    for (size_t i = 0; i < count; ++i) {
+        Node *n = entries[i].node;
+        OneNumber const *target = (n->list)->first;
+        size_t shared = 0;
+        if (i > 0) {
+            OneNumber const *previous = (entries[i - 1].node->list)->first;
+            shared = packedCommonPrefix(target, previous);
+            if ((shared < target->number_length) || (shared < previous->number_length)) {
+                r = NULL;
+            }
+        }
+        if ((r == NULL) && ((r = walkCreatingPacked(pf->pool, range, path, shared, target)) == NULL)) {
+            free(path);
+            return false;
+        }
+        if (((r->list == NULL) && ((r->list = newList()) == NULL)) || !reserveSorted(r->list, 1)) {
+            free(path);
+            return false;
+        }
+        insertSortedElement(r->list, entries[i].source);
+        coldOf(pf->pool, n)->infoAboutMe = r->index;
+    }
+    free(path);
+    return true;
+}
+
+/** @brief Wczytuje przekierowania do pustej struktury.
+ * Dodaje przekierowania z par numerów (num1, num2) zwracanych przez
+ * @p iterator, tak jak @ref phfwdAdd. Pary muszą być posortowane rosnąco
+ * według num1 w porządku leksykograficznym, w którym cyfra * następuje po 9,
+ * a cyfra # po *, i nie mogą powtarzać num1. Drzewo przekierowań jest
+ * budowane w jednym przejściu od lewej do prawej, a drzewo odwróceń
+ * w jednym przejściu po przekierowaniach posortowanych według num2.
+ * Jeśli funkcja zwróci @p false, struktura pozostaje pusta.
+ * @param[in,out] pf - wskaźnik na pustą strukturę przechowującą przekierowania numerów;
+ * @param[in] iterator - funkcja zwracająca kolejne pary numerów;
+ * @param[in] data - wskaźnik przekazywany funkcji @p iterator.
+ * @return Wartość @p true, jeśli wszystkie przekierowania zostały dodane.
+ *         Wartość @p false, jeśli struktura nie była pusta, któraś para
+ *         jest niepoprawna, pary nie są posortowane lub nie udało się
+ *         alokować pamięci.
+ */
+bool phfwdBulkLoad(PhoneForward *pf, PhoneForwardPairIterator iterator, void *data) {
+    if ((pf == NULL) || (pf->engine != NULL) || (iterator == NULL) || !isLeaf(pf->forward) || (pf->graveyard != NULL)) {
+        return false;
+    }
+    BulkEntry *entries = NULL;
+    size_t count = 0;
+    size_t max_length = 0;
+    bool result = bulkLoadForward(pf, iterator, data, &entries, &count, &max_length);
+    if (result && (pf->reverse != NULL)) {
+        sortReverseEntries(entries, count);
+        result = bulkLoadReverse(pf, NULL, entries, count, max_length);
+    }
+    if (!result) {
+        for (size_t i = 0; i < count; ++i) {
+            if (coldOf(pf->pool, entries[i].node)->infoAboutMe == 0) {
+                freeNumber(coldOf(pf->pool, entries[i].node)->imHere);
+            }
+        }
+        clearTree(pf->pool, pf->forward);
+        if (pf->reverse != NULL) {
+            clearTree(pf->pool, pf->reverse);
+        }
+    }
+    else if (pf->log != NULL) {
+        logForwards(pf->log, pf);
+    }
+    directIndexRebuild(pf->direct, pf->pool, pf->forward);
+    free(entries);
+    return result;
+}
@@ -0,0 +1,110 @@
+/** @file
+ * Interfejs klasy funkcji wykonujących wiele operacji na przekierowaniach naraz
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_BATCH_H__
+#define __PHFWD_BATCH_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+#include "list.h"
+
+/**
+ * To jest struktura opisująca jedno dodanie przekierowania wykonywane w paczce.
+ * Przechowuje węzły i pamięć przygotowane przed zmianą widocznego stanu struktury.
+ */
+typedef struct BatchAdd {
+    char const *num1; ///< prefiks numerów przekierowywanych
+    size_t length1; ///< długość prefiksu num1
+    uint64_t head1; ///< początek prefiksu num1 zapisany w słowie 64-bitowym
+    char const *num2; ///< prefiks numerów, na które jest wykonywane przekierowanie
+    size_t length2; ///< długość prefiksu num2
+    uint64_t head2; ///< początek prefiksu num2 zapisany w słowie 64-bitowym
+    Node *forward; ///< węzeł drzewa przekierowań odpowiadający num1
+    Node *reverse; ///< węzeł drzewa odwróceń odpowiadający num2
+    Node *created_forward; ///< pierwszy węzeł drzewa przekierowań utworzony dla tego dodania
+    Node *created_reverse; ///< pierwszy węzeł drzewa odwróceń utworzony dla tego dodania
+    OneNumber *forward_entry; ///< przygotowany wpis listy węzła drzewa przekierowań
+    OneNumber *reverse_entry; ///< przygotowany wpis listy węzła drzewa odwróceń
+    ListOfNumbers *forward_list; ///< przygotowana lista dla węzła drzewa przekierowań, jeśli jej nie miał
+    ListOfNumbers *reverse_list; ///< przygotowana lista dla węzła drzewa odwróceń, jeśli jej nie miał
+} BatchAdd;
+
+/**
+ * To jest struktura opisująca przekierowanie wczytane przez @ref phfwdBulkLoad.
+ */
+typedef struct BulkEntry {
+    uint64_t head; ///< początek numeru, na który jest wykonywane przekierowanie, w postaci zwróconej przez @ref packedHead
+    Node *node; ///< węzeł drzewa przekierowań
+    OneNumber *source; ///< przygotowany wpis drzewa odwróceń z numerem przekierowywanym
+} BulkEntry;
+
+/** @brief Porównuje 2 numery w porządku leksykograficznym wartości cyfr.
+ * Napisy muszą kończyć się znakiem '\0', ale nie wcześniej niż po podanej liczbie cyfr.
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] length1 - długość pierwszego numeru
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer
+ * @param[in] length2 - długość drugiego numeru
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
+ */
+int compareNumbers(char const *num1, size_t length1, char const *num2, size_t length2);
+
+/** @brief Zwraca długość najdłuższego wspólnego prefiksu dwóch numerów.
+ * Napisy muszą kończyć się znakiem '\0', ale nie wcześniej niż po podanej liczbie cyfr.
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] length1 - długość pierwszego numeru
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer
+ * @param[in] length2 - długość drugiego numeru
+ * @return Długość najdłuższego wspólnego prefiksu.
+ */
+size_t commonPrefix(char const *num1, size_t length1, char const *num2, size_t length2);
+
+/** @brief Zapewnia, że tablica ma miejsce na co najmniej @p needed elementów.
+ * @param[in,out] array - adres wskaźnika na tablicę
+ * @param[in,out] capacity - adres zmiennej przechowującej liczbę elementów, na które jest miejsce
+ * @param[in] needed - wymagana liczba elementów
+ * @param[in] size - rozmiar jednego elementu
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool reserveArray(void **array, size_t *capacity, size_t needed, size_t size);
+
+/** @brief Sortuje wczytane przekierowania według numerów, na które są wykonywane.
+ * Przy równych numerach rozstrzyga numer przekierowywany.
+ * @param[in,out] entries - tablica wczytanych przekierowań
+ * @param[in] count - liczba wczytanych przekierowań
+ * @return Liczba różnych niepustych prefiksów numerów, na które są wykonywane
+ *         przekierowania, czyli liczba węzłów, które @ref bulkLoadReverse
+ *         tworzy w pustych poddrzewach drzewa odwróceń.
+ */
+size_t sortReverseEntries(BulkEntry *entries, size_t count);
+
+/** @brief Buduje drzewo odwróceń dla wczytanych przekierowań.
+ * Przechodzi przekierowania posortowane przez @ref sortReverseEntries,
+ * korzystając ze wspólnych prefiksów kolejnych numerów.
+ * Pola imHere węzłów i pola @p source przekierowań muszą wskazywać na
+ * przygotowane wpisy drzewa odwróceń. Wpisy trafiają do list węzłów w porządku
+ * rosnącym; górne ograniczenie ich długości w puli uaktualnia wywołujący.
+ * Zmienia jedynie poddrzewa korzenia drzewa odwróceń odpowiadające pierwszym
+ * cyfrom numerów z tablicy @p entries. Jeśli @p range nie ma wartości NULL,
+ * nie zmienia samej puli, więc wywołania dla rozłącznych poddrzew
+ * i rozłącznych przedziałów mogą działać jednocześnie.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in,out] range - wskaźnik na przedział indeksów, z którego są tworzone
+ *                        węzły, lub NULL, gdy węzły są brane wprost z puli
+ * @param[in] entries - posortowana tablica wczytanych przekierowań
+ * @param[in] count - liczba wczytanych przekierowań
+ * @param[in] max_length - długość najdłuższego numeru, na który jest wykonywane przekierowanie
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool bulkLoadReverse(PhoneForward *pf, NodeRange *range, BulkEntry const *entries, size_t count, size_t max_length);
+
+#endif /* __PHFWD_BATCH_H__ */
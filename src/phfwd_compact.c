@@ -0,0 +1,322 @@
+/** @file
+ * Implementacja klasy funkcji układających węzły drzew w pamięci
+ *
+ * Węzły obu drzew leżą w puli i są wskazywane indeksami, więc przeniesienie
+ * węzła na inne miejsce puli wymaga jedynie poprawienia indeksów w jego
+ * rodzicu, synach i, dla węzłów drzewa odwróceń, w węzłach drzewa
+ * przekierowań, których wpisy przechowuje. Porządkowanie umieszcza kolejne
+ * węzły w porządku prefiksowym pod kolejnymi indeksami, zamieniając je
+ * miejscami z węzłami, które tam leżały. Tu są też funkcje przydzielające
+ * z góry i oddające pamięć puli.
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+#include "phfwd_auxiliary_functions.h"
+#include "phfwd_direct.h"
+#include "packed_number.h"
+#include "list.h"
+
+/** @brief Wyznacza indeks po zamianie miejscami dwóch węzłów.
+ * @param[in] index - indeks sprzed zamiany
+ * @param[in] from - indeks pierwszego z zamienianych węzłów
+ * @param[in] to - indeks drugiego z zamienianych węzłów
+ * @return Indeks po zamianie.
+ */
+static uint32_t swapped(uint32_t index, uint32_t from, uint32_t to) {
+    if (index == from) {
+        return to;
+    }
+    return (index == to) ? from : index;
+}
+
+/** @brief Wyznacza kolejny węzeł w porządku prefiksowym.
+ * Po ostatnim węźle drzewa przekierowań następuje korzeń drzewa odwróceń.
+ * Korzysta z pól parent zamiast stosu, więc nie alokuje pamięci.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in] n - wskaźnik na węzeł
+ * @return Wskaźnik na kolejny węzeł lub NULL, gdy @p n jest ostatni.
+ */
+static Node * nextInOrder(PhoneForward const *pf, Node *n) {
+    NodePool const *pool = pf->pool;
+    for (int i = 0; i < SONS; ++i) {
+        if ((n->sons)[i] != 0) {
+            return sonOf(pool, n, i);
+        }
+    }
+    Node *child = n;
+    Node *father = parentOf(pool, child);
+    while (father != NULL) {
+        for (int i = whichChild(pool, child) + 1; i < SONS; ++i) {
+            if ((father->sons)[i] != 0) {
+                return sonOf(pool, father, i);
+            }
+        }
+        child = father;
+        father = parentOf(pool, child);
+    }
+    return (child == pf->forward) ? pf->reverse : NULL;
+}
+
+/** @brief Sprawdza, czy węzeł należy do drzewa odwróceń.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in] n - wskaźnik na węzeł
+ * @return Wartość @p true, jeśli węzeł należy do drzewa odwróceń.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool inReverseTree(PhoneForward const *pf, Node *n) {
+    if (pf->reverse == NULL) {
+        return false;
+    }
+    Node *root = n;
+    Node *father;
+    while ((father = parentOf(pf->pool, root)) != NULL) {
+        root = father;
+    }
+    return root == pf->reverse;
+}
+
+/** @brief Szuka węzła drzewa wyznaczanego przez spakowany numer.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa
+ * @param[in] number - wskaźnik na spakowany numer
+ * @return Wskaźnik na znaleziony węzeł lub NULL, gdy takiego węzła nie ma.
+ */
+static Node * findPackedNode(NodePool const *pool, Node *root, OneNumber const *number) {
+    Node *help = root;
+    for (size_t i = 0; (help != NULL) && (i < number->number_length); ++i) {
+        help = sonOf(pool, help, packedDigitValue(number->digits, i));
+    }
+    return help;
+}
+
+/** @brief Zamienia w tablicy synów węzła indeksy zamienianych węzłów.
+ * @param[in,out] n - wskaźnik na węzeł
+ * @param[in] from - indeks pierwszego z zamienianych węzłów
+ * @param[in] to - indeks drugiego z zamienianych węzłów
+ */
+static void relabelSons(Node *n, uint32_t from, uint32_t to) {
+    for (int i = 0; i < SONS; ++i) {
+        (n->sons)[i] = swapped((n->sons)[i], from, to);
+    }
+}
+
+/** @brief Zamienia w danych węzła indeksy zamienianych węzłów.
+ * @param[in] pool - wskaźnik na pulę węzłów
+ * @param[in,out] n - wskaźnik na węzeł
+ * @param[in] from - indeks pierwszego z zamienianych węzłów
+ * @param[in] to - indeks drugiego z zamienianych węzłów
+ */
+static void relabel(NodePool const *pool, Node *n, uint32_t from, uint32_t to) {
+    relabelSons(n, from, to);
+    NodeCold *cold = coldOf(pool, n);
+    cold->parent = swapped(cold->parent, from, to);
+    cold->infoAboutMe = swapped(cold->infoAboutMe, from, to);
+}
+
+/** @brief Poprawia odwołania do przeniesionego węzła w jego rodzicu i synach.
+ * Odwołania z węzłów, które również zamieniono miejscami, zostały już
+ * poprawione przez @ref relabel. Rodzic może być wspólny dla obu
+ * zamienianych węzłów, więc jego tablica synów jest poprawiana tylko raz.
+ * @param[in] pool - wskaźnik na pulę węzłów
+ * @param[in] n - wskaźnik na przeniesiony węzeł
+ * @param[in] from - indeks pierwszego z zamienianych węzłów
+ * @param[in] to - indeks drugiego z zamienianych węzłów
+ * @param[in] skip_father - indeks rodzica, którego tablica synów została już poprawiona, lub 0
+ */
+static void fixLinks(NodePool const *pool, Node *n, uint32_t from, uint32_t to, uint32_t skip_father) {
+    uint32_t father = coldOf(pool, n)->parent;
+    if ((father != 0) && (father != from) && (father != to) && (father != skip_father)) {
+        relabelSons(nodeAt(pool, father), from, to);
+    }
+    for (int i = 0; i < SONS; ++i) {
+        uint32_t son = (n->sons)[i];
+        if ((son != 0) && (son != from) && (son != to)) {
+            coldAt(pool, son)->parent = n->index;
+        }
+    }
+}
+
+/** @brief Poprawia pola infoAboutMe węzłów wskazujących na przeniesiony węzeł drzewa odwróceń.
+ * Węzły drzewa przekierowań są wyznaczane przez numery z listy przeniesionego
+ * węzła. Nic nie robi dla węzłów drzewa przekierowań.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in] n - wskaźnik na przeniesiony węzeł
+ * @param[in] from - indeks pierwszego z zamienianych węzłów
+ * @param[in] to - indeks drugiego z zamienianych węzłów
+ */
+static void fixReverseEntries(PhoneForward *pf, Node *n, uint32_t from, uint32_t to) {
+    if ((n->list == NULL) || !inReverseTree(pf, n)) {
+        return;
+    }
+    for (OneNumber *element = n->list->first; element != NULL; element = element->next) {
+        Node *help = findPackedNode(pf->pool, pf->forward, element);
+        if ((help != NULL) && (help->index != from) && (help->index != to)) {
+            coldOf(pf->pool, help)->infoAboutMe = n->index;
+        }
+    }
+}
+
+/** @brief Przenosi węzeł pod dany indeks.
+ * Węzeł leżący pod indeksem @p to trafia na miejsce przenoszonego węzła,
+ * a jeśli był zwolniony, miejsce przenoszonego węzła zostaje zwolnione.
+ * Listy węzłów i ich wpisy nie są przenoszone, więc pola imHere pozostają ważne.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in] n - wskaźnik na przenoszony węzeł
+ * @param[in] to - indeks, pod który trafia węzeł
+ * @return Wskaźnik na węzeł po przeniesieniu.
+ */
+static Node * moveNode(PhoneForward *pf, Node *n, uint32_t to) {
+    NodePool *pool = pf->pool;
+    uint32_t from = n->index;
+    uint32_t forward = swapped(pf->forward->index, from, to);
+    uint32_t reverse = swapped(nodeIndex(pf->reverse), from, to);
+    Node *other = nodeAt(pool, to);
+    bool occupied = (other->index != 0);
+    if (!occupied) {
+        takeFreeNode(pool, to);
+    }
+
+    Node hot = *other;
+    *other = *n;
+    *n = hot;
+    NodeCold cold = *coldAt(pool, to);
+    *coldAt(pool, to) = *coldAt(pool, from);
+    *coldAt(pool, from) = cold;
+    other->index = to;
+    n->index = from;
+
+    relabel(pool, other, from, to);
+    fixLinks(pool, other, from, to, 0);
+    if (occupied) {
+        relabel(pool, n, from, to);
+        fixLinks(pool, n, from, to, coldOf(pool, other)->parent);
+    }
+    pf->forward = nodeAt(pool, forward);
+    pf->reverse = nodeAt(pool, reverse);
+    fixReverseEntries(pf, other, from, to);
+    if (occupied) {
+        fixReverseEntries(pf, n, from, to);
+    }
+    else {
+        freeNode(pool, n);
+    }
+    return other;
+}
+
+/** @brief Układa węzły drzew w pamięci w kolejności przechodzenia.
+ * Przenosi węzły drzewa przekierowań, a po nich węzły drzewa odwróceń, tak
+ * aby zajmowały kolejne miejsca w pamięci w porządku prefiksowym, w jakim
+ * przechodzą je wyszukiwania i przeglądanie. Po wielu dodaniach i usunięciach
+ * węzły sąsiednie w drzewie leżą wtedy znowu obok siebie, jak po wczytaniu
+ * struktury od nowa. Porządkowanie może być wykonywane po kawałku: każde
+ * wywołanie przenosi co najwyżej @p budget węzłów i kontynuuje od miejsca,
+ * w którym skończyło poprzednie. Jeśli drzewa zmieniły się między wywołaniami,
+ * porządkowanie zaczyna się od początku, ale węzły leżące już na swoich
+ * miejscach nie są przenoszone. Najpierw zwalnia, tak jak @ref phfwdReclaim,
+ * co najwyżej @p budget węzłów odłączonych przez usuwanie przyrostowe
+ * i porządkuje dopiero wtedy, gdy nie ma już takich węzłów. Nie alokuje pamięci.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] budget - maksymalna liczba przenoszonych węzłów; 0 oznacza wszystkie.
+ * @return Wartość @p true, jeśli wszystkie węzły leżą w kolejności przechodzenia.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdCompact(PhoneForward *pf, size_t budget) {
+    if ((pf == NULL) || (pf->engine != NULL)) {
+        return true;
+    }
+    if (!phfwdReclaim(pf, budget)) {
+        return false;
+    }
+    NodePool *pool = pf->pool;
+    if ((pf->compact_next == 0) || (pf->compact_changes != pool->changes)) {
+        pf->compact_next = 1; // Zaczynamy od początku.
+    }
+    Node *n = (pf->compact_next == 1) ? pf->forward : nextInOrder(pf, nodeAt(pool, pf->compact_next - 1));
+    size_t moved = 0;
+    while ((n != NULL) && ((budget == 0) || (moved < budget))) {
+        if (n->index != pf->compact_next) {
+            n = moveNode(pf, n, pf->compact_next);
+            ++moved;
+        }
+        ++(pf->compact_next);
+        n = nextInOrder(pf, n);
+    }
+    pf->compact_changes = pool->changes;
+    if (moved > 0) {
+        directIndexRebuild(pf->direct, pool, pf->forward);
+    }
+    return n == NULL;
+}
+
+/** @brief Prosi system o trzymanie węzłów drzew w dużych stronach pamięci.
+ * Włącza przezroczyste duże strony dla pamięci węzłów drzew struktury, także
+ * przydzielanej później. Węzły ułożone przez @ref phfwdCompact mieszczą się
+ * wtedy w mniejszej liczbie stron, co zmniejsza liczbę chybień w buforze TLB.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli system przyjął prośbę.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, struktura nie
+ *         przechowuje przekierowań w drzewie lub system nie obsługuje dużych stron.
+ */
+bool phfwdUseHugePages(PhoneForward *pf) {
+    if ((pf == NULL) || (pf->engine != NULL)) {
+        return false;
+    }
+    pf->pool->huge_pages = true;
+    bool result = true;
+    for (int i = 0; i < POOL_SEGMENTS; ++i) {
+        result = adviseSegment(pf->pool, i) && result;
+    }
+    return result;
+}
+
+/** @brief Przydziela z góry pamięć na węzły drzew i wpisy list.
+ * Tworzy segmenty puli mieszczące co najmniej @p nodes nowych węzłów drzew
+ * oraz przydziela węzły list na wpisy przekierowań i odwróceń zajmujące
+ * łącznie około @p bytes bajtów, tak aby późniejsze dodawanie przekierowań
+ * rzadziej alokowało pamięć. Węzły drzew i wpisy list zwolnione przez
+ * @ref phfwdRemove są używane ponownie przez @ref phfwdAdd, więc usuwanie
+ * i ponowne dodawanie przekierowań też rzadko alokuje i zwalnia pamięć.
+ * Zwolnionych wpisów list czeka na ponowne użycie ograniczona liczba; pozostałe
+ * są od razu oddawane alokatorowi.
+ * Dla struktury, która nie przechowuje przekierowań w drzewie, nic nie robi.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] nodes - liczba węzłów drzew;
+ * @param[in] bytes - liczba bajtów na wpisy list.
+ * @return Wartość @p true, jeśli pamięć została przydzielona.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, struktura nie
+ *         przechowuje przekierowań w drzewie lub nie udało się alokować
+ *         pamięci; pamięć przydzielona przed niepowodzeniem zostaje w strukturze.
+ */
+bool phfwdReserve(PhoneForward *pf, size_t nodes, size_t bytes) {
+    if ((pf == NULL) || (pf->engine != NULL)) {
+        return false;
+    }
+    return reserveNodes(pf->pool, nodes) && reserveNumbers(&pf->pool->numbers, bytes / sizeof(OneNumber));
+}
+
+/** @brief Oddaje systemowi nieużywaną pamięć struktury.
+ * Najpierw zwalnia, tak jak @ref phfwdReclaim, wszystkie węzły odłączone
+ * przez usuwanie przyrostowe. Potem zwalnia wpisy list czekające na ponowne
+ * użycie, segmenty puli węzłów, w których nie ma już żadnego węzła, i strony
+ * za ostatnim używanym węzłem. Najwięcej pamięci oddaje po pełnym
+ * uporządkowaniu drzew przez @ref phfwdCompact, które zbiera używane węzły
+ * na początku puli. Nie alokuje pamięci.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Liczba bajtów oddanych systemowi lub alokatorowi albo 0, gdy
+ *         parametr pf ma wartość NULL lub struktura nie przechowuje
+ *         przekierowań w drzewie.
+ */
+size_t phfwdTrim(PhoneForward *pf) {
+    if ((pf == NULL) || (pf->engine != NULL)) {
+        return 0;
+    }
+    phfwdReclaim(pf, 0);
+    return trimNodePool(pf->pool);
+}
@@ -0,0 +1,310 @@
+/** @file
+ * Implementacja klasy tablicy bezpośredniego dostępu do początku drzewa przekierowań
+ *
+ * Tablica ma 12^k pozycji, po jednej dla każdego prefiksu złożonego z k cyfr,
+ * tak jak pierwszy poziom tablic DIR-24-8 w routingu IP. Pozycja przechowuje
+ * węzeł drzewa wyznaczany przez prefiks oraz najdłuższe przekierowanie na
+ * jego ścieżce, więc wyszukiwanie zamiast k kroków po węzłach wykonuje jeden
+ * odczyt i schodzi dalej w drzewie od głębokości k.
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "phfwd_direct.h"
+#include "phfwd_traversal.h"
+#include "packed_number.h"
+
+/**
+ * To jest procent przekierowań, które mogą mieć prefiks krótszy niż
+ * głębokość tablicy. Takie przekierowania są powielane w wielu pozycjach.
+ */
+#define DIRECT_SHORT_PERCENT 10
+
+/**
+ * To jest największa liczba pozycji tablicy przypadająca na węzeł drzewa.
+ */
+#define DIRECT_ENTRIES_PER_NODE 4
+
+/** @brief Wyznacza liczbę pozycji tablicy danej głębokości.
+ * @param[in] depth - liczba cyfr indeksujących tablicę
+ * @return Liczba 12 do potęgi @p depth.
+ */
+static size_t directSize(size_t depth) {
+    size_t size = 1;
+    for (size_t i = 0; i < depth; ++i) {
+        size *= SONS;
+    }
+    return size;
+}
+
+/** @brief Wybiera głębokość tablicy na podstawie rozkładu długości przekierowywanych prefiksów.
+ * Wybiera największą głębokość, dla której co najwyżej
+ * @ref DIRECT_SHORT_PERCENT procent przekierowań ma krótszy prefiks, a tablica
+ * ma co najwyżej @ref DIRECT_ENTRIES_PER_NODE pozycji na węzeł drzewa.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ * @return Liczba z zakresu od 1 do @ref DIRECT_MAX_DEPTH lub 0, gdy nie udało
+ *         się alokować pamięci.
+ */
+size_t directChooseDepth(NodePool const *pool, Node *root) {
+    size_t counts[DIRECT_MAX_DEPTH + 1] = {0};
+    size_t forwards = 0;
+    size_t nodes = 0;
+    TrieWalk walk;
+    if (!walkStart(&walk, pool, root, NULL, 0)) {
+        return 0;
+    }
+    Node *n;
+    while ((n = walkNext(&walk)) != NULL) {
+        ++nodes;
+        if (n->list != NULL) {
+            size_t length = walkPathLength(&walk);
+            ++counts[(length < DIRECT_MAX_DEPTH) ? length : DIRECT_MAX_DEPTH];
+            ++forwards;
+        }
+    }
+    bool failed = walk.failed;
+    walkFinish(&walk);
+    if (failed) {
+        return 0;
+    }
+
+    size_t depth = 1;
+    size_t shorter = counts[1];
+    while ((depth < DIRECT_MAX_DEPTH) && (shorter * 100 <= forwards * DIRECT_SHORT_PERCENT)
+           && (directSize(depth + 1) <= nodes * DIRECT_ENTRIES_PER_NODE)) {
+        ++depth;
+        shorter += counts[depth];
+    }
+    return depth;
+}
+
+/** @brief Wypełnia pozycje tablicy odpowiadające poddrzewu węzła.
+ * @param[in,out] d - wskaźnik na tablicę
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] n - wskaźnik na węzeł lub NULL, gdy prefiksu nie ma w drzewie
+ * @param[in] level - głębokość węzła
+ * @param[in] index - wartość cyfr ścieżki węzła w systemie o podstawie 12
+ * @param[in] best - najgłębszy węzeł z przekierowaniem na ścieżce węzła lub NULL
+ * @param[in] best_depth - głębokość węzła @p best
+ */
+static void fillEntries(DirectIndex *d, NodePool const *pool, Node *n, size_t level, size_t index,
+                        Node *best, size_t best_depth) {
+    if (level == d->depth) {
+        DirectEntry *e = &(d->entries[index]);
+        e->node = n;
+        e->best = best;
+        e->best_depth = best_depth;
+        return;
+    }
+    for (size_t digit = 0; digit < SONS; ++digit) {
+        Node *son = (n != NULL) ? sonOf(pool, n, (int)digit) : NULL;
+        if ((son != NULL) && (son->list != NULL)) {
+            fillEntries(d, pool, son, level + 1, index * SONS + digit, son, level + 1);
+        }
+        else {
+            fillEntries(d, pool, son, level + 1, index * SONS + digit, best, best_depth);
+        }
+    }
+}
+
+/** @brief Tworzy tablicę bezpośredniego dostępu.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ * @param[in] depth - liczba cyfr indeksujących tablicę
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+DirectIndex * directIndexNew(NodePool const *pool, Node *root, size_t depth) {
+    DirectIndex *d = malloc(sizeof(*d));
+    if (d == NULL) {
+        return NULL;
+    }
+    d->depth = depth;
+    d->size = directSize(depth);
+    d->entries = malloc(d->size * sizeof(DirectEntry));
+    if (d->entries == NULL) {
+        free(d);
+        return NULL;
+    }
+    fillEntries(d, pool, root, 0, 0, NULL, 0);
+    return d;
+}
+
+/** @brief Usuwa tablicę bezpośredniego dostępu.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] d - wskaźnik na usuwaną strukturę
+ */
+void directIndexFree(DirectIndex *d) {
+    if (d != NULL) {
+        free(d->entries);
+        free(d);
+    }
+}
+
+/** @brief Wypełnia całą tablicę od nowa po zmianie wielu przekierowań.
+ * Nie alokuje pamięci. Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in,out] d - wskaźnik na strukturę
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ */
+void directIndexRebuild(DirectIndex *d, NodePool const *pool, Node *root) {
+    if (d != NULL) {
+        fillEntries(d, pool, root, 0, 0, NULL, 0);
+    }
+}
+
+/** @brief Uaktualnia pozycje tablicy po dodaniu lub usunięciu przekierowań z prefiksem @p num.
+ * Wypełnia od nowa pozycje prefiksów zaczynających się od pierwszych cyfr
+ * @p num, których jest tyle, ile wynosi głębokość tablicy, albo mniej, gdy
+ * numer jest krótszy. Nie alokuje pamięci. Nic nie robi, jeśli wskaźnik ma
+ * wartość NULL.
+ * @param[in,out] d - wskaźnik na strukturę
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ * @param[in] num - wskaźnik na napis reprezentujący zmieniony prefiks
+ * @param[in] length - długość prefiksu
+ */
+void directIndexRefresh(DirectIndex *d, NodePool const *pool, Node *root, char const *num, size_t length) {
+    if (d == NULL) {
+        return;
+    }
+    size_t level = (length < d->depth) ? length : d->depth;
+    Node *n = root;
+    Node *best = NULL;
+    size_t best_depth = 0;
+    size_t index = 0;
+    for (size_t i = 0; i < level; ++i) {
+        int digit = digitValue(num + i);
+        n = (n != NULL) ? sonOf(pool, n, digit) : NULL;
+        if ((n != NULL) && (n->list != NULL)) {
+            best = n;
+            best_depth = i + 1;
+        }
+        index = index * SONS + (size_t)digit;
+    }
+    fillEntries(d, pool, n, level, index, best, best_depth);
+}
+
+/** @brief Szuka najdłuższego prefiksu numeru, który ma przekierowanie.
+ * Działa tak jak @ref lookForModification, ale pierwsze cyfry numeru
+ * przechodzi jednym odczytem z tablicy.
+ * @param[in] d - wskaźnik na tablicę lub NULL, gdy jej nie ma
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ * @param[in, out] last_modification - wskaźnik na zmienną zawierającą adres węzła
+ * z najbardziej aktualnym przekierowaniem
+ * @param[in, out] how_many_digits_eaten - wskaźnik na zmienną zawierającą głębokość tego węzła
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - długość numeru
+ */
+void directLookup(DirectIndex const *d, NodePool const *pool, Node *root, Node **last_modification,
+                  size_t *how_many_digits_eaten, char const *num, size_t length) {
+    if ((d == NULL) || (length < d->depth)) {
+        lookForModification(pool, root, last_modification, how_many_digits_eaten, num);
+        return;
+    }
+    size_t index = 0;
+    for (size_t i = 0; i < d->depth; ++i) {
+        index = index * SONS + (size_t)digitValue(num + i);
+    }
+    DirectEntry const *e = &(d->entries[index]);
+    if (e->best != NULL) {
+        *last_modification = e->best;
+        *how_many_digits_eaten = e->best_depth;
+    }
+    Node *help = e->node;
+    for (size_t i = d->depth; (help != NULL) && (i < length); ++i) {
+        help = sonOf(pool, help, digitValue(num + i));
+        if ((help != NULL) && (help->list != NULL)) {
+            *last_modification = help;
+            *how_many_digits_eaten = i + 1;
+        }
+    }
+}
+
+/** @brief Szuka najdłuższego prefiksu spakowanego numeru, który ma przekierowanie.
+ * Działa tak jak @ref lookForModificationPacked, ale pierwsze cyfry numeru
+ * przechodzi jednym odczytem z tablicy.
+ * @param[in] d - wskaźnik na tablicę lub NULL, gdy jej nie ma
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ * @param[in, out] last_modification - wskaźnik na zmienną zawierającą adres węzła
+ * z najbardziej aktualnym przekierowaniem
+ * @param[in, out] how_many_digits_eaten - wskaźnik na zmienną zawierającą głębokość tego węzła
+ * @param[in] digits - wskaźnik na tablicę spakowanych cyfr numeru
+ * @param[in] length - długość numeru
+ */
+void directLookupPacked(DirectIndex const *d, NodePool const *pool, Node *root, Node **last_modification,
+                        size_t *how_many_digits_eaten, unsigned char const *digits, size_t length) {
+    if ((d == NULL) || (length < d->depth)) {
+        lookForModificationPacked(pool, root, last_modification, how_many_digits_eaten, digits, length);
+        return;
+    }
+    size_t index = 0;
+    for (size_t i = 0; i < d->depth; ++i) {
+        index = index * SONS + (size_t)packedDigitValue(digits, i);
+    }
+    DirectEntry const *e = &(d->entries[index]);
+    if (e->best != NULL) {
+        *last_modification = e->best;
+        *how_many_digits_eaten = e->best_depth;
+    }
+    Node *help = e->node;
+    for (size_t i = d->depth; (help != NULL) && (i < length); ++i) {
+        help = sonOf(pool, help, packedDigitValue(digits, i));
+        if ((help != NULL) && (help->list != NULL)) {
+            *last_modification = help;
+            *how_many_digits_eaten = i + 1;
+        }
+    }
+}
+
+/** @brief Buduje tablicę bezpośredniego dostępu do początku drzewa przekierowań.
+ * Tablica ma 12^k pozycji, po jednej dla każdego ciągu k pierwszych cyfr.
+ * Pozycja przechowuje najdłuższe przekierowanie z prefiksem tych cyfr i węzeł
+ * drzewa, od którego wyszukiwanie jest kontynuowane, więc @ref phfwdGet oraz
+ * @ref phfwdGetReverse dla numerów o co najmniej k cyfrach pomijają k kroków
+ * w drzewie. Tablica jest uaktualniana przez wszystkie funkcje zmieniające
+ * przekierowania. Jeśli @p depth ma wartość 0, k jest wybierane na podstawie
+ * rozkładu długości przekierowywanych prefiksów i liczby węzłów drzewa.
+ * Zastępuje wcześniej zbudowaną tablicę.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] depth  - liczba cyfr k od 1 do 5 lub 0, aby wybrać ją automatycznie.
+ * @return Wartość @p true, jeśli tablica została zbudowana.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, struktura jest
+ *         przechowywana w pliku, @p depth jest większe niż 5 lub nie udało się
+ *         alokować pamięci; wtedy struktura pozostaje bez zmian.
+ */
+bool phfwdBuildDirectIndex(PhoneForward *pf, size_t depth) {
+    if ((pf == NULL) || (pf->engine != NULL) || (depth > DIRECT_MAX_DEPTH)) {
+        return false;
+    }
+    if (depth == 0) {
+        depth = directChooseDepth(pf->pool, pf->forward);
+        if (depth == 0) {
+            return false;
+        }
+    }
+    DirectIndex *d = directIndexNew(pf->pool, pf->forward, depth);
+    if (d == NULL) {
+        return false;
+    }
+    directIndexFree(pf->direct);
+    pf->direct = d;
+    return true;
+}
+
+/** @brief Zwraca głębokość tablicy bezpośredniego dostępu.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Liczba cyfr indeksujących tablicę lub 0, gdy struktura jej nie ma
+ *         albo parametr pf ma wartość NULL.
+ */
+size_t phfwdDirectIndexDepth(PhoneForward const *pf) {
+    return ((pf != NULL) && (pf->direct != NULL)) ? pf->direct->depth : 0;
+}
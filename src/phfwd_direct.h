@@ -0,0 +1,113 @@
+/** @file
+ * Interfejs klasy tablicy bezpośredniego dostępu do początku drzewa przekierowań
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_DIRECT_H__
+#define __PHFWD_DIRECT_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+#include "phfwd_auxiliary_functions.h"
+
+/**
+ * To jest największa liczba cyfr indeksujących tablicę bezpośredniego dostępu.
+ */
+#define DIRECT_MAX_DEPTH 5
+
+/**
+ * To jest pozycja tablicy bezpośredniego dostępu odpowiadająca jednemu
+ * prefiksowi długości równej głębokości tablicy.
+ */
+typedef struct DirectEntry {
+    Node *node; ///< węzeł drzewa przekierowań wyznaczany przez prefiks lub NULL, gdy go nie ma
+    Node *best; ///< najgłębszy węzeł z przekierowaniem na ścieżce prefiksu lub NULL, gdy go nie ma
+    size_t best_depth; ///< głębokość węzła @p best
+} DirectEntry;
+
+/**
+ * To jest tablica bezpośredniego dostępu do początku drzewa przekierowań.
+ */
+typedef struct DirectIndex {
+    size_t depth; ///< liczba cyfr indeksujących tablicę
+    size_t size; ///< liczba pozycji, równa 12 do potęgi @p depth
+    DirectEntry *entries; ///< pozycje uporządkowane według wartości cyfr prefiksów
+} DirectIndex;
+
+/** @brief Wybiera głębokość tablicy na podstawie rozkładu długości przekierowywanych prefiksów.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ * @return Liczba z zakresu od 1 do @ref DIRECT_MAX_DEPTH lub 0, gdy nie udało
+ *         się alokować pamięci.
+ */
+size_t directChooseDepth(NodePool const *pool, Node *root);
+
+/** @brief Tworzy tablicę bezpośredniego dostępu.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ * @param[in] depth - liczba cyfr indeksujących tablicę
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+DirectIndex * directIndexNew(NodePool const *pool, Node *root, size_t depth);
+
+/** @brief Usuwa tablicę bezpośredniego dostępu.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] d - wskaźnik na usuwaną strukturę
+ */
+void directIndexFree(DirectIndex *d);
+
+/** @brief Wypełnia całą tablicę od nowa po zmianie wielu przekierowań.
+ * Nie alokuje pamięci. Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in,out] d - wskaźnik na strukturę
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ */
+void directIndexRebuild(DirectIndex *d, NodePool const *pool, Node *root);
+
+/** @brief Uaktualnia pozycje tablicy po dodaniu lub usunięciu przekierowań z prefiksem @p num.
+ * Nie alokuje pamięci. Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in,out] d - wskaźnik na strukturę
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ * @param[in] num - wskaźnik na napis reprezentujący zmieniony prefiks
+ * @param[in] length - długość prefiksu
+ */
+void directIndexRefresh(DirectIndex *d, NodePool const *pool, Node *root, char const *num, size_t length);
+
+/** @brief Szuka najdłuższego prefiksu numeru, który ma przekierowanie.
+ * Działa tak jak @ref lookForModification, ale pierwsze cyfry numeru
+ * przechodzi jednym odczytem z tablicy.
+ * @param[in] d - wskaźnik na tablicę lub NULL, gdy jej nie ma
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ * @param[in, out] last_modification - wskaźnik na zmienną zawierającą adres węzła
+ * z najbardziej aktualnym przekierowaniem
+ * @param[in, out] how_many_digits_eaten - wskaźnik na zmienną zawierającą głębokość tego węzła
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - długość numeru
+ */
+void directLookup(DirectIndex const *d, NodePool const *pool, Node *root, Node **last_modification,
+                  size_t *how_many_digits_eaten, char const *num, size_t length);
+
+/** @brief Szuka najdłuższego prefiksu spakowanego numeru, który ma przekierowanie.
+ * Działa tak jak @ref lookForModificationPacked, ale pierwsze cyfry numeru
+ * przechodzi jednym odczytem z tablicy.
+ * @param[in] d - wskaźnik na tablicę lub NULL, gdy jej nie ma
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa przekierowań
+ * @param[in, out] last_modification - wskaźnik na zmienną zawierającą adres węzła
+ * z najbardziej aktualnym przekierowaniem
+ * @param[in, out] how_many_digits_eaten - wskaźnik na zmienną zawierającą głębokość tego węzła
+ * @param[in] digits - wskaźnik na tablicę spakowanych cyfr numeru
+ * @param[in] length - długość numeru
+ */
+void directLookupPacked(DirectIndex const *d, NodePool const *pool, Node *root, Node **last_modification,
+                        size_t *how_many_digits_eaten, unsigned char const *digits, size_t length);
+
+#endif /* __PHFWD_DIRECT_H__ */
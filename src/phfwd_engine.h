@@ -0,0 +1,45 @@
+/** @file
+ * Interfejs silników przechowujących przekierowania zamiast drzewa
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_ENGINE_H__
+#define __PHFWD_ENGINE_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+
+/**
+ * To jest tablica funkcji silnika przechowującego przekierowania zamiast
+ * drzewa węzłów. Każda funkcja otrzymuje stan silnika przekazany do
+ * @ref phfwdNewWithEngine i działa tak jak odpowiadająca jej funkcja
+ * interfejsu, która sprawdziła już, że struktura nie ma wartości NULL.
+ */
+typedef struct PhoneForwardEngine {
+    char const *name; ///< nazwa silnika
+    bool (*add)(void *data, char const *num1, char const *num2); ///< funkcja wywoływana przez @ref phfwdAdd
+    bool (*remove)(void *data, char const *num); ///< funkcja wywoływana przez @ref phfwdRemove
+    PhoneNumbers * (*get)(void *data, char const *num); ///< funkcja wywoływana przez @ref phfwdGet
+    PhoneNumbers * (*reverse)(void *data, char const *num); ///< funkcja wywoływana przez @ref phfwdReverse
+    PhoneNumbers * (*get_reverse)(void *data, char const *num); ///< funkcja wywoływana przez @ref phfwdGetReverse
+    void (*close)(void *data); ///< funkcja zwalniająca stan silnika, wywoływana przez @ref phfwdDelete
+} PhoneForwardEngine;
+
+/** @brief Tworzy strukturę, której przekierowania przechowuje silnik.
+ * Funkcje paczek, migawek, dziennika, przeglądania i publikowania zwracają
+ * dla takiej struktury @p false lub NULL.
+ * @param[in] engine - wskaźnik na tablicę funkcji silnika
+ * @param[in] data - wskaźnik na stan silnika, który przechodzi na własność
+ *                   struktury; jest zwalniany przez @p engine->close także
+ *                   wtedy, gdy nie udało się utworzyć struktury
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+PhoneForward * phfwdNewWithEngine(PhoneForwardEngine const *engine, void *data);
+
+#endif /* __PHFWD_ENGINE_H__ */
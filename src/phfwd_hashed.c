@@ -0,0 +1,1268 @@
+/** @file
+ * Implementacja klasy przekierowań przechowywanych w tablicach haszujących
+ *
+ * Przekierowania są trzymane w tablicy haszującej z adresowaniem otwartym,
+ * której kluczem jest para (długość prefiksu, spakowany prefiks). Najdłuższy
+ * prefiks numeru mający przekierowanie jest szukany binarnie po długościach
+ * (metoda Waldvogla). Długości tworzą ustalone drzewo poszukiwań binarnych
+ * nad przedziałem od 1 do @p universe, a każde przekierowanie zostawia
+ * znaczniki w tych węzłach swojej ścieżki, w których wyszukiwanie musi pójść
+ * w prawo. Znacznik pamięta długość najdłuższego przekierowania będącego jego
+ * prefiksem; jest ona wyznaczana przy pierwszym użyciu po zmianie zbioru
+ * przekierowań.
+ *
+ * Każda długość ma własny filtr Blooma kluczy tej długości, więc długości bez
+ * kluczy i większość nietrafionych prefiksów są odrzucane bez odczytu tablicy.
+ * Odwrócenia korzystają z drugiej tablicy haszującej, której kluczem jest
+ * numer docelowy, a wartością zbiór przekierowań na ten numer.
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phfwd_hashed.h"
+#include "phfwd_engine.h"
+#include "phfwd_auxiliary_functions.h"
+#include "phfwd_batch.h"
+#include "phfwd_iterator.h"
+#include "phfwd_simd.h"
+#include "packed_number.h"
+#include "list.h"
+
+/**
+ * To jest najmniejsza liczba pozycji tablicy haszującej.
+ */
+#define HASHED_MIN_CAPACITY 64
+
+/**
+ * To jest największy procent zajętych pozycji tablicy (razem ze zwolnionymi).
+ */
+#define HASHED_MAX_LOAD_PERCENT 70
+
+/**
+ * To jest początkowy zakres długości prefiksów, równy 2 do potęgi 5 minus 1.
+ */
+#define HASHED_MIN_UNIVERSE 31
+
+/**
+ * To jest największa liczba znaczników jednego przekierowania, czyli głębokość
+ * drzewa długości dla zakresu mieszczącego się w typie @p size_t.
+ */
+#define HASHED_MAX_MARKERS 64
+
+/**
+ * To jest liczba bitów filtra Blooma przypadająca na klucz.
+ */
+#define BLOOM_BITS_PER_KEY 16
+
+/**
+ * To jest najmniejsza liczba bitów filtra Blooma.
+ */
+#define BLOOM_MIN_BITS 64
+
+/**
+ * To jest liczba bitów filtra Blooma ustawianych dla jednego klucza.
+ */
+#define BLOOM_HASHES 3
+
+/**
+ * To jest najmniejsza liczba usuniętych kluczy, po której filtr jest budowany od nowa.
+ */
+#define BLOOM_STALE_MIN 64
+
+/**
+ * To jest początkowa wartość skrótu prefiksu.
+ */
+#define HASH_SEED 0xCBF29CE484222325ULL
+
+/**
+ * To jest liczba początkowych cyfr prefiksu, według których przekierowania
+ * są grupowane na potrzeby @ref hashedRemove.
+ */
+#define HASHED_GROUP_DIGITS 4
+
+/**
+ * To są rodzaje zbiorów, do których należy każde przekierowanie.
+ */
+enum {
+    BY_TARGET, ///< zbiór przekierowań na ten sam numer
+    BY_GROUP, ///< zbiór przekierowań o tych samych początkowych cyfrach prefiksu
+    MEMBERSHIPS ///< liczba rodzajów zbiorów
+};
+
+struct SourceSet;
+
+/**
+ * To jest przynależność przekierowania do zbioru.
+ */
+typedef struct Membership {
+    struct SourceSet *set; ///< zbiór zawierający przekierowanie
+    size_t position; ///< pozycja przekierowania w zbiorze @p set
+} Membership;
+
+/**
+ * To jest przekierowanie przechowywane w tablicy.
+ */
+typedef struct HashedForward {
+    char *source; ///< prefiks numerów przekierowywanych
+    size_t source_length; ///< długość prefiksu @p source
+    char *target; ///< prefiks numerów, na które jest wykonywane przekierowanie
+    size_t target_length; ///< długość prefiksu @p target
+    Membership member[MEMBERSHIPS]; ///< zbiory zawierające przekierowanie, indeksowane ich rodzajem
+} HashedForward;
+
+/**
+ * To jest zbiór przekierowań o wspólnym kluczu.
+ */
+typedef struct SourceSet {
+    HashedForward **items; ///< tablica przekierowań w dowolnej kolejności
+    size_t count; ///< liczba przekierowań
+    size_t capacity; ///< liczba przekierowań, na które jest miejsce
+    uint64_t hash; ///< skrót klucza, pod którym zbiór jest w swojej tablicy
+} SourceSet;
+
+/**
+ * To jest pozycja tablicy haszującej.
+ */
+typedef struct HashSlot {
+    unsigned char *digits; ///< spakowany klucz lub NULL, gdy pozycja jest wolna
+    bool deleted; ///< czy pozycja została zwolniona po usunięciu klucza
+    size_t length; ///< długość klucza
+    uint64_t hash; ///< skrót klucza
+    void *value; ///< przekierowanie, zbiór przekierowań lub NULL, gdy pozycja jest tylko znacznikiem
+    size_t markers; ///< liczba przekierowań, których ścieżka ma znacznik w tej pozycji
+    size_t best; ///< długość najdłuższego przekierowania będącego prefiksem znacznika
+    uint64_t best_epoch; ///< numer zmiany, dla której wyznaczono @p best
+} HashSlot;
+
+/**
+ * To jest tablica haszująca z adresowaniem otwartym.
+ */
+typedef struct HashMap {
+    HashSlot *slots; ///< pozycje tablicy
+    size_t capacity; ///< liczba pozycji, będąca potęgą dwójki lub zerem
+    size_t used; ///< liczba pozycji zajętych lub zwolnionych
+    size_t live; ///< liczba pozycji zajętych
+} HashMap;
+
+/**
+ * To jest filtr Blooma kluczy jednej długości.
+ */
+typedef struct Bloom {
+    uint64_t *bits; ///< bity filtra lub NULL, gdy nie udało się ich alokować
+    size_t mask; ///< liczba bitów filtra pomniejszona o 1
+    size_t keys; ///< liczba kluczy tej długości w tablicy
+    size_t inserted; ///< liczba kluczy zapisanych w filtrze od jego zbudowania
+} Bloom;
+
+/**
+ * To jest numer przygotowany do wyszukiwania w tablicy.
+ */
+typedef struct Query {
+    unsigned char *packed; ///< spakowane cyfry numeru
+    size_t packed_capacity; ///< liczba bajtów, na które jest miejsce w @p packed
+    uint64_t *hashes; ///< skróty prefiksów numeru indeksowane ich długością
+    size_t hashes_capacity; ///< liczba skrótów, na które jest miejsce w @p hashes
+    size_t length; ///< długość numeru
+} Query;
+
+/**
+ * To jest struktura przekierowań przechowywanych w tablicach haszujących.
+ */
+struct HashedTable {
+    HashMap forward; ///< przekierowania i znaczniki
+    HashMap reverse; ///< zbiory przekierowań według numeru docelowego
+    HashMap groups; ///< zbiory przekierowań według @ref HASHED_GROUP_DIGITS początkowych cyfr prefiksu
+    Bloom *blooms; ///< filtry Blooma indeksowane długością klucza, od 0 do @p universe
+    size_t universe; ///< największa długość klucza, równa potędze dwójki minus 1
+    uint64_t epoch; ///< numer zmiany zbioru przekierowań
+    Query query; ///< numer zapytania
+    Query other; ///< drugi numer operacji
+    char *text; ///< bufor wyniku
+    size_t text_capacity; ///< liczba znaków, na które jest miejsce w @p text
+};
+
+/** @brief Dopisuje cyfrę do skrótu prefiksu.
+ * @param[in] state - skrót prefiksu przed dopisaniem cyfry
+ * @param[in] value - wartość cyfry
+ * @return Skrót prefiksu po dopisaniu cyfry.
+ */
+static uint64_t hashStep(uint64_t state, int value) {
+    return (state ^ (uint64_t)(value + 1)) * 0x100000001B3ULL;
+}
+
+/** @brief Wyznacza skrót klucza z ostatecznym wymieszaniem bitów.
+ * @param[in] state - skrót prefiksu
+ * @param[in] length - długość prefiksu
+ * @return Skrót klucza.
+ */
+static uint64_t hashFinish(uint64_t state, size_t length) {
+    uint64_t h = state ^ ((uint64_t)length * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/** @brief Przygotowuje numer do wyszukiwania.
+ * @param[in,out] q - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - długość numeru
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool prepareQuery(Query *q, char const *num, size_t length) {
+    if (!reserveArray((void **)&q->packed, &q->packed_capacity, packedSize(length), sizeof(unsigned char))
+        || !reserveArray((void **)&q->hashes, &q->hashes_capacity, length + 1, sizeof(uint64_t))) {
+        return false;
+    }
+    encodePacked(q->packed, num, length);
+    uint64_t state = HASH_SEED;
+    q->hashes[0] = 0;
+    for (size_t i = 0; i < length; ++i) {
+        state = hashStep(state, digitValue(num + i));
+        q->hashes[i + 1] = hashFinish(state, i + 1);
+    }
+    q->length = length;
+    return true;
+}
+
+/** @brief Sprawdza, czy klucz jest równy prefiksowi spakowanego numeru.
+ * @param[in] digits - wskaźnik na spakowany klucz
+ * @param[in] packed - wskaźnik na spakowany numer
+ * @param[in] length - długość klucza
+ * @return Wartość @p true, jeśli pierwsze @p length cyfr jest równych.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool keysEqual(unsigned char const *digits, unsigned char const *packed, size_t length) {
+    size_t whole = length / 2;
+    if (memcmp(digits, packed, whole) != 0) {
+        return false;
+    }
+    return (length % 2 == 0) || (((digits[whole] ^ packed[whole]) & 0xF0) == 0);
+}
+
+/** @brief Tworzy spakowaną kopię prefiksu spakowanego numeru.
+ * @param[in] packed - wskaźnik na spakowany numer
+ * @param[in] length - długość kopiowanego prefiksu
+ * @return Wskaźnik na kopię lub NULL, gdy nie udało się alokować pamięci.
+ */
+static unsigned char * copyPrefix(unsigned char const *packed, size_t length) {
+    size_t size = packedSize(length);
+    unsigned char *digits = malloc(size);
+    if (digits != NULL) {
+        memcpy(digits, packed, size);
+        if (length % 2 == 1) {
+            digits[size - 1] &= 0xF0;
+        }
+    }
+    return digits;
+}
+
+/** @brief Szuka klucza w tablicy.
+ * @param[in] map - wskaźnik na tablicę
+ * @param[in] hash - skrót klucza
+ * @param[in] length - długość klucza
+ * @param[in] packed - wskaźnik na spakowany numer, którego prefiksem jest klucz
+ * @return Wskaźnik na pozycję klucza lub NULL, gdy go nie ma.
+ */
+static HashSlot * mapFind(HashMap const *map, uint64_t hash, size_t length, unsigned char const *packed) {
+    if (map->capacity == 0) {
+        return NULL;
+    }
+    size_t mask = map->capacity - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        HashSlot *s = &map->slots[i];
+        if (s->digits == NULL) {
+            if (!s->deleted) {
+                return NULL;
+            }
+        }
+        else if ((s->hash == hash) && (s->length == length) && keysEqual(s->digits, packed, length)) {
+            return s;
+        }
+    }
+}
+
+/** @brief Szuka pozycji o danej wartości.
+ * @param[in] map - wskaźnik na tablicę
+ * @param[in] hash - skrót klucza pozycji
+ * @param[in] value - wartość pozycji
+ * @return Wskaźnik na pozycję lub NULL, gdy jej nie ma.
+ */
+static HashSlot * mapFindValue(HashMap const *map, uint64_t hash, void const *value) {
+    size_t mask = map->capacity - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        HashSlot *s = &map->slots[i];
+        if ((s->digits == NULL) && !s->deleted) {
+            return NULL;
+        }
+        if ((s->digits != NULL) && (s->value == value)) {
+            return s;
+        }
+    }
+}
+
+/** @brief Wstawia do tablicy klucz, którego w niej nie ma.
+ * Tablica musi mieć miejsce zapewnione przez @ref mapReserve.
+ * @param[in,out] map - wskaźnik na tablicę
+ * @param[in] hash - skrót klucza
+ * @param[in] length - długość klucza
+ * @param[in] digits - wskaźnik na spakowany klucz, który przechodzi na własność tablicy
+ * @param[in] value - wartość pozycji
+ * @return Wskaźnik na pozycję klucza.
+ */
+static HashSlot * mapInsert(HashMap *map, uint64_t hash, size_t length, unsigned char *digits, void *value) {
+    size_t mask = map->capacity - 1;
+    size_t i = hash & mask;
+    while (map->slots[i].digits != NULL) {
+        i = (i + 1) & mask;
+    }
+    HashSlot *s = &map->slots[i];
+    if (!s->deleted) {
+        ++map->used;
+    }
+    ++map->live;
+    s->digits = digits;
+    s->deleted = false;
+    s->length = length;
+    s->hash = hash;
+    s->value = value;
+    s->markers = 0;
+    s->best = 0;
+    s->best_epoch = 0;
+    return s;
+}
+
+/** @brief Usuwa pozycję z tablicy.
+ * Pozycja zostaje oznaczona jako zwolniona, więc pozostałe pozycje nie są
+ * przesuwane.
+ * @param[in,out] map - wskaźnik na tablicę
+ * @param[in,out] s - wskaźnik na pozycję
+ */
+static void mapErase(HashMap *map, HashSlot *s) {
+    free(s->digits);
+    s->digits = NULL;
+    s->deleted = true;
+    s->value = NULL;
+    --map->live;
+}
+
+/** @brief Zapewnia, że do tablicy można wstawić @p extra kluczy bez przebudowy.
+ * Przebudowa usuwa zwolnione pozycje i zmienia adresy wszystkich pozycji.
+ * @param[in,out] map - wskaźnik na tablicę
+ * @param[in] extra - liczba wstawianych kluczy
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku; wtedy tablica pozostaje bez zmian.
+ */
+static bool mapReserve(HashMap *map, size_t extra) {
+    if ((map->used + extra) * 100 <= map->capacity * HASHED_MAX_LOAD_PERCENT) {
+        return true;
+    }
+    size_t capacity = HASHED_MIN_CAPACITY;
+    while ((map->live + extra) * 200 > capacity * HASHED_MAX_LOAD_PERCENT) {
+        capacity *= 2;
+    }
+    HashSlot *slots = calloc(capacity, sizeof(HashSlot));
+    if (slots == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < map->capacity; ++i) {
+        if (map->slots[i].digits != NULL) {
+            size_t j = map->slots[i].hash & (capacity - 1);
+            while (slots[j].digits != NULL) {
+                j = (j + 1) & (capacity - 1);
+            }
+            slots[j] = map->slots[i];
+        }
+    }
+    free(map->slots);
+    map->slots = slots;
+    map->capacity = capacity;
+    map->used = map->live;
+    return true;
+}
+
+/** @brief Wyznacza długości znaczników ścieżki klucza.
+ * @param[in] universe - największa długość klucza
+ * @param[in] length - długość klucza
+ * @param[out] markers - tablica na co najmniej @ref HASHED_MAX_MARKERS rosnących długości
+ * @return Liczba znaczników.
+ */
+static size_t markerLengths(size_t universe, size_t length, size_t *markers) {
+    size_t count = 0;
+    size_t lo = 1;
+    size_t hi = universe;
+    while (lo <= hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (mid == length) {
+            break;
+        }
+        if (mid < length) {
+            markers[count++] = mid;
+            lo = mid + 1;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+    return count;
+}
+
+/** @brief Wyznacza skróty prefiksów numeru o rosnących długościach.
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] lengths - tablica rosnących długości prefiksów
+ * @param[in] count - liczba prefiksów
+ * @param[out] hashes - tablica na @p count skrótów
+ */
+static void prefixHashes(char const *num, size_t const *lengths, size_t count, uint64_t *hashes) {
+    uint64_t state = HASH_SEED;
+    size_t done = 0;
+    for (size_t i = 0; i < count; ++i) {
+        while (done < lengths[i]) {
+            state = hashStep(state, digitValue(num + done));
+            ++done;
+        }
+        hashes[i] = hashFinish(state, lengths[i]);
+    }
+}
+
+/** @brief Wyznacza rozmiar filtra Blooma dla danej liczby kluczy.
+ * @param[in] keys - liczba kluczy
+ * @return Liczba bitów filtra, będąca potęgą dwójki.
+ */
+static size_t bloomBits(size_t keys) {
+    size_t bits = BLOOM_MIN_BITS;
+    while (bits < keys * BLOOM_BITS_PER_KEY * 2) {
+        bits *= 2;
+    }
+    return bits;
+}
+
+/** @brief Zapisuje klucz w filtrze Blooma.
+ * @param[in,out] b - wskaźnik na filtr z alokowanymi bitami
+ * @param[in] hash - skrót klucza
+ */
+static void bloomSet(Bloom *b, uint64_t hash) {
+    uint64_t step = (hash >> 32) | 1;
+    for (int k = 0; k < BLOOM_HASHES; ++k) {
+        uint64_t bit = (hash + k * step) & b->mask;
+        b->bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+    }
+    ++b->inserted;
+}
+
+/** @brief Sprawdza, czy klucz może być w tablicy.
+ * @param[in] b - wskaźnik na filtr
+ * @param[in] hash - skrót klucza
+ * @return Wartość @p false, jeśli klucza na pewno nie ma.
+ *         Wartość @p true w przeciwnym przypadku.
+ */
+static bool bloomMaybe(Bloom const *b, uint64_t hash) {
+    if (b->keys == 0) {
+        return false;
+    }
+    if (b->bits == NULL) {
+        return true;
+    }
+    uint64_t step = (hash >> 32) | 1;
+    for (int k = 0; k < BLOOM_HASHES; ++k) {
+        uint64_t bit = (hash + k * step) & b->mask;
+        if (((b->bits[bit / 64] >> (bit % 64)) & 1) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Buduje od nowa filtr Blooma kluczy jednej długości.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] length - długość kluczy
+ * @param[in] bits - liczba bitów filtra, będąca potęgą dwójki
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku; wtedy filtr pozostaje bez zmian.
+ */
+static bool bloomRefill(HashedTable *h, size_t length, size_t bits) {
+    uint64_t *words = calloc(bits / 64, sizeof(uint64_t));
+    if (words == NULL) {
+        return false;
+    }
+    Bloom *b = &h->blooms[length];
+    free(b->bits);
+    b->bits = words;
+    b->mask = bits - 1;
+    b->inserted = 0;
+    for (size_t i = 0; i < h->forward.capacity; ++i) {
+        HashSlot const *s = &h->forward.slots[i];
+        if ((s->digits != NULL) && (s->length == length)) {
+            bloomSet(b, s->hash);
+        }
+    }
+    return true;
+}
+
+/** @brief Uwzględnia w filtrze klucz wstawiony do tablicy przekierowań.
+ * Gdy filtr jest pełny, buduje go od nowa w dwukrotnie większym rozmiarze.
+ * Jeśli nie uda się alokować pamięci, filtr przepuszcza więcej kluczy, ale
+ * nadal nie odrzuca żadnego z tych, które są w tablicy.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] s - wskaźnik na pozycję wstawionego klucza
+ */
+static void bloomAdd(HashedTable *h, HashSlot const *s) {
+    Bloom *b = &h->blooms[s->length];
+    ++b->keys;
+    if ((b->bits != NULL) && ((b->inserted + 1) * BLOOM_BITS_PER_KEY <= b->mask + 1)) {
+        bloomSet(b, s->hash);
+    }
+    else if (!bloomRefill(h, s->length, bloomBits(b->keys)) && (b->bits != NULL)) {
+        bloomSet(b, s->hash);
+    }
+}
+
+/** @brief Uwzględnia w filtrze klucz usunięty z tablicy przekierowań.
+ * Gdy w filtrze jest więcej usuniętych kluczy niż obecnych, buduje go od nowa.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] length - długość usuniętego klucza
+ */
+static void bloomRemove(HashedTable *h, size_t length) {
+    Bloom *b = &h->blooms[length];
+    --b->keys;
+    size_t stale = b->inserted - b->keys;
+    if (b->keys == 0) {
+        free(b->bits);
+        b->bits = NULL;
+        b->mask = 0;
+        b->inserted = 0;
+    }
+    else if ((b->bits != NULL) && (stale > b->keys) && (stale >= BLOOM_STALE_MIN)) {
+        bloomRefill(h, length, bloomBits(b->keys));
+    }
+}
+
+/** @brief Zwalnia pamięć tablicy przekierowań, nie zwalniając przekierowań.
+ * @param[in,out] map - wskaźnik na tablicę
+ */
+static void mapFreeKeys(HashMap *map) {
+    for (size_t i = 0; i < map->capacity; ++i) {
+        free(map->slots[i].digits);
+    }
+    free(map->slots);
+}
+
+/** @brief Zwalnia filtry Blooma.
+ * @param[in] blooms - tablica filtrów
+ * @param[in] count - liczba filtrów
+ */
+static void bloomsFree(Bloom *blooms, size_t count) {
+    for (size_t i = 0; (blooms != NULL) && (i < count); ++i) {
+        free(blooms[i].bits);
+    }
+    free(blooms);
+}
+
+/** @brief Wstawia klucz przekierowania i jego znaczniki do tablicy.
+ * @param[in,out] map - wskaźnik na tablicę
+ * @param[in] universe - największa długość klucza
+ * @param[in] s - wskaźnik na pozycję przekierowania w innej tablicy
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool insertWithMarkers(HashMap *map, size_t universe, HashSlot const *s) {
+    HashedForward *f = s->value;
+    size_t markers[HASHED_MAX_MARKERS];
+    uint64_t hashes[HASHED_MAX_MARKERS];
+    size_t count = markerLengths(universe, s->length, markers);
+    prefixHashes(f->source, markers, count, hashes);
+    if (!mapReserve(map, count + 1)) {
+        return false;
+    }
+    HashSlot *key = mapFind(map, s->hash, s->length, s->digits);
+    if (key == NULL) {
+        unsigned char *digits = copyPrefix(s->digits, s->length);
+        if (digits == NULL) {
+            return false;
+        }
+        key = mapInsert(map, s->hash, s->length, digits, NULL);
+    }
+    key->value = f;
+    for (size_t i = 0; i < count; ++i) {
+        HashSlot *marker = mapFind(map, hashes[i], markers[i], s->digits);
+        if (marker == NULL) {
+            unsigned char *digits = copyPrefix(s->digits, markers[i]);
+            if (digits == NULL) {
+                return false;
+            }
+            marker = mapInsert(map, hashes[i], markers[i], digits, NULL);
+        }
+        ++marker->markers;
+    }
+    return true;
+}
+
+/** @brief Powiększa zakres długości kluczy i rozmieszcza znaczniki od nowa.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] length - długość, która musi mieścić się w zakresie
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku; wtedy struktura pozostaje bez zmian.
+ */
+static bool growUniverse(HashedTable *h, size_t length) {
+    size_t universe = h->universe;
+    while (universe < length) {
+        universe = 2 * universe + 1;
+    }
+    HashMap map = {NULL, 0, 0, 0};
+    Bloom *blooms = calloc(universe + 1, sizeof(Bloom));
+    bool success = (blooms != NULL);
+    for (size_t i = 0; success && (i < h->forward.capacity); ++i) {
+        HashSlot const *s = &h->forward.slots[i];
+        if ((s->digits != NULL) && (s->value != NULL)) {
+            success = insertWithMarkers(&map, universe, s);
+        }
+    }
+    if (!success) {
+        mapFreeKeys(&map);
+        free(blooms);
+        return false;
+    }
+    mapFreeKeys(&h->forward);
+    bloomsFree(h->blooms, h->universe + 1);
+    h->forward = map;
+    h->blooms = blooms;
+    h->universe = universe;
+    ++h->epoch;
+    for (size_t i = 0; i < map.capacity; ++i) {
+        if (map.slots[i].digits != NULL) {
+            ++blooms[map.slots[i].length].keys;
+        }
+    }
+    for (size_t i = 1; i <= universe; ++i) {
+        if (blooms[i].keys > 0) {
+            blooms[i].bits = calloc(bloomBits(blooms[i].keys) / 64, sizeof(uint64_t));
+            blooms[i].mask = (blooms[i].bits != NULL) ? bloomBits(blooms[i].keys) - 1 : 0;
+        }
+    }
+    for (size_t i = 0; i < map.capacity; ++i) {
+        HashSlot const *s = &map.slots[i];
+        if ((s->digits != NULL) && (blooms[s->length].bits != NULL)) {
+            bloomSet(&blooms[s->length], s->hash);
+        }
+    }
+    return true;
+}
+
+/** @brief Szuka najdłuższego prefiksu numeru, który ma przekierowanie.
+ * Przeszukuje poddrzewo drzewa długości obejmujące długości od @p lo do @p hi.
+ * Wyznacza przy tym brakujące wartości znaczników, przez które przechodzi.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] q - wskaźnik na przygotowany numer
+ * @param[in] lo - najmniejsza długość poddrzewa
+ * @param[in] hi - największa długość poddrzewa
+ * @param[in] best - długość najdłuższego przekierowania krótszego niż @p lo
+ * @return Długość najdłuższego prefiksu mającego przekierowanie lub 0, gdy go nie ma.
+ */
+static size_t searchLengths(HashedTable *h, Query const *q, size_t lo, size_t hi, size_t best) {
+    while (lo <= hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        HashSlot *s = NULL;
+        if ((mid <= q->length) && bloomMaybe(&h->blooms[mid], q->hashes[mid])) {
+            s = mapFind(&h->forward, q->hashes[mid], mid, q->packed);
+        }
+        if (s == NULL) {
+            hi = mid - 1;
+            continue;
+        }
+        if (s->value != NULL) {
+            best = mid;
+        }
+        else {
+            if (s->best_epoch != h->epoch) {
+                s->best = searchLengths(h, q, lo, mid - 1, best);
+                s->best_epoch = h->epoch;
+            }
+            best = s->best;
+        }
+        lo = mid + 1;
+    }
+    return best;
+}
+
+/** @brief Szuka przekierowania najdłuższego prefiksu numeru.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] q - wskaźnik na przygotowany numer
+ * @return Wskaźnik na przekierowanie lub NULL, gdy żaden prefiks go nie ma.
+ */
+static HashedForward const * lookupForward(HashedTable *h, Query const *q) {
+    size_t best = searchLengths(h, q, 1, h->universe, 0);
+    if (best == 0) {
+        return NULL;
+    }
+    return mapFind(&h->forward, q->hashes[best], best, q->packed)->value;
+}
+
+/** @brief Przygotowuje zbiór o danym kluczu na dopisanie przekierowania.
+ * Jeśli zbioru nie ma w tablicy, tworzy nowy, który jest wstawiany do tablicy
+ * dopiero przez @ref commitSet.
+ * @param[in] map - wskaźnik na tablicę zbiorów
+ * @param[in] hash - skrót klucza
+ * @param[in] length - długość klucza
+ * @param[in] packed - wskaźnik na spakowany numer, którego prefiksem jest klucz
+ * @param[out] fresh - wskaźnik na nowy zbiór lub NULL, gdy zbiór jest w tablicy
+ * @param[out] digits - wskaźnik na spakowany klucz nowego zbioru
+ * @return Wskaźnik na zbiór z miejscem na jeszcze jedno przekierowanie lub
+ *         NULL, gdy nie udało się alokować pamięci; wtedy @p fresh i @p digits
+ *         trzeba zwolnić przez @ref discardSet.
+ */
+static SourceSet * reserveSet(HashMap const *map, uint64_t hash, size_t length, unsigned char const *packed,
+                              SourceSet **fresh, unsigned char **digits) {
+    HashSlot *slot = mapFind(map, hash, length, packed);
+    *fresh = NULL;
+    *digits = NULL;
+    if (slot == NULL) {
+        *fresh = calloc(1, sizeof(SourceSet));
+        *digits = copyPrefix(packed, length);
+        if ((*fresh == NULL) || (*digits == NULL)) {
+            return NULL;
+        }
+        (*fresh)->hash = hash;
+    }
+    SourceSet *set = (slot != NULL) ? slot->value : *fresh;
+    if (!reserveArray((void **)&set->items, &set->capacity, set->count + 1, sizeof(HashedForward *))) {
+        return NULL;
+    }
+    return set;
+}
+
+/** @brief Zwalnia zbiór utworzony przez @ref reserveSet, który nie trafił do tablicy.
+ * @param[in] fresh - wskaźnik na nowy zbiór lub NULL
+ * @param[in] digits - wskaźnik na spakowany klucz nowego zbioru lub NULL
+ */
+static void discardSet(SourceSet *fresh, unsigned char *digits) {
+    if (fresh != NULL) {
+        free(fresh->items);
+    }
+    free(fresh);
+    free(digits);
+}
+
+/** @brief Wstawia do tablicy zbiór utworzony przez @ref reserveSet.
+ * Nic nie robi, jeśli zbiór już był w tablicy.
+ * Tablica musi mieć miejsce zapewnione przez @ref mapReserve.
+ * @param[in,out] map - wskaźnik na tablicę zbiorów
+ * @param[in] length - długość klucza
+ * @param[in] fresh - wskaźnik na nowy zbiór lub NULL
+ * @param[in] digits - wskaźnik na spakowany klucz nowego zbioru
+ */
+static void commitSet(HashMap *map, size_t length, SourceSet *fresh, unsigned char *digits) {
+    if (fresh != NULL) {
+        mapInsert(map, fresh->hash, length, digits, fresh);
+    }
+}
+
+/** @brief Dopisuje przekierowanie do zbioru przygotowanego przez @ref reserveSet.
+ * @param[in,out] set - wskaźnik na zbiór
+ * @param[in,out] f - wskaźnik na przekierowanie
+ * @param[in] kind - rodzaj zbioru
+ */
+static void joinSet(SourceSet *set, HashedForward *f, int kind) {
+    f->member[kind].set = set;
+    f->member[kind].position = set->count;
+    set->items[set->count++] = f;
+}
+
+/** @brief Usuwa przekierowanie z jego zbioru danego rodzaju.
+ * Na jego miejsce trafia ostatnie przekierowanie zbioru. Pusty zbiór jest
+ * usuwany z tablicy.
+ * @param[in,out] map - wskaźnik na tablicę zbiorów tego rodzaju
+ * @param[in,out] f - wskaźnik na przekierowanie
+ * @param[in] kind - rodzaj zbioru
+ */
+static void leaveSet(HashMap *map, HashedForward *f, int kind) {
+    SourceSet *set = f->member[kind].set;
+    HashedForward *last = set->items[--set->count];
+    set->items[f->member[kind].position] = last;
+    last->member[kind].position = f->member[kind].position;
+    if (set->count == 0) {
+        mapErase(map, mapFindValue(map, set->hash, set));
+        free(set->items);
+        free(set);
+    }
+}
+
+/** @brief Zwalnia pamięć tablicy zbiorów razem ze zbiorami.
+ * @param[in,out] map - wskaźnik na tablicę
+ */
+static void mapFreeSets(HashMap *map) {
+    for (size_t i = 0; i < map->capacity; ++i) {
+        SourceSet *set = (map->slots[i].digits != NULL) ? map->slots[i].value : NULL;
+        if (set != NULL) {
+            free(set->items);
+            free(set);
+        }
+    }
+    mapFreeKeys(map);
+}
+
+/** @brief Usuwa przekierowanie i jego znaczniki.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] f - wskaźnik na przekierowanie
+ */
+static void removeForward(HashedTable *h, HashedForward *f) {
+    size_t length = f->source_length;
+    uint64_t hash;
+    prefixHashes(f->source, &length, 1, &hash);
+    HashSlot *s = mapFindValue(&h->forward, hash, f);
+    size_t markers[HASHED_MAX_MARKERS] = {0};
+    uint64_t hashes[HASHED_MAX_MARKERS];
+    size_t count = markerLengths(h->universe, length, markers);
+    prefixHashes(f->source, markers, count, hashes);
+    for (size_t i = 0; i < count; ++i) {
+        HashSlot *marker = mapFind(&h->forward, hashes[i], markers[i], s->digits);
+        if ((--marker->markers == 0) && (marker->value == NULL)) {
+            mapErase(&h->forward, marker);
+            bloomRemove(h, markers[i]);
+        }
+    }
+    leaveSet(&h->reverse, f, BY_TARGET);
+    leaveSet(&h->groups, f, BY_GROUP);
+    free(f->source);
+    free(f->target);
+    free(f);
+    s->value = NULL;
+    if (s->markers == 0) {
+        mapErase(&h->forward, s);
+        bloomRemove(h, length);
+    }
+    // Numer zmiany nie jest zwiększany: każdy znacznik, którego wartość
+    // wskazuje usuwane przekierowanie, ma je jako prefiks, więc wszystkie
+    // przekierowania, które go utworzyły, też są usuwane razem z nim.
+}
+
+/** @brief Usuwa przekierowania z grupy, których prefiks zaczyna się od numeru.
+ * Przegląda grupę od końca, więc przekierowanie przeniesione na miejsce
+ * usuniętego zostało już sprawdzone. Grupa jest zwalniana razem z ostatnim
+ * przekierowaniem, a wtedy pętla się kończy.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] set - wskaźnik na grupę
+ * @param[in] num - wskaźnik na napis reprezentujący prefiks numerów
+ * @param[in] length - długość numeru
+ * @return Wartość @p true, jeśli usunięto jakieś przekierowanie.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool removeFromGroup(HashedTable *h, SourceSet *set, char const *num, size_t length) {
+    bool result = false;
+    for (size_t i = set->count; i > 0; --i) {
+        HashedForward *f = set->items[i - 1];
+        if ((f->source_length >= length) && (memcmp(f->source, num, length) == 0)) {
+            removeForward(h, f);
+            result = true;
+        }
+    }
+    return result;
+}
+
+/** @brief Tworzy pustą strukturę.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+HashedTable * hashedNew(void) {
+    HashedTable *h = calloc(1, sizeof(HashedTable));
+    if (h != NULL) {
+        h->universe = HASHED_MIN_UNIVERSE;
+        h->epoch = 1;
+        h->blooms = calloc(h->universe + 1, sizeof(Bloom));
+        if (h->blooms == NULL) {
+            free(h);
+            h = NULL;
+        }
+    }
+    return h;
+}
+
+/** @brief Usuwa strukturę.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] h - wskaźnik na usuwaną strukturę
+ */
+void hashedFree(HashedTable *h) {
+    if (h == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < h->forward.capacity; ++i) {
+        HashedForward *f = (h->forward.slots[i].digits != NULL) ? h->forward.slots[i].value : NULL;
+        if (f != NULL) {
+            free(f->source);
+            free(f->target);
+            free(f);
+        }
+    }
+    mapFreeKeys(&h->forward);
+    mapFreeSets(&h->reverse);
+    mapFreeSets(&h->groups);
+    bloomsFree(h->blooms, h->universe + 1);
+    free(h->query.packed);
+    free(h->query.hashes);
+    free(h->other.packed);
+    free(h->other.hashes);
+    free(h->text);
+    free(h);
+}
+
+/** @brief Dodaje przekierowanie, tak jak @ref phfwdAdd.
+ * Najpierw alokuje całą potrzebną pamięć, a dopiero potem zmienia tablice,
+ * więc nieudana alokacja pozostawia strukturę bez zmian.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest wykonywane przekierowanie
+ * @return Wartość @p true, jeśli przekierowanie zostało dodane.
+ *         Wartość @p false w przeciwnym przypadku; wtedy struktura pozostaje bez zmian.
+ */
+bool hashedAdd(HashedTable *h, char const *num1, char const *num2) {
+    if (!onlyDigitsAndNotEmpty(num1) || !onlyDigitsAndNotEmpty(num2) || !numbersDiffer(num1, num2)) {
+        return false;
+    }
+    size_t length = howLong(num1);
+    size_t target_length = howLong(num2);
+    if ((length > h->universe) && !growUniverse(h, length)) {
+        return false;
+    }
+    size_t markers[HASHED_MAX_MARKERS];
+    size_t count = markerLengths(h->universe, length, markers);
+    if (!prepareQuery(&h->query, num1, length) || !prepareQuery(&h->other, num2, target_length)
+        || !mapReserve(&h->forward, count + 1) || !mapReserve(&h->reverse, 1)
+        || !mapReserve(&h->groups, 1)) {
+        return false;
+    }
+    Query const *q = &h->query;
+    uint64_t target_hash = h->other.hashes[target_length];
+    HashSlot *slot = mapFind(&h->forward, q->hashes[length], length, q->packed);
+    HashedForward *f = (slot != NULL) ? slot->value : NULL;
+    if ((f != NULL) && (f->target_length == target_length) && (memcmp(f->target, num2, target_length) == 0)) {
+        return true;
+    }
+
+    char *target = malloc(target_length + 1);
+    SourceSet *fresh_set = NULL;
+    unsigned char *set_digits = NULL;
+    SourceSet *set = reserveSet(&h->reverse, target_hash, target_length, h->other.packed, &fresh_set, &set_digits);
+    bool success = (target != NULL) && (set != NULL);
+    size_t group_length = (length < HASHED_GROUP_DIGITS) ? length : HASHED_GROUP_DIGITS;
+    SourceSet *fresh_group = NULL;
+    unsigned char *group_digits = NULL;
+    SourceSet *group = NULL;
+    HashedForward *created = NULL;
+    unsigned char *key_digits = NULL;
+    unsigned char *marker_digits[HASHED_MAX_MARKERS] = {NULL};
+    if (success && (f == NULL)) {
+        group = reserveSet(&h->groups, q->hashes[group_length], group_length, q->packed, &fresh_group, &group_digits);
+        created = calloc(1, sizeof(HashedForward));
+        success = (group != NULL) && (created != NULL) && ((created->source = malloc(length + 1)) != NULL);
+        if (success && (slot == NULL)) {
+            success = ((key_digits = copyPrefix(q->packed, length)) != NULL);
+        }
+        for (size_t i = 0; success && (i < count); ++i) {
+            if (mapFind(&h->forward, q->hashes[markers[i]], markers[i], q->packed) == NULL) {
+                success = ((marker_digits[i] = copyPrefix(q->packed, markers[i])) != NULL);
+            }
+        }
+    }
+    if (!success) {
+        free(target);
+        discardSet(fresh_set, set_digits);
+        discardSet(fresh_group, group_digits);
+        if (created != NULL) {
+            free(created->source);
+        }
+        free(created);
+        free(key_digits);
+        for (size_t i = 0; i < count; ++i) {
+            free(marker_digits[i]);
+        }
+        return false;
+    }
+
+    memcpy(target, num2, target_length + 1);
+    commitSet(&h->reverse, target_length, fresh_set, set_digits);
+    if (f != NULL) {
+        leaveSet(&h->reverse, f, BY_TARGET);
+        free(f->target);
+    }
+    else {
+        f = created;
+        memcpy(f->source, num1, length + 1);
+        f->source_length = length;
+        commitSet(&h->groups, group_length, fresh_group, group_digits);
+        joinSet(group, f, BY_GROUP);
+        if (slot == NULL) {
+            slot = mapInsert(&h->forward, q->hashes[length], length, key_digits, NULL);
+            bloomAdd(h, slot);
+        }
+        slot->value = f;
+        for (size_t i = 0; i < count; ++i) {
+            HashSlot *marker = mapFind(&h->forward, q->hashes[markers[i]], markers[i], q->packed);
+            if (marker == NULL) {
+                marker = mapInsert(&h->forward, q->hashes[markers[i]], markers[i], marker_digits[i], NULL);
+                bloomAdd(h, marker);
+            }
+            ++marker->markers;
+        }
+        ++h->epoch;
+    }
+    f->target = target;
+    f->target_length = target_length;
+    joinSet(set, f, BY_TARGET);
+    return true;
+}
+
+/** @brief Usuwa przekierowania, tak jak @ref phfwdRemove.
+ * Przegląda tylko grupy przekierowań, których początkowe cyfry prefiksu
+ * zgadzają się z numerem, więc dla numeru mającego co najmniej
+ * @ref HASHED_GROUP_DIGITS cyfr nie zależy od liczby pozostałych przekierowań.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący prefiks numerów
+ * @return Wartość @p true, jeśli usunięto jakieś przekierowanie.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool hashedRemove(HashedTable *h, char const *num) {
+    if (!onlyDigitsAndNotEmpty(num)) {
+        return false;
+    }
+    size_t length = howLong(num);
+    size_t group_length = (length < HASHED_GROUP_DIGITS) ? length : HASHED_GROUP_DIGITS;
+    unsigned char packed[(HASHED_GROUP_DIGITS + 1) / 2];
+    encodePacked(packed, num, group_length);
+    if (length >= HASHED_GROUP_DIGITS) {
+        uint64_t hash;
+        prefixHashes(num, &group_length, 1, &hash);
+        HashSlot *s = mapFind(&h->groups, hash, group_length, packed);
+        return (s != NULL) && removeFromGroup(h, s->value, num, length);
+    }
+    // Krótki prefiks obejmuje wiele grup. Usuwane grupy są tylko oznaczane
+    // jako zwolnione, więc przeglądanie tablicy w trakcie usuwania niczego
+    // nie pomija.
+    bool result = false;
+    for (size_t i = 0; i < h->groups.capacity; ++i) {
+        HashSlot *s = &h->groups.slots[i];
+        if ((s->digits != NULL) && (s->length >= length) && keysEqual(s->digits, packed, length)) {
+            result = removeFromGroup(h, s->value, num, length) || result;
+        }
+    }
+    return result;
+}
+
+/** @brief Wyznacza przekierowanie numeru, tak jak @ref phfwdGet.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * hashedGet(HashedTable *h, char const *num) {
+    PhoneNumbers *result = newPhoneNumbers();
+    if ((result == NULL) || !onlyDigitsAndNotEmpty(num)) {
+        return result;
+    }
+    size_t length = howLong(num);
+    if (!prepareQuery(&h->query, num, length)) {
+        phnumDelete(result);
+        return NULL;
+    }
+    HashedForward const *f = lookupForward(h, &h->query);
+    size_t prefix_length = (f == NULL) ? 0 : f->target_length;
+    size_t eaten = (f == NULL) ? 0 : f->source_length;
+    size_t result_length = prefix_length + length - eaten;
+    if (!reserveArray((void **)&h->text, &h->text_capacity, result_length + 1, sizeof(char))) {
+        phnumDelete(result);
+        return NULL;
+    }
+    if (f != NULL) {
+        memcpy(h->text, f->target, prefix_length);
+    }
+    memcpy(h->text + prefix_length, num + eaten, length - eaten);
+    h->text[result_length] = '\0';
+    if (!addElement(result->list, h->text, result_length)) {
+        phnumDelete(result);
+        result = NULL;
+    }
+    return result;
+}
+
+/** @brief Sprawdza, czy numer jest przekierowywany na dany numer.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] candidate - wskaźnik na napis reprezentujący sprawdzany numer
+ * @param[in] target - wskaźnik na napis reprezentujący numer, który powinien być wynikiem przekierowania
+ * @param[out] forwards - czy @p candidate jest przekierowywany na @p target
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool forwardsTo(HashedTable *h, char const *candidate, char const *target, bool *forwards) {
+    size_t length = howLong(candidate);
+    size_t target_length = howLong(target);
+    if (!prepareQuery(&h->other, candidate, length)) {
+        return false;
+    }
+    HashedForward const *f = lookupForward(h, &h->other);
+    if (f == NULL) {
+        *forwards = !numbersDiffer(candidate, target);
+        return true;
+    }
+    *forwards = (f->target_length + length - f->source_length == target_length)
+                && (f->target_length <= target_length)
+                && (memcmp(f->target, target, f->target_length) == 0)
+                && (memcmp(candidate + f->source_length, target + f->target_length, length - f->source_length) == 0);
+    return true;
+}
+
+/** @brief Dopisuje do tablicy kandydatów konkatenację dwóch napisów.
+ * @param[in,out] candidates - adres tablicy kandydatów
+ * @param[in,out] count - adres liczby kandydatów
+ * @param[in,out] capacity - adres pojemności tablicy
+ * @param[in] prefix - wskaźnik na początek prefiksu
+ * @param[in] prefix_length - długość prefiksu
+ * @param[in] suffix - wskaźnik na napis zakończony znakiem '\0'
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool addCandidate(char ***candidates, size_t *count, size_t *capacity,
+                         char const *prefix, size_t prefix_length, char const *suffix) {
+    size_t suffix_length = howLong(suffix);
+    char *candidate = malloc(prefix_length + suffix_length + 1);
+    if ((candidate == NULL) || !reserveArray((void **)candidates, capacity, *count + 1, sizeof(char *))) {
+        free(candidate);
+        return false;
+    }
+    memcpy(candidate, prefix, prefix_length);
+    memcpy(candidate + prefix_length, suffix, suffix_length + 1);
+    (*candidates)[(*count)++] = candidate;
+    return true;
+}
+
+/** @brief Wyznacza odwrócenie lub przeciwobraz, tak jak @ref phfwdReverseOrGetReverse.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] only_counterimage - czy wyznaczamy tylko przeciwobraz
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * hashedReverse(HashedTable *h, char const *num, bool only_counterimage) {
+    PhoneNumbers *result = newPhoneNumbers();
+    if ((result == NULL) || !onlyDigitsAndNotEmpty(num)) {
+        return result;
+    }
+    size_t length = howLong(num);
+    char **candidates = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    bool success = prepareQuery(&h->query, num, length) && addCandidate(&candidates, &count, &capacity, num, length, "");
+    for (size_t i = 1; success && (i <= length); ++i) {
+        HashSlot const *s = mapFind(&h->reverse, h->query.hashes[i], i, h->query.packed);
+        SourceSet const *set = (s != NULL) ? s->value : NULL;
+        for (size_t j = 0; success && (set != NULL) && (j < set->count); ++j) {
+            success = addCandidate(&candidates, &count, &capacity,
+                                   set->items[j]->source, set->items[j]->source_length, num + i);
+        }
+    }
+    if (success) {
+        qsort(candidates, count, sizeof(char *), myCompare);
+    }
+    for (size_t i = 0; success && (i < count); ++i) {
+        if ((i > 0) && !numbersDiffer(candidates[i - 1], candidates[i])) {
+            continue;
+        }
+        bool forwards = true;
+        if (only_counterimage) {
+            success = forwardsTo(h, candidates[i], num, &forwards);
+        }
+        if (success && forwards) {
+            success = addElement(result->list, candidates[i], howLong(candidates[i]));
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        free(candidates[i]);
+    }
+    free(candidates);
+    if (!success) {
+        phnumDelete(result);
+        result = NULL;
+    }
+    return result;
+}
+
+/** @brief Dodaje przekierowanie; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref HashedTable
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest wykonywane przekierowanie
+ * @return Wartość @p true, jeśli przekierowanie zostało dodane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool engineAdd(void *data, char const *num1, char const *num2) {
+    return hashedAdd(data, num1, num2);
+}
+
+/** @brief Usuwa przekierowania; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref HashedTable
+ * @param[in] num - wskaźnik na napis reprezentujący prefiks numerów
+ * @return Wartość @p true, jeśli usunięto jakieś przekierowanie.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool engineRemove(void *data, char const *num) {
+    return hashedRemove(data, num);
+}
+
+/** @brief Wyznacza przekierowanie numeru; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref HashedTable
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+static PhoneNumbers * engineGet(void *data, char const *num) {
+    return hashedGet(data, num);
+}
+
+/** @brief Wyznacza odwrócenie; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref HashedTable
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+static PhoneNumbers * engineReverse(void *data, char const *num) {
+    return hashedReverse(data, num, false);
+}
+
+/** @brief Wyznacza przeciwobraz; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref HashedTable
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+static PhoneNumbers * engineGetReverse(void *data, char const *num) {
+    return hashedReverse(data, num, true);
+}
+
+/** @brief Zwalnia strukturę; funkcja silnika.
+ * @param[in] data - wskaźnik na strukturę @ref HashedTable
+ */
+static void engineClose(void *data) {
+    hashedFree(data);
+}
+
+/**
+ * To jest tablica funkcji silnika przechowującego przekierowania w tablicach haszujących.
+ */
+static PhoneForwardEngine const hashedEngine = {
+    "hashed", engineAdd, engineRemove, engineGet, engineReverse, engineGetReverse, engineClose
+};
+
+/** @brief Tworzy strukturę przechowującą przekierowania w tablicach haszujących.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+PhoneForward * phfwdNewHashed(void) {
+    HashedTable *h = hashedNew();
+    return (h == NULL) ? NULL : phfwdNewWithEngine(&hashedEngine, h);
+}
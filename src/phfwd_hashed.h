@@ -0,0 +1,71 @@
+/** @file
+ * Interfejs klasy przekierowań przechowywanych w tablicach haszujących
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_HASHED_H__
+#define __PHFWD_HASHED_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+
+/**
+ * To jest struktura przekierowań przechowywanych w tablicach haszujących.
+ */
+typedef struct HashedTable HashedTable;
+
+/** @brief Tworzy pustą strukturę.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+HashedTable * hashedNew(void);
+
+/** @brief Usuwa strukturę.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] h - wskaźnik na usuwaną strukturę
+ */
+void hashedFree(HashedTable *h);
+
+/** @brief Dodaje przekierowanie, tak jak @ref phfwdAdd.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest wykonywane przekierowanie
+ * @return Wartość @p true, jeśli przekierowanie zostało dodane.
+ *         Wartość @p false w przeciwnym przypadku; wtedy struktura pozostaje bez zmian.
+ */
+bool hashedAdd(HashedTable *h, char const *num1, char const *num2);
+
+/** @brief Usuwa przekierowania, tak jak @ref phfwdRemove.
+ * Przegląda tylko grupy przekierowań, których początkowe cyfry prefiksu
+ * zgadzają się z numerem, więc dla numeru mającego co najmniej cztery
+ * cyfry nie zależy od liczby pozostałych przekierowań.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący prefiks numerów
+ * @return Wartość @p true, jeśli usunięto jakieś przekierowanie.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool hashedRemove(HashedTable *h, char const *num);
+
+/** @brief Wyznacza przekierowanie numeru, tak jak @ref phfwdGet.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * hashedGet(HashedTable *h, char const *num);
+
+/** @brief Wyznacza odwrócenie lub przeciwobraz, tak jak @ref phfwdReverseOrGetReverse.
+ * @param[in,out] h - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] only_counterimage - czy wyznaczamy tylko przeciwobraz
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * hashedReverse(HashedTable *h, char const *num, bool only_counterimage);
+
+#endif /* __PHFWD_HASHED_H__ */
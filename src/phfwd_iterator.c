@@ -0,0 +1,536 @@
+/** @file
+ * Implementacja klasy iteratora po wynikach funkcji phfwdReverse i phfwdGetReverse
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phfwd_iterator.h"
+#include "phone_forward.h"
+#include "phfwd_auxiliary_functions.h"
+#include "list.h"
+#include "packed_number.h"
+
+/** @brief Zwraca długość wyniku opisanego przez strukturę @ref ReverseSource.
+ * @param[in] source - wskaźnik na opis wyniku
+ * @return Liczba cyfr wyniku.
+ */
+size_t sourceLength(ReverseSource const *source) {
+    size_t prefix_length = (source->element != NULL) ? source->element->number_length : 0;
+    return prefix_length + source->query->length - source->suffix_start;
+}
+
+/** @brief Zwraca wartość cyfry wyniku opisanego przez strukturę @ref ReverseSource.
+ * @param[in] source - wskaźnik na opis wyniku
+ * @param[in] i - pozycja cyfry
+ * @return Wartość cyfry z zakresu od 0 do 11.
+ */
+int sourceDigit(ReverseSource const *source, size_t i) {
+    if (source->element != NULL) {
+        if (i < source->element->number_length) {
+            return packedDigitValue(source->element->digits, i);
+        }
+        i -= source->element->number_length;
+    }
+    return packedDigitValue(source->query->digits, source->suffix_start + i);
+}
+
+/** @brief Porównuje 2 wyniki opisane przez struktury @ref ReverseSource.
+ * Funkcja w postaci wymaganej przez qsort.
+ * @param[in] source1 - wskaźnik na opis pierwszego wyniku
+ * @param[in] source2 - wskaźnik na opis drugiego wyniku
+ * @return Wartość @p 0, gdy wyniki są równe, wartość @p 1, gdy pierwszy wynik jest większy, a @p -1, gdy mniejszy.
+ */
+int compareSources(const void *source1, const void *source2) {
+    ReverseSource const *s1 = source1;
+    ReverseSource const *s2 = source2;
+    size_t length1 = sourceLength(s1);
+    size_t length2 = sourceLength(s2);
+    size_t length = (length1 < length2) ? length1 : length2;
+    for (size_t i = 0; i < length; ++i) {
+        int d1 = sourceDigit(s1, i);
+        int d2 = sourceDigit(s2, i);
+        if (d1 != d2) {
+            return (d1 > d2) ? 1 : -1;
+        }
+    }
+    if (length1 == length2) {
+        return 0;
+    }
+    return (length1 < length2) ? -1 : 1;
+}
+
+/** @brief Porównuje wynik opisany przez strukturę @ref ReverseSource z numerem.
+ * @param[in] source - wskaźnik na opis wyniku
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wartość @p 0, gdy wynik jest równy numerowi, wartość @p 1, gdy jest większy, a @p -1, gdy mniejszy.
+ */
+static int compareSourceWithNumber(ReverseSource const *source, char const *num) {
+    size_t length = sourceLength(source);
+    size_t i = 0;
+    while ((i < length) && (num[i] != '\0')) {
+        int d1 = sourceDigit(source, i);
+        int d2 = digitValue(num + i);
+        if (d1 != d2) {
+            return (d1 > d2) ? 1 : -1;
+        }
+        ++i;
+    }
+    if ((i == length) && (num[i] == '\0')) {
+        return 0;
+    }
+    return (i == length) ? -1 : 1;
+}
+
+/** @brief Sprawdza, czy numer wpisu jest prefiksem numeru innego wpisu.
+ * @param[in] shorter - wskaźnik na pierwszy wpis
+ * @param[in] longer - wskaźnik na drugi wpis
+ * @return Wartość @p true, jeśli numer pierwszego wpisu jest prefiksem numeru drugiego wpisu.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool entryIsPrefix(OneNumber const *shorter, OneNumber const *longer) {
+    size_t length = shorter->number_length;
+    if ((length > longer->number_length) || (memcmp(shorter->digits, longer->digits, length / 2) != 0)) {
+        return false;
+    }
+    return (length % 2 == 0) || (packedDigitValue(shorter->digits, length - 1) == packedDigitValue(longer->digits, length - 1));
+}
+
+/** @brief Zwraca pierwszy aktualny wpis listy, zaczynając od podanego.
+ * @param[in] it - wskaźnik na iterator
+ * @param[in] run - wskaźnik na serię, do której listy należy wpis
+ * @param[in] element - wskaźnik na wpis lub NULL
+ * @return Wskaźnik na aktualny wpis lub NULL, gdy takiego nie ma.
+ */
+static OneNumber const * aliveFrom(PhoneNumbersIter const *it, ReverseRun const *run, OneNumber const *element) {
+    while ((element != NULL) && (it->pf->graveyard != NULL)
+           && !reverseEntryAlive(it->pf->pool, it->pf->forward, run->node, element)) {
+        element = element->next; // Przekierowanie usunięte, ale jeszcze niezwolnione.
+    }
+    return element;
+}
+
+/** @brief Wyznacza najmniejszy nieodczytany wynik serii.
+ * Wyniki ze stosu wpisów odłożonych, których najdłuższy wpis nie jest prefiksem
+ * kolejnego wpisu listy, są mniejsze od wszystkich wyników z dalszej części
+ * listy. W przeciwnym razie odkłada na stos kolejne wpisy listy, dopóki są
+ * prefiksami swoich następników; ostatni z nich daje wynik mniejszy od wyników
+ * z dalszej części listy.
+ * @param[in] it - wskaźnik na iterator
+ * @param[in,out] run - wskaźnik na serię z listą węzła drzewa odwróceń
+ */
+static void fillHead(PhoneNumbersIter const *it, ReverseRun *run) {
+    bool use_next = (run->next != NULL)
+                    && ((run->deferred_count == 0) || entryIsPrefix(run->deferred[run->deferred_count - 1], run->next));
+    while (use_next && (run->deferred_count < run->deferred_capacity)) {
+        OneNumber const *following = aliveFrom(it, run, run->next->next);
+        if ((following == NULL) || !entryIsPrefix(run->next, following)) {
+            break;
+        }
+        run->deferred[run->deferred_count] = run->next;
+        ++(run->deferred_count);
+        run->next = following;
+    }
+
+    ReverseSource candidate = run->head;
+    run->has_head = use_next;
+    run->head.element = run->next;
+    for (size_t i = 0; i < run->deferred_count; ++i) {
+        candidate.element = run->deferred[i];
+        if (!run->has_head || (compareSources(&candidate, &(run->head)) < 0)) {
+            run->head.element = candidate.element;
+            run->has_head = true;
+        }
+    }
+}
+
+/** @brief Przechodzi do kolejnego wyniku serii.
+ * @param[in] it - wskaźnik na iterator
+ * @param[in,out] run - wskaźnik na serię mającą wynik
+ */
+static void advanceRun(PhoneNumbersIter const *it, ReverseRun *run) {
+    if (run->node == NULL) {
+        run->has_head = false; // Seria z samym numerem zapytania ma jeden wynik.
+        return;
+    }
+    if (run->head.element == run->next) {
+        run->next = aliveFrom(it, run, run->next->next);
+    }
+    else {
+        size_t i = 0;
+        while (run->deferred[i] != run->head.element) {
+            ++i;
+        }
+        memmove(&(run->deferred[i]), &(run->deferred[i + 1]), (run->deferred_count - i - 1) * sizeof(*(run->deferred)));
+        --(run->deferred_count);
+    }
+    fillHead(it, run);
+}
+
+/** @brief Przywraca własność kopca serii, przesuwając serię w dół.
+ * @param[in,out] it - wskaźnik na iterator
+ * @param[in] i - pozycja przesuwanej serii w kopcu
+ */
+static void siftDown(PhoneNumbersIter *it, size_t i) {
+    ReverseRun **heap = it->heap;
+    while (2 * i + 1 < it->heap_size) {
+        size_t child = 2 * i + 1;
+        if ((child + 1 < it->heap_size) && (compareSources(&(heap[child + 1]->head), &(heap[child]->head)) < 0)) {
+            ++child;
+        }
+        if (compareSources(&(heap[child]->head), &(heap[i]->head)) >= 0) {
+            return;
+        }
+        ReverseRun *help = heap[i];
+        heap[i] = heap[child];
+        heap[child] = help;
+        i = child;
+    }
+}
+
+/** @brief Układa kopiec z serii, które mają jeszcze wyniki.
+ * @param[in,out] it - wskaźnik na iterator
+ */
+static void buildHeap(PhoneNumbersIter *it) {
+    it->heap_size = 0;
+    for (size_t i = 0; i < it->runs_count; ++i) {
+        if (it->runs[i].has_head) {
+            it->heap[it->heap_size] = &(it->runs[i]);
+            ++(it->heap_size);
+        }
+    }
+    for (size_t i = it->heap_size / 2; i > 0; --i) {
+        siftDown(it, i - 1);
+    }
+}
+
+/** @brief Ustawia wszystkie serie na ich pierwsze wyniki.
+ * Nie układa kopca.
+ * @param[in,out] it - wskaźnik na iterator
+ */
+static void rewindRuns(PhoneNumbersIter *it) {
+    for (size_t i = 0; i < it->runs_count; ++i) {
+        ReverseRun *run = &(it->runs[i]);
+        run->deferred_count = 0;
+        if (run->node == NULL) {
+            run->has_head = true;
+        }
+        else {
+            run->next = aliveFrom(it, run, run->node->list->first);
+            fillHead(it, run);
+        }
+    }
+    it->has_previous = false;
+}
+
+/** @brief Tworzy iterator po wynikach phfwdReverse lub phfwdGetReverse.
+ * Zapamiętuje listy węzłów drzewa odwróceń na ścieżce numeru @p num,
+ * nie przeglądając ich. Listy są posortowane, więc kolejne wyniki powstają
+ * przez scalanie ich na bieżąco.
+ * @param[in] pf  - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num - wskaźnik na napis reprezentujący numer;
+ * @param[in] only_counterimage - zmienna informująca o tym, czy wyznaczamy tylko przeciwobraz phfwdGet
+ * @return Wskaźnik na utworzony iterator lub NULL, gdy nie udało się
+ *         alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
+ */
+PhoneNumbersIter * phfwdReverseOrGetReverseIter(PhoneForward const *pf, char const *num, bool only_counterimage) {
+    if ((pf == NULL) || (pf->reverse == NULL)) {
+        return NULL;
+    }
+    PhoneNumbersIter *it = malloc(sizeof(*it));
+    if (it == NULL) {
+        return NULL;
+    }
+    it->pf = pf;
+    it->query.digits = NULL;
+    it->query.length = 0;
+    it->runs = NULL;
+    it->runs_count = 0;
+    it->heap = NULL;
+    it->heap_size = 0;
+    it->deferred = NULL;
+    it->has_previous = false;
+    it->only_counterimage = only_counterimage;
+    it->current.digits = NULL;
+    it->current.length = 0;
+    it->text = NULL;
+
+    if (!onlyDigitsAndNotEmpty(num)) {
+        return it; // Iterator po pustym ciągu.
+    }
+
+    // Pierwszy przebieg: liczba serii i rozmiar ich stosów.
+    size_t how_long = howLong(num);
+    size_t longest_entry = pf->pool->longest_entry;
+    size_t runs_count = 1;
+    size_t deferred_count = 0;
+    Node *help = pf->reverse;
+    for (size_t i = 0; (help != NULL) && (i < how_long); ++i) {
+        help = sonOf(pf->pool, help, digitValue(num + i));
+        if ((help != NULL) && (help->list != NULL) && !empty(help->list)) {
+            ++runs_count;
+            deferred_count += (help->list->list_size < longest_entry) ? help->list->list_size : longest_entry;
+        }
+    }
+
+    it->query.length = how_long;
+    it->query.digits = packNumber(num, how_long);
+    it->runs = malloc(runs_count * sizeof(*(it->runs)));
+    it->heap = malloc(runs_count * sizeof(*(it->heap)));
+    it->deferred = (deferred_count > 0) ? malloc(deferred_count * sizeof(*(it->deferred))) : NULL;
+    it->current.digits = malloc(packedSize(longest_entry + how_long));
+    it->text = malloc((longest_entry + how_long + 1) * sizeof(*(it->text)));
+    if ((it->query.digits == NULL) || (it->runs == NULL) || (it->heap == NULL)
+        || ((deferred_count > 0) && (it->deferred == NULL)) || (it->current.digits == NULL) || (it->text == NULL)) {
+        phfwdIterDelete(it);
+        return NULL;
+    }
+
+    // Drugi przebieg: serie wyników, bez przeglądania list.
+    it->runs[0].node = NULL;
+    it->runs[0].next = NULL;
+    it->runs[0].deferred = NULL;
+    it->runs[0].deferred_capacity = 0;
+    it->runs[0].head = (ReverseSource){NULL, &(it->query), 0};
+    it->runs_count = 1;
+    OneNumber const **deferred = it->deferred;
+    help = pf->reverse;
+    for (size_t i = 0; (help != NULL) && (i < how_long); ++i) {
+        help = sonOf(pf->pool, help, digitValue(num + i));
+        if ((help != NULL) && (help->list != NULL) && !empty(help->list)) {
+            ReverseRun *run = &(it->runs[it->runs_count]);
+            run->node = help;
+            run->deferred = deferred;
+            run->deferred_capacity = (help->list->list_size < longest_entry) ? help->list->list_size : longest_entry;
+            run->head = (ReverseSource){NULL, &(it->query), i + 1};
+            deferred += run->deferred_capacity;
+            ++(it->runs_count);
+        }
+    }
+    rewindRuns(it);
+    buildHeap(it);
+
+    return it;
+}
+
+/** @brief Tworzy iterator po wynikach funkcji phfwdReverse.
+ * Kolejne numery są zwracane przez funkcję @ref phfwdIterNext w porządku
+ * leksykograficznym, bez powtórzeń. Iterator nie kopiuje ani nie sortuje
+ * wyników z góry. Listy węzłów drzewa odwróceń są posortowane, więc iterator
+ * scala je na bieżąco, a pierwszy wynik jest dostępny po przejściu ścieżki
+ * numeru @p num. Pamięć iteratora nie zależy od liczby wyników. Do pobierania
+ * wyników stronami służy funkcja @ref phfwdIterPage. Iterator musi zostać usunięty
+ * za pomocą funkcji @ref phfwdIterDelete przed modyfikacją struktury @p pf.
+ * @param[in] pf  - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num - wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na utworzony iterator lub NULL, gdy nie udało się
+ *         alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
+ */
+PhoneNumbersIter * phfwdReverseIter(PhoneForward const *pf, char const *num) {
+    return phfwdReverseOrGetReverseIter(pf, num, false);
+}
+
+/** @brief Tworzy iterator po wynikach funkcji phfwdGetReverse.
+ * Działa tak jak @ref phfwdReverseIter, ale zwraca tylko numery, które są
+ * przekierowywane na numer @p num.
+ * @param[in] pf  - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num - wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na utworzony iterator lub NULL, gdy nie udało się
+ *         alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
+ */
+PhoneNumbersIter * phfwdGetReverseIter(PhoneForward const *pf, char const *num) {
+    return phfwdReverseOrGetReverseIter(pf, num, true);
+}
+
+/** @brief Udostępnia kolejny numer.
+ * Nie alokuje pamięci.
+ * @param[in,out] it - wskaźnik na iterator.
+ * @return Wskaźnik na napis reprezentujący kolejny numer, ważny do następnego
+ *         wywołania funkcji na tym iteratorze. Wartość NULL, gdy nie ma więcej
+ *         numerów lub wskaźnik @p it ma wartość NULL.
+ */
+char const * phfwdIterNext(PhoneNumbersIter *it) {
+    if (it == NULL) {
+        return NULL;
+    }
+    while (it->heap_size > 0) {
+        ReverseRun *run = it->heap[0];
+        ReverseSource const source = run->head;
+        advanceRun(it, run);
+        if (!run->has_head) {
+            --(it->heap_size);
+            it->heap[0] = it->heap[it->heap_size];
+        }
+        siftDown(it, 0);
+        if (it->has_previous && (compareSources(&source, &(it->previous)) == 0)) {
+            continue; // Powtórzenia wychodzą z kopca jedno po drugim.
+        }
+        it->previous = source;
+        it->has_previous = true;
+
+        size_t prefix_length = 0;
+        if (source.element != NULL) {
+            prefix_length = source.element->number_length;
+            memcpy(it->current.digits, source.element->digits, packedSize(prefix_length));
+        }
+        it->current.length = sourceLength(&source);
+        for (size_t i = prefix_length; i < it->current.length; ++i) {
+            setPackedDigit(it->current.digits, i, sourceDigit(&source, i));
+        }
+
+        if (it->only_counterimage && !isCounterimage(it->pf, &(it->current), &(it->query))) {
+            continue;
+        }
+        unpackDigits(it->text, it->current.digits, it->current.length);
+        (it->text)[it->current.length] = '\0';
+        return it->text;
+    }
+    return NULL;
+}
+
+/** @brief Przesuwa iterator za podany numer.
+ * Ustawia iterator tak, aby kolejnym zwróconym numerem był najmniejszy numer
+ * większy od @p after. Jeśli @p after ma wartość NULL, iterator wraca na
+ * początek. Jeśli napis @p after nie reprezentuje numeru, iterator zostaje
+ * ustawiony na koniec. Przesunięcie do przodu pomija wyniki bez ich
+ * tworzenia, a przesunięcie do tyłu zaczyna przeglądanie od początku.
+ * Nie alokuje pamięci.
+ * @param[in,out] it - wskaźnik na iterator;
+ * @param[in] after - wskaźnik na napis reprezentujący ostatni odczytany numer.
+ */
+void phfwdIterSeek(PhoneNumbersIter *it, char const *after) {
+    if (it == NULL) {
+        return;
+    }
+    if (after == NULL) {
+        rewindRuns(it);
+        buildHeap(it);
+        return;
+    }
+    if (!onlyDigitsAndNotEmpty(after)) {
+        it->heap_size = 0;
+        return;
+    }
+    if (!it->has_previous || (compareSourceWithNumber(&(it->previous), after) > 0)) {
+        rewindRuns(it); // Nie wiadomo, czy wszystkie wyniki większe od after są jeszcze nieodczytane.
+    }
+    for (size_t i = 0; i < it->runs_count; ++i) {
+        ReverseRun *run = &(it->runs[i]);
+        while (run->has_head && (compareSourceWithNumber(&(run->head), after) <= 0)) {
+            advanceRun(it, run);
+        }
+    }
+    it->has_previous = false; // Pominięte wyniki nie są większe od after, więc nie powtórzą się.
+    buildHeap(it);
+}
+
+/** @brief Wyznacza kolejną stronę wyników iteratora.
+ * Wyznacza co najwyżej @p limit kolejnych numerów iteratora. Kolejne
+ * wywołanie zaczyna się tam, gdzie skończyło się poprzednie, bez ponownego
+ * przeglądania wcześniejszych wyników, więc przejście wszystkich stron kosztuje
+ * tyle, co jedno przejście iteratora. Alokuje strukturę @p PhoneNumbers, która
+ * musi być zwolniona za pomocą funkcji @ref phnumDelete.
+ * @param[in,out] it - wskaźnik na iterator;
+ * @param[in] limit  - maksymalna liczba numerów na stronie.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci albo wskaźnik @p it ma wartość NULL.
+ */
+PhoneNumbers * phfwdIterPage(PhoneNumbersIter *it, size_t limit) {
+    if (it == NULL) {
+        return NULL;
+    }
+    return phnumFromIter(it, limit);
+}
+
+/** @brief Usuwa iterator.
+ * Nic nie robi, jeśli wskaźnik @p it ma wartość NULL.
+ * @param[in] it - wskaźnik na usuwany iterator.
+ */
+void phfwdIterDelete(PhoneNumbersIter *it) {
+    if (it != NULL) {
+        free(it->query.digits);
+        free(it->runs);
+        free(it->heap);
+        free(it->deferred);
+        free(it->current.digits);
+        free(it->text);
+        free(it);
+    }
+}
+
+/** @brief Wyznacza stronę wyników funkcji phfwdReverse.
+ * Wyznacza co najwyżej @p limit kolejnych numerów z wyniku funkcji
+ * @ref phfwdReverse, większych od numeru @p after. Jeśli @p after ma wartość
+ * NULL, strona zaczyna się od pierwszego numeru. Ostatni numer strony służy
+ * jako wartość @p after przy pobieraniu kolejnej strony. Każde wywołanie
+ * pomija od nowa wyniki nie większe od @p after, więc do przeglądania wielu
+ * kolejnych stron służy iterator i funkcja @ref phfwdIterPage. Alokuje
+ * strukturę @p PhoneNumbers, która musi być zwolniona za pomocą funkcji
+ * @ref phnumDelete.
+ * @param[in] pf    - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num   - wskaźnik na napis reprezentujący numer;
+ * @param[in] after - wskaźnik na napis reprezentujący ostatni numer poprzedniej strony;
+ * @param[in] limit - maksymalna liczba numerów na stronie.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
+ */
+PhoneNumbers * phfwdReversePage(PhoneForward const *pf, char const *num, char const *after, size_t limit) {
+    PhoneNumbersIter *it = phfwdReverseIter(pf, num);
+    if (it == NULL) {
+        return NULL;
+    }
+    phfwdIterSeek(it, after);
+    PhoneNumbers *result = phnumFromIter(it, limit);
+    phfwdIterDelete(it);
+    return result;
+}
+
+/** @brief Tworzy pusty ciąg numerów.
+ * Alokuje strukturę @p PhoneNumbers, która musi być zwolniona za pomocą
+ * funkcji @ref phnumDelete.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+PhoneNumbers * newPhoneNumbers(void) {
+    PhoneNumbers *result = malloc(sizeof(*result));
+    if (result != NULL) {
+        result->list = newList();
+        if (result->list == NULL) {
+            free(result);
+            result = NULL;
+        }
+    }
+    return result;
+}
+
+/** @brief Tworzy ciąg numerów z kolejnych wyników iteratora.
+ * Alokuje strukturę @p PhoneNumbers, która musi być zwolniona za pomocą
+ * funkcji @ref phnumDelete.
+ * @param[in,out] it - wskaźnik na iterator;
+ * @param[in] limit  - maksymalna liczba numerów w ciągu.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * phnumFromIter(PhoneNumbersIter *it, size_t limit) {
+    PhoneNumbers *result = newPhoneNumbers();
+    if (result == NULL) {
+        return NULL;
+    }
+    char const *number = NULL;
+    while ((result->list->list_size < limit) && ((number = phfwdIterNext(it)) != NULL)) {
+        if (!addElement(result->list, number, howLong(number))) {
+            phnumDelete(result);
+            return NULL;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,117 @@
+/** @file
+ * Interfejs klasy iteratora po wynikach funkcji phfwdReverse i phfwdGetReverse
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_ITERATOR_H__
+#define __PHFWD_ITERATOR_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+#include "list.h"
+#include "packed_number.h"
+
+/**
+ * To jest struktura opisująca jeden wynik odwrócenia bez jego materializowania.
+ * Wynik jest konkatenacją numeru zapisanego w węźle listy drzewa odwróceń
+ * i sufiksu numeru zapytania zaczynającego się na pozycji @p suffix_start.
+ */
+typedef struct ReverseSource {
+    OneNumber const *element; ///< węzeł listy drzewa odwróceń lub NULL, gdy wynikiem jest sam numer zapytania
+    PackedNumber const *query; ///< spakowany numer zapytania
+    size_t suffix_start; ///< pozycja w numerze zapytania, od której zaczyna się sufiks
+} ReverseSource;
+
+/**
+ * To jest struktura opisująca jedną serię wyników odwrócenia: wyniki powstałe
+ * z listy jednego węzła drzewa odwróceń na ścieżce numeru zapytania albo sam
+ * numer zapytania. Lista węzła jest posortowana, ale wynik powstały z wpisu,
+ * którego prefiksem jest wcześniejszy wpis, może być mniejszy od wyniku
+ * powstałego z wcześniejszego wpisu. Dlatego wpisy będące prefiksami kolejnego
+ * wpisu listy czekają na stosie @p deferred, dopóki nie okażą się najmniejsze.
+ */
+typedef struct ReverseRun {
+    struct Node const *node; ///< węzeł drzewa odwróceń lub NULL dla serii złożonej z samego numeru zapytania
+    OneNumber const *next; ///< kolejny nieodczytany aktualny wpis listy węzła lub NULL
+    OneNumber const **deferred; ///< odczytane z listy wpisy, z których każdy jest prefiksem następnego
+    size_t deferred_count; ///< liczba wpisów na stosie @p deferred
+    size_t deferred_capacity; ///< rozmiar stosu @p deferred
+    ReverseSource head; ///< najmniejszy nieodczytany wynik serii
+    bool has_head; ///< czy seria ma jeszcze wyniki
+} ReverseRun;
+
+/**
+ * To jest struktura iteratora po posortowanych wynikach odwrócenia.
+ * Iterator scala na bieżąco posortowane serie wyników, więc jego pamięć
+ * zależy od długości numeru zapytania i najdłuższego numeru przekierowywanego,
+ * a nie od liczby wyników.
+ */
+struct PhoneNumbersIter {
+    PhoneForward const *pf; ///< wskaźnik na strukturę przechowującą przekierowania
+    PackedNumber query; ///< spakowany numer zapytania
+    ReverseRun *runs; ///< serie wyników
+    size_t runs_count; ///< liczba elementów tablicy @p runs
+    ReverseRun **heap; ///< kopiec serii mających wyniki, uporządkowany według ich najmniejszych wyników
+    size_t heap_size; ///< liczba elementów kopca @p heap
+    OneNumber const **deferred; ///< pamięć na stosy wszystkich serii
+    ReverseSource previous; ///< ostatni wynik odczytany z serii, do pomijania powtórzeń
+    bool has_previous; ///< czy pole @p previous opisuje wynik
+    bool only_counterimage; ///< czy iterujemy po wynikach phfwdGetReverse
+    PackedNumber current; ///< bufor na spakowany bieżący wynik
+    char *text; ///< bufor na bieżący wynik w postaci napisu
+};
+
+/** @brief Zwraca długość wyniku opisanego przez strukturę @ref ReverseSource.
+ * @param[in] source - wskaźnik na opis wyniku
+ * @return Liczba cyfr wyniku.
+ */
+size_t sourceLength(ReverseSource const *source);
+
+/** @brief Zwraca wartość cyfry wyniku opisanego przez strukturę @ref ReverseSource.
+ * @param[in] source - wskaźnik na opis wyniku
+ * @param[in] i - pozycja cyfry
+ * @return Wartość cyfry z zakresu od 0 do 11.
+ */
+int sourceDigit(ReverseSource const *source, size_t i);
+
+/** @brief Porównuje 2 wyniki opisane przez struktury @ref ReverseSource.
+ * Funkcja w postaci wymaganej przez qsort.
+ * @param[in] source1 - wskaźnik na opis pierwszego wyniku
+ * @param[in] source2 - wskaźnik na opis drugiego wyniku
+ * @return Wartość @p 0, gdy wyniki są równe, wartość @p 1, gdy pierwszy wynik jest większy, a @p -1, gdy mniejszy.
+ */
+int compareSources(const void *source1, const void *source2);
+
+/** @brief Tworzy iterator po wynikach phfwdReverse lub phfwdGetReverse.
+ * @param[in] pf  - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num - wskaźnik na napis reprezentujący numer;
+ * @param[in] only_counterimage - zmienna informująca o tym, czy wyznaczamy tylko przeciwobraz phfwdGet
+ * @return Wskaźnik na utworzony iterator lub NULL, gdy nie udało się
+ *         alokować pamięci albo parametr pf ma wartość NULL.
+ */
+PhoneNumbersIter * phfwdReverseOrGetReverseIter(PhoneForward const *pf, char const *num, bool only_counterimage);
+
+/** @brief Tworzy pusty ciąg numerów.
+ * Alokuje strukturę @p PhoneNumbers, która musi być zwolniona za pomocą
+ * funkcji @ref phnumDelete.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+PhoneNumbers * newPhoneNumbers(void);
+
+/** @brief Tworzy ciąg numerów z kolejnych wyników iteratora.
+ * Alokuje strukturę @p PhoneNumbers, która musi być zwolniona za pomocą
+ * funkcji @ref phnumDelete.
+ * @param[in,out] it - wskaźnik na iterator;
+ * @param[in] limit  - maksymalna liczba numerów w ciągu.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * phnumFromIter(PhoneNumbersIter *it, size_t limit);
+
+#endif /* __PHFWD_ITERATOR_H__ */
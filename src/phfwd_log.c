@@ -0,0 +1,1337 @@
+/** @file
+ * Implementacja klasy dziennika operacji i migawek struktury przechowującej przekierowania
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include "phfwd_log.h"
+#include "phone_forward.h"
+#include "phfwd_auxiliary_functions.h"
+#include "phfwd_traversal.h"
+#include "phfwd_batch.h"
+#include "packed_number.h"
+#include "list.h"
+
+/**
+ * To jest napis rozpoczynający plik dziennika.
+ */
+#define LOG_MAGIC "PFWDLOG1"
+
+/**
+ * To jest napis rozpoczynający plik migawki.
+ */
+#define SNAPSHOT_MAGIC "PFWDSNP1"
+
+/**
+ * To jest napis rozpoczynający plik zmian zapisanych przyrostowo.
+ */
+#define DELTA_MAGIC "PFWDDLT1"
+
+/**
+ * To jest długość napisów rozpoczynających pliki.
+ */
+#define MAGIC_LENGTH 8
+
+/**
+ * To jest liczba bajtów identyfikatora migawki lub pliku zmian.
+ */
+#define ID_BYTES 8
+
+/**
+ * To jest rodzaj rekordu opisującego dodanie przekierowania.
+ */
+#define RECORD_ADD 1
+
+/**
+ * To jest rodzaj rekordu opisującego usunięcie przekierowań.
+ */
+#define RECORD_REMOVE 2
+
+/**
+ * To jest maksymalna liczba bajtów zapisu długości numeru.
+ */
+#define VARINT_BYTES 10
+
+/**
+ * To jest liczba bajtów sumy kontrolnej rekordu.
+ */
+#define CHECKSUM_BYTES 4
+
+/**
+ * To jest początkowy rozmiar bufora zapisu i odczytu.
+ */
+#define IO_BUFFER_SIZE (1 << 16)
+
+/**
+ * To jest liczba operacji odtwarzanych jednym wywołaniem @ref phfwdApplyBatch.
+ */
+#define REPLAY_BATCH 4096
+
+/**
+ * To jest struktura opisująca rekord odczytany z pliku.
+ * Wskaźniki na cyfry są ważne do kolejnego odczytu.
+ */
+typedef struct LogRecord {
+    int type; ///< rodzaj rekordu
+    size_t length1; ///< długość pierwszego numeru
+    size_t length2; ///< długość drugiego numeru; 0 dla usunięcia
+    unsigned char const *digits1; ///< spakowane cyfry pierwszego numeru
+    unsigned char const *digits2; ///< spakowane cyfry drugiego numeru
+} LogRecord;
+
+/**
+ * To jest struktura czytająca kolejne rekordy z pliku przez duży bufor.
+ */
+typedef struct RecordReader {
+    int fd; ///< deskryptor czytanego pliku
+    unsigned char *buffer; ///< bufor odczytu
+    size_t start; ///< pozycja pierwszego nieprzetworzonego bajtu bufora
+    size_t end; ///< pozycja za ostatnim wczytanym bajtem bufora
+    size_t capacity; ///< rozmiar bufora
+    size_t consumed; ///< liczba bajtów pliku zajętych przez poprawnie odczytane rekordy
+    size_t file_size; ///< rozmiar pliku
+    bool failed; ///< czy wystąpił błąd odczytu lub alokacji pamięci
+} RecordReader;
+
+/** @brief Wyznacza sumę kontrolną (FNV-1a) ciągu bajtów.
+ * @param[in] bytes - wskaźnik na ciąg bajtów
+ * @param[in] size - długość ciągu
+ * @return Suma kontrolna.
+ */
+static uint32_t checksum(unsigned char const *bytes, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/** @brief Zapisuje liczbę w postaci o zmiennej długości (po 7 bitów na bajt).
+ * @param[out] out - wskaźnik na miejsce zapisu
+ * @param[in] value - zapisywana liczba
+ * @return Liczba zapisanych bajtów.
+ */
+static size_t putVarint(unsigned char *out, size_t value) {
+    size_t i = 0;
+    while (value >= 0x80) {
+        out[i++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[i++] = (unsigned char)value;
+    return i;
+}
+
+/** @brief Zapisuje cały ciąg bajtów do pliku.
+ * @param[in] fd - deskryptor pliku
+ * @param[in] bytes - wskaźnik na ciąg bajtów
+ * @param[in] size - długość ciągu
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool writeAll(int fd, unsigned char const *bytes, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+/** @brief Przygotowuje dziennik do zapisu rekordów do pliku.
+ * @param[out] log - wskaźnik na dziennik
+ * @param[in] fd - deskryptor pliku otwartego do zapisu
+ * @param[in] sync_every - co ile rekordów synchronizować plik
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool logInit(PhoneForwardLog *log, int fd, size_t sync_every) {
+    log->fd = fd;
+    log->used = 0;
+    log->capacity = IO_BUFFER_SIZE;
+    log->pending = 0;
+    log->sync_every = sync_every;
+    log->failed = false;
+    log->buffer = malloc(log->capacity);
+    return log->buffer != NULL;
+}
+
+/** @brief Zapisuje do pliku rekordy zgromadzone w buforze.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool logFlush(PhoneForwardLog *log) {
+    if (!log->failed && (log->used > 0) && !writeAll(log->fd, log->buffer, log->used)) {
+        log->failed = true;
+    }
+    log->used = 0;
+    return !log->failed;
+}
+
+/** @brief Zapisuje rekordy z bufora i synchronizuje plik z dyskiem.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool logSync(PhoneForwardLog *log) {
+    if (logFlush(log) && (fdatasync(log->fd) != 0)) {
+        log->failed = true;
+    }
+    log->pending = 0;
+    return !log->failed;
+}
+
+/** @brief Dopisuje rekord do bufora dziennika.
+ * Rekord składa się z rodzaju, długości numerów, spakowanych cyfr
+ * i sumy kontrolnej poprzedzających bajtów.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @param[in] type - rodzaj rekordu
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer lub NULL
+ */
+static void logRecord(PhoneForwardLog *log, int type, char const *num1, char const *num2) {
+    if (log->failed) {
+        return;
+    }
+    size_t length1 = howLong(num1);
+    size_t length2 = (num2 == NULL) ? 0 : howLong(num2);
+    size_t bound = 1 + 2 * VARINT_BYTES + packedSize(length1) + packedSize(length2) + CHECKSUM_BYTES;
+    if ((log->used + bound > log->capacity) && !logFlush(log)) {
+        return;
+    }
+    if (bound > log->capacity) {
+        unsigned char *help = realloc(log->buffer, bound);
+        if (help == NULL) {
+            log->failed = true;
+            return;
+        }
+        log->buffer = help;
+        log->capacity = bound;
+    }
+
+    unsigned char *record = log->buffer + log->used;
+    size_t size = 0;
+    record[size++] = (unsigned char)type;
+    size += putVarint(record + size, length1);
+    if (type == RECORD_ADD) {
+        size += putVarint(record + size, length2);
+    }
+    packDigits(record + size, num1, length1);
+    size += packedSize(length1);
+    if (type == RECORD_ADD) {
+        packDigits(record + size, num2, length2);
+        size += packedSize(length2);
+    }
+    uint32_t sum = checksum(record, size);
+    for (int i = 0; i < CHECKSUM_BYTES; ++i) {
+        record[size++] = (unsigned char)(sum >> (8 * i));
+    }
+    log->used += size;
+
+    ++(log->pending);
+    if ((log->sync_every > 0) && (log->pending >= log->sync_every)) {
+        logSync(log);
+    }
+}
+
+/** @brief Dopisuje do dziennika rekord dodania przekierowania.
+ * Błąd zapisu jest zapamiętywany i zgłaszany przez @ref phfwdSyncLog.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest wykonywane przekierowanie
+ */
+void logAdd(PhoneForwardLog *log, char const *num1, char const *num2) {
+    logRecord(log, RECORD_ADD, num1, num2);
+}
+
+/** @brief Dopisuje do dziennika rekord usunięcia przekierowań.
+ * Błąd zapisu jest zapamiętywany i zgłaszany przez @ref phfwdSyncLog.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @param[in] num - wskaźnik na napis reprezentujący prefiks usuwanych numerów
+ */
+void logRemove(PhoneForwardLog *log, char const *num) {
+    logRecord(log, RECORD_REMOVE, num, NULL);
+}
+
+/** @brief Dopisuje do dziennika rekord dodania jednego przekierowania.
+ * @param[in] num1 - wskaźnik na napis reprezentujący numer przekierowywany
+ * @param[in] num2 - wskaźnik na napis reprezentujący numer, na który jest wykonywane przekierowanie
+ * @param[in] data - wskaźnik na dziennik
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool logForward(char const *num1, char const *num2, void *data) {
+    PhoneForwardLog *log = data;
+    logAdd(log, num1, num2);
+    return !log->failed;
+}
+
+/** @brief Dopisuje do dziennika rekordy dodania wszystkich przekierowań struktury.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool logForwards(PhoneForwardLog *log, PhoneForward const *pf) {
+    return phfwdForEachPrefix(pf, NULL, logForward, log);
+}
+
+/** @brief Zamyka dziennik i zwalnia jego pamięć.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @return Wartość @p true, jeśli wszystkie rekordy zostały zapisane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool logClose(PhoneForwardLog *log) {
+    bool result = logSync(log);
+    if (close(log->fd) != 0) {
+        result = false;
+    }
+    free(log->buffer);
+    free(log);
+    return result;
+}
+
+/** @brief Zapewnia, że w buforze jest co najmniej @p needed nieprzetworzonych bajtów.
+ * @param[in,out] reader - wskaźnik na strukturę czytającą
+ * @param[in] needed - wymagana liczba bajtów
+ * @return Wartość @p true, jeśli udało się wczytać wymaganą liczbę bajtów.
+ *         Wartość @p false, jeśli plik się skończył lub wystąpił błąd.
+ */
+static bool readerFill(RecordReader *reader, size_t needed) {
+    if (reader->end - reader->start >= needed) {
+        return true;
+    }
+    if (reader->consumed + needed > reader->file_size) {
+        return false; // Rekord wykracza poza plik.
+    }
+    memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+    reader->end -= reader->start;
+    reader->start = 0;
+    if (needed > reader->capacity) {
+        unsigned char *help = realloc(reader->buffer, needed);
+        if (help == NULL) {
+            reader->failed = true;
+            return false;
+        }
+        reader->buffer = help;
+        reader->capacity = needed;
+    }
+    while (reader->end < needed) {
+        ssize_t got = read(reader->fd, reader->buffer + reader->end, reader->capacity - reader->end);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            reader->failed = true;
+            return false;
+        }
+        if (got == 0) {
+            return false;
+        }
+        reader->end += (size_t)got;
+    }
+    return true;
+}
+
+/** @brief Przygotowuje czytanie rekordów z pliku.
+ * Sprawdza, czy plik zaczyna się od napisu @p magic.
+ * @param[out] reader - wskaźnik na strukturę czytającą
+ * @param[in] fd - deskryptor pliku otwartego do odczytu
+ * @param[in] magic - napis, od którego powinien zaczynać się plik
+ * @return Wartość @p true, jeśli plik zaczyna się od napisu @p magic.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool readerInit(RecordReader *reader, int fd, char const *magic) {
+    struct stat info;
+    reader->fd = fd;
+    reader->start = 0;
+    reader->end = 0;
+    reader->capacity = IO_BUFFER_SIZE;
+    reader->consumed = 0;
+    reader->failed = false;
+    reader->file_size = 0;
+    reader->buffer = malloc(reader->capacity);
+    if ((reader->buffer == NULL) || (fstat(fd, &info) != 0)) {
+        reader->failed = true;
+        return false;
+    }
+    reader->file_size = (size_t)info.st_size;
+    if (!readerFill(reader, MAGIC_LENGTH) || (memcmp(reader->buffer, magic, MAGIC_LENGTH) != 0)) {
+        return false;
+    }
+    reader->start = MAGIC_LENGTH;
+    reader->consumed = MAGIC_LENGTH;
+    return true;
+}
+
+/** @brief Odczytuje identyfikatory zapisane za napisem rozpoczynającym plik.
+ * @param[in,out] reader - wskaźnik na strukturę czytającą
+ * @param[out] ids - tablica odczytanych identyfikatorów
+ * @param[in] count - liczba identyfikatorów
+ * @return Wartość @p true, jeśli odczyt się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool readerIds(RecordReader *reader, uint64_t *ids, size_t count) {
+    if (!readerFill(reader, count * ID_BYTES)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        ids[i] = 0;
+        for (int k = 0; k < ID_BYTES; ++k) {
+            ids[i] |= (uint64_t)reader->buffer[reader->start + k] << (8 * k);
+        }
+        reader->start += ID_BYTES;
+        reader->consumed += ID_BYTES;
+    }
+    return true;
+}
+
+/** @brief Odczytuje liczbę zapisaną w postaci o zmiennej długości.
+ * @param[in,out] reader - wskaźnik na strukturę czytającą
+ * @param[in,out] offset - pozycja liczby względem początku rekordu; jest przesuwana za liczbę
+ * @param[out] value - odczytana liczba
+ * @return Wartość @p true, jeśli odczyt się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool readVarint(RecordReader *reader, size_t *offset, size_t *value) {
+    *value = 0;
+    for (int i = 0; i < VARINT_BYTES; ++i) {
+        if (!readerFill(reader, *offset + 1)) {
+            return false;
+        }
+        unsigned char byte = reader->buffer[reader->start + *offset];
+        ++(*offset);
+        *value |= (size_t)(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @brief Odczytuje kolejny rekord.
+ * Uszkodzony lub niepełny rekord, np. zapisany częściowo przed awarią,
+ * jest traktowany jak koniec pliku.
+ * @param[in,out] reader - wskaźnik na strukturę czytającą
+ * @param[out] record - wskaźnik na opis odczytanego rekordu
+ * @return Wartość @p true, jeśli odczytano poprawny rekord.
+ *         Wartość @p false, jeśli rekordów już nie ma lub wystąpił błąd
+ *         (wtedy @p reader->failed ma wartość @p true).
+ */
+static bool readRecord(RecordReader *reader, LogRecord *record) {
+    size_t offset = 1;
+    if (!readerFill(reader, 1)) {
+        return false;
+    }
+    record->type = reader->buffer[reader->start];
+    record->length2 = 0;
+    if (((record->type != RECORD_ADD) && (record->type != RECORD_REMOVE))
+        || !readVarint(reader, &offset, &(record->length1)) || (record->length1 == 0)) {
+        return false;
+    }
+    if ((record->type == RECORD_ADD)
+        && (!readVarint(reader, &offset, &(record->length2)) || (record->length2 == 0))) {
+        return false;
+    }
+    size_t digits = offset;
+    size_t size = digits + packedSize(record->length1) + packedSize(record->length2);
+    if ((size < digits) || !readerFill(reader, size + CHECKSUM_BYTES)) {
+        return false;
+    }
+    unsigned char const *bytes = reader->buffer + reader->start;
+    uint32_t sum = 0;
+    for (int i = 0; i < CHECKSUM_BYTES; ++i) {
+        sum |= (uint32_t)bytes[size + i] << (8 * i);
+    }
+    if (sum != checksum(bytes, size)) {
+        return false;
+    }
+    record->digits1 = bytes + digits;
+    record->digits2 = record->digits1 + packedSize(record->length1);
+    reader->start += size + CHECKSUM_BYTES;
+    reader->consumed += size + CHECKSUM_BYTES;
+    return true;
+}
+
+/** @brief Sprawdza, czy spakowany numer składa się z poprawnych cyfr.
+ * @param[in] digits - wskaźnik na spakowane cyfry
+ * @param[in] length - liczba cyfr
+ * @return Wartość @p true, jeśli wszystkie cyfry są poprawne.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool validDigits(unsigned char const *digits, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        int value = packedDigitValue(digits, i);
+        if ((value < 0) || (value >= SONS)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Synchronizuje z dyskiem katalog zawierający plik.
+ * Dzięki temu przemianowanie pliku jest trwałe.
+ * @param[in] path - wskaźnik na napis reprezentujący ścieżkę pliku
+ * @return Wartość @p true, jeśli synchronizacja się powiodła.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool syncDirectory(char const *path) {
+    char const *slash = strrchr(path, '/');
+    size_t length = (slash == NULL) ? 1 : (size_t)(slash - path) + 1;
+    char *directory = malloc(length + 1);
+    if (directory == NULL) {
+        return false;
+    }
+    memcpy(directory, (slash == NULL) ? "." : path, length);
+    directory[length] = '\0';
+    int fd = open(directory, O_RDONLY);
+    free(directory);
+    if (fd < 0) {
+        return false;
+    }
+    bool result = (fsync(fd) == 0);
+    close(fd);
+    return result;
+}
+
+/**
+ * To jest typ funkcji dopisującej rekordy do zapisywanego pliku.
+ */
+typedef bool (*RecordWriter)(PhoneForwardLog *writer, void *data);
+
+/** @brief Atomowo zapisuje plik z rekordami.
+ * Plik zaczyna się od napisu @p magic i identyfikatorów @p ids. Jest
+ * najpierw zapisywany pod nazwą z dodanym sufiksem ".tmp", synchronizowany
+ * z dyskiem, a następnie przemianowywany, więc po awarii pozostaje
+ * poprzednia lub nowa wersja pliku.
+ * @param[in] path - wskaźnik na napis reprezentujący ścieżkę pliku
+ * @param[in] magic - napis rozpoczynający plik
+ * @param[in] ids - tablica identyfikatorów zapisywanych za napisem
+ * @param[in] count - liczba identyfikatorów
+ * @param[in] records - funkcja dopisująca rekordy
+ * @param[in] data - wskaźnik przekazywany funkcji @p records
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool saveFile(char const *path, char const *magic, uint64_t const *ids, size_t count,
+                     RecordWriter records, void *data) {
+    size_t length = strlen(path);
+    char *temporary = malloc(length + sizeof(".tmp"));
+    if (temporary == NULL) {
+        return false;
+    }
+    memcpy(temporary, path, length);
+    memcpy(temporary + length, ".tmp", sizeof(".tmp"));
+
+    bool result = false;
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        PhoneForwardLog writer;
+        if (logInit(&writer, fd, 0)) {
+            memcpy(writer.buffer, magic, MAGIC_LENGTH);
+            writer.used = MAGIC_LENGTH;
+            for (size_t i = 0; i < count; ++i) {
+                for (int k = 0; k < ID_BYTES; ++k) {
+                    writer.buffer[writer.used++] = (unsigned char)(ids[i] >> (8 * k));
+                }
+            }
+            result = records(&writer, data) && logSync(&writer);
+        }
+        free(writer.buffer);
+        result = (close(fd) == 0) && result;
+        result = result && (rename(temporary, path) == 0) && syncDirectory(path);
+        if (!result) {
+            unlink(temporary);
+        }
+    }
+    free(temporary);
+    return result;
+}
+
+/** @brief Dopisuje do zapisywanego pliku rekordy dodania wszystkich przekierowań.
+ * @param[in,out] writer - wskaźnik na strukturę zapisującą plik
+ * @param[in] data - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool snapshotRecords(PhoneForwardLog *writer, void *data) {
+    return logForwards(writer, data);
+}
+
+/** @brief Zapisuje do pliku migawkę przekierowań.
+ * Migawka zawiera rekordy dodania wszystkich przekierowań w porządku
+ * leksykograficznym parametrów num1, więc może być wczytana przez
+ * @ref phfwdBulkLoad. Plik jest najpierw zapisywany pod nazwą z dodanym
+ * sufiksem ".tmp", synchronizowany z dyskiem, a następnie atomowo
+ * przemianowywany, więc po awarii pozostaje poprzednia lub nowa migawka.
+ * Taka migawka nie może być podstawą zapisu przyrostowego
+ * (zob. @ref phfwdSaveIncremental).
+ * @param[in] pf   - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path - wskaźnik na napis reprezentujący ścieżkę pliku.
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdSaveSnapshot(PhoneForward const *pf, char const *path) {
+    if ((pf == NULL) || (pf->engine != NULL) || (path == NULL)) {
+        return false;
+    }
+    uint64_t id = 0;
+    return saveFile(path, SNAPSHOT_MAGIC, &id, 1, snapshotRecords, (void *)pf);
+}
+
+/**
+ * To jest stan funkcji zwracającej kolejne przekierowania z migawki.
+ */
+typedef struct SnapshotSource {
+    RecordReader reader; ///< struktura czytająca rekordy migawki
+    char *num1; ///< bufor na pierwszy numer
+    char *num2; ///< bufor na drugi numer
+    size_t capacity; ///< rozmiar buforów
+} SnapshotSource;
+
+/** @brief Zwraca kolejne przekierowanie z migawki dla @ref phfwdBulkLoad.
+ * Po błędzie lub uszkodzonym rekordzie zwraca pusty numer, co przerywa
+ * wczytywanie z błędem.
+ * @param[out] num1 - adres, pod którym jest zapisywany wskaźnik na numer przekierowywany
+ * @param[out] num2 - adres, pod którym jest zapisywany wskaźnik na numer, na który jest wykonywane przekierowanie
+ * @param[in,out] data - wskaźnik na strukturę @ref SnapshotSource
+ * @return Wartość @p true, jeśli zwrócono przekierowanie.
+ *         Wartość @p false, jeśli migawka się skończyła.
+ */
+static bool nextSnapshotForward(char const **num1, char const **num2, void *data) {
+    SnapshotSource *source = data;
+    LogRecord record;
+    if (!readRecord(&(source->reader), &record)) {
+        if (!source->reader.failed && (source->reader.consumed == source->reader.file_size)) {
+            return false;
+        }
+        source->num1[0] = '\0'; // Migawka jest uszkodzona.
+        *num1 = source->num1;
+        *num2 = source->num1;
+        return true;
+    }
+    size_t longer = (record.length1 > record.length2) ? record.length1 : record.length2;
+    if (longer + 1 > source->capacity) {
+        char *help1 = realloc(source->num1, longer + 1);
+        if (help1 != NULL) {
+            source->num1 = help1;
+        }
+        char *help2 = realloc(source->num2, longer + 1);
+        if (help2 != NULL) {
+            source->num2 = help2;
+        }
+        if ((help1 == NULL) || (help2 == NULL)) {
+            source->reader.failed = true;
+            source->num1[0] = '\0';
+            *num1 = source->num1;
+            *num2 = source->num1;
+            return true;
+        }
+        source->capacity = longer + 1;
+    }
+    if ((record.type != RECORD_ADD) || !validDigits(record.digits1, record.length1)
+        || !validDigits(record.digits2, record.length2)) {
+        source->num1[0] = '\0';
+    }
+    else {
+        unpackDigits(source->num1, record.digits1, record.length1);
+        source->num1[record.length1] = '\0';
+        unpackDigits(source->num2, record.digits2, record.length2);
+        source->num2[record.length2] = '\0';
+    }
+    *num1 = source->num1;
+    *num2 = source->num2;
+    return true;
+}
+
+/** @brief Wczytuje migawkę przekierowań do pustej struktury.
+ * Wczytuje plik zapisany przez @ref phfwdSaveSnapshot za pomocą
+ * @ref phfwdBulkLoad. Wczytane przekierowania nie są zapisywane do
+ * dziennika operacji. Jeśli funkcja zwróci @p false, struktura pozostaje pusta.
+ * Migawka zapisana przez @ref phfwdSaveIncremental może być następnie
+ * uzupełniona plikami zmian za pomocą @ref phfwdLoadIncremental.
+ * @param[in,out] pf - wskaźnik na pustą strukturę przechowującą przekierowania numerów;
+ * @param[in] path   - wskaźnik na napis reprezentujący ścieżkę pliku.
+ * @return Wartość @p true, jeśli migawka została wczytana.
+ *         Wartość @p false, jeśli struktura nie była pusta, nie udało się
+ *         odczytać pliku, plik jest uszkodzony lub nie udało się alokować pamięci.
+ */
+bool phfwdLoadSnapshot(PhoneForward *pf, char const *path) {
+    if ((pf == NULL) || (pf->engine != NULL) || (path == NULL)) {
+        return false;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    SnapshotSource source;
+    source.capacity = 1;
+    source.num1 = malloc(source.capacity);
+    source.num2 = malloc(source.capacity);
+    uint64_t id = 0;
+    bool result = readerInit(&(source.reader), fd, SNAPSHOT_MAGIC) && readerIds(&(source.reader), &id, 1)
+                  && (source.num1 != NULL) && (source.num2 != NULL);
+    if (result) {
+        PhoneForwardLog *log = pf->log;
+        pf->log = NULL;
+        result = phfwdBulkLoad(pf, nextSnapshotForward, &source);
+        pf->log = log;
+    }
+    if (result) {
+        clearMarks(pf);
+        pf->chain_id = id;
+    }
+    free(source.num1);
+    free(source.num2);
+    free(source.reader.buffer);
+    close(fd);
+    return result;
+}
+
+/**
+ * To jest struktura gromadząca operacje odtwarzane z dziennika.
+ * Numery są przechowywane w jednej tablicy znaków, a operacje pamiętają
+ * ich pozycje, bo tablica może zostać przeniesiona przy powiększaniu.
+ */
+typedef struct ReplayBatch {
+    PhoneForwardOperation operations[REPLAY_BATCH]; ///< operacje paczki
+    size_t offsets[REPLAY_BATCH][2]; ///< pozycje numerów operacji w tablicy @p text
+    size_t count; ///< liczba operacji paczki
+    char *text; ///< tablica numerów
+    size_t used; ///< liczba zajętych znaków tablicy @p text
+    size_t capacity; ///< rozmiar tablicy @p text
+} ReplayBatch;
+
+/** @brief Dopisuje numer do tablicy numerów paczki.
+ * @param[in,out] batch - wskaźnik na paczkę
+ * @param[in] digits - wskaźnik na spakowane cyfry numeru
+ * @param[in] length - liczba cyfr numeru
+ * @param[out] offset - pozycja numeru w tablicy numerów
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool replayText(ReplayBatch *batch, unsigned char const *digits, size_t length, size_t *offset) {
+    if (batch->used + length + 1 > batch->capacity) {
+        size_t capacity = more(batch->capacity);
+        if (capacity < batch->used + length + 1) {
+            capacity = batch->used + length + 1;
+        }
+        char *help = realloc(batch->text, capacity);
+        if (help == NULL) {
+            return false;
+        }
+        batch->text = help;
+        batch->capacity = capacity;
+    }
+    *offset = batch->used;
+    unpackDigits(batch->text + batch->used, digits, length);
+    batch->text[batch->used + length] = '\0';
+    batch->used += length + 1;
+    return true;
+}
+
+/** @brief Wykonuje zgromadzone operacje paczki.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in,out] batch - wskaźnik na paczkę
+ * @return Wartość @p true, jeśli operacje zostały wykonane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool replayFlush(PhoneForward *pf, ReplayBatch *batch) {
+    for (size_t i = 0; i < batch->count; ++i) {
+        batch->operations[i].num1 = batch->text + batch->offsets[i][0];
+        batch->operations[i].num2 = batch->text + batch->offsets[i][1];
+    }
+    bool result = phfwdApplyBatch(pf, batch->operations, batch->count);
+    batch->count = 0;
+    batch->used = 0;
+    return result;
+}
+
+/** @brief Wykonuje operacje zapisane w kolejnych rekordach pliku.
+ * Czyta rekordy do końca pliku lub pierwszego niepełnego albo uszkodzonego
+ * rekordu. Wykonywane operacje nie są zapisywane do dziennika dołączonego
+ * do struktury.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in,out] reader - wskaźnik na strukturę czytającą rekordy
+ * @return Wartość @p true, jeśli operacje zostały wykonane.
+ *         Wartość @p false, jeśli wystąpił błąd odczytu lub nie udało się alokować pamięci.
+ */
+static bool replayRecords(PhoneForward *pf, RecordReader *reader) {
+    ReplayBatch *batch = malloc(sizeof(*batch));
+    if (batch == NULL) {
+        return false;
+    }
+    PhoneForwardLog *log = pf->log;
+    pf->log = NULL;
+    batch->count = 0;
+    batch->text = NULL;
+    batch->used = 0;
+    batch->capacity = 0;
+    bool result = true;
+    LogRecord record;
+    while (result && readRecord(reader, &record)) {
+        if (!validDigits(record.digits1, record.length1) || !validDigits(record.digits2, record.length2)) {
+            break;
+        }
+        PhoneForwardOperation *operation = &(batch->operations[batch->count]);
+        operation->type = (record.type == RECORD_ADD) ? PHFWD_ADD : PHFWD_REMOVE;
+        result = replayText(batch, record.digits1, record.length1, &(batch->offsets[batch->count][0]))
+                 && replayText(batch, record.digits2, record.length2, &(batch->offsets[batch->count][1]));
+        if (result && (++(batch->count) == REPLAY_BATCH)) {
+            result = replayFlush(pf, batch);
+        }
+    }
+    result = result && !reader->failed && replayFlush(pf, batch);
+    free(batch->text);
+    free(batch);
+    pf->log = log;
+    return result;
+}
+
+/** @brief Odtwarza operacje zapisane w dzienniku.
+ * Wykonuje kolejno operacje z pliku dziennika paczkami za pomocą
+ * @ref phfwdApplyBatch. Niepełny lub uszkodzony rekord na końcu pliku,
+ * pozostały po awarii, kończy odtwarzanie. Odtworzone operacje nie są
+ * zapisywane do dziennika dołączonego do struktury. Odtworzenie dziennika
+ * na strukturze, która zawiera już skutki części jego operacji (np. po
+ * wczytaniu nowszej migawki), daje ten sam wynik, bo wartość każdego
+ * przekierowania zależy tylko od ostatniej dotyczącej go operacji.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path   - wskaźnik na napis reprezentujący ścieżkę pliku dziennika.
+ * @return Wartość @p true, jeśli dziennik został odtworzony.
+ *         Wartość @p false, jeśli nie udało się odczytać pliku, nie jest on
+ *         dziennikiem lub nie udało się alokować pamięci; wtedy część
+ *         operacji mogła zostać wykonana.
+ */
+bool phfwdReplay(PhoneForward *pf, char const *path) {
+    if ((pf == NULL) || (pf->engine != NULL) || (path == NULL)) {
+        return false;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    RecordReader reader;
+    bool result = readerInit(&reader, fd, LOG_MAGIC) && replayRecords(pf, &reader);
+    if (!reader.failed && (reader.file_size == 0)) {
+        result = true; // Pusty plik jest pustym dziennikiem.
+    }
+    free(reader.buffer);
+    close(fd);
+    return result;
+}
+
+/** @brief Dołącza do struktury dziennik operacji.
+ * Od tej chwili każde udane wywołanie @ref phfwdAdd, @ref phfwdRemove,
+ * @ref phfwdApplyBatch i @ref phfwdBulkLoad dopisuje do pliku dziennika
+ * rekordy w zwartej postaci binarnej. Rekordy są zapisywane do pliku
+ * grupami przez bufor, a plik jest synchronizowany z dyskiem co
+ * @p sync_every rekordów (0 oznacza synchronizację tylko przez
+ * @ref phfwdSyncLog i @ref phfwdCloseLog). Jeśli plik istnieje, jego
+ * uszkodzony koniec, pozostały po awarii, jest obcinany, a nowe rekordy
+ * są dopisywane za poprawnymi.
+ * @param[in,out] pf     - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path       - wskaźnik na napis reprezentujący ścieżkę pliku dziennika;
+ * @param[in] sync_every - co ile rekordów synchronizować plik z dyskiem.
+ * @return Wartość @p true, jeśli dziennik został dołączony.
+ *         Wartość @p false, jeśli struktura ma już dziennik, plik nie jest
+ *         dziennikiem, nie udało się go otworzyć lub alokować pamięci.
+ */
+bool phfwdOpenLog(PhoneForward *pf, char const *path, size_t sync_every) {
+    if ((pf == NULL) || (pf->engine != NULL) || (path == NULL) || (pf->log != NULL)) {
+        return false;
+    }
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    PhoneForwardLog *log = malloc(sizeof(*log));
+    bool result = (log != NULL) && logInit(log, fd, sync_every);
+
+    struct stat info;
+    if (result && ((result = (fstat(fd, &info) == 0)))) {
+        if (info.st_size == 0) {
+            result = writeAll(fd, (unsigned char const *)LOG_MAGIC, MAGIC_LENGTH) && (fdatasync(fd) == 0);
+        }
+        else {
+            RecordReader reader;
+            LogRecord record;
+            result = readerInit(&reader, fd, LOG_MAGIC);
+            while (result && readRecord(&reader, &record)) {
+            }
+            result = result && !reader.failed;
+            if (result && (reader.consumed < reader.file_size)) {
+                result = (ftruncate(fd, (off_t)reader.consumed) == 0) && (fdatasync(fd) == 0);
+            }
+            free(reader.buffer);
+        }
+    }
+
+    if (result) {
+        pf->log = log;
+    }
+    else {
+        if (log != NULL) {
+            free(log->buffer);
+        }
+        free(log);
+        close(fd);
+    }
+    return result;
+}
+
+/** @brief Zapisuje zgromadzone rekordy dziennika i synchronizuje go z dyskiem.
+ * Po udanym wywołaniu wszystkie wcześniejsze operacje są trwałe.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli zapis się powiódł lub struktura nie ma dziennika.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL lub zapis
+ *         któregoś rekordu dziennika się nie powiódł.
+ */
+bool phfwdSyncLog(PhoneForward *pf) {
+    if (pf == NULL) {
+        return false;
+    }
+    return (pf->log == NULL) || logSync(pf->log);
+}
+
+/** @brief Odłącza i zamyka dziennik operacji.
+ * Zapisuje zgromadzone rekordy i synchronizuje plik z dyskiem.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli zapis się powiódł lub struktura nie miała dziennika.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdCloseLog(PhoneForward *pf) {
+    if (pf == NULL) {
+        return false;
+    }
+    if (pf->log == NULL) {
+        return true;
+    }
+    bool result = logClose(pf->log);
+    pf->log = NULL;
+    return result;
+}
+
+/** @brief Zastępuje dziennik migawką.
+ * Zapisuje migawkę bieżącego stanu za pomocą @ref phfwdSaveSnapshot,
+ * a następnie obcina dziennik. Jeśli awaria nastąpi między tymi krokami,
+ * odtworzenie starego dziennika na nowej migawce daje ten sam stan.
+ * @param[in,out] pf        - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] snapshot_path - wskaźnik na napis reprezentujący ścieżkę pliku migawki.
+ * @return Wartość @p true, jeśli migawka została zapisana, a dziennik obcięty.
+ *         Wartość @p false, jeśli struktura nie ma dziennika lub zapis się nie powiódł.
+ */
+bool phfwdCompactLog(PhoneForward *pf, char const *snapshot_path) {
+    if ((pf == NULL) || (pf->log == NULL) || !logSync(pf->log) || !phfwdSaveSnapshot(pf, snapshot_path)) {
+        return false;
+    }
+    if ((ftruncate(pf->log->fd, MAGIC_LENGTH) != 0) || (fdatasync(pf->log->fd) != 0)) {
+        pf->log->failed = true;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * To jest struktura opisująca zapis migawki w procesie potomnym.
+ */
+struct PhoneForwardSave {
+    pid_t pid; ///< identyfikator procesu zapisującego migawkę lub 0, gdy zapis się nie toczy
+    PhoneForwardSaveStatus status; ///< stan ostatniego zapisu
+    PhoneForwardSaveCallback callback; ///< funkcja wywoływana po zakończeniu zapisu lub NULL
+    void *data; ///< wskaźnik przekazywany funkcji @p callback
+};
+
+/** @brief Zapisuje migawkę w tle.
+ * Tworzy proces potomny funkcją fork(), który zapisuje migawkę za pomocą
+ * @ref phfwdSaveSnapshot ze swojej kopii pamięci, współdzielonej z procesem
+ * macierzystym aż do pierwszego zapisu strony (kopiowanie przy zapisie).
+ * Proces macierzysty może w tym czasie dalej modyfikować strukturę,
+ * a migawka odpowiada stanowi z chwili wywołania. Zakończenie zapisu
+ * sprawdza funkcja @ref phfwdBackgroundSaveStatus, która wywołuje też
+ * funkcję @p callback. Dziennik operacji nie jest zmieniany; odtworzenie go
+ * na zapisanej migawce daje bieżący stan.
+ * @param[in,out] pf   - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path     - wskaźnik na napis reprezentujący ścieżkę pliku migawki;
+ * @param[in] callback - funkcja wywoływana po zakończeniu zapisu lub NULL;
+ * @param[in] data     - wskaźnik przekazywany funkcji @p callback.
+ * @return Wartość @p true, jeśli zapis został rozpoczęty.
+ *         Wartość @p false, jeśli poprzedni zapis jeszcze się toczy, nie
+ *         udało się utworzyć procesu lub alokować pamięci.
+ */
+bool phfwdBackgroundSave(PhoneForward *pf, char const *path, PhoneForwardSaveCallback callback, void *data) {
+    if ((pf == NULL) || (pf->engine != NULL) || (path == NULL)) {
+        return false;
+    }
+    if (pf->save == NULL) {
+        if ((pf->save = malloc(sizeof(*(pf->save)))) == NULL) {
+            return false;
+        }
+        pf->save->pid = 0;
+        pf->save->status = PHFWD_SAVE_NONE;
+    }
+    if (pf->save->pid != 0) {
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        // Proces potomny nie może zapisywać buforów procesu macierzystego.
+        _exit(phfwdSaveSnapshot(pf, path) ? 0 : 1);
+    }
+    pf->save->pid = pid;
+    pf->save->status = PHFWD_SAVE_RUNNING;
+    pf->save->callback = callback;
+    pf->save->data = data;
+    return true;
+}
+
+/** @brief Sprawdza stan zapisu migawki w tle.
+ * Jeśli zapis się zakończył, wywołuje funkcję przekazaną do
+ * @ref phfwdBackgroundSave (dokładnie raz) i zwraca jego wynik, aż do
+ * rozpoczęcia kolejnego zapisu.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] wait   - czy czekać na zakończenie zapisu.
+ * @return Stan ostatniego zapisu lub @p PHFWD_SAVE_NONE, jeśli żaden zapis
+ *         nie został rozpoczęty albo parametr pf ma wartość NULL.
+ */
+PhoneForwardSaveStatus phfwdBackgroundSaveStatus(PhoneForward *pf, bool wait) {
+    if ((pf == NULL) || (pf->save == NULL)) {
+        return PHFWD_SAVE_NONE;
+    }
+    struct PhoneForwardSave *save = pf->save;
+    if (save->pid != 0) {
+        int status = 0;
+        pid_t result;
+        do {
+            result = waitpid(save->pid, &status, wait ? 0 : WNOHANG);
+        } while ((result < 0) && (errno == EINTR));
+        if (result == 0) {
+            return PHFWD_SAVE_RUNNING;
+        }
+        save->pid = 0;
+        save->status = ((result > 0) && WIFEXITED(status) && (WEXITSTATUS(status) == 0))
+                       ? PHFWD_SAVE_DONE : PHFWD_SAVE_FAILED;
+        if (save->callback != NULL) {
+            save->callback(save->status == PHFWD_SAVE_DONE, save->data);
+        }
+    }
+    return save->status;
+}
+
+/** @brief Czeka na zakończenie zapisu migawki w tle i zwalnia jego zasoby.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ */
+void backgroundSaveFinish(PhoneForward *pf) {
+    if (pf->save != NULL) {
+        phfwdBackgroundSaveStatus(pf, true);
+        free(pf->save);
+        pf->save = NULL;
+    }
+}
+
+/**
+ * To jest wartość oznaczająca, że zapis nie przepisuje w całości żadnego poddrzewa.
+ */
+#define NO_REWRITE SIZE_MAX
+
+/**
+ * To jest stan zapisu przekierowań zmienionych od ostatniego zapisu przyrostowego.
+ */
+typedef struct DeltaSource {
+    PhoneForward *pf; ///< wskaźnik na strukturę przechowującą przekierowania numerów
+    bool full; ///< czy zapisywać wszystkie przekierowania
+    char *buffer; ///< bufor na numery zapisywanych rekordów
+    size_t capacity; ///< rozmiar bufora
+} DeltaSource;
+
+/** @brief Dopisuje do zapisywanego pliku rekord dodania przekierowania zapisanego w węźle.
+ * @param[in,out] writer - wskaźnik na strukturę zapisującą plik
+ * @param[in,out] source - wskaźnik na stan zapisu
+ * @param[in] path - wskaźnik na napis reprezentujący ścieżkę węzła
+ * @param[in] target - wskaźnik na numer, na który jest wykonywane przekierowanie
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool deltaAdd(PhoneForwardLog *writer, DeltaSource *source, char const *path, OneNumber const *target) {
+    if (!reserveArray((void **)&(source->buffer), &(source->capacity), target->number_length + 1, 1)) {
+        return false;
+    }
+    unpackDigits(source->buffer, target->digits, target->number_length);
+    source->buffer[target->number_length] = '\0';
+    logAdd(writer, path, source->buffer);
+    return !writer->failed;
+}
+
+/** @brief Dopisuje do zapisywanego pliku rekordy usunięcia poddrzew synów węzła.
+ * @param[in,out] writer - wskaźnik na strukturę zapisującą plik
+ * @param[in,out] source - wskaźnik na stan zapisu
+ * @param[in] path - wskaźnik na napis reprezentujący ścieżkę węzła
+ * @param[in] length - długość ścieżki
+ * @param[in] sons - maska cyfr synów
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool deltaRemoveSons(PhoneForwardLog *writer, DeltaSource *source, char const *path, size_t length,
+                            unsigned sons) {
+    if (sons == 0) {
+        return true;
+    }
+    if (!reserveArray((void **)&(source->buffer), &(source->capacity), length + 2, 1)) {
+        return false;
+    }
+    memcpy(source->buffer, path, length);
+    source->buffer[length + 1] = '\0';
+    for (int d = 0; d < SONS; ++d) {
+        if ((sons >> d) & 1u) {
+            source->buffer[length] = digitCharacter(d);
+            logRemove(writer, source->buffer);
+        }
+    }
+    return !writer->failed;
+}
+
+/** @brief Dopisuje do zapisywanego pliku rekordy zmian od ostatniego zapisu przyrostowego.
+ * Przechodzi tylko oznaczone poddrzewa drzewa przekierowań. Dla zmienionego
+ * przekierowania zapisuje rekord dodania, dla usuniętego poddrzewa syna rekord
+ * usunięcia, a jeśli w miejscu usuniętego poddrzewa powstało nowe, zapisuje
+ * je w całości. Wykonanie rekordów na strukturze w stanie z chwili
+ * poprzedniego zapisu daje bieżący stan.
+ * @param[in,out] writer - wskaźnik na strukturę zapisującą plik
+ * @param[in,out] data - wskaźnik na stan zapisu @ref DeltaSource
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool deltaRecords(PhoneForwardLog *writer, void *data) {
+    DeltaSource *source = data;
+    NodePool const *pool = source->pf->pool;
+    TrieWalk walk;
+    if (!walkStart(&walk, source->pf->pool, source->pf->forward, NULL, 0)) {
+        return false;
+    }
+    bool result = true;
+    size_t rewrite = NO_REWRITE; // głębokość korzenia poddrzewa zapisywanego w całości
+    Node *n = NULL;
+    while (result && ((n = walkNext(&walk)) != NULL)) {
+        size_t depth = walkPathLength(&walk);
+        bool has_forward = (n->list != NULL) && !empty(n->list);
+        if ((rewrite != NO_REWRITE) && (depth <= rewrite)) {
+            rewrite = NO_REWRITE;
+        }
+        if ((rewrite == NO_REWRITE)
+            && ((depth == 0) ? source->full
+                             : ((coldOf(pool, parentOf(pool, n))->removed_sons >> digitValue(walk.path + depth - 1)) & 1u))) {
+            rewrite = depth;
+        }
+        if (rewrite != NO_REWRITE) {
+            result = !has_forward || deltaAdd(writer, source, walk.path, n->list->first);
+            continue;
+        }
+        if (!coldOf(pool, n)->dirty) {
+            walkSkip(&walk);
+            continue;
+        }
+        if (coldOf(pool, n)->changed && has_forward) {
+            result = deltaAdd(writer, source, walk.path, n->list->first);
+        }
+        else if (coldOf(pool, n)->changed && (depth > 0)) {
+            // Przekierowanie zniknęło bez usuwania węzła, więc zapisujemy całe poddrzewo od nowa.
+            logRemove(writer, walk.path);
+            result = !writer->failed;
+            rewrite = depth;
+        }
+        result = result && deltaRemoveSons(writer, source, walk.path, depth, coldOf(pool, n)->removed_sons);
+    }
+    result = result && !walk.failed;
+    walkFinish(&walk);
+    return result;
+}
+
+/** @brief Usuwa oznaczenia zmian z drzewa.
+ * Przechodzi oznaczone węzły, korzystając z pól parent zamiast stosu,
+ * więc nie alokuje pamięci. Oznaczenie węzła jest usuwane dopiero po
+ * usunięciu oznaczeń jego synów.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in,out] root - wskaźnik na korzeń drzewa lub NULL
+ */
+static void clearTreeMarks(NodePool const *pool, Node *root) {
+    Node *n = root;
+    while ((n != NULL) && coldOf(pool, n)->dirty) {
+        Node *son = NULL;
+        for (int d = 0; (son == NULL) && (d < SONS); ++d) {
+            Node *candidate = sonOf(pool, n, d);
+            if ((candidate != NULL) && coldOf(pool, candidate)->dirty) {
+                son = candidate;
+            }
+        }
+        if (son != NULL) {
+            n = son;
+            continue;
+        }
+        NodeCold *cold = coldOf(pool, n);
+        cold->dirty = false;
+        cold->changed = false;
+        cold->removed_sons = 0;
+        n = (n == root) ? NULL : parentOf(pool, n);
+    }
+}
+
+/** @brief Usuwa oznaczenia zmian z drzewa przekierowań i drzewa odwróceń.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ */
+void clearMarks(PhoneForward *pf) {
+    clearTreeMarks(pf->pool, pf->forward);
+    clearTreeMarks(pf->pool, pf->reverse);
+}
+
+/** @brief Wyznacza nowy identyfikator migawki lub pliku zmian.
+ * @param[in] previous - identyfikator poprzedniego pliku
+ * @return Niezerowy identyfikator.
+ */
+static uint64_t newChainId(uint64_t previous) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t x = ((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec)
+                 ^ ((uint64_t)getpid() << 32) ^ (previous * 0x9E3779B97F4A7C15u);
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9u;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBu;
+    x ^= x >> 31;
+    return (x == 0) ? 1 : x;
+}
+
+/** @brief Odczytuje identyfikator migawki lub pliku zmian.
+ * @param[in] path - wskaźnik na napis reprezentujący ścieżkę pliku
+ * @param[out] id - odczytany identyfikator
+ * @return Wartość @p true, jeśli plik jest migawką lub plikiem zmian.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool readChainId(char const *path, uint64_t *id) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    unsigned char header[MAGIC_LENGTH + ID_BYTES];
+    size_t got = 0;
+    while (got < sizeof(header)) {
+        ssize_t part = read(fd, header + got, sizeof(header) - got);
+        if ((part < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (part <= 0) {
+            break;
+        }
+        got += (size_t)part;
+    }
+    close(fd);
+    if ((got < sizeof(header)) || ((memcmp(header, SNAPSHOT_MAGIC, MAGIC_LENGTH) != 0)
+                                   && (memcmp(header, DELTA_MAGIC, MAGIC_LENGTH) != 0))) {
+        return false;
+    }
+    *id = 0;
+    for (int k = 0; k < ID_BYTES; ++k) {
+        *id |= (uint64_t)header[MAGIC_LENGTH + k] << (8 * k);
+    }
+    return true;
+}
+
+/** @brief Zapisuje przyrostowo zmiany przekierowań.
+ * Struktura oznacza zmienione poddrzewa drzew przekierowań i odwróceń.
+ * Jeśli @p base ma wartość NULL, zapisuje pełną migawkę, od której zaczyna
+ * się ciąg zapisów przyrostowych. W przeciwnym przypadku @p base musi być
+ * plikiem zapisanym ostatnio tą funkcją lub wczytanym ostatnio przez
+ * @ref phfwdLoadSnapshot lub @ref phfwdLoadIncremental, a do pliku @p path
+ * trafiają tylko zmienione poddrzewa, więc czas i rozmiar zapisu zależą od
+ * liczby zmian, a nie od liczby przekierowań. Plik jest zapisywany atomowo
+ * tak jak przez @ref phfwdSaveSnapshot. Po udanym zapisie oznaczenia zmian
+ * są usuwane.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] base   - wskaźnik na napis reprezentujący ścieżkę poprzedniego pliku lub NULL;
+ * @param[in] path   - wskaźnik na napis reprezentujący ścieżkę zapisywanego pliku.
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false, jeśli plik @p base nie jest ostatnim plikiem ciągu
+ *         zapisów struktury, zapis się nie powiódł lub nie udało się alokować
+ *         pamięci; wtedy oznaczenia zmian pozostają bez zmian.
+ */
+bool phfwdSaveIncremental(PhoneForward *pf, char const *base, char const *path) {
+    if ((pf == NULL) || (pf->engine != NULL) || (path == NULL)) {
+        return false;
+    }
+    uint64_t ids[2] = {newChainId(pf->chain_id), pf->chain_id};
+    uint64_t base_id = 0;
+    if ((base != NULL) && ((pf->chain_id == 0) || !readChainId(base, &base_id) || (base_id != pf->chain_id))) {
+        return false;
+    }
+    DeltaSource source = {pf, base == NULL, NULL, 0};
+    bool result = (base == NULL) ? saveFile(path, SNAPSHOT_MAGIC, ids, 1, deltaRecords, &source)
+                                 : saveFile(path, DELTA_MAGIC, ids, 2, deltaRecords, &source);
+    free(source.buffer);
+    if (result) {
+        clearMarks(pf);
+        pf->chain_id = ids[0];
+    }
+    return result;
+}
+
+/** @brief Nakłada na strukturę zmiany zapisane przyrostowo.
+ * Wykonuje rekordy pliku zapisanego przez @ref phfwdSaveIncremental
+ * paczkami za pomocą @ref phfwdApplyBatch. Struktura musi być w stanie
+ * z chwili zapisu pliku, względem którego zapisano zmiany, tzn. ostatnio
+ * wczytanym plikiem musi być migawka lub plik zmian będący jego podstawą.
+ * Wykonane operacje nie są zapisywane do dziennika operacji.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path   - wskaźnik na napis reprezentujący ścieżkę pliku zmian.
+ * @return Wartość @p true, jeśli zmiany zostały nałożone.
+ *         Wartość @p false, jeśli plik nie jest plikiem zmian, jego podstawa
+ *         nie jest ostatnio wczytanym plikiem, plik jest uszkodzony lub nie
+ *         udało się alokować pamięci; jeśli część zmian została już
+ *         nałożona, nie można nakładać kolejnych plików zmian.
+ */
+bool phfwdLoadIncremental(PhoneForward *pf, char const *path) {
+    if ((pf == NULL) || (path == NULL) || (pf->chain_id == 0)) {
+        return false;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    RecordReader reader;
+    uint64_t ids[2];
+    bool result = readerInit(&reader, fd, DELTA_MAGIC) && readerIds(&reader, ids, 2) && (ids[1] == pf->chain_id);
+    if (result) {
+        result = replayRecords(pf, &reader) && (reader.consumed == reader.file_size);
+        pf->chain_id = result ? ids[0] : 0;
+    }
+    if (result) {
+        clearMarks(pf);
+    }
+    free(reader.buffer);
+    close(fd);
+    return result;
+}
@@ -0,0 +1,73 @@
+/** @file
+ * Interfejs klasy dziennika operacji i migawek struktury przechowującej przekierowania
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_LOG_H__
+#define __PHFWD_LOG_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+
+/**
+ * To jest struktura dziennika operacji, do którego są dopisywane rekordy.
+ * Rekordy są gromadzone w buforze i zapisywane do pliku, gdy bufor się
+ * zapełni, a co @p sync_every rekordów plik jest synchronizowany z dyskiem.
+ * Ta sama struktura służy do zapisu migawek.
+ */
+struct PhoneForwardLog {
+    int fd; ///< deskryptor pliku dziennika
+    unsigned char *buffer; ///< bufor rekordów czekających na zapis
+    size_t used; ///< liczba zajętych bajtów bufora
+    size_t capacity; ///< rozmiar bufora
+    size_t pending; ///< liczba rekordów dopisanych od ostatniej synchronizacji
+    size_t sync_every; ///< co ile rekordów synchronizować plik; 0 oznacza tylko na żądanie
+    bool failed; ///< czy zapis do pliku się nie powiódł
+};
+
+/** @brief Dopisuje do dziennika rekord dodania przekierowania.
+ * Błąd zapisu jest zapamiętywany i zgłaszany przez @ref phfwdSyncLog.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest wykonywane przekierowanie
+ */
+void logAdd(PhoneForwardLog *log, char const *num1, char const *num2);
+
+/** @brief Dopisuje do dziennika rekord usunięcia przekierowań.
+ * Błąd zapisu jest zapamiętywany i zgłaszany przez @ref phfwdSyncLog.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @param[in] num - wskaźnik na napis reprezentujący prefiks usuwanych numerów
+ */
+void logRemove(PhoneForwardLog *log, char const *num);
+
+/** @brief Dopisuje do dziennika rekordy dodania wszystkich przekierowań struktury.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool logForwards(PhoneForwardLog *log, PhoneForward const *pf);
+
+/** @brief Zamyka dziennik i zwalnia jego pamięć.
+ * @param[in,out] log - wskaźnik na dziennik
+ * @return Wartość @p true, jeśli wszystkie rekordy zostały zapisane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool logClose(PhoneForwardLog *log);
+
+/** @brief Czeka na zakończenie zapisu migawki w tle i zwalnia jego zasoby.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ */
+void backgroundSaveFinish(PhoneForward *pf);
+
+/** @brief Usuwa oznaczenia zmian z drzewa przekierowań i drzewa odwróceń.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ */
+void clearMarks(PhoneForward *pf);
+
+#endif /* __PHFWD_LOG_H__ */
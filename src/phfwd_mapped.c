@@ -0,0 +1,1228 @@
+/** @file
+ * Implementacja klasy przekierowań przechowywanych w zmapowanym pliku
+ *
+ * Plik składa się z jednostek po @ref UNIT_SIZE bajtów. Pierwsze
+ * @ref HEADER_UNITS jednostek zajmuje nagłówek, a pozostałe są węzłami drzew
+ * albo fragmentami numerów. Jednostki odwołują się do siebie przez indeksy,
+ * więc plik może być zmapowany pod dowolnym adresem, a jego otwarcie nie
+ * wymaga przeglądania drzew.
+ *
+ * Zmiany nie nadpisują węzłów należących do ostatniego zatwierdzonego stanu.
+ * Zmieniany węzeł jest najpierw kopiowany, a stare jednostki trafiają na
+ * listę wolnych dopiero przy zatwierdzeniu. Nagłówek ma dwa miejsca na stan
+ * (korzenie drzew, listę wolnych jednostek i koniec sterty) z sumą kontrolną.
+ * Zatwierdzenie zapisuje nowy stan w miejscu nieaktualnym, więc przerwanie
+ * zapisu w dowolnym momencie pozostawia w pliku poprzedni albo nowy stan.
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "phfwd_mapped.h"
+#include "phfwd_engine.h"
+#include "phfwd_auxiliary_functions.h"
+#include "phfwd_batch.h"
+#include "phfwd_iterator.h"
+#include "packed_number.h"
+#include "list.h"
+
+/**
+ * To jest napis rozpoczynający plik przekierowań.
+ */
+#define MAPPED_MAGIC "PFWDMAP1"
+
+/**
+ * To jest długość napisu rozpoczynającego plik przekierowań.
+ */
+#define MAGIC_LENGTH 8
+
+/**
+ * To jest rozmiar jednostki pliku w bajtach.
+ */
+#define UNIT_SIZE 64
+
+/**
+ * To jest liczba jednostek zajmowanych przez nagłówek.
+ */
+#define HEADER_UNITS 64
+
+/**
+ * To jest liczba jednostek nowo utworzonego pliku.
+ */
+#define INITIAL_UNITS 16384
+
+/**
+ * To jest indeks oznaczający brak jednostki. Wskazuje na nagłówek, więc nie
+ * może być indeksem węzła.
+ */
+#define NO_UNIT 0
+
+/**
+ * To jest wartość węzła drzewa zbioru oznaczająca, że numer należy do zbioru.
+ * Wskazuje na nagłówek, więc nie może być indeksem fragmentu numeru.
+ */
+#define SET_END 1
+
+/**
+ * To jest liczba cyfr mieszczących się w jednym fragmencie numeru.
+ */
+#define CHUNK_DIGITS 104
+
+/**
+ * To jest stan pliku zapisywany w nagłówku.
+ */
+typedef struct MappedState {
+    uint64_t sequence; ///< numer kolejny stanu
+    uint32_t forward_root; ///< korzeń drzewa przekierowań
+    uint32_t reverse_root; ///< korzeń drzewa odwróceń
+    uint32_t free_head; ///< pierwsza wolna jednostka lub @ref NO_UNIT
+    uint32_t heap_end; ///< pierwsza jednostka za ostatnią kiedykolwiek użytą
+    uint64_t checksum; ///< suma kontrolna poprzednich pól
+} MappedState;
+
+/**
+ * To jest nagłówek pliku przekierowań.
+ */
+typedef struct MappedHeader {
+    char magic[MAGIC_LENGTH]; ///< napis @ref MAPPED_MAGIC
+    uint32_t unit_size; ///< rozmiar jednostki, równy @ref UNIT_SIZE
+    uint32_t unused; ///< wyrównanie
+    MappedState slots[2]; ///< dwa miejsca na stan; aktualny jest poprawny stan o większym numerze
+} MappedHeader;
+
+/**
+ * To jest węzeł drzewa zapisany w jednostce pliku.
+ * W drzewie przekierowań wartością jest pierwszy fragment numeru, na który
+ * jest wykonywane przekierowanie. W drzewie odwróceń wartością jest korzeń
+ * drzewa zbioru numerów przekierowywanych na numer węzła. W drzewie zbioru
+ * wartością jest @ref SET_END.
+ */
+typedef struct MappedNode {
+    uint32_t free_next; ///< następna wolna jednostka, gdy jednostka jest wolna
+    uint32_t value; ///< wartość węzła lub @ref NO_UNIT
+    uint64_t epoch; ///< numer stanu, w którym węzeł został utworzony
+    uint32_t sons[SONS]; ///< synowie węzła lub @ref NO_UNIT
+} MappedNode;
+
+/**
+ * To jest fragment numeru zapisany w jednostce pliku.
+ * Fragmenty są niezmienne od utworzenia do zwolnienia.
+ */
+typedef struct MappedChunk {
+    uint32_t free_next; ///< następna wolna jednostka, gdy jednostka jest wolna
+    uint32_t length; ///< liczba cyfr całego numeru
+    uint32_t next; ///< następny fragment lub @ref NO_UNIT
+    unsigned char digits[UNIT_SIZE - 3 * sizeof(uint32_t)]; ///< spakowane cyfry fragmentu
+} MappedChunk;
+
+/**
+ * To jest struktura przekierowań przechowywanych w zmapowanym pliku.
+ */
+struct MappedTable {
+    int fd; ///< deskryptor pliku
+    unsigned char *base; ///< początek zmapowanego pliku
+    size_t units; ///< liczba jednostek pliku
+    bool durable; ///< czy zatwierdzenie czeka na zapis na dysk
+    MappedState state; ///< ostatni zatwierdzony stan
+    int slot; ///< miejsce nagłówka przechowujące zatwierdzony stan
+    MappedState txn; ///< stan zmieniany przez bieżącą operację
+    uint32_t *released; ///< jednostki zatwierdzonego stanu zwolnione przez bieżącą operację
+    size_t released_count; ///< liczba elementów tablicy @p released
+    size_t released_capacity; ///< pojemność tablicy @p released
+    uint32_t *recycled; ///< jednostki przydzielone i zwolnione przez bieżącą operację
+    size_t recycled_count; ///< liczba elementów tablicy @p recycled
+    size_t recycled_capacity; ///< pojemność tablicy @p recycled
+    uint32_t *pending; ///< jednostki do dołączenia do listy wolnych przy następnym zatwierdzeniu
+    size_t pending_count; ///< liczba elementów tablicy @p pending
+    size_t pending_capacity; ///< pojemność tablicy @p pending
+    uint32_t *path; ///< ścieżka kopiowana w drzewie przekierowań lub odwróceń
+    uint32_t *set_path; ///< ścieżka kopiowana w drzewie zbioru
+    size_t path_capacity; ///< pojemność tablic @p path i @p set_path
+    char *text; ///< bufor na odczytany numer
+    size_t text_capacity; ///< pojemność bufora @p text
+};
+
+/** @brief Zwraca wskaźnik na węzeł.
+ * Wskaźnik jest ważny do następnego przydzielenia jednostki.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] u - indeks jednostki
+ * @return Wskaźnik na węzeł.
+ */
+static inline MappedNode * node(MappedTable const *m, uint32_t u) {
+    return (MappedNode *)(m->base + (size_t)u * UNIT_SIZE);
+}
+
+/** @brief Zwraca wskaźnik na fragment numeru.
+ * Wskaźnik jest ważny do następnego przydzielenia jednostki.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] u - indeks jednostki
+ * @return Wskaźnik na fragment.
+ */
+static inline MappedChunk * chunk(MappedTable const *m, uint32_t u) {
+    return (MappedChunk *)(m->base + (size_t)u * UNIT_SIZE);
+}
+
+/** @brief Zwraca wskaźnik na nagłówek.
+ * @param[in] m - wskaźnik na strukturę
+ * @return Wskaźnik na nagłówek.
+ */
+static inline MappedHeader * header(MappedTable const *m) {
+    return (MappedHeader *)m->base;
+}
+
+/** @brief Wyznacza sumę kontrolną stanu.
+ * @param[in] state - wskaźnik na stan
+ * @return Suma kontrolna FNV-1a pól poprzedzających pole @p checksum.
+ */
+static uint64_t stateChecksum(MappedState const *state) {
+    unsigned char const *bytes = (unsigned char const *)state;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < offsetof(MappedState, checksum); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/** @brief Sprawdza, czy stan zapisany w nagłówku jest poprawny.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] state - wskaźnik na stan
+ * @return Wartość @p true, jeśli stan jest poprawny.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool stateValid(MappedTable const *m, MappedState const *state) {
+    return (state->sequence != 0) && (state->checksum == stateChecksum(state))
+           && (state->heap_end <= m->units)
+           && (state->forward_root >= HEADER_UNITS) && (state->forward_root < state->heap_end)
+           && (state->reverse_root >= HEADER_UNITS) && (state->reverse_root < state->heap_end)
+           && ((state->free_head == NO_UNIT) || (state->free_head >= HEADER_UNITS))
+           && (state->free_head < state->heap_end);
+}
+
+/** @brief Zapewnia, że plik ma co najmniej @p needed jednostek.
+ * Może przenieść mapowanie pod inny adres.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] needed - wymagana liczba jednostek
+ * @return Wartość @p true, jeśli plik ma wymaganą liczbę jednostek.
+ *         Wartość @p false, jeśli nie udało się go powiększyć.
+ */
+static bool ensureUnits(MappedTable *m, size_t needed) {
+    if (needed <= m->units) {
+        return true;
+    }
+    if (needed > UINT32_MAX) {
+        return false;
+    }
+    size_t units = m->units * 2;
+    if (units < needed) {
+        units = needed;
+    }
+    if (units > UINT32_MAX) {
+        units = UINT32_MAX;
+    }
+    if (ftruncate(m->fd, (off_t)(units * UNIT_SIZE)) != 0) {
+        return false;
+    }
+    void *base = mremap(m->base, m->units * UNIT_SIZE, units * UNIT_SIZE, MREMAP_MAYMOVE);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    m->base = base;
+    m->units = units;
+    return true;
+}
+
+/** @brief Rozpoczyna operację zmieniającą plik.
+ * @param[in,out] m - wskaźnik na strukturę
+ */
+static void begin(MappedTable *m) {
+    m->txn = m->state;
+    m->txn.sequence = m->state.sequence + 1;
+    m->released_count = 0;
+    m->recycled_count = 0;
+}
+
+/** @brief Przydziela jednostkę.
+ * Nie zmienia pola @p free_next przydzielonej jednostki, bo może ono należeć
+ * do listy wolnych jednostek zatwierdzonego stanu.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @return Indeks jednostki lub @ref NO_UNIT, gdy nie udało się powiększyć pliku.
+ */
+static uint32_t allocUnit(MappedTable *m) {
+    if (m->recycled_count > 0) {
+        return m->recycled[--m->recycled_count];
+    }
+    uint32_t u = m->txn.free_head;
+    if (u != NO_UNIT) {
+        m->txn.free_head = node(m, u)->free_next;
+        return u;
+    }
+    if (!ensureUnits(m, (size_t)m->txn.heap_end + 1)) {
+        return NO_UNIT;
+    }
+    return m->txn.heap_end++;
+}
+
+/** @brief Przydziela pusty węzeł.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @return Indeks węzła lub @ref NO_UNIT, gdy nie udało się powiększyć pliku.
+ */
+static uint32_t allocNode(MappedTable *m) {
+    uint32_t u = allocUnit(m);
+    if (u != NO_UNIT) {
+        MappedNode *n = node(m, u);
+        n->value = NO_UNIT;
+        n->epoch = m->txn.sequence;
+        memset(n->sons, 0, sizeof(n->sons));
+    }
+    return u;
+}
+
+/** @brief Zwalnia jednostkę.
+ * Jednostki zatwierdzonego stanu trafiają na listę wolnych przy zatwierdzeniu,
+ * a jednostki przydzielone przez bieżącą operację mogą być od razu użyte ponownie.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] u - indeks jednostki
+ * @param[in] fresh - czy jednostka została przydzielona przez bieżącą operację
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool releaseUnit(MappedTable *m, uint32_t u, bool fresh) {
+    if (fresh) {
+        if (!reserveArray((void **)&m->recycled, &m->recycled_capacity, m->recycled_count + 1, sizeof(uint32_t))) {
+            return false;
+        }
+        m->recycled[m->recycled_count++] = u;
+    }
+    else {
+        if (!reserveArray((void **)&m->released, &m->released_capacity, m->released_count + 1, sizeof(uint32_t))) {
+            return false;
+        }
+        m->released[m->released_count++] = u;
+    }
+    return true;
+}
+
+/** @brief Zwalnia węzeł.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] u - indeks węzła
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool releaseNode(MappedTable *m, uint32_t u) {
+    return releaseUnit(m, u, node(m, u)->epoch == m->txn.sequence);
+}
+
+/** @brief Zwraca węzeł, który może być zmieniany przez bieżącą operację.
+ * Węzeł zatwierdzonego stanu jest kopiowany, a oryginał zwalniany.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] u - indeks węzła
+ * @return Indeks węzła do zmiany lub @ref NO_UNIT, gdy nie udało się
+ *         powiększyć pliku lub alokować pamięci.
+ */
+static uint32_t writable(MappedTable *m, uint32_t u) {
+    if (node(m, u)->epoch == m->txn.sequence) {
+        return u;
+    }
+    uint32_t copy = allocUnit(m);
+    if ((copy == NO_UNIT) || !releaseUnit(m, u, false)) {
+        return NO_UNIT;
+    }
+    MappedNode *to = node(m, copy);
+    MappedNode const *from = node(m, u);
+    memcpy((unsigned char *)to + sizeof(to->free_next), (unsigned char const *)from + sizeof(from->free_next),
+           UNIT_SIZE - sizeof(to->free_next));
+    to->epoch = m->txn.sequence;
+    return copy;
+}
+
+/** @brief Sprawdza, czy węzeł nie ma wartości ani synów.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] u - indeks węzła
+ * @return Wartość @p true, jeśli węzeł jest pusty.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool emptyNode(MappedTable const *m, uint32_t u) {
+    MappedNode const *n = node(m, u);
+    if (n->value != NO_UNIT) {
+        return false;
+    }
+    for (int i = 0; i < SONS; ++i) {
+        if (n->sons[i] != NO_UNIT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Zapewnia miejsce na ścieżki o podanej długości.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] length - liczba cyfr numeru wyznaczającego ścieżkę
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool reservePaths(MappedTable *m, size_t length) {
+    size_t capacity = m->path_capacity;
+    return reserveArray((void **)&m->path, &capacity, length + 1, sizeof(uint32_t))
+           && reserveArray((void **)&m->set_path, &m->path_capacity, length + 1, sizeof(uint32_t));
+}
+
+/** @brief Kopiuje ścieżkę od korzenia do węzła numeru, tworząc brakujące węzły.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] root - korzeń, który może być zmieniany przez bieżącą operację
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - liczba kopiowanych cyfr numeru
+ * @param[out] path - tablica na @p length + 1 indeksów węzłów ścieżki
+ * @return Wartość @p true, jeśli ścieżka została skopiowana.
+ *         Wartość @p false, jeśli nie udało się powiększyć pliku lub alokować pamięci.
+ */
+static bool copyPath(MappedTable *m, uint32_t root, char const *num, size_t length, uint32_t *path) {
+    path[0] = root;
+    for (size_t i = 0; i < length; ++i) {
+        int digit = digitValue(num + i);
+        uint32_t son = node(m, path[i])->sons[digit];
+        son = (son == NO_UNIT) ? allocNode(m) : writable(m, son);
+        if (son == NO_UNIT) {
+            return false;
+        }
+        node(m, path[i])->sons[digit] = son;
+        path[i + 1] = son;
+    }
+    return true;
+}
+
+/** @brief Usuwa puste węzły z końca skopiowanej ścieżki.
+ * Nie usuwa korzenia.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer wyznaczający ścieżkę
+ * @param[in] length - liczba cyfr ścieżki
+ * @param[in] path - tablica indeksów węzłów ścieżki
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool prunePath(MappedTable *m, char const *num, size_t length, uint32_t const *path) {
+    for (size_t i = length; (i > 0) && emptyNode(m, path[i]); --i) {
+        if (!releaseNode(m, path[i])) {
+            return false;
+        }
+        node(m, path[i - 1])->sons[digitValue(num + i - 1)] = NO_UNIT;
+    }
+    return true;
+}
+
+/** @brief Zapisuje numer we fragmentach.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - liczba cyfr numeru
+ * @return Indeks pierwszego fragmentu lub @ref NO_UNIT, gdy nie udało się powiększyć pliku.
+ */
+static uint32_t writeNumber(MappedTable *m, char const *num, size_t length) {
+    uint32_t first = NO_UNIT;
+    uint32_t previous = NO_UNIT;
+    for (size_t start = 0; start < length; start += CHUNK_DIGITS) {
+        uint32_t u = allocUnit(m);
+        if (u == NO_UNIT) {
+            return NO_UNIT;
+        }
+        size_t count = (length - start < CHUNK_DIGITS) ? length - start : CHUNK_DIGITS;
+        MappedChunk *c = chunk(m, u);
+        c->length = (uint32_t)length;
+        c->next = NO_UNIT;
+        packDigits(c->digits, num + start, count);
+        if (previous == NO_UNIT) {
+            first = u;
+        }
+        else {
+            chunk(m, previous)->next = u;
+        }
+        previous = u;
+    }
+    return first;
+}
+
+/** @brief Zwalnia fragmenty numeru zatwierdzonego stanu.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] u - indeks pierwszego fragmentu
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool releaseNumber(MappedTable *m, uint32_t u) {
+    while (u != NO_UNIT) {
+        uint32_t next = chunk(m, u)->next;
+        if (!releaseUnit(m, u, false)) {
+            return false;
+        }
+        u = next;
+    }
+    return true;
+}
+
+/** @brief Odczytuje numer zapisany we fragmentach.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] u - indeks pierwszego fragmentu
+ * @param[out] num - wskaźnik na miejsce na co najmniej tyle znaków, ile cyfr ma numer
+ */
+static void readNumber(MappedTable const *m, uint32_t u, char *num) {
+    size_t length = chunk(m, u)->length;
+    for (size_t start = 0; u != NO_UNIT; start += CHUNK_DIGITS) {
+        size_t count = (length - start < CHUNK_DIGITS) ? length - start : CHUNK_DIGITS;
+        unpackDigits(num + start, chunk(m, u)->digits, count);
+        u = chunk(m, u)->next;
+    }
+}
+
+/** @brief Sprawdza, czy numer zapisany we fragmentach jest równy napisowi.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] u - indeks pierwszego fragmentu
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - liczba cyfr numeru @p num
+ * @return Wartość @p true, jeśli numery są równe.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool numberEquals(MappedTable const *m, uint32_t u, char const *num, size_t length) {
+    if (chunk(m, u)->length != length) {
+        return false;
+    }
+    for (size_t start = 0; u != NO_UNIT; start += CHUNK_DIGITS) {
+        size_t count = (length - start < CHUNK_DIGITS) ? length - start : CHUNK_DIGITS;
+        unsigned char const *digits = chunk(m, u)->digits;
+        for (size_t i = 0; i < count; ++i) {
+            if (packedDigitValue(digits, i) != digitValue(num + start + i)) {
+                return false;
+            }
+        }
+        u = chunk(m, u)->next;
+    }
+    return true;
+}
+
+/** @brief Zapewnia miejsce na odczytywany numer w buforze struktury.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] length - liczba cyfr numeru
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool reserveText(MappedTable *m, size_t length) {
+    return reserveArray((void **)&m->text, &m->text_capacity, length + 1, sizeof(char));
+}
+
+/** @brief Dodaje numer przekierowywany do zbioru numeru, na który jest wykonywane przekierowanie.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] num2 - wskaźnik na napis reprezentujący numer, na który jest wykonywane przekierowanie
+ * @param[in] num1 - wskaźnik na napis reprezentujący numer przekierowywany
+ * @return Wartość @p true, jeśli numer został dodany.
+ *         Wartość @p false, jeśli nie udało się powiększyć pliku lub alokować pamięci.
+ */
+static bool setInsert(MappedTable *m, char const *num2, char const *num1) {
+    size_t length2 = howLong(num2);
+    size_t length1 = howLong(num1);
+    if (!reservePaths(m, (length1 > length2) ? length1 : length2)) {
+        return false;
+    }
+    uint32_t root = writable(m, m->txn.reverse_root);
+    if (root == NO_UNIT) {
+        return false;
+    }
+    m->txn.reverse_root = root;
+    if (!copyPath(m, root, num2, length2, m->path)) {
+        return false;
+    }
+    uint32_t target = m->path[length2];
+    uint32_t set = node(m, target)->value;
+    set = (set == NO_UNIT) ? allocNode(m) : writable(m, set);
+    if (set == NO_UNIT) {
+        return false;
+    }
+    node(m, target)->value = set;
+    if (!copyPath(m, set, num1, length1, m->set_path)) {
+        return false;
+    }
+    node(m, m->set_path[length1])->value = SET_END;
+    return true;
+}
+
+/** @brief Usuwa numer przekierowywany ze zbioru numeru, na który jest wykonywane przekierowanie.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] num2 - wskaźnik na napis reprezentujący numer, na który jest wykonywane przekierowanie
+ * @param[in] num1 - wskaźnik na napis reprezentujący numer przekierowywany
+ * @return Wartość @p true, jeśli numer został usunięty.
+ *         Wartość @p false, jeśli nie udało się powiększyć pliku lub alokować pamięci.
+ */
+static bool setRemove(MappedTable *m, char const *num2, char const *num1) {
+    size_t length2 = howLong(num2);
+    size_t length1 = howLong(num1);
+    if (!reservePaths(m, (length1 > length2) ? length1 : length2)) {
+        return false;
+    }
+    uint32_t root = writable(m, m->txn.reverse_root);
+    if (root == NO_UNIT) {
+        return false;
+    }
+    m->txn.reverse_root = root;
+    if (!copyPath(m, root, num2, length2, m->path)) {
+        return false;
+    }
+    uint32_t target = m->path[length2];
+    uint32_t set = node(m, target)->value;
+    set = (set == NO_UNIT) ? allocNode(m) : writable(m, set);
+    if (set == NO_UNIT) {
+        return false;
+    }
+    node(m, target)->value = set;
+    if (!copyPath(m, set, num1, length1, m->set_path)) {
+        return false;
+    }
+    node(m, m->set_path[length1])->value = NO_UNIT;
+    if (!prunePath(m, num1, length1, m->set_path)) {
+        return false;
+    }
+    if (emptyNode(m, set)) {
+        if (!releaseNode(m, set)) {
+            return false;
+        }
+        node(m, target)->value = NO_UNIT;
+    }
+    return prunePath(m, num2, length2, m->path);
+}
+
+/** @brief Zatwierdza bieżącą operację.
+ * Dołącza zwolnione jednostki do listy wolnych, a w trybie trwałym zapisuje
+ * zmienione jednostki na dysk, zanim zapisze nowy stan w nagłówku.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @return Wartość @p true, jeśli stan został zatwierdzony.
+ *         Wartość @p false, jeśli nie udało się zapisać go na dysk.
+ */
+static bool commit(MappedTable *m) {
+    uint32_t next = m->txn.free_head;
+    for (size_t i = m->pending_count; i > 0; --i) {
+        node(m, m->pending[i - 1])->free_next = next;
+        next = m->pending[i - 1];
+    }
+    for (size_t i = m->released_count; i > 0; --i) {
+        node(m, m->released[i - 1])->free_next = next;
+        next = m->released[i - 1];
+    }
+    m->txn.free_head = next;
+    m->txn.checksum = stateChecksum(&m->txn);
+    // Jednostki przydzielone i zwolnione przez operację mogły pochodzić z listy
+    // wolnych zatwierdzonego stanu, więc ich pola free_next można zmienić
+    // dopiero przy następnym zatwierdzeniu.
+    uint32_t *help = m->pending;
+    size_t help_capacity = m->pending_capacity;
+    m->pending = m->recycled;
+    m->pending_capacity = m->recycled_capacity;
+    m->pending_count = m->recycled_count;
+    m->recycled = help;
+    m->recycled_capacity = help_capacity;
+    m->recycled_count = 0;
+    m->released_count = 0;
+
+    bool success = true;
+    if (m->durable) {
+        success = msync(m->base, (size_t)m->txn.heap_end * UNIT_SIZE, MS_SYNC) == 0;
+    }
+    int slot = 1 - m->slot;
+    header(m)->slots[slot] = m->txn;
+    if (m->durable) {
+        success = (msync(m->base, HEADER_UNITS * UNIT_SIZE, MS_SYNC) == 0) && success;
+    }
+    m->slot = slot;
+    m->state = m->txn;
+    return success;
+}
+
+/** @brief Zapisuje w nagłówku stan nowo utworzonego pliku.
+ * @param[in,out] m - wskaźnik na strukturę
+ */
+static void initialize(MappedTable *m) {
+    MappedHeader *h = header(m);
+    memcpy(h->magic, MAPPED_MAGIC, MAGIC_LENGTH);
+    h->unit_size = UNIT_SIZE;
+    m->state.sequence = 0;
+    m->state.free_head = NO_UNIT;
+    m->state.heap_end = HEADER_UNITS;
+    m->slot = 1;
+    begin(m);
+    m->txn.forward_root = allocNode(m);
+    m->txn.reverse_root = allocNode(m);
+    commit(m);
+}
+
+/** @brief Otwiera plik przekierowań, tworząc go w razie potrzeby.
+ * @param[in] path - ścieżka pliku
+ * @param[in] durable - czy każda zmiana ma być synchronizowana z dyskiem przed powrotem
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy plik nie jest plikiem
+ *         przekierowań, jest używany przez inny proces, nie udało się go
+ *         otworzyć lub alokować pamięci.
+ */
+MappedTable * mappedOpen(char const *path, bool durable) {
+    if (path == NULL) {
+        return NULL;
+    }
+    MappedTable *m = calloc(1, sizeof(*m));
+    if (m == NULL) {
+        return NULL;
+    }
+    m->durable = durable;
+    m->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat st;
+    bool created = false;
+    bool success = (m->fd >= 0) && (flock(m->fd, LOCK_EX | LOCK_NB) == 0) && (fstat(m->fd, &st) == 0);
+    if (success && (st.st_size == 0)) {
+        created = true;
+        st.st_size = (off_t)INITIAL_UNITS * UNIT_SIZE;
+        success = ftruncate(m->fd, st.st_size) == 0;
+    }
+    success = success && (st.st_size % UNIT_SIZE == 0) && (st.st_size >= HEADER_UNITS * UNIT_SIZE)
+              && ((uint64_t)st.st_size / UNIT_SIZE <= UINT32_MAX);
+    if (success) {
+        m->units = (size_t)st.st_size / UNIT_SIZE;
+        m->base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, m->fd, 0);
+        success = m->base != MAP_FAILED;
+        if (!success) {
+            m->base = NULL;
+        }
+    }
+    if (success && created) {
+        initialize(m);
+    }
+    else if (success) {
+        MappedHeader const *h = header(m);
+        success = (memcmp(h->magic, MAPPED_MAGIC, MAGIC_LENGTH) == 0) && (h->unit_size == UNIT_SIZE);
+        bool valid0 = success && stateValid(m, &h->slots[0]);
+        bool valid1 = success && stateValid(m, &h->slots[1]);
+        if (valid0 && (!valid1 || (h->slots[0].sequence > h->slots[1].sequence))) {
+            m->slot = 0;
+        }
+        else if (valid1) {
+            m->slot = 1;
+        }
+        else {
+            success = false;
+        }
+        if (success) {
+            m->state = h->slots[m->slot];
+        }
+    }
+    if (!success) {
+        if (m->base != NULL) {
+            munmap(m->base, m->units * UNIT_SIZE);
+        }
+        if (m->fd >= 0) {
+            close(m->fd);
+        }
+        free(m);
+        m = NULL;
+    }
+    return m;
+}
+
+/** @brief Synchronizuje plik przekierowań z dyskiem.
+ * @param[in] m - wskaźnik na strukturę
+ * @return Wartość @p true, jeśli synchronizacja się powiodła.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool mappedSync(MappedTable *m) {
+    if (m == NULL) {
+        return false;
+    }
+    return msync(m->base, m->units * UNIT_SIZE, MS_SYNC) == 0;
+}
+
+/** @brief Zamyka plik przekierowań i zwalnia pamięć struktury.
+ * @param[in] m - wskaźnik na strukturę
+ * @return Wartość @p true, jeśli wszystkie zmiany zostały zapisane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool mappedClose(MappedTable *m) {
+    if (m == NULL) {
+        return true;
+    }
+    bool success = true;
+    if (m->pending_count > 0) {
+        // Pusta operacja dołącza odłożone jednostki do listy wolnych.
+        begin(m);
+        success = commit(m);
+    }
+    success = (msync(m->base, m->units * UNIT_SIZE, MS_SYNC) == 0) && success;
+    munmap(m->base, m->units * UNIT_SIZE);
+    success = (close(m->fd) == 0) && success;
+    free(m->released);
+    free(m->recycled);
+    free(m->pending);
+    free(m->path);
+    free(m->set_path);
+    free(m->text);
+    free(m);
+    return success;
+}
+
+/** @brief Wyznacza przekierowanie o najdłuższym prefiksie numeru.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - liczba cyfr numeru
+ * @param[out] eaten - długość prefiksu, którego dotyczy przekierowanie
+ * @return Indeks pierwszego fragmentu numeru, na który jest wykonywane
+ *         przekierowanie, lub @ref NO_UNIT, gdy numer nie jest przekierowywany.
+ */
+static uint32_t lookupForward(MappedTable const *m, char const *num, size_t length, size_t *eaten) {
+    uint32_t result = NO_UNIT;
+    uint32_t u = m->state.forward_root;
+    *eaten = 0;
+    for (size_t i = 0; u != NO_UNIT; ++i) {
+        MappedNode const *n = node(m, u);
+        if (n->value != NO_UNIT) {
+            result = n->value;
+            *eaten = i;
+        }
+        if (i == length) {
+            break;
+        }
+        u = n->sons[digitValue(num + i)];
+    }
+    return result;
+}
+
+/** @brief Wyznacza węzeł numeru w drzewie przekierowań.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - liczba cyfr numeru
+ * @return Indeks węzła lub @ref NO_UNIT, gdy go nie ma.
+ */
+static uint32_t findForward(MappedTable const *m, char const *num, size_t length) {
+    uint32_t u = m->state.forward_root;
+    for (size_t i = 0; (i < length) && (u != NO_UNIT); ++i) {
+        u = node(m, u)->sons[digitValue(num + i)];
+    }
+    return u;
+}
+
+/** @brief Dodaje przekierowanie, tak jak @ref phfwdAdd.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest wykonywane przekierowanie
+ * @return Wartość @p true, jeśli przekierowanie zostało dodane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool mappedAdd(MappedTable *m, char const *num1, char const *num2) {
+    if ((m == NULL) || !onlyDigitsAndNotEmpty(num1) || !onlyDigitsAndNotEmpty(num2) || !numbersDiffer(num1, num2)) {
+        return false;
+    }
+    size_t length1 = howLong(num1);
+    size_t length2 = howLong(num2);
+    if ((length1 > UINT32_MAX) || (length2 > UINT32_MAX)) {
+        return false;
+    }
+    uint32_t existing = findForward(m, num1, length1);
+    if ((existing != NO_UNIT) && (node(m, existing)->value != NO_UNIT)
+        && numberEquals(m, node(m, existing)->value, num2, length2)) {
+        return true;
+    }
+    begin(m);
+    bool success = reservePaths(m, length1);
+    uint32_t root = success ? writable(m, m->txn.forward_root) : NO_UNIT;
+    success = (root != NO_UNIT) && copyPath(m, root, num1, length1, m->path);
+    if (success) {
+        m->txn.forward_root = root;
+        uint32_t target = m->path[length1];
+        uint32_t old = node(m, target)->value;
+        if (old != NO_UNIT) {
+            success = reserveText(m, chunk(m, old)->length);
+            if (success) {
+                m->text[chunk(m, old)->length] = '\0';
+                readNumber(m, old, m->text);
+                success = releaseNumber(m, old) && setRemove(m, m->text, num1);
+            }
+        }
+        uint32_t value = success ? writeNumber(m, num2, length2) : NO_UNIT;
+        success = (value != NO_UNIT) && setInsert(m, num2, num1);
+        if (success) {
+            node(m, target)->value = value;
+        }
+    }
+    if (!success) {
+        return false;
+    }
+    return commit(m);
+}
+
+/**
+ * To jest element stosu przeglądania usuwanego poddrzewa.
+ */
+typedef struct MappedFrame {
+    uint32_t unit; ///< indeks węzła
+    uint32_t depth; ///< głębokość węzła względem korzenia poddrzewa
+    char digit; ///< cyfra prowadząca do węzła
+} MappedFrame;
+
+/** @brief Usuwa przekierowania z poddrzewa z drzewa odwróceń i zwalnia jego jednostki.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] u - korzeń poddrzewa
+ * @param[in] num - wskaźnik na napis reprezentujący numer korzenia poddrzewa
+ * @param[in] length - liczba cyfr numeru
+ * @return Wartość @p true, jeśli poddrzewo zostało usunięte.
+ *         Wartość @p false, jeśli nie udało się powiększyć pliku lub alokować pamięci.
+ */
+static bool releaseSubtree(MappedTable *m, uint32_t u, char const *num, size_t length) {
+    MappedFrame *stack = NULL;
+    size_t stack_capacity = 0;
+    char *key = NULL;
+    size_t key_capacity = 0;
+    bool success = reserveArray((void **)&stack, &stack_capacity, 1, sizeof(MappedFrame))
+                   && reserveArray((void **)&key, &key_capacity, length + 1, sizeof(char));
+    size_t count = 0;
+    if (success) {
+        memcpy(key, num, length);
+        stack[count++] = (MappedFrame){u, 0, '\0'};
+    }
+    while (success && (count > 0)) {
+        MappedFrame frame = stack[--count];
+        size_t key_length = length + frame.depth;
+        success = reserveArray((void **)&key, &key_capacity, key_length + 2, sizeof(char))
+                  && reserveArray((void **)&stack, &stack_capacity, count + SONS, sizeof(MappedFrame));
+        if (!success) {
+            break;
+        }
+        if (frame.depth > 0) {
+            key[key_length - 1] = frame.digit;
+        }
+        key[key_length] = '\0';
+        uint32_t value = node(m, frame.unit)->value;
+        if (value != NO_UNIT) {
+            success = reserveText(m, chunk(m, value)->length);
+            if (success) {
+                m->text[chunk(m, value)->length] = '\0';
+                readNumber(m, value, m->text);
+                success = setRemove(m, m->text, key) && releaseNumber(m, value);
+            }
+        }
+        for (int i = SONS - 1; success && (i >= 0); --i) {
+            uint32_t son = node(m, frame.unit)->sons[i];
+            if (son != NO_UNIT) {
+                stack[count++] = (MappedFrame){son, frame.depth + 1, digitCharacter(i)};
+            }
+        }
+        success = success && releaseNode(m, frame.unit);
+    }
+    free(stack);
+    free(key);
+    return success;
+}
+
+/** @brief Usuwa przekierowania, tak jak @ref phfwdRemove.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący prefiks numerów
+ * @return Wartość @p true, jeśli usunięcie się powiodło lub nie było czego usuwać.
+ *         Wartość @p false, jeśli nie udało się powiększyć pliku lub alokować pamięci.
+ */
+bool mappedRemove(MappedTable *m, char const *num) {
+    if ((m == NULL) || !onlyDigitsAndNotEmpty(num)) {
+        return true;
+    }
+    size_t length = howLong(num);
+    uint32_t u = findForward(m, num, length);
+    if (u == NO_UNIT) {
+        return true;
+    }
+    begin(m);
+    bool success = releaseSubtree(m, u, num, length) && reservePaths(m, length);
+    uint32_t root = success ? writable(m, m->txn.forward_root) : NO_UNIT;
+    success = (root != NO_UNIT) && copyPath(m, root, num, length - 1, m->path);
+    if (success) {
+        m->txn.forward_root = root;
+        node(m, m->path[length - 1])->sons[digitValue(num + length - 1)] = NO_UNIT;
+        success = prunePath(m, num, length - 1, m->path);
+    }
+    if (!success) {
+        return false;
+    }
+    return commit(m);
+}
+
+/** @brief Wyznacza przekierowanie numeru, tak jak @ref phfwdGet.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * mappedGet(MappedTable *m, char const *num) {
+    PhoneNumbers *result = newPhoneNumbers();
+    if ((result == NULL) || !onlyDigitsAndNotEmpty(num)) {
+        return result;
+    }
+    size_t length = howLong(num);
+    size_t eaten;
+    uint32_t forward = lookupForward(m, num, length, &eaten);
+    size_t prefix_length = (forward == NO_UNIT) ? 0 : chunk(m, forward)->length;
+    size_t result_length = prefix_length + length - eaten;
+    if (!reserveText(m, result_length)) {
+        phnumDelete(result);
+        return NULL;
+    }
+    if (forward != NO_UNIT) {
+        readNumber(m, forward, m->text);
+    }
+    memcpy(m->text + prefix_length, num + eaten, length - eaten);
+    m->text[result_length] = '\0';
+    if (!addElement(result->list, m->text, result_length)) {
+        phnumDelete(result);
+        result = NULL;
+    }
+    return result;
+}
+
+/** @brief Sprawdza, czy numer jest przekierowywany na dany numer.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] candidate - wskaźnik na napis reprezentujący sprawdzany numer
+ * @param[in] target - wskaźnik na napis reprezentujący numer, który powinien być wynikiem przekierowania
+ * @return Wartość @p true, jeśli @p candidate jest przekierowywany na @p target.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool forwardsTo(MappedTable const *m, char const *candidate, char const *target) {
+    size_t length = howLong(candidate);
+    size_t target_length = howLong(target);
+    size_t eaten;
+    uint32_t forward = lookupForward(m, candidate, length, &eaten);
+    if (forward == NO_UNIT) {
+        return !numbersDiffer(candidate, target);
+    }
+    size_t prefix_length = chunk(m, forward)->length;
+    if ((prefix_length + length - eaten != target_length) || (prefix_length > target_length)) {
+        return false;
+    }
+    // Przekierowanie porównujemy z prefiksem celu zapisanym jako napis.
+    size_t start = 0;
+    for (uint32_t u = forward; u != NO_UNIT; u = chunk(m, u)->next) {
+        size_t count = (prefix_length - start < CHUNK_DIGITS) ? prefix_length - start : CHUNK_DIGITS;
+        unsigned char const *digits = chunk(m, u)->digits;
+        for (size_t i = 0; i < count; ++i) {
+            if (packedDigitValue(digits, i) != digitValue(target + start + i)) {
+                return false;
+            }
+        }
+        start += count;
+    }
+    return memcmp(candidate + eaten, target + prefix_length, length - eaten) == 0;
+}
+
+/** @brief Dopisuje do tablicy kandydatów konkatenację dwóch napisów.
+ * @param[in,out] candidates - adres tablicy kandydatów
+ * @param[in,out] count - adres liczby kandydatów
+ * @param[in,out] capacity - adres pojemności tablicy
+ * @param[in] prefix - wskaźnik na początek prefiksu
+ * @param[in] prefix_length - długość prefiksu
+ * @param[in] suffix - wskaźnik na napis zakończony znakiem '\0'
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool addCandidate(char ***candidates, size_t *count, size_t *capacity,
+                         char const *prefix, size_t prefix_length, char const *suffix) {
+    size_t suffix_length = howLong(suffix);
+    char *candidate = malloc(prefix_length + suffix_length + 1);
+    if ((candidate == NULL) || !reserveArray((void **)candidates, capacity, *count + 1, sizeof(char *))) {
+        free(candidate);
+        return false;
+    }
+    memcpy(candidate, prefix, prefix_length);
+    memcpy(candidate + prefix_length, suffix, suffix_length + 1);
+    (*candidates)[(*count)++] = candidate;
+    return true;
+}
+
+/** @brief Dopisuje do tablicy kandydatów numery zbioru z dopisanym sufiksem.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] set - korzeń drzewa zbioru
+ * @param[in] suffix - wskaźnik na sufiks numeru zapytania
+ * @param[in,out] candidates - adres tablicy kandydatów
+ * @param[in,out] count - adres liczby kandydatów
+ * @param[in,out] capacity - adres pojemności tablicy
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool collectSet(MappedTable const *m, uint32_t set, char const *suffix,
+                       char ***candidates, size_t *count, size_t *capacity) {
+    MappedFrame *stack = NULL;
+    size_t stack_capacity = 0;
+    char *key = NULL;
+    size_t key_capacity = 0;
+    size_t stack_count = 0;
+    bool success = reserveArray((void **)&stack, &stack_capacity, 1, sizeof(MappedFrame));
+    if (success) {
+        stack[stack_count++] = (MappedFrame){set, 0, '\0'};
+    }
+    while (success && (stack_count > 0)) {
+        MappedFrame frame = stack[--stack_count];
+        success = reserveArray((void **)&key, &key_capacity, (size_t)frame.depth + 1, sizeof(char))
+                  && reserveArray((void **)&stack, &stack_capacity, stack_count + SONS, sizeof(MappedFrame));
+        if (!success) {
+            break;
+        }
+        if (frame.depth > 0) {
+            key[frame.depth - 1] = frame.digit;
+        }
+        MappedNode const *n = node(m, frame.unit);
+        if (n->value == SET_END) {
+            success = addCandidate(candidates, count, capacity, key, frame.depth, suffix);
+        }
+        for (int i = SONS - 1; success && (i >= 0); --i) {
+            if (n->sons[i] != NO_UNIT) {
+                stack[stack_count++] = (MappedFrame){n->sons[i], frame.depth + 1, digitCharacter(i)};
+            }
+        }
+    }
+    free(stack);
+    free(key);
+    return success;
+}
+
+/** @brief Wyznacza odwrócenie lub przeciwobraz, tak jak @ref phfwdReverseOrGetReverse.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] only_counterimage - czy wyznaczamy tylko przeciwobraz
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * mappedReverse(MappedTable *m, char const *num, bool only_counterimage) {
+    PhoneNumbers *result = newPhoneNumbers();
+    if ((result == NULL) || !onlyDigitsAndNotEmpty(num)) {
+        return result;
+    }
+    size_t length = howLong(num);
+    char **candidates = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    bool success = addCandidate(&candidates, &count, &capacity, num, length, "");
+    uint32_t u = m->state.reverse_root;
+    for (size_t i = 0; success && (u != NO_UNIT); ++i) {
+        uint32_t set = node(m, u)->value;
+        if (set != NO_UNIT) {
+            success = collectSet(m, set, num + i, &candidates, &count, &capacity);
+        }
+        u = (i < length) ? node(m, u)->sons[digitValue(num + i)] : NO_UNIT;
+    }
+    if (success) {
+        qsort(candidates, count, sizeof(char *), myCompare);
+    }
+    for (size_t i = 0; success && (i < count); ++i) {
+        if ((i > 0) && !numbersDiffer(candidates[i - 1], candidates[i])) {
+            continue;
+        }
+        if (only_counterimage && !forwardsTo(m, candidates[i], num)) {
+            continue;
+        }
+        success = addElement(result->list, candidates[i], howLong(candidates[i]));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        free(candidates[i]);
+    }
+    free(candidates);
+    if (!success) {
+        phnumDelete(result);
+        result = NULL;
+    }
+    return result;
+}
+
+/** @brief Dodaje przekierowanie; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref MappedTable
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest wykonywane przekierowanie
+ * @return Wartość @p true, jeśli przekierowanie zostało dodane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool engineAdd(void *data, char const *num1, char const *num2) {
+    return mappedAdd(data, num1, num2);
+}
+
+/** @brief Usuwa przekierowania; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref MappedTable
+ * @param[in] num - wskaźnik na napis reprezentujący prefiks numerów
+ * @return Wartość @p true, jeśli usunięto jakieś przekierowanie.
+ *         Wartość @p false, jeśli nie było czego usuwać lub usunięcie się nie powiodło.
+ */
+static bool engineRemove(void *data, char const *num) {
+    MappedTable *m = data;
+    bool present = onlyDigitsAndNotEmpty(num) && (findForward(m, num, howLong(num)) != NO_UNIT);
+    return mappedRemove(m, num) && present;
+}
+
+/** @brief Wyznacza przekierowanie numeru; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref MappedTable
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+static PhoneNumbers * engineGet(void *data, char const *num) {
+    return mappedGet(data, num);
+}
+
+/** @brief Wyznacza odwrócenie; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref MappedTable
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+static PhoneNumbers * engineReverse(void *data, char const *num) {
+    return mappedReverse(data, num, false);
+}
+
+/** @brief Wyznacza przeciwobraz; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref MappedTable
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+static PhoneNumbers * engineGetReverse(void *data, char const *num) {
+    return mappedReverse(data, num, true);
+}
+
+/** @brief Zwalnia strukturę; funkcja silnika.
+ * @param[in] data - wskaźnik na strukturę @ref MappedTable
+ */
+static void engineClose(void *data) {
+    mappedClose(data);
+}
+
+/**
+ * To jest tablica funkcji silnika przechowującego przekierowania w zmapowanym pliku.
+ */
+static PhoneForwardEngine const mappedEngine = {
+    "mapped", engineAdd, engineRemove, engineGet, engineReverse, engineGetReverse, engineClose
+};
+
+/** @brief Otwiera przekierowania przechowywane w zmapowanym pliku.
+ * @param[in] path    - wskaźnik na napis reprezentujący ścieżkę pliku;
+ * @param[in] durable - czy każda zmiana ma być zapisywana na dysk przed powrotem.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy plik nie jest plikiem
+ *         przekierowań, jest otwarty przez inny proces, nie udało się go
+ *         otworzyć lub alokować pamięci.
+ */
+PhoneForward * phfwdOpenMapped(char const *path, bool durable) {
+    MappedTable *m = mappedOpen(path, durable);
+    return (m == NULL) ? NULL : phfwdNewWithEngine(&mappedEngine, m);
+}
+
+/** @brief Zapisuje na dysk plik przekierowań.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli zmiany zostały zapisane.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, struktura nie
+ *         jest przechowywana w pliku lub zapis się nie powiódł.
+ */
+bool phfwdSyncMapped(PhoneForward *pf) {
+    if ((pf == NULL) || (pf->engine != &mappedEngine)) {
+        return false;
+    }
+    return mappedSync(pf->engine_data);
+}
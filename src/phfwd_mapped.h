@@ -0,0 +1,79 @@
+/** @file
+ * Interfejs klasy przekierowań przechowywanych w zmapowanym pliku
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_MAPPED_H__
+#define __PHFWD_MAPPED_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+
+/**
+ * To jest struktura przekierowań przechowywanych w zmapowanym pliku.
+ */
+typedef struct MappedTable MappedTable;
+
+/** @brief Otwiera plik przekierowań, tworząc go w razie potrzeby.
+ * @param[in] path - ścieżka pliku
+ * @param[in] durable - czy każda zmiana ma być synchronizowana z dyskiem przed powrotem
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy plik nie jest plikiem
+ *         przekierowań, jest używany przez inny proces, nie udało się go
+ *         otworzyć lub alokować pamięci.
+ */
+MappedTable * mappedOpen(char const *path, bool durable);
+
+/** @brief Zamyka plik przekierowań i zwalnia pamięć struktury.
+ * @param[in] m - wskaźnik na strukturę
+ * @return Wartość @p true, jeśli wszystkie zmiany zostały zapisane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool mappedClose(MappedTable *m);
+
+/** @brief Synchronizuje plik przekierowań z dyskiem.
+ * @param[in] m - wskaźnik na strukturę
+ * @return Wartość @p true, jeśli synchronizacja się powiodła.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool mappedSync(MappedTable *m);
+
+/** @brief Dodaje przekierowanie, tak jak @ref phfwdAdd.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest wykonywane przekierowanie
+ * @return Wartość @p true, jeśli przekierowanie zostało dodane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool mappedAdd(MappedTable *m, char const *num1, char const *num2);
+
+/** @brief Usuwa przekierowania, tak jak @ref phfwdRemove.
+ * @param[in,out] m - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący prefiks numerów
+ * @return Wartość @p true, jeśli usunięcie się powiodło lub nie było czego usuwać.
+ *         Wartość @p false, jeśli nie udało się powiększyć pliku lub alokować pamięci.
+ */
+bool mappedRemove(MappedTable *m, char const *num);
+
+/** @brief Wyznacza przekierowanie numeru, tak jak @ref phfwdGet.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * mappedGet(MappedTable *m, char const *num);
+
+/** @brief Wyznacza odwrócenie lub przeciwobraz, tak jak @ref phfwdReverseOrGetReverse.
+ * @param[in] m - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] only_counterimage - czy wyznaczamy tylko przeciwobraz
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * mappedReverse(MappedTable *m, char const *num, bool only_counterimage);
+
+#endif /* __PHFWD_MAPPED_H__ */
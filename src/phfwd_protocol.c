@@ -0,0 +1,148 @@
+/** @file
+ * Implementacja klasy funkcji kodujących binarny protokół serwera przekierowań
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "phfwd_protocol.h"
+#include "packed_number.h"
+
+/**
+ * To jest liczba różnych cyfr numerów.
+ */
+#define DIGIT_VALUES 12
+
+/** @brief Zwraca rozmiar zapisanego numeru.
+ * @param[in] length - liczba cyfr numeru
+ * @return Liczba bajtów zajmowanych przez numer razem z nagłówkiem.
+ */
+size_t protoNumberSize(size_t length) {
+    return PHFWD_PROTO_NUMBER_HEADER + packedSize(length);
+}
+
+/** @brief Zapisuje numer.
+ * @param[out] out - wskaźnik na miejsce o rozmiarze co najmniej @ref protoNumberSize
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - długość numeru, nie większa niż @ref PHFWD_PROTO_MAX_DIGITS
+ * @return Wskaźnik na pierwszy bajt za zapisanym numerem.
+ */
+unsigned char * protoPutNumber(unsigned char *out, char const *num, size_t length) {
+    out[0] = (unsigned char)(length & 0xFF);
+    out[1] = (unsigned char)(length >> 8);
+    packDigits(out + PHFWD_PROTO_NUMBER_HEADER, num, length);
+    return out + protoNumberSize(length);
+}
+
+/** @brief Odczytuje liczbę cyfr zapisanego numeru.
+ * @param[in] in - wskaźnik na początek zapisanego numeru
+ * @return Liczba cyfr numeru.
+ */
+size_t protoNumberLength(unsigned char const *in) {
+    return (size_t)in[0] | ((size_t)in[1] << 8);
+}
+
+/** @brief Odczytuje numer.
+ * @param[out] num - wskaźnik na miejsce na co najmniej @ref protoNumberLength + 1 znaków
+ * @param[in] in - wskaźnik na początek zapisanego numeru
+ * @return Wartość @p true, jeśli wszystkie cyfry są poprawne.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool protoGetNumber(char *num, unsigned char const *in) {
+    size_t length = protoNumberLength(in);
+    unsigned char const *digits = in + PHFWD_PROTO_NUMBER_HEADER;
+    for (size_t i = 0; i < length; ++i) {
+        int value = packedDigitValue(digits, i);
+        if ((value < 0) || (value >= DIGIT_VALUES)) {
+            num[0] = '\0';
+            return false;
+        }
+        num[i] = digitCharacter(value);
+    }
+    num[length] = '\0';
+    return true;
+}
+
+/** @brief Wyznacza rozmiar zapisanych kolejno numerów.
+ * @param[in] in - wskaźnik na początek pierwszego numeru
+ * @param[in] available - liczba dostępnych bajtów
+ * @param[in] count - liczba numerów
+ * @return Rozmiar numerów lub wartość @p 0, jeśli nie są jeszcze pełne.
+ */
+static size_t numbersSize(unsigned char const *in, size_t available, size_t count) {
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (available - size < PHFWD_PROTO_NUMBER_HEADER) {
+            return 0;
+        }
+        size += protoNumberSize(protoNumberLength(in + size));
+        if (size > available) {
+            return 0;
+        }
+    }
+    return size;
+}
+
+/** @brief Wyznacza rozmiar pierwszego żądania w buforze.
+ * @param[in] in - wskaźnik na początek żądania
+ * @param[in] available - liczba dostępnych bajtów
+ * @return Rozmiar żądania, wartość @p 0, jeśli żądanie nie jest jeszcze
+ *         pełne, lub SIZE_MAX, jeśli rodzaj operacji jest nieznany.
+ */
+size_t protoRequestSize(unsigned char const *in, size_t available) {
+    if (available == 0) {
+        return 0;
+    }
+    size_t count;
+    switch (in[0]) {
+        case PHFWD_PROTO_GET:
+        case PHFWD_PROTO_REVERSE:
+        case PHFWD_PROTO_GETREVERSE:
+        case PHFWD_PROTO_REMOVE:
+            count = 1;
+            break;
+        case PHFWD_PROTO_ADD:
+            count = 2;
+            break;
+        default:
+            return SIZE_MAX;
+    }
+    size_t size = numbersSize(in + 1, available - 1, count);
+    return (size == 0) ? 0 : size + 1;
+}
+
+/** @brief Wyznacza rozmiar pierwszej odpowiedzi w buforze.
+ * @param[in] in - wskaźnik na początek odpowiedzi
+ * @param[in] available - liczba dostępnych bajtów
+ * @return Rozmiar odpowiedzi lub wartość @p 0, jeśli odpowiedź nie jest jeszcze pełna.
+ */
+size_t protoResponseSize(unsigned char const *in, size_t available) {
+    if (available < PHFWD_PROTO_RESPONSE_HEADER) {
+        return 0;
+    }
+    size_t count = (size_t)in[1] | ((size_t)in[2] << 8) | ((size_t)in[3] << 16) | ((size_t)in[4] << 24);
+    if (count == 0) {
+        return PHFWD_PROTO_RESPONSE_HEADER;
+    }
+    size_t size = numbersSize(in + PHFWD_PROTO_RESPONSE_HEADER, available - PHFWD_PROTO_RESPONSE_HEADER, count);
+    return (size == 0) ? 0 : size + PHFWD_PROTO_RESPONSE_HEADER;
+}
+
+/** @brief Zapisuje nagłówek odpowiedzi.
+ * @param[out] out - wskaźnik na miejsce o rozmiarze co najmniej @ref PHFWD_PROTO_RESPONSE_HEADER
+ * @param[in] status - stan odpowiedzi
+ * @param[in] count - liczba numerów odpowiedzi
+ * @return Wskaźnik na pierwszy bajt za nagłówkiem.
+ */
+unsigned char * protoPutResponseHeader(unsigned char *out, PhoneForwardResponseStatus status, uint32_t count) {
+    out[0] = (unsigned char)status;
+    for (int i = 0; i < 4; ++i) {
+        out[1 + i] = (unsigned char)(count >> (8 * i));
+    }
+    return out + PHFWD_PROTO_RESPONSE_HEADER;
+}
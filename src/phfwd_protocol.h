@@ -0,0 +1,111 @@
+/** @file
+ * Interfejs klasy funkcji kodujących binarny protokół serwera przekierowań
+ *
+ * Każde żądanie zaczyna się bajtem rodzaju operacji, po którym następuje
+ * jeden numer (dwa dla @ref PHFWD_PROTO_ADD). Każda odpowiedź zaczyna się
+ * bajtem stanu i czterobajtową liczbą numerów, po której następują numery.
+ * Numer jest zapisany jako dwubajtowa liczba cyfr i cyfry spakowane po dwie
+ * w bajcie, tak jak w @ref PackedNumber. Liczby są zapisywane od najmłodszego
+ * bajtu. Żądania można wysyłać jedno za drugim bez czekania na odpowiedzi;
+ * odpowiedzi przychodzą w kolejności żądań.
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_PROTOCOL_H__
+#define __PHFWD_PROTOCOL_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * To jest największa liczba cyfr numeru, którą można zapisać w protokole.
+ */
+#define PHFWD_PROTO_MAX_DIGITS UINT16_MAX
+
+/**
+ * To jest rozmiar nagłówka numeru.
+ */
+#define PHFWD_PROTO_NUMBER_HEADER 2
+
+/**
+ * To jest rozmiar nagłówka odpowiedzi.
+ */
+#define PHFWD_PROTO_RESPONSE_HEADER 5
+
+/**
+ * To jest typ operacji żądania.
+ */
+typedef enum PhoneForwardRequestType {
+    PHFWD_PROTO_GET = 1, ///< przekierowanie numeru, jak w @ref phfwdGet
+    PHFWD_PROTO_REVERSE = 2, ///< odwrócenie przekierowań, jak w @ref phfwdReverse
+    PHFWD_PROTO_GETREVERSE = 3, ///< przeciwobraz, jak w @ref phfwdGetReverse
+    PHFWD_PROTO_ADD = 4, ///< dodanie przekierowania, jak w @ref phfwdAdd
+    PHFWD_PROTO_REMOVE = 5 ///< usunięcie przekierowań, jak w @ref phfwdRemove
+} PhoneForwardRequestType;
+
+/**
+ * To jest typ stanu odpowiedzi.
+ */
+typedef enum PhoneForwardResponseStatus {
+    PHFWD_PROTO_OK = 0, ///< operacja się powiodła
+    PHFWD_PROTO_FAILED = 1, ///< operacja się nie powiodła, np. nie udało się alokować pamięci
+    PHFWD_PROTO_BAD_REQUEST = 2 ///< żądanie jest błędne; serwer zamyka połączenie
+} PhoneForwardResponseStatus;
+
+/** @brief Zwraca rozmiar zapisanego numeru.
+ * @param[in] length - liczba cyfr numeru
+ * @return Liczba bajtów zajmowanych przez numer razem z nagłówkiem.
+ */
+size_t protoNumberSize(size_t length);
+
+/** @brief Zapisuje numer.
+ * @param[out] out - wskaźnik na miejsce o rozmiarze co najmniej @ref protoNumberSize
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - długość numeru, nie większa niż @ref PHFWD_PROTO_MAX_DIGITS
+ * @return Wskaźnik na pierwszy bajt za zapisanym numerem.
+ */
+unsigned char * protoPutNumber(unsigned char *out, char const *num, size_t length);
+
+/** @brief Odczytuje liczbę cyfr zapisanego numeru.
+ * @param[in] in - wskaźnik na początek zapisanego numeru
+ * @return Liczba cyfr numeru.
+ */
+size_t protoNumberLength(unsigned char const *in);
+
+/** @brief Odczytuje numer.
+ * @param[out] num - wskaźnik na miejsce na co najmniej @ref protoNumberLength + 1 znaków
+ * @param[in] in - wskaźnik na początek zapisanego numeru
+ * @return Wartość @p true, jeśli wszystkie cyfry są poprawne.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool protoGetNumber(char *num, unsigned char const *in);
+
+/** @brief Wyznacza rozmiar pierwszego żądania w buforze.
+ * @param[in] in - wskaźnik na początek żądania
+ * @param[in] available - liczba dostępnych bajtów
+ * @return Rozmiar żądania, wartość @p 0, jeśli żądanie nie jest jeszcze
+ *         pełne, lub SIZE_MAX, jeśli rodzaj operacji jest nieznany.
+ */
+size_t protoRequestSize(unsigned char const *in, size_t available);
+
+/** @brief Wyznacza rozmiar pierwszej odpowiedzi w buforze.
+ * @param[in] in - wskaźnik na początek odpowiedzi
+ * @param[in] available - liczba dostępnych bajtów
+ * @return Rozmiar odpowiedzi lub wartość @p 0, jeśli odpowiedź nie jest jeszcze pełna.
+ */
+size_t protoResponseSize(unsigned char const *in, size_t available);
+
+/** @brief Zapisuje nagłówek odpowiedzi.
+ * @param[out] out - wskaźnik na miejsce o rozmiarze co najmniej @ref PHFWD_PROTO_RESPONSE_HEADER
+ * @param[in] status - stan odpowiedzi
+ * @param[in] count - liczba numerów odpowiedzi
+ * @return Wskaźnik na pierwszy bajt za nagłówkiem.
+ */
+unsigned char * protoPutResponseHeader(unsigned char *out, PhoneForwardResponseStatus status, uint32_t count);
+
+#endif /* __PHFWD_PROTOCOL_H__ */
@@ -0,0 +1,234 @@
+/** @file
+ * Implementacja klasy funkcji budujących drzewo odwróceń dla istniejących przekierowań
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "phone_forward.h"
+#include "phfwd_auxiliary_functions.h"
+#include "phfwd_traversal.h"
+#include "phfwd_batch.h"
+#include "packed_number.h"
+#include "list.h"
+
+/**
+ * To jest struktura opisująca zadanie jednego wątku budującego drzewo odwróceń.
+ * W pierwszym etapie wątek zbiera przekierowania z poddrzewa drzewa
+ * przekierowań o danej pierwszej cyfrze, a w drugim buduje poddrzewo drzewa
+ * odwróceń dla przekierowań na numery o danej pierwszej cyfrze.
+ */
+typedef struct IndexTask {
+    PhoneForward *pf; ///< wskaźnik na strukturę przechowującą przekierowania numerów
+    int digit; ///< pierwsza cyfra numerów obsługiwanych przez zadanie
+    BulkEntry *entries; ///< tablica przekierowań obsługiwanych przez zadanie
+    size_t count; ///< liczba elementów tablicy @p entries
+    size_t max_length; ///< długość najdłuższego numeru: w pierwszym etapie przekierowywanego, w drugim tego, na który jest wykonywane przekierowanie
+    size_t nodes; ///< liczba węzłów drzewa odwróceń tworzonych w drugim etapie
+    NodeRange range; ///< przedział indeksów puli, z którego w drugim etapie są tworzone węzły
+    bool result; ///< czy zadanie się powiodło
+} IndexTask;
+
+/** @brief Zbiera przekierowania z poddrzewa drzewa przekierowań.
+ * Dla każdego przekierowania przygotowuje wpis drzewa odwróceń z numerem
+ * przekierowywanym i zapisuje go w polu imHere węzła.
+ * @param[in,out] argument - wskaźnik na strukturę @ref IndexTask
+ * @return Wartość NULL.
+ */
+static void * collectForwards(void *argument) {
+    IndexTask *task = argument;
+    char prefix = digitCharacter(task->digit);
+    size_t capacity = 0;
+    TrieWalk walk;
+    task->result = walkStart(&walk, task->pf->pool, sonOf(task->pf->pool, task->pf->forward, task->digit), &prefix, 1);
+    if (!task->result) {
+        return NULL;
+    }
+    Node *n = NULL;
+    while ((n = walkNext(&walk)) != NULL) {
+        if ((n->list == NULL) || empty(n->list)) {
+            continue;
+        }
+        if (!reserveArray((void **)&(task->entries), &capacity, task->count + 1, sizeof(*(task->entries)))
+            || ((coldOf(task->pf->pool, n)->imHere = newPackedNumber(walk.path, walkPathLength(&walk))) == NULL)) {
+            task->result = false;
+            break;
+        }
+        OneNumber const *target = n->list->first;
+        task->entries[task->count].node = n;
+        task->entries[task->count].source = coldOf(task->pf->pool, n)->imHere;
+        task->entries[task->count].head = packedHead(target->digits, target->number_length);
+        ++(task->count);
+        if (walkPathLength(&walk) > task->max_length) {
+            task->max_length = walkPathLength(&walk);
+        }
+    }
+    if (walk.failed) {
+        task->result = false;
+    }
+    walkFinish(&walk);
+    return NULL;
+}
+
+/** @brief Sortuje przekierowania zadania i wyznacza liczbę potrzebnych węzłów.
+ * @param[in,out] argument - wskaźnik na strukturę @ref IndexTask
+ * @return Wartość NULL.
+ */
+static void * sortForwards(void *argument) {
+    IndexTask *task = argument;
+    task->nodes = sortReverseEntries(task->entries, task->count);
+    return NULL;
+}
+
+/** @brief Buduje poddrzewo drzewa odwróceń.
+ * Węzły tworzy z przedziału indeksów zadania, bez zmieniania puli.
+ * @param[in,out] argument - wskaźnik na strukturę @ref IndexTask
+ * @return Wartość NULL.
+ */
+static void * buildReverseSubtree(void *argument) {
+    IndexTask *task = argument;
+    task->result = bulkLoadReverse(task->pf, &task->range, task->entries, task->count, task->max_length);
+    return NULL;
+}
+
+/** @brief Wykonuje zadania równolegle, po jednym wątku na zadanie.
+ * Zadanie, dla którego nie udało się utworzyć wątku, jest wykonywane
+ * w wątku wywołującym.
+ * @param[in] work - funkcja wykonująca zadanie
+ * @param[in,out] tasks - tablica zadań
+ * @param[in] count - liczba zadań
+ */
+static void runTasks(void * (*work)(void *), IndexTask *tasks, size_t count) {
+    pthread_t threads[SONS];
+    bool started[SONS];
+    for (size_t i = 0; i < count; ++i) {
+        started[i] = (pthread_create(&threads[i], NULL, work, &tasks[i]) == 0);
+        if (!started[i]) {
+            work(&tasks[i]);
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
+
+/** @brief Rozdziela zebrane przekierowania według pierwszej cyfry numeru, na który są wykonywane.
+ * @param[in] collected - zadania pierwszego etapu
+ * @param[out] buckets - zadania drugiego etapu
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool distributeForwards(IndexTask const *collected, IndexTask *buckets) {
+    for (int d = 0; d < SONS; ++d) {
+        for (size_t i = 0; i < collected[d].count; ++i) {
+            OneNumber const *target = collected[d].entries[i].node->list->first;
+            IndexTask *bucket = &buckets[packedDigitValue(target->digits, 0)];
+            ++(bucket->count);
+            if (target->number_length > bucket->max_length) {
+                bucket->max_length = target->number_length;
+            }
+        }
+    }
+    for (int d = 0; d < SONS; ++d) {
+        if ((buckets[d].count > 0)
+            && ((buckets[d].entries = malloc(buckets[d].count * sizeof(*(buckets[d].entries)))) == NULL)) {
+            return false;
+        }
+        buckets[d].count = 0;
+    }
+    for (int d = 0; d < SONS; ++d) {
+        for (size_t i = 0; i < collected[d].count; ++i) {
+            OneNumber const *target = collected[d].entries[i].node->list->first;
+            IndexTask *bucket = &buckets[packedDigitValue(target->digits, 0)];
+            bucket->entries[bucket->count] = collected[d].entries[i];
+            ++(bucket->count);
+        }
+    }
+    return true;
+}
+
+/** @brief Buduje drzewo odwróceń dla struktury utworzonej bez niego.
+ * Najpierw równolegle, dla każdej pierwszej cyfry numeru przekierowywanego,
+ * zbiera przekierowania i przygotowuje wpisy drzewa odwróceń, a następnie
+ * równolegle, dla każdej pierwszej cyfry numeru, na który jest wykonywane
+ * przekierowanie, sortuje przekierowania i buduje odpowiednie poddrzewo
+ * drzewa odwróceń w jednym przejściu po posortowanych numerach. Wątki
+ * modyfikują rozłączne poddrzewa i tworzą węzły z rozłącznych przedziałów
+ * indeksów przydzielonych z góry, więc pula nie potrzebuje blokady.
+ * Po udanym wywołaniu struktura działa tak jak utworzona przez @ref phfwdNew.
+ * Nic nie robi, jeśli struktura ma już drzewo odwróceń.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli struktura ma drzewo odwróceń.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL lub nie udało
+ *         się alokować pamięci; wtedy struktura pozostaje bez zmian.
+ */
+bool phfwdBuildReverseIndex(PhoneForward *pf) {
+    if ((pf == NULL) || (pf->engine != NULL)) {
+        return false;
+    }
+    if (pf->reverse != NULL) {
+        return true;
+    }
+    if ((pf->reverse = newNode(pf->pool, NULL)) == NULL) {
+        return false;
+    }
+
+    IndexTask collected[SONS];
+    IndexTask buckets[SONS];
+    for (int d = 0; d < SONS; ++d) {
+        collected[d] = (IndexTask){pf, d, NULL, 0, 0, 0, {0, 0}, true};
+        buckets[d] = (IndexTask){pf, d, NULL, 0, 0, 0, {0, 0}, true};
+    }
+    runTasks(collectForwards, collected, SONS);
+    bool result = true;
+    size_t longest_entry = pf->pool->longest_entry;
+    for (int d = 0; d < SONS; ++d) {
+        result = result && collected[d].result;
+        longest_entry = (collected[d].max_length > longest_entry) ? collected[d].max_length : longest_entry;
+    }
+    result = result && distributeForwards(collected, buckets);
+    if (result) {
+        runTasks(sortForwards, buckets, SONS);
+        for (int d = 0; d < SONS; ++d) {
+            result = result && takeNodeRange(pf->pool, buckets[d].nodes, &buckets[d].range);
+        }
+    }
+    if (result) {
+        runTasks(buildReverseSubtree, buckets, SONS);
+        for (int d = 0; d < SONS; ++d) {
+            result = result && buckets[d].result;
+        }
+    }
+    for (int d = 0; d < SONS; ++d) {
+        returnNodeRange(pf->pool, &buckets[d].range);
+    }
+
+    // Po niepowodzeniu wpisy, które nie trafiły do drzewa odwróceń, zwalniamy osobno.
+    for (int d = 0; d < SONS; ++d) {
+        for (size_t i = 0; !result && (i < collected[d].count); ++i) {
+            Node *n = collected[d].entries[i].node;
+            if (coldOf(pf->pool, n)->infoAboutMe == 0) {
+                freeNumber(coldOf(pf->pool, n)->imHere);
+            }
+            coldOf(pf->pool, n)->infoAboutMe = 0;
+            coldOf(pf->pool, n)->imHere = NULL;
+        }
+        free(collected[d].entries);
+        free(buckets[d].entries);
+    }
+    if (!result) {
+        treeFree(pf->pool, pf->reverse);
+        pf->reverse = NULL;
+    }
+    else {
+        pf->pool->longest_entry = longest_entry;
+    }
+    return result;
+}
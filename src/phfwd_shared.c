@@ -0,0 +1,752 @@
+/** @file
+ * Implementacja klasy funkcji udostępniających przekierowania wielu procesom
+ *
+ * Przekierowania są publikowane jako niezmienny obraz w obiekcie pamięci
+ * dzielonej POSIX lub w pliku. Węzły obrazu odwołują się do siebie przez
+ * indeksy, a nie wskaźniki, więc obraz może być zmapowany pod dowolnym
+ * adresem. Każda wersja ma osobny obiekt o nazwie z dopisanym numerem
+ * wersji, a mały obiekt sterujący o podanej nazwie przechowuje numer
+ * wersji bieżącej, zmieniany niepodzielnie.
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "phone_forward.h"
+#include "phfwd_auxiliary_functions.h"
+#include "phfwd_batch.h"
+#include "phfwd_iterator.h"
+#include "packed_number.h"
+#include "list.h"
+
+/**
+ * To jest napis rozpoczynający obraz przekierowań.
+ */
+#define IMAGE_MAGIC "PFWDSHM1"
+
+/**
+ * To jest napis rozpoczynający obiekt sterujący.
+ */
+#define CONTROL_MAGIC "PFWDSHC1"
+
+/**
+ * To jest długość napisów rozpoczynających obraz i obiekt sterujący.
+ */
+#define MAGIC_LENGTH 8
+
+/**
+ * To jest indeks oznaczający brak węzła.
+ */
+#define NO_NODE UINT32_MAX
+
+/**
+ * To jest liczba prób otwarcia bieżącej wersji, gdy wydawca ją właśnie podmienia.
+ */
+#define ATTACH_ATTEMPTS 16
+
+/**
+ * To jest nagłówek obiektu sterującego.
+ */
+typedef struct SharedControl {
+    char magic[MAGIC_LENGTH]; ///< napis @ref CONTROL_MAGIC
+    _Atomic uint64_t generation; ///< numer bieżącej wersji; 0 oznacza brak opublikowanej wersji
+} SharedControl;
+
+/**
+ * To jest węzeł obrazu. Synowie węzła leżą w tablicy węzłów jeden za drugim,
+ * w kolejności cyfr.
+ */
+typedef struct SharedNode {
+    uint32_t sons; ///< indeks pierwszego syna
+    uint16_t mask; ///< maska cyfr, dla których węzeł ma syna
+    uint16_t unused; ///< wyrównanie
+    uint32_t first; ///< indeks pierwszego numeru węzła w tablicy numerów
+    uint32_t count; ///< liczba numerów węzła
+} SharedNode;
+
+/**
+ * To jest numer zapisany w obrazie.
+ */
+typedef struct SharedEntry {
+    uint64_t offset; ///< pozycja spakowanych cyfr w obrazie
+    uint64_t length; ///< liczba cyfr
+} SharedEntry;
+
+/**
+ * To jest nagłówek obrazu.
+ */
+typedef struct SharedImage {
+    char magic[MAGIC_LENGTH]; ///< napis @ref IMAGE_MAGIC
+    uint64_t size; ///< rozmiar obrazu w bajtach
+    uint64_t nodes; ///< pozycja tablicy węzłów w obrazie
+    uint64_t entries; ///< pozycja tablicy numerów w obrazie
+    uint32_t forward_root; ///< indeks korzenia drzewa przekierowań
+    uint32_t reverse_root; ///< indeks korzenia drzewa odwróceń lub @ref NO_NODE
+} SharedImage;
+
+/**
+ * To jest struktura procesu czytającego opublikowane przekierowania.
+ */
+struct PhoneForwardShared {
+    char *name; ///< nazwa obiektu sterującego
+    SharedControl const *control; ///< zmapowany obiekt sterujący
+    uint64_t generation; ///< numer zmapowanej wersji
+    SharedImage const *image; ///< zmapowany obraz tej wersji
+    size_t size; ///< rozmiar zmapowanego obrazu
+};
+
+/** @brief Sprawdza, czy nazwa oznacza obiekt pamięci dzielonej.
+ * @param[in] name - nazwa
+ * @return Wartość @p true, jeśli nazwa zaczyna się znakiem '/' i nie zawiera innych.
+ *         Wartość @p false, jeśli oznacza zwykły plik.
+ */
+static bool isSharedMemoryName(char const *name) {
+    return (name[0] == '/') && (strchr(name + 1, '/') == NULL);
+}
+
+/** @brief Otwiera obiekt pamięci dzielonej lub plik.
+ * @param[in] name - nazwa
+ * @param[in] flags - flagi otwarcia
+ * @return Deskryptor lub -1, gdy się nie udało.
+ */
+static int openObject(char const *name, int flags) {
+    return isSharedMemoryName(name) ? shm_open(name, flags, 0644) : open(name, flags, 0644);
+}
+
+/** @brief Usuwa obiekt pamięci dzielonej lub plik.
+ * @param[in] name - nazwa
+ * @return Wartość @p 0 lub -1, gdy się nie udało.
+ */
+static int unlinkObject(char const *name) {
+    return isSharedMemoryName(name) ? shm_unlink(name) : unlink(name);
+}
+
+/** @brief Tworzy nazwę obiektu z obrazem danej wersji.
+ * @param[in] name - nazwa obiektu sterującego
+ * @param[in] generation - numer wersji
+ * @return Wskaźnik na nazwę lub NULL, gdy nie udało się alokować pamięci.
+ */
+static char * versionName(char const *name, uint64_t generation) {
+    size_t size = strlen(name) + 22;
+    char *result = malloc(size);
+    if (result != NULL) {
+        snprintf(result, size, "%s.%llu", name, (unsigned long long)generation);
+    }
+    return result;
+}
+
+/**
+ * To jest stan budowania obrazu.
+ */
+typedef struct ImageBuilder {
+    PhoneForward const *pf; ///< wskaźnik na strukturę przechowującą przekierowania numerów
+    Node **order; ///< węzły obu drzew w kolejności wszerz
+    size_t count; ///< liczba węzłów
+    size_t capacity; ///< liczba węzłów, na które jest miejsce
+    size_t entries; ///< liczba numerów
+    size_t digits; ///< liczba bajtów spakowanych cyfr
+} ImageBuilder;
+
+/** @brief Sprawdza, czy numer węzła trafia do obrazu.
+ * @param[in] b - wskaźnik na stan budowania
+ * @param[in] reverse - czy węzeł należy do drzewa odwróceń
+ * @param[in] n - wskaźnik na węzeł
+ * @param[in] element - wskaźnik na numer węzła
+ * @return Wartość @p true, jeśli numer odpowiada istniejącemu przekierowaniu.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool entryPublished(ImageBuilder const *b, bool reverse, Node const *n, OneNumber const *element) {
+    return !reverse || (b->pf->graveyard == NULL) || reverseEntryAlive(b->pf->pool, b->pf->forward, n, element);
+}
+
+/** @brief Dopisuje węzły drzewa w kolejności wszerz i liczy ich numery.
+ * @param[in,out] b - wskaźnik na stan budowania
+ * @param[in] root - wskaźnik na korzeń drzewa
+ * @param[in] reverse - czy drzewo jest drzewem odwróceń
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool collectNodes(ImageBuilder *b, Node *root, bool reverse) {
+    size_t position = b->count;
+    if (!reserveArray((void **)&(b->order), &(b->capacity), b->count + 1, sizeof(*(b->order)))) {
+        return false;
+    }
+    b->order[b->count++] = root;
+    while (position < b->count) {
+        Node *n = b->order[position++];
+        for (int i = 0; i < SONS; ++i) {
+            if ((n->sons)[i] == 0) {
+                continue;
+            }
+            if (!reserveArray((void **)&(b->order), &(b->capacity), b->count + 1, sizeof(*(b->order)))) {
+                return false;
+            }
+            b->order[b->count++] = sonOf(b->pf->pool, n, i);
+        }
+        if (n->list == NULL) {
+            continue;
+        }
+        for (OneNumber *element = n->list->first; element != NULL; element = element->next) {
+            if (entryPublished(b, reverse, n, element)) {
+                ++(b->entries);
+                b->digits += packedSize(element->number_length);
+            }
+            if (!reverse) {
+                break; // W drzewie przekierowań liczy się tylko pierwszy numer listy.
+            }
+        }
+    }
+    return true;
+}
+
+/** @brief Zapisuje węzły drzewa do obrazu.
+ * @param[in] b - wskaźnik na stan budowania
+ * @param[out] image - wskaźnik na początek obrazu
+ * @param[in] begin - indeks korzenia drzewa w kolejności wszerz
+ * @param[in] end - indeks za ostatnim węzłem drzewa
+ * @param[in] reverse - czy drzewo jest drzewem odwróceń
+ * @param[in,out] entry - adres indeksu kolejnego wolnego numeru
+ * @param[in,out] offset - adres pozycji kolejnych wolnych bajtów cyfr
+ */
+static void writeNodes(ImageBuilder const *b, SharedImage *image, size_t begin, size_t end, bool reverse,
+                       size_t *entry, size_t *offset) {
+    unsigned char *base = (unsigned char *)image;
+    SharedNode *nodes = (SharedNode *)(base + image->nodes);
+    SharedEntry *entries = (SharedEntry *)(base + image->entries);
+    size_t next_son = begin + 1;
+    for (size_t k = begin; k < end; ++k) {
+        Node const *n = b->order[k];
+        SharedNode *out = &(nodes[k]);
+        out->sons = (uint32_t)next_son;
+        out->mask = 0;
+        out->unused = 0;
+        for (int i = 0; i < SONS; ++i) {
+            if ((n->sons)[i] != 0) {
+                out->mask |= (uint16_t)(1u << i);
+                ++next_son;
+            }
+        }
+        out->first = (uint32_t)*entry;
+        out->count = 0;
+        for (OneNumber const *element = (n->list == NULL) ? NULL : n->list->first; element != NULL;
+             element = element->next) {
+            if (entryPublished(b, reverse, n, element)) {
+                entries[*entry].offset = *offset;
+                entries[*entry].length = element->number_length;
+                memcpy(base + *offset, element->digits, packedSize(element->number_length));
+                *offset += packedSize(element->number_length);
+                ++(*entry);
+                ++(out->count);
+            }
+            if (!reverse) {
+                break;
+            }
+        }
+    }
+}
+
+/** @brief Buduje obraz przekierowań w podanym obiekcie.
+ * @param[in,out] b - wskaźnik na stan budowania z zebranymi węzłami
+ * @param[in] fd - deskryptor obiektu otwartego do zapisu
+ * @param[in] forward_count - liczba węzłów drzewa przekierowań
+ * @return Wartość @p true, jeśli obraz został zapisany.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool writeImage(ImageBuilder *b, int fd, size_t forward_count) {
+    size_t nodes = sizeof(SharedImage);
+    size_t entries = nodes + b->count * sizeof(SharedNode);
+    size_t digits = entries + b->entries * sizeof(SharedEntry);
+    size_t size = digits + b->digits;
+    if ((ftruncate(fd, (off_t)size) != 0)) {
+        return false;
+    }
+    SharedImage *image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (image == MAP_FAILED) {
+        return false;
+    }
+    memset(image, 0, sizeof(*image));
+    image->size = size;
+    image->nodes = nodes;
+    image->entries = entries;
+    image->forward_root = 0;
+    image->reverse_root = (forward_count < b->count) ? (uint32_t)forward_count : NO_NODE;
+    size_t entry = 0;
+    size_t offset = digits;
+    writeNodes(b, image, 0, forward_count, false, &entry, &offset);
+    writeNodes(b, image, forward_count, b->count, true, &entry, &offset);
+    // Napis rozpoczynający jest zapisywany na końcu, więc niepełny obraz nie zostanie przyjęty.
+    memcpy(image->magic, IMAGE_MAGIC, MAGIC_LENGTH);
+    munmap(image, size);
+    return true;
+}
+
+/** @brief Mapuje obiekt sterujący, tworząc go w razie potrzeby.
+ * @param[in] fd - deskryptor obiektu otwartego do zapisu
+ * @return Wskaźnik na zmapowany obiekt lub NULL, gdy się nie udało.
+ */
+static SharedControl * mapControl(int fd) {
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        return NULL;
+    }
+    if (((size_t)status.st_size < sizeof(SharedControl)) && (ftruncate(fd, sizeof(SharedControl)) != 0)) {
+        return NULL;
+    }
+    SharedControl *control = mmap(NULL, sizeof(*control), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (control == MAP_FAILED) {
+        return NULL;
+    }
+    if (memcmp(control->magic, CONTROL_MAGIC, MAGIC_LENGTH) != 0) {
+        if (status.st_size != 0) {
+            munmap(control, sizeof(*control));
+            return NULL; // To nie jest obiekt sterujący.
+        }
+        atomic_store(&(control->generation), 0);
+        memcpy(control->magic, CONTROL_MAGIC, MAGIC_LENGTH);
+    }
+    return control;
+}
+
+/** @brief Publikuje przekierowania dla innych procesów.
+ * Zapisuje niezmienny obraz przekierowań jako nową wersję i niepodzielnie
+ * czyni ją bieżącą. Procesy, które dołączyły się przez @ref phfwdAttach,
+ * przechodzą na nową wersję przy kolejnym zapytaniu; poprzednia wersja
+ * jest usuwana, ale pozostaje dostępna dla procesów, które ją zmapowały.
+ * Nazwa zaczynająca się znakiem '/' i niezawierająca innych znaków '/'
+ * oznacza obiekt pamięci dzielonej POSIX, a każda inna – zwykły plik.
+ * Równoczesne publikacje pod tą samą nazwą są szeregowane blokadą pliku.
+ * @param[in] pf   - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] name - wskaźnik na napis reprezentujący nazwę.
+ * @return Wartość @p true, jeśli przekierowania zostały opublikowane.
+ *         Wartość @p false, jeśli parametr pf lub name ma wartość NULL,
+ *         struktura ma więcej niż 2^32 - 1 węzłów, nie udało się utworzyć
+ *         obiektu lub alokować pamięci.
+ */
+bool phfwdPublish(PhoneForward const *pf, char const *name) {
+    if ((pf == NULL) || (pf->engine != NULL) || (name == NULL)) {
+        return false;
+    }
+    ImageBuilder b = {pf, NULL, 0, 0, 0, 0};
+    bool result = collectNodes(&b, pf->forward, false);
+    size_t forward_count = b.count;
+    if (result && (pf->reverse != NULL)) {
+        result = collectNodes(&b, pf->reverse, true);
+    }
+    result = result && (b.count < NO_NODE) && (b.entries < UINT32_MAX);
+
+    int control_fd = result ? openObject(name, O_RDWR | O_CREAT) : -1;
+    SharedControl *control = NULL;
+    char *version = NULL;
+    if (control_fd >= 0) {
+        flock(control_fd, LOCK_EX);
+        control = mapControl(control_fd);
+    }
+    result = result && (control != NULL);
+    uint64_t generation = result ? atomic_load(&(control->generation)) + 1 : 0;
+    if (result) {
+        version = versionName(name, generation);
+        int fd = (version == NULL) ? -1 : openObject(version, O_RDWR | O_CREAT | O_TRUNC);
+        result = (fd >= 0) && writeImage(&b, fd, forward_count);
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (!result && (version != NULL)) {
+            unlinkObject(version);
+        }
+    }
+    if (result) {
+        atomic_store_explicit(&(control->generation), generation, memory_order_release);
+        char *previous = versionName(name, generation - 1);
+        if (previous != NULL) {
+            unlinkObject(previous); // Procesy, które mają ją zmapowaną, mogą z niej dalej korzystać.
+            free(previous);
+        }
+    }
+    if (control != NULL) {
+        munmap(control, sizeof(*control));
+    }
+    if (control_fd >= 0) {
+        close(control_fd); // Zwalnia też blokadę.
+    }
+    free(version);
+    free(b.order);
+    return result;
+}
+
+/** @brief Mapuje bieżącą wersję, jeśli różni się od zmapowanej.
+ * @param[in,out] shared - wskaźnik na strukturę procesu czytającego
+ * @return Wartość @p true, jeśli zmapowana jest bieżąca lub wcześniejsza poprawna wersja.
+ *         Wartość @p false, jeśli nie udało się zmapować żadnej wersji.
+ */
+static bool refresh(PhoneForwardShared *shared) {
+    for (int attempt = 0; attempt < ATTACH_ATTEMPTS; ++attempt) {
+        uint64_t generation = atomic_load_explicit(&(shared->control->generation), memory_order_acquire);
+        if ((generation == shared->generation) || (generation == 0)) {
+            break;
+        }
+        char *version = versionName(shared->name, generation);
+        if (version == NULL) {
+            break;
+        }
+        int fd = openObject(version, O_RDONLY);
+        free(version);
+        if (fd < 0) {
+            continue; // Wydawca właśnie opublikował nowszą wersję i usunął tę.
+        }
+        struct stat status;
+        SharedImage const *image = MAP_FAILED;
+        if ((fstat(fd, &status) == 0) && ((size_t)status.st_size >= sizeof(SharedImage))) {
+            image = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (image == MAP_FAILED) {
+            break;
+        }
+        if ((memcmp(image->magic, IMAGE_MAGIC, MAGIC_LENGTH) != 0) || (image->size != (uint64_t)status.st_size)) {
+            munmap((void *)image, (size_t)status.st_size);
+            break;
+        }
+        if (shared->image != NULL) {
+            munmap((void *)shared->image, shared->size);
+        }
+        shared->image = image;
+        shared->size = (size_t)status.st_size;
+        shared->generation = generation;
+        break;
+    }
+    return shared->image != NULL;
+}
+
+/** @brief Dołącza się do opublikowanych przekierowań.
+ * Mapuje bieżącą wersję przekierowań opublikowanych przez @ref phfwdPublish
+ * pod nazwą @p name. Zapytania nie kopiują obrazu; gdy zostanie opublikowana
+ * nowa wersja, kolejne zapytanie ją zmapuje. Struktura nie może być używana
+ * równocześnie przez kilka wątków; każdy wątek może mieć własną.
+ * @param[in] name - wskaźnik na napis reprezentujący nazwę.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nic nie opublikowano
+ *         pod tą nazwą, nie udało się zmapować obrazu lub alokować pamięci.
+ */
+PhoneForwardShared * phfwdAttach(char const *name) {
+    if (name == NULL) {
+        return NULL;
+    }
+    PhoneForwardShared *shared = calloc(1, sizeof(*shared));
+    if (shared == NULL) {
+        return NULL;
+    }
+    shared->name = malloc(strlen(name) + 1);
+    int fd = openObject(name, O_RDONLY);
+    struct stat status;
+    if ((shared->name != NULL) && (fd >= 0) && (fstat(fd, &status) == 0)
+        && ((size_t)status.st_size >= sizeof(SharedControl))) {
+        strcpy(shared->name, name);
+        SharedControl const *control = mmap(NULL, sizeof(SharedControl), PROT_READ, MAP_SHARED, fd, 0);
+        if (control != MAP_FAILED) {
+            shared->control = control;
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    if ((shared->control == NULL) || (memcmp(shared->control->magic, CONTROL_MAGIC, MAGIC_LENGTH) != 0)
+        || !refresh(shared)) {
+        phfwdDetach(shared);
+        return NULL;
+    }
+    return shared;
+}
+
+/** @brief Odłącza się od opublikowanych przekierowań.
+ * Usuwa strukturę wskazywaną przez @p shared. Nic nie robi, jeśli wskaźnik
+ * ten ma wartość NULL.
+ * @param[in] shared - wskaźnik na usuwaną strukturę.
+ */
+void phfwdDetach(PhoneForwardShared *shared) {
+    if (shared == NULL) {
+        return;
+    }
+    if (shared->image != NULL) {
+        munmap((void *)shared->image, shared->size);
+    }
+    if (shared->control != NULL) {
+        munmap((void *)shared->control, sizeof(SharedControl));
+    }
+    free(shared->name);
+    free(shared);
+}
+
+/** @brief Usuwa opublikowane przekierowania.
+ * Usuwa obiekt sterujący i bieżącą wersję. Procesy, które je zmapowały,
+ * mogą z nich dalej korzystać.
+ * @param[in] name - wskaźnik na napis reprezentujący nazwę.
+ * @return Wartość @p true, jeśli obiekty zostały usunięte.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdUnpublish(char const *name) {
+    PhoneForwardShared *shared = phfwdAttach(name);
+    if (shared == NULL) {
+        return false;
+    }
+    char *version = versionName(name, shared->generation);
+    bool result = (version != NULL) && (unlinkObject(version) == 0);
+    result = (unlinkObject(name) == 0) && result;
+    free(version);
+    phfwdDetach(shared);
+    return result;
+}
+
+/** @brief Zwraca węzeł obrazu.
+ * @param[in] image - wskaźnik na obraz
+ * @param[in] index - indeks węzła
+ * @return Wskaźnik na węzeł.
+ */
+static inline SharedNode const * imageNode(SharedImage const *image, uint32_t index) {
+    return (SharedNode const *)((unsigned char const *)image + image->nodes) + index;
+}
+
+/** @brief Zwraca numer zapisany w obrazie.
+ * @param[in] image - wskaźnik na obraz
+ * @param[in] index - indeks numeru
+ * @return Wskaźnik na opis numeru.
+ */
+static inline SharedEntry const * imageEntry(SharedImage const *image, uint32_t index) {
+    return (SharedEntry const *)((unsigned char const *)image + image->entries) + index;
+}
+
+/** @brief Zwraca syna węzła obrazu.
+ * @param[in] image - wskaźnik na obraz
+ * @param[in] node - wskaźnik na węzeł
+ * @param[in] digit - wartość cyfry
+ * @return Wskaźnik na syna lub NULL, gdy go nie ma.
+ */
+static inline SharedNode const * imageSon(SharedImage const *image, SharedNode const *node, int digit) {
+    uint32_t bit = 1u << digit;
+    if ((node->mask & bit) == 0) {
+        return NULL;
+    }
+    return imageNode(image, node->sons + (uint32_t)__builtin_popcount(node->mask & (bit - 1)));
+}
+
+/** @brief Szuka w obrazie najdłuższego prefiksu numeru, który ma przekierowanie.
+ * @param[in] image - wskaźnik na obraz
+ * @param[in] source - wskaźnik na opis numeru
+ * @param[out] eaten - adres zmiennej, w której zostanie zapisana długość prefiksu
+ * @return Wskaźnik na przekierowanie prefiksu lub NULL, gdy go nie ma.
+ */
+static SharedEntry const * imageLookup(SharedImage const *image, ReverseSource const *source, size_t *eaten) {
+    SharedEntry const *result = NULL;
+    SharedNode const *node = imageNode(image, image->forward_root);
+    size_t length = sourceLength(source);
+    *eaten = 0;
+    for (size_t i = 0; (node != NULL) && (i < length); ++i) {
+        node = imageSon(image, node, sourceDigit(source, i));
+        if ((node != NULL) && (node->count > 0)) {
+            result = imageEntry(image, node->first);
+            *eaten = i + 1;
+        }
+    }
+    return result;
+}
+
+/** @brief Dopisuje do ciągu numer opisany przez strukturę @ref ReverseSource.
+ * @param[in,out] pnum - wskaźnik na ciąg numerów
+ * @param[in] source - wskaźnik na opis numeru
+ * @param[out] text - bufor na co najmniej sourceLength(source) + 1 znaków
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool appendSource(PhoneNumbers *pnum, ReverseSource const *source, char *text) {
+    size_t length = sourceLength(source);
+    for (size_t i = 0; i < length; ++i) {
+        text[i] = digitCharacter(sourceDigit(source, i));
+    }
+    text[length] = '\0';
+    return addElement(pnum->list, text, length);
+}
+
+/** @brief Wyznacza przekierowanie numeru w opublikowanych przekierowaniach.
+ * Działa tak jak @ref phfwdGet. Przechodzi na bieżącą wersję, jeśli
+ * opublikowano nową.
+ * @param[in,out] shared - wskaźnik na strukturę procesu czytającego;
+ * @param[in] num        - wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci albo parametr shared ma wartość NULL.
+ */
+PhoneNumbers * phfwdSharedGet(PhoneForwardShared *shared, char const *num) {
+    if ((shared == NULL) || !refresh(shared)) {
+        return NULL;
+    }
+    PhoneNumbers *result = newPhoneNumbers();
+    if ((result == NULL) || !onlyDigitsAndNotEmpty(num)) {
+        return result;
+    }
+    SharedImage const *image = shared->image;
+    size_t length = howLong(num);
+    PackedNumber query = {packNumber(num, length), length};
+    char *text = NULL;
+    if (query.digits != NULL) {
+        ReverseSource source = {NULL, &query, 0};
+        size_t eaten;
+        SharedEntry const *forward = imageLookup(image, &source, &eaten);
+        OneNumber element;
+        if (forward != NULL) {
+            element.digits = (unsigned char *)image + forward->offset;
+            element.number_length = forward->length;
+            source.element = &element;
+            source.suffix_start = eaten;
+        }
+        text = malloc(sourceLength(&source) + 1);
+        if ((text == NULL) || !appendSource(result, &source, text)) {
+            phnumDelete(result);
+            result = NULL;
+        }
+    }
+    else {
+        phnumDelete(result);
+        result = NULL;
+    }
+    free(text);
+    free(query.digits);
+    return result;
+}
+
+/** @brief Sprawdza, czy numer jest przekierowywany na numer zapytania.
+ * @param[in] image - wskaźnik na obraz
+ * @param[in] source - wskaźnik na opis sprawdzanego numeru
+ * @return Wartość @p true, jeśli przekierowaniem numeru jest numer zapytania.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool imageIsCounterimage(SharedImage const *image, ReverseSource const *source) {
+    size_t eaten;
+    SharedEntry const *forward = imageLookup(image, source, &eaten);
+    PackedNumber const *target = source->query;
+    if (forward == NULL) {
+        return compareSources(source, &(ReverseSource){NULL, target, 0}) == 0;
+    }
+    size_t length = sourceLength(source);
+    if (forward->length + length - eaten != target->length) {
+        return false;
+    }
+    unsigned char const *digits = (unsigned char const *)image + forward->offset;
+    for (size_t i = 0; i < forward->length; ++i) {
+        if (packedDigitValue(digits, i) != packedDigitValue(target->digits, i)) {
+            return false;
+        }
+    }
+    for (size_t i = eaten; i < length; ++i) {
+        if (sourceDigit(source, i) != packedDigitValue(target->digits, i - eaten + forward->length)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Wyznacza odwrócenie lub przeciwobraz w opublikowanych przekierowaniach.
+ * @param[in,out] shared - wskaźnik na strukturę procesu czytającego
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] only_counterimage - czy wyznaczamy tylko przeciwobraz
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci, parametr shared ma wartość NULL lub
+ *         opublikowano strukturę bez drzewa odwróceń.
+ */
+static PhoneNumbers * sharedReverse(PhoneForwardShared *shared, char const *num, bool only_counterimage) {
+    if ((shared == NULL) || !refresh(shared) || (shared->image->reverse_root == NO_NODE)) {
+        return NULL;
+    }
+    PhoneNumbers *result = newPhoneNumbers();
+    if ((result == NULL) || !onlyDigitsAndNotEmpty(num)) {
+        return result;
+    }
+    SharedImage const *image = shared->image;
+    size_t length = howLong(num);
+    size_t count = 1;
+    size_t max_length = length;
+    SharedNode const *node = imageNode(image, image->reverse_root);
+    for (size_t i = 0; (node != NULL) && (i < length); ++i) {
+        node = imageSon(image, node, digitValue(num + i));
+        for (uint32_t j = 0; (node != NULL) && (j < node->count); ++j) {
+            size_t candidate = imageEntry(image, node->first + j)->length + length - i - 1;
+            max_length = (candidate > max_length) ? candidate : max_length;
+            ++count;
+        }
+    }
+    PackedNumber query = {packNumber(num, length), length};
+    OneNumber *elements = malloc(count * sizeof(*elements));
+    ReverseSource *sources = malloc(count * sizeof(*sources));
+    char *text = malloc(max_length + 1);
+    bool success = (query.digits != NULL) && (elements != NULL) && (sources != NULL) && (text != NULL);
+    if (success) {
+        sources[0] = (ReverseSource){NULL, &query, 0};
+        size_t k = 1;
+        node = imageNode(image, image->reverse_root);
+        for (size_t i = 0; (node != NULL) && (i < length); ++i) {
+            node = imageSon(image, node, digitValue(num + i));
+            for (uint32_t j = 0; (node != NULL) && (j < node->count); ++j, ++k) {
+                SharedEntry const *entry = imageEntry(image, node->first + j);
+                elements[k].digits = (unsigned char *)image + entry->offset;
+                elements[k].number_length = entry->length;
+                sources[k] = (ReverseSource){&(elements[k]), &query, i + 1};
+            }
+        }
+        qsort(sources, count, sizeof(*sources), compareSources);
+        for (size_t i = 0; success && (i < count); ++i) {
+            if ((i > 0) && (compareSources(&(sources[i - 1]), &(sources[i])) == 0)) {
+                continue;
+            }
+            if (only_counterimage && !imageIsCounterimage(image, &(sources[i]))) {
+                continue;
+            }
+            success = appendSource(result, &(sources[i]), text);
+        }
+    }
+    if (!success) {
+        phnumDelete(result);
+        result = NULL;
+    }
+    free(text);
+    free(sources);
+    free(elements);
+    free(query.digits);
+    return result;
+}
+
+/** @brief Wyznacza odwrócenie w opublikowanych przekierowaniach.
+ * Działa tak jak @ref phfwdReverse. Przechodzi na bieżącą wersję, jeśli
+ * opublikowano nową.
+ * @param[in,out] shared - wskaźnik na strukturę procesu czytającego;
+ * @param[in] num        - wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci, parametr shared ma wartość NULL lub
+ *         opublikowano strukturę bez drzewa odwróceń.
+ */
+PhoneNumbers * phfwdSharedReverse(PhoneForwardShared *shared, char const *num) {
+    return sharedReverse(shared, num, false);
+}
+
+/** @brief Wyznacza przeciwobraz w opublikowanych przekierowaniach.
+ * Działa tak jak @ref phfwdGetReverse. Przechodzi na bieżącą wersję, jeśli
+ * opublikowano nową.
+ * @param[in,out] shared - wskaźnik na strukturę procesu czytającego;
+ * @param[in] num        - wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci, parametr shared ma wartość NULL lub
+ *         opublikowano strukturę bez drzewa odwróceń.
+ */
+PhoneNumbers * phfwdSharedGetReverse(PhoneForwardShared *shared, char const *num) {
+    return sharedReverse(shared, num, true);
+}
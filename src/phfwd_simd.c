@@ -0,0 +1,515 @@
+/** @file
+ * Implementacja klasy funkcji wektorowych sprawdzających, kodujących i porównujących numery
+ *
+ * Każda funkcja ma wersję przetwarzającą znak po znaku oraz, na procesorach
+ * x86-64, wersje SSE2 i AVX2. Wersja jest wybierana przy uruchomieniu
+ * programu na podstawie instrukcji obsługiwanych przez procesor.
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phfwd_simd.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+/**
+ * To jest znacznik dostępności wersji SSE2 i AVX2.
+ */
+#define SIMD_X86 1
+#else
+/**
+ * To jest znacznik dostępności wersji SSE2 i AVX2.
+ */
+#define SIMD_X86 0
+#endif
+
+/**
+ * To jest atrybut funkcji czytającej wyrównane bloki, które mogą wykraczać
+ * poza koniec napisu, ale nigdy poza stronę pamięci zawierającą jego koniec.
+ */
+#define READS_PAST_END __attribute__((no_sanitize_address))
+
+/**
+ * To jest najmniejszy rozmiar strony pamięci. Blok, który się w niej mieści,
+ * można przeczytać w całości, jeśli jego pierwszy bajt należy do napisu.
+ */
+#define MIN_PAGE_SIZE 4096
+
+/**
+ * To jest zestaw implementacji funkcji wektorowych.
+ */
+typedef struct SimdKernels {
+    size_t (*length)(char const *num); ///< implementacja @ref validNumberLength
+    bool (*pack)(unsigned char *digits, char const *num, size_t length); ///< implementacja @ref encodePacked
+    size_t (*difference)(char const *num1, char const *num2); ///< implementacja @ref firstDifference
+} SimdKernels;
+
+/** @brief Sprawdza, czy znak jest cyfrą numeru.
+ * @param[in] c - znak
+ * @return Wartość @p true, jeśli znak jest cyfrą, gwiazdką lub krzyżykiem.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static inline bool digitCharacterValid(char c) {
+    return ((c >= '0') && (c <= '9')) || (c == '*') || (c == '#');
+}
+
+/** @brief Zwraca kod spakowanej cyfry, czyli jej wartość powiększoną o jeden.
+ * @param[in] c - znak reprezentujący cyfrę
+ * @return Liczba całkowita z zakresu od 1 do 12.
+ */
+static inline unsigned char packedCode(char c) {
+    if (c == '*') {
+        return 11;
+    }
+    else if (c == '#') {
+        return 12;
+    }
+    else {
+        return (unsigned char)(c - '0' + 1);
+    }
+}
+
+/** @brief Sprawdza numer i wyznacza jego długość znak po znaku.
+ * @param[in] num - wskaźnik na napis
+ * @return Liczba cyfr numeru lub wartość @p 0, gdy numer nie jest poprawny.
+ */
+static size_t lengthScalar(char const *num) {
+    size_t i = 0;
+    while (digitCharacterValid(num[i])) {
+        ++i;
+    }
+    return (num[i] == '\0') ? i : 0;
+}
+
+/** @brief Sprawdza i pakuje numer znak po znaku.
+ * @param[out] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] num - wskaźnik na co najmniej @p length znaków
+ * @param[in] length - liczba pakowanych znaków
+ * @return Wartość @p true, jeśli wszystkie znaki są cyframi.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool packScalar(unsigned char *digits, char const *num, size_t length) {
+    bool valid = true;
+    size_t i = 0;
+    while (i + 1 < length) {
+        valid &= digitCharacterValid(num[i]) & digitCharacterValid(num[i + 1]);
+        digits[i / 2] = (unsigned char)((packedCode(num[i]) << 4) | packedCode(num[i + 1]));
+        i += 2;
+    }
+    if (i < length) {
+        valid &= digitCharacterValid(num[i]);
+        digits[i / 2] = (unsigned char)(packedCode(num[i]) << 4);
+    }
+    return valid;
+}
+
+/** @brief Wyznacza pierwszą pozycję, na której napisy się różnią, znak po znaku.
+ * @param[in] num1 - wskaźnik na pierwszy napis
+ * @param[in] num2 - wskaźnik na drugi napis
+ * @return Indeks pierwszego różnego znaku lub długość napisów, gdy są równe.
+ */
+static size_t differenceScalar(char const *num1, char const *num2) {
+    size_t i = 0;
+    while ((num1[i] == num2[i]) && (num1[i] != '\0')) {
+        ++i;
+    }
+    return i;
+}
+
+/** @brief Zwraca pozycję znaku w porządku numerów.
+ * Koniec napisu poprzedza cyfry, a po cyfrze 9 są kolejno gwiazdka i krzyżyk.
+ * @param[in] c - znak numeru lub znak końca napisu
+ * @return Liczba całkowita z zakresu od 0 do 12.
+ */
+static inline int characterRank(char c) {
+    return (c == '\0') ? 0 : packedCode(c);
+}
+
+/** @brief Sprawdza, czy blok zaczynający się od danego bajtu mieści się w jego stronie pamięci.
+ * @param[in] p - wskaźnik na pierwszy bajt bloku
+ * @param[in] width - liczba bajtów bloku
+ * @return Wartość @p true, jeśli blok nie przekracza granicy strony.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static inline bool blockFitsInPage(char const *p, size_t width) {
+    return ((uintptr_t)p & (MIN_PAGE_SIZE - 1)) <= MIN_PAGE_SIZE - width;
+}
+
+#if SIMD_X86
+
+/** @brief Klasyfikuje 16 znaków.
+ * @param[in] v - znaki
+ * @param[out] star - bajty 0xFF na pozycjach gwiazdek
+ * @param[out] hash - bajty 0xFF na pozycjach krzyżyków
+ * @return Bajty 0xFF na pozycjach cyfr od 0 do 9.
+ */
+static inline __m128i classifySse2(__m128i v, __m128i *star, __m128i *hash) {
+    *star = _mm_cmpeq_epi8(v, _mm_set1_epi8('*'));
+    *hash = _mm_cmpeq_epi8(v, _mm_set1_epi8('#'));
+    // Znaki spoza ASCII są ujemne, więc porównania ze znakiem je odrzucają.
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+}
+
+/** @brief Wyznacza maskę znaków, które nie są cyframi.
+ * @param[in] v - 16 znaków
+ * @return Maska bitowa pozycji znaków, które nie są cyframi.
+ */
+static inline uint32_t invalidMaskSse2(__m128i v) {
+    __m128i star, hash;
+    __m128i digit = classifySse2(v, &star, &hash);
+    __m128i valid = _mm_or_si128(digit, _mm_or_si128(star, hash));
+    return (uint32_t)_mm_movemask_epi8(valid) ^ 0xFFFFu;
+}
+
+/** @brief Sprawdza numer i wyznacza jego długość po 16 znaków.
+ * Czyta wyrównane bloki, więc nie wykracza poza stronę zawierającą koniec napisu.
+ * @param[in] num - wskaźnik na napis
+ * @return Liczba cyfr numeru lub wartość @p 0, gdy numer nie jest poprawny.
+ */
+READS_PAST_END static size_t lengthSse2(char const *num) {
+    size_t offset = (uintptr_t)num & 15;
+    char const *block = num - offset;
+    uint32_t stop = invalidMaskSse2(_mm_load_si128((__m128i const *)block)) & (0xFFFFu << offset);
+    while (stop == 0) {
+        block += 16;
+        stop = invalidMaskSse2(_mm_load_si128((__m128i const *)block));
+    }
+    char const *end = block + __builtin_ctz(stop);
+    return (*end == '\0') ? (size_t)(end - num) : 0;
+}
+
+/** @brief Sprawdza i pakuje 16 znaków.
+ * @param[in] v - znaki
+ * @param[in,out] invalid - bajty 0xFF są dopisywane na pozycjach znaków, które nie są cyframi
+ * @return Wektor, którego młodsze 8 bajtów to spakowane cyfry.
+ */
+static inline __m128i packBlockSse2(__m128i v, __m128i *invalid) {
+    __m128i star, hash;
+    __m128i digit = classifySse2(v, &star, &hash);
+    __m128i valid = _mm_or_si128(digit, _mm_or_si128(star, hash));
+    *invalid = _mm_or_si128(*invalid, _mm_andnot_si128(valid, _mm_set1_epi8(-1)));
+    __m128i codes = _mm_or_si128(_mm_and_si128(_mm_sub_epi8(v, _mm_set1_epi8('0' - 1)), digit),
+                                 _mm_or_si128(_mm_and_si128(star, _mm_set1_epi8(11)),
+                                              _mm_and_si128(hash, _mm_set1_epi8(12))));
+    // Starsza połowa bajtu to cyfra parzysta, młodsza – nieparzysta.
+    __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(codes, _mm_set1_epi16(0x00FF)), 4),
+                                 _mm_srli_epi16(codes, 8));
+    return _mm_packus_epi16(pairs, pairs);
+}
+
+/** @brief Sprawdza i pakuje numer po 16 znaków.
+ * Końcówkę krótszą niż 16 znaków dopełnia zerami w buforze pomocniczym.
+ * @param[out] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] num - wskaźnik na co najmniej @p length znaków
+ * @param[in] length - liczba pakowanych znaków
+ * @return Wartość @p true, jeśli wszystkie znaki są cyframi.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool packSse2(unsigned char *digits, char const *num, size_t length) {
+    __m128i invalid = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i packed = packBlockSse2(_mm_loadu_si128((__m128i const *)(num + i)), &invalid);
+        _mm_storel_epi64((__m128i *)(digits + i / 2), packed);
+    }
+    if (i < length) {
+        char tail[16];
+        unsigned char out[16];
+        memset(tail, '0', sizeof(tail));
+        memcpy(tail, num + i, length - i);
+        _mm_storeu_si128((__m128i *)out, packBlockSse2(_mm_loadu_si128((__m128i const *)tail), &invalid));
+        memcpy(digits + i / 2, out, (length - i + 1) / 2);
+        if (length % 2 == 1) {
+            // Młodsza połowa ostatniego bajtu pozostaje pusta, jak w packDigits.
+            digits[length / 2] &= 0xF0;
+        }
+    }
+    return _mm_movemask_epi8(invalid) == 0;
+}
+
+/** @brief Wyznacza pierwszą pozycję, na której napisy się różnią, po 16 znaków.
+ * Blok, który przekroczyłby granicę strony w którymkolwiek napisie, jest
+ * zastępowany porównaniem jednego znaku.
+ * @param[in] num1 - wskaźnik na pierwszy napis
+ * @param[in] num2 - wskaźnik na drugi napis
+ * @return Indeks pierwszego różnego znaku lub długość napisów, gdy są równe.
+ */
+READS_PAST_END static size_t differenceSse2(char const *num1, char const *num2) {
+    size_t i = 0;
+    while (true) {
+        if (blockFitsInPage(num1 + i, 16) && blockFitsInPage(num2 + i, 16)) {
+            __m128i a = _mm_loadu_si128((__m128i const *)(num1 + i));
+            __m128i b = _mm_loadu_si128((__m128i const *)(num2 + i));
+            uint32_t stop = ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) ^ 0xFFFFu)
+                            | (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128()));
+            if (stop != 0) {
+                return i + __builtin_ctz(stop);
+            }
+            i += 16;
+        }
+        else if ((num1[i] != num2[i]) || (num1[i] == '\0')) {
+            return i;
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+/** @brief Klasyfikuje 32 znaki.
+ * @param[in] v - znaki
+ * @param[out] star - bajty 0xFF na pozycjach gwiazdek
+ * @param[out] hash - bajty 0xFF na pozycjach krzyżyków
+ * @return Bajty 0xFF na pozycjach cyfr od 0 do 9.
+ */
+__attribute__((target("avx2")))
+static inline __m256i classifyAvx2(__m256i v, __m256i *star, __m256i *hash) {
+    *star = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('*'));
+    *hash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('#'));
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+}
+
+/** @brief Wyznacza maskę znaków, które nie są cyframi.
+ * @param[in] v - 32 znaki
+ * @return Maska bitowa pozycji znaków, które nie są cyframi.
+ */
+__attribute__((target("avx2")))
+static inline uint32_t invalidMaskAvx2(__m256i v) {
+    __m256i star, hash;
+    __m256i digit = classifyAvx2(v, &star, &hash);
+    __m256i valid = _mm256_or_si256(digit, _mm256_or_si256(star, hash));
+    return ~(uint32_t)_mm256_movemask_epi8(valid);
+}
+
+/** @brief Sprawdza numer i wyznacza jego długość po 32 znaki.
+ * Czyta wyrównane bloki, więc nie wykracza poza stronę zawierającą koniec napisu.
+ * @param[in] num - wskaźnik na napis
+ * @return Liczba cyfr numeru lub wartość @p 0, gdy numer nie jest poprawny.
+ */
+__attribute__((target("avx2")))
+READS_PAST_END static size_t lengthAvx2(char const *num) {
+    size_t offset = (uintptr_t)num & 31;
+    char const *block = num - offset;
+    uint32_t stop = invalidMaskAvx2(_mm256_load_si256((__m256i const *)block)) & (UINT32_MAX << offset);
+    while (stop == 0) {
+        block += 32;
+        stop = invalidMaskAvx2(_mm256_load_si256((__m256i const *)block));
+    }
+    char const *end = block + __builtin_ctz(stop);
+    return (*end == '\0') ? (size_t)(end - num) : 0;
+}
+
+/** @brief Sprawdza i pakuje numer po 32 znaki.
+ * Końcówkę krótszą niż 32 znaki pakuje funkcją @ref packSse2.
+ * @param[out] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] num - wskaźnik na co najmniej @p length znaków
+ * @param[in] length - liczba pakowanych znaków
+ * @return Wartość @p true, jeśli wszystkie znaki są cyframi.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+__attribute__((target("avx2")))
+static bool packAvx2(unsigned char *digits, char const *num, size_t length) {
+    __m256i invalid = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i v = _mm256_loadu_si256((__m256i const *)(num + i));
+        __m256i star, hash;
+        __m256i digit = classifyAvx2(v, &star, &hash);
+        __m256i valid = _mm256_or_si256(digit, _mm256_or_si256(star, hash));
+        invalid = _mm256_or_si256(invalid, _mm256_andnot_si256(valid, _mm256_set1_epi8(-1)));
+        __m256i codes = _mm256_or_si256(_mm256_and_si256(_mm256_sub_epi8(v, _mm256_set1_epi8('0' - 1)), digit),
+                                        _mm256_or_si256(_mm256_and_si256(star, _mm256_set1_epi8(11)),
+                                                        _mm256_and_si256(hash, _mm256_set1_epi8(12))));
+        __m256i pairs = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(codes, _mm256_set1_epi16(0x00FF)), 4),
+                                        _mm256_srli_epi16(codes, 8));
+        // Pakowanie działa osobno w każdej połowie rejestru, więc łączymy
+        // pierwsze słowa obu połówek.
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(pairs, pairs), 0x08);
+        _mm_storeu_si128((__m128i *)(digits + i / 2), _mm256_castsi256_si128(packed));
+    }
+    bool valid = _mm256_movemask_epi8(invalid) == 0;
+    return packSse2(digits + i / 2, num + i, length - i) && valid;
+}
+
+/** @brief Wyznacza pierwszą pozycję, na której napisy się różnią, po 32 znaki.
+ * Blok, który przekroczyłby granicę strony w którymkolwiek napisie, jest
+ * zastępowany porównaniem jednego znaku.
+ * @param[in] num1 - wskaźnik na pierwszy napis
+ * @param[in] num2 - wskaźnik na drugi napis
+ * @return Indeks pierwszego różnego znaku lub długość napisów, gdy są równe.
+ */
+__attribute__((target("avx2")))
+READS_PAST_END static size_t differenceAvx2(char const *num1, char const *num2) {
+    size_t i = 0;
+    while (true) {
+        if (blockFitsInPage(num1 + i, 32) && blockFitsInPage(num2 + i, 32)) {
+            __m256i a = _mm256_loadu_si256((__m256i const *)(num1 + i));
+            __m256i b = _mm256_loadu_si256((__m256i const *)(num2 + i));
+            uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b))
+                            | (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, _mm256_setzero_si256()));
+            if (stop != 0) {
+                return i + __builtin_ctz(stop);
+            }
+            i += 32;
+        }
+        else if ((num1[i] != num2[i]) || (num1[i] == '\0')) {
+            return i;
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+/**
+ * To są implementacje funkcji wektorowych dla kolejnych zestawów instrukcji.
+ */
+static SimdKernels const simd_kernels[SIMD_LEVELS] = {
+    {lengthScalar, packScalar, differenceScalar},
+    {lengthSse2, packSse2, differenceSse2},
+    {lengthAvx2, packAvx2, differenceAvx2}
+};
+
+#else
+
+/**
+ * To są implementacje funkcji wektorowych dla kolejnych zestawów instrukcji.
+ */
+static SimdKernels const simd_kernels[SIMD_LEVELS] = {
+    {lengthScalar, packScalar, differenceScalar},
+    {lengthScalar, packScalar, differenceScalar},
+    {lengthScalar, packScalar, differenceScalar}
+};
+
+#endif
+
+/**
+ * To jest używany zestaw instrukcji.
+ */
+static SimdLevel simd_level = SIMD_SCALAR;
+
+/**
+ * To jest wskaźnik na implementacje dla używanego zestawu instrukcji.
+ */
+static SimdKernels const *kernels = &simd_kernels[SIMD_SCALAR];
+
+/** @brief Sprawdza, czy procesor obsługuje zestaw instrukcji.
+ * @param[in] level - zestaw instrukcji
+ * @return Wartość @p true, jeśli zestaw jest obsługiwany.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool simdSupported(SimdLevel level) {
+    switch (level) {
+        case SIMD_SCALAR:
+            return true;
+#if SIMD_X86
+        case SIMD_SSE2:
+            return true;
+        case SIMD_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+/** @brief Wybiera najszerszy zestaw instrukcji przed uruchomieniem programu.
+ */
+__attribute__((constructor))
+static void simdInit(void) {
+    for (int level = SIMD_LEVELS - 1; level > SIMD_SCALAR; --level) {
+        if (simdSetLevel((SimdLevel)level)) {
+            break;
+        }
+    }
+}
+
+/** @brief Zwraca zestaw instrukcji używany przez funkcje wektorowe.
+ * Domyślnie jest to najszerszy zestaw obsługiwany przez procesor.
+ * @return Używany zestaw instrukcji.
+ */
+SimdLevel simdLevel(void) {
+    return simd_level;
+}
+
+/** @brief Zwraca nazwę zestawu instrukcji.
+ * @param[in] level - zestaw instrukcji
+ * @return Wskaźnik na napis z nazwą zestawu.
+ */
+char const * simdLevelName(SimdLevel level) {
+    static char const * const names[SIMD_LEVELS] = {"scalar", "sse2", "avx2"};
+    return ((unsigned)level < SIMD_LEVELS) ? names[level] : "unknown";
+}
+
+/** @brief Zmienia zestaw instrukcji używany przez funkcje wektorowe.
+ * Służy do porównywania implementacji. Nie może być wywoływana równocześnie
+ * z innymi funkcjami wektorowymi.
+ * @param[in] level - zestaw instrukcji
+ * @return Wartość @p true, jeśli zestaw został zmieniony.
+ *         Wartość @p false, jeśli procesor go nie obsługuje.
+ */
+bool simdSetLevel(SimdLevel level) {
+    if (!simdSupported(level)) {
+        return false;
+    }
+    simd_level = level;
+    kernels = &simd_kernels[level];
+    return true;
+}
+
+/** @brief Sprawdza numer i wyznacza jego długość w jednym przejściu.
+ * @param[in] num - wskaźnik na napis
+ * @return Liczba cyfr numeru lub wartość @p 0, gdy napis jest pusty lub
+ *         zawiera znak, który nie jest cyfrą.
+ */
+size_t validNumberLength(char const *num) {
+    return kernels->length(num);
+}
+
+/** @brief Sprawdza i pakuje numer w jednym przejściu.
+ * Zapisuje @p length pierwszych znaków napisu @p num w postaci spakowanej,
+ * tak jak @ref packDigits, w tablicy o co najmniej @ref packedSize(length)
+ * bajtach.
+ * @param[out] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] num - wskaźnik na co najmniej @p length znaków
+ * @param[in] length - liczba pakowanych znaków
+ * @return Wartość @p true, jeśli wszystkie znaki są cyframi.
+ *         Wartość @p false w przeciwnym przypadku; zawartość tablicy
+ *         @p digits jest wtedy nieokreślona.
+ */
+bool encodePacked(unsigned char *digits, char const *num, size_t length) {
+    return kernels->pack(digits, num, length);
+}
+
+/** @brief Wyznacza pierwszą pozycję, na której napisy się różnią.
+ * @param[in] num1 - wskaźnik na pierwszy napis
+ * @param[in] num2 - wskaźnik na drugi napis
+ * @return Indeks pierwszego różnego znaku lub długość napisów, gdy są równe.
+ */
+size_t firstDifference(char const *num1, char const *num2) {
+    return kernels->difference(num1, num2);
+}
+
+/** @brief Porównuje numery.
+ * Cyfry są uporządkowane od 0 do 9, po nich są gwiazdka i krzyżyk, a numer
+ * jest mniejszy od każdego numeru, którego jest właściwym prefiksem.
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer
+ *         jest większy, a @p -1, gdy mniejszy.
+ */
+int compareNumberStrings(char const *num1, char const *num2) {
+    size_t i = kernels->difference(num1, num2);
+    int rank1 = characterRank(num1[i]);
+    int rank2 = characterRank(num2[i]);
+    return (rank1 > rank2) - (rank1 < rank2);
+}
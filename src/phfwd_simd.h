@@ -0,0 +1,91 @@
+/** @file
+ * Interfejs klasy funkcji wektorowych sprawdzających, kodujących i porównujących numery
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_SIMD_H__
+#define __PHFWD_SIMD_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * To jest typ zestawu instrukcji używanego przez funkcje wektorowe.
+ */
+typedef enum SimdLevel {
+    SIMD_SCALAR, ///< przetwarzanie znak po znaku
+    SIMD_SSE2, ///< po 16 znaków instrukcjami SSE2
+    SIMD_AVX2, ///< po 32 znaki instrukcjami AVX2
+    SIMD_LEVELS ///< liczba zestawów
+} SimdLevel;
+
+/** @brief Zwraca zestaw instrukcji używany przez funkcje wektorowe.
+ * Domyślnie jest to najszerszy zestaw obsługiwany przez procesor.
+ * @return Używany zestaw instrukcji.
+ */
+SimdLevel simdLevel(void);
+
+/** @brief Zwraca nazwę zestawu instrukcji.
+ * @param[in] level - zestaw instrukcji
+ * @return Wskaźnik na napis z nazwą zestawu.
+ */
+char const * simdLevelName(SimdLevel level);
+
+/** @brief Sprawdza, czy procesor obsługuje zestaw instrukcji.
+ * @param[in] level - zestaw instrukcji
+ * @return Wartość @p true, jeśli zestaw jest obsługiwany.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool simdSupported(SimdLevel level);
+
+/** @brief Zmienia zestaw instrukcji używany przez funkcje wektorowe.
+ * Służy do porównywania implementacji. Nie może być wywoływana równocześnie
+ * z innymi funkcjami wektorowymi.
+ * @param[in] level - zestaw instrukcji
+ * @return Wartość @p true, jeśli zestaw został zmieniony.
+ *         Wartość @p false, jeśli procesor go nie obsługuje.
+ */
+bool simdSetLevel(SimdLevel level);
+
+/** @brief Sprawdza numer i wyznacza jego długość w jednym przejściu.
+ * @param[in] num - wskaźnik na napis
+ * @return Liczba cyfr numeru lub wartość @p 0, gdy napis jest pusty lub
+ *         zawiera znak, który nie jest cyfrą.
+ */
+size_t validNumberLength(char const *num);
+
+/** @brief Sprawdza i pakuje numer w jednym przejściu.
+ * Zapisuje @p length pierwszych znaków napisu @p num w postaci spakowanej,
+ * tak jak @ref packDigits, w tablicy o co najmniej @ref packedSize(length)
+ * bajtach.
+ * @param[out] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] num - wskaźnik na co najmniej @p length znaków
+ * @param[in] length - liczba pakowanych znaków
+ * @return Wartość @p true, jeśli wszystkie znaki są cyframi.
+ *         Wartość @p false w przeciwnym przypadku; zawartość tablicy
+ *         @p digits jest wtedy nieokreślona.
+ */
+bool encodePacked(unsigned char *digits, char const *num, size_t length);
+
+/** @brief Wyznacza pierwszą pozycję, na której napisy się różnią.
+ * @param[in] num1 - wskaźnik na pierwszy napis
+ * @param[in] num2 - wskaźnik na drugi napis
+ * @return Indeks pierwszego różnego znaku lub długość napisów, gdy są równe.
+ */
+size_t firstDifference(char const *num1, char const *num2);
+
+/** @brief Porównuje numery.
+ * Cyfry są uporządkowane od 0 do 9, po nich są gwiazdka i krzyżyk, a numer
+ * jest mniejszy od każdego numeru, którego jest właściwym prefiksem.
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer
+ *         jest większy, a @p -1, gdy mniejszy.
+ */
+int compareNumberStrings(char const *num1, char const *num2);
+
+#endif /* __PHFWD_SIMD_H__ */
@@ -0,0 +1,981 @@
+/** @file
+ * Implementacja klasy zwięzłej, niezmiennej kopii przekierowań
+ *
+ * Kopia składa się z dwóch drzew trie: drzewa prefiksów przekierowywanych
+ * i drzewa numerów docelowych. Kształt każdego drzewa jest zapisany w kolejności
+ * wszerz jako ciąg bitów LOUDS: węzeł mający d synów to d jedynek i zero,
+ * a całość poprzedza para bitów 10 oznaczająca korzeń. Synowie węzła mają
+ * kolejne numery, a cyfra prowadząca do węzła zajmuje 4 bity. Przekierowanie
+ * wskazuje swój numer docelowy indeksem węzła drugiego drzewa, a numer
+ * docelowy wskazuje przekierowania na siebie indeksami węzłów pierwszego
+ * drzewa; indeksy zajmują tyle bitów, ile wymaga liczba węzłów. Numer
+ * węzła jest odtwarzany przez przejście do korzenia.
+ *
+ * Przejścia po drzewach korzystają z operacji rank i select na ciągach
+ * bitów. Katalog pamięta liczbę jedynek przed każdym blokiem 512 bitów
+ * i blok, w którym leży co 512-ty bit każdej wartości, więc obie operacje
+ * czytają stałą liczbę słów, o ile bity nie są skrajnie nierównomierne.
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phfwd_succinct.h"
+#include "phfwd_engine.h"
+#include "phfwd_auxiliary_functions.h"
+#include "phfwd_batch.h"
+#include "phfwd_iterator.h"
+#include "packed_number.h"
+#include "list.h"
+
+/**
+ * To jest liczba bitów słowa ciągu bitów.
+ */
+#define WORD_BITS 64
+
+/**
+ * To jest liczba słów bloku katalogu ciągu bitów.
+ */
+#define BLOCK_WORDS 8
+
+/**
+ * To jest liczba bitów bloku katalogu ciągu bitów.
+ */
+#define BLOCK_BITS (WORD_BITS * BLOCK_WORDS)
+
+/**
+ * To jest odstęp między bitami jednej wartości, których bloki pamięta katalog.
+ */
+#define SELECT_SAMPLE 512
+
+/**
+ * To jest indeks oznaczający brak węzła.
+ */
+#define NO_NODE SIZE_MAX
+
+/**
+ * To jest ciąg bitów z katalogiem dla operacji rank i select.
+ */
+typedef struct BitVector {
+    uint64_t *words; ///< bity, od najmłodszego bitu pierwszego słowa
+    size_t length; ///< liczba bitów
+    size_t capacity; ///< liczba słów, na które jest miejsce w @p words
+    uint32_t *ranks; ///< liczba jedynek przed każdym blokiem i na końcu liczba wszystkich jedynek
+    uint32_t *samples[2]; ///< dla zer i jedynek: blok zawierający bit tej wartości o numerze k * @ref SELECT_SAMPLE + 1
+} BitVector;
+
+/**
+ * To jest tablica indeksów węzłów, z których każdy zajmuje tyle samo bitów.
+ */
+typedef struct RefArray {
+    uint64_t *words; ///< upakowane indeksy
+    unsigned width; ///< liczba bitów jednego indeksu
+    size_t count; ///< liczba indeksów
+} RefArray;
+
+/**
+ * To jest drzewo trie zapisane w kolejności wszerz.
+ */
+typedef struct Trie {
+    BitVector louds; ///< kształt drzewa
+    unsigned char *labels; ///< cyfry prowadzące do węzłów, spakowane jak numery; korzeń ma cyfrę 0
+    size_t labels_capacity; ///< liczba bajtów, na które jest miejsce w @p labels
+    BitVector marks; ///< czy ścieżka do węzła jest jednym z zapisanych numerów
+    size_t nodes; ///< liczba węzłów
+} Trie;
+
+/**
+ * To jest struktura zwięzłej, niezmiennej kopii przekierowań.
+ */
+struct SuccinctTable {
+    Trie sources; ///< drzewo prefiksów przekierowywanych
+    Trie targets; ///< drzewo numerów docelowych
+    RefArray forward; ///< węzeł drzewa @p targets każdego przekierowania, w kolejności zaznaczonych węzłów drzewa @p sources
+    RefArray counterimages; ///< węzły drzewa @p sources przekierowań na kolejne zaznaczone węzły drzewa @p targets
+    BitVector ends; ///< czy pozycja tablicy @p counterimages jest ostatnią dla swojego numeru docelowego
+    bool reversible; ///< czy kopiowana struktura miała drzewo odwróceń
+};
+
+/** @brief Zwraca liczbę bajtów ciągu bitów.
+ * @param[in] b - wskaźnik na ciąg bitów
+ * @return Liczba bajtów tablic ciągu bitów.
+ */
+static size_t bitsSize(BitVector const *b) {
+    size_t blocks = (b->length + BLOCK_BITS - 1) / BLOCK_BITS;
+    size_t samples = (b->length + SELECT_SAMPLE - 1) / SELECT_SAMPLE;
+    return b->capacity * sizeof(uint64_t) + (blocks + 1 + samples + 1) * sizeof(uint32_t);
+}
+
+/** @brief Dopisuje bit na końcu ciągu.
+ * @param[in,out] b - wskaźnik na ciąg bitów przed zbudowaniem katalogu
+ * @param[in] bit - wartość bitu
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool bitsAppend(BitVector *b, bool bit) {
+    if (b->length % WORD_BITS == 0) {
+        if (!reserveArray((void **)&b->words, &b->capacity, b->length / WORD_BITS + 1, sizeof(uint64_t))) {
+            return false;
+        }
+        b->words[b->length / WORD_BITS] = 0;
+    }
+    if (bit) {
+        b->words[b->length / WORD_BITS] |= (uint64_t)1 << (b->length % WORD_BITS);
+    }
+    ++b->length;
+    return true;
+}
+
+/** @brief Odczytuje bit ciągu.
+ * @param[in] b - wskaźnik na ciąg bitów
+ * @param[in] position - pozycja bitu, mniejsza niż długość ciągu
+ * @return Wartość bitu.
+ */
+static bool bitsGet(BitVector const *b, size_t position) {
+    return (b->words[position / WORD_BITS] >> (position % WORD_BITS)) & 1;
+}
+
+/** @brief Zwraca liczbę bitów danej wartości przed blokiem.
+ * @param[in] b - wskaźnik na ciąg bitów z katalogiem
+ * @param[in] value - wartość bitów
+ * @param[in] block - indeks bloku, co najwyżej równy liczbie bloków
+ * @return Liczba bitów o wartości @p value przed blokiem @p block.
+ */
+static size_t bitsBefore(BitVector const *b, int value, size_t block) {
+    if (value == 1) {
+        return b->ranks[block];
+    }
+    size_t bits = block * BLOCK_BITS;
+    return ((bits < b->length) ? bits : b->length) - b->ranks[block];
+}
+
+/** @brief Buduje katalog ciągu bitów i zwalnia nadmiarową pamięć.
+ * @param[in,out] b - wskaźnik na ciąg bitów
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku lub gdy ciąg ma co najmniej
+ *         2^32 - 1 bitów.
+ */
+static bool bitsFinish(BitVector *b) {
+    if (b->length >= UINT32_MAX) {
+        return false;
+    }
+    size_t words = (b->length + WORD_BITS - 1) / WORD_BITS;
+    if ((words > 0) && (words < b->capacity)) {
+        uint64_t *help = realloc(b->words, words * sizeof(uint64_t));
+        if (help != NULL) {
+            b->words = help;
+            b->capacity = words;
+        }
+    }
+    size_t blocks = (b->length + BLOCK_BITS - 1) / BLOCK_BITS;
+    b->ranks = malloc((blocks + 1) * sizeof(uint32_t));
+    if (b->ranks == NULL) {
+        return false;
+    }
+    uint32_t ones = 0;
+    for (size_t w = 0; w < words; ++w) {
+        if (w % BLOCK_WORDS == 0) {
+            b->ranks[w / BLOCK_WORDS] = ones;
+        }
+        ones += (uint32_t)__builtin_popcountll(b->words[w]);
+    }
+    b->ranks[blocks] = ones;
+    for (int value = 0; value < 2; ++value) {
+        size_t total = bitsBefore(b, value, blocks);
+        b->samples[value] = malloc(((total + SELECT_SAMPLE - 1) / SELECT_SAMPLE + 1) * sizeof(uint32_t));
+        if (b->samples[value] == NULL) {
+            return false;
+        }
+        size_t k = 0;
+        for (size_t block = 0; block < blocks; ++block) {
+            while ((k * SELECT_SAMPLE + 1 <= total) && (k * SELECT_SAMPLE + 1 <= bitsBefore(b, value, block + 1))) {
+                b->samples[value][k++] = (uint32_t)block;
+            }
+        }
+    }
+    return true;
+}
+
+/** @brief Zwalnia pamięć ciągu bitów.
+ * @param[in,out] b - wskaźnik na ciąg bitów
+ */
+static void bitsFree(BitVector *b) {
+    free(b->words);
+    free(b->ranks);
+    free(b->samples[0]);
+    free(b->samples[1]);
+}
+
+/** @brief Wyznacza liczbę jedynek przed pozycją (rank).
+ * @param[in] b - wskaźnik na ciąg bitów z katalogiem
+ * @param[in] position - pozycja, co najwyżej równa długości ciągu
+ * @return Liczba jedynek na pozycjach mniejszych niż @p position.
+ */
+static size_t bitsRank(BitVector const *b, size_t position) {
+    size_t block = position / BLOCK_BITS;
+    size_t result = b->ranks[block];
+    size_t last = position / WORD_BITS;
+    for (size_t w = block * BLOCK_WORDS; w < last; ++w) {
+        result += (size_t)__builtin_popcountll(b->words[w]);
+    }
+    if (position % WORD_BITS != 0) {
+        result += (size_t)__builtin_popcountll(b->words[last] & (((uint64_t)1 << (position % WORD_BITS)) - 1));
+    }
+    return result;
+}
+
+/** @brief Wyznacza pozycję jedynki o danym numerze w słowie.
+ * @param[in] word - słowo
+ * @param[in] k - numer jedynki, liczony od 1, nie większy niż liczba jedynek słowa
+ * @return Pozycja jedynki w słowie.
+ */
+static size_t selectInWord(uint64_t word, size_t k) {
+    for (; k > 1; --k) {
+        word &= word - 1;
+    }
+    return (size_t)__builtin_ctzll(word);
+}
+
+/** @brief Wyznacza pozycję bitu danej wartości o danym numerze (select).
+ * @param[in] b - wskaźnik na ciąg bitów z katalogiem
+ * @param[in] value - wartość bitu
+ * @param[in] k - numer bitu, liczony od 1, nie większy niż liczba bitów tej wartości
+ * @return Pozycja @p k-tego bitu o wartości @p value.
+ */
+static size_t bitsSelect(BitVector const *b, int value, size_t k) {
+    size_t block = b->samples[value][(k - 1) / SELECT_SAMPLE];
+    while (bitsBefore(b, value, block + 1) < k) {
+        ++block;
+    }
+    k -= bitsBefore(b, value, block);
+    for (size_t w = block * BLOCK_WORDS; ; ++w) {
+        uint64_t word = (value == 1) ? b->words[w] : ~b->words[w];
+        size_t count = (size_t)__builtin_popcountll(word);
+        if (k <= count) {
+            return w * WORD_BITS + selectInWord(word, k);
+        }
+        k -= count;
+    }
+}
+
+/** @brief Tworzy tablicę indeksów wypełnioną zerami.
+ * @param[out] a - wskaźnik na tablicę
+ * @param[in] count - liczba indeksów
+ * @param[in] limit - liczba większa od każdego zapisywanego indeksu
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool refInit(RefArray *a, size_t count, size_t limit) {
+    a->width = 0;
+    while ((a->width < WORD_BITS) && (((uint64_t)1 << a->width) < limit)) {
+        ++a->width;
+    }
+    a->count = count;
+    a->words = calloc((count * a->width + WORD_BITS - 1) / WORD_BITS + 1, sizeof(uint64_t));
+    return a->words != NULL;
+}
+
+/** @brief Zapisuje indeks w tablicy.
+ * @param[in,out] a - wskaźnik na tablicę
+ * @param[in] i - pozycja indeksu
+ * @param[in] value - indeks
+ */
+static void refSet(RefArray *a, size_t i, size_t value) {
+    size_t bit = i * a->width;
+    size_t w = bit / WORD_BITS;
+    unsigned offset = bit % WORD_BITS;
+    a->words[w] |= (uint64_t)value << offset;
+    if ((offset > 0) && (offset + a->width > WORD_BITS)) {
+        a->words[w + 1] |= (uint64_t)value >> (WORD_BITS - offset);
+    }
+}
+
+/** @brief Odczytuje indeks z tablicy.
+ * @param[in] a - wskaźnik na tablicę
+ * @param[in] i - pozycja indeksu
+ * @return Indeks zapisany na pozycji @p i.
+ */
+static size_t refGet(RefArray const *a, size_t i) {
+    if (a->width == 0) {
+        return 0;
+    }
+    size_t bit = i * a->width;
+    size_t w = bit / WORD_BITS;
+    unsigned offset = bit % WORD_BITS;
+    uint64_t value = a->words[w] >> offset;
+    if ((offset > 0) && (offset + a->width > WORD_BITS)) {
+        value |= a->words[w + 1] << (WORD_BITS - offset);
+    }
+    return (size_t)(value & (((uint64_t)1 << a->width) - 1));
+}
+
+/** @brief Zwraca syna węzła drzewa.
+ * Synowie węzła @p node mają kolejne numery, a ich bity LOUDS zaczynają się
+ * za zerem o numerze @p node + 1.
+ * @param[in] t - wskaźnik na drzewo
+ * @param[in] node - indeks węzła
+ * @param[in] digit - wartość cyfry
+ * @return Indeks syna lub @ref NO_NODE, gdy go nie ma.
+ */
+static size_t trieChild(Trie const *t, size_t node, int digit) {
+    size_t start = bitsSelect(&t->louds, 0, node + 1) + 1;
+    size_t first = start - node - 1;
+    for (size_t k = 0; bitsGet(&t->louds, start + k); ++k) {
+        int label = packedDigitValue(t->labels, first + k);
+        if (label == digit) {
+            return first + k;
+        }
+        if (label > digit) {
+            break;
+        }
+    }
+    return NO_NODE;
+}
+
+/** @brief Zwraca ojca węzła drzewa.
+ * Węzeł @p node odpowiada jedynce o numerze @p node + 1, a jego ojciec to
+ * liczba zer przed nią pomniejszona o 1.
+ * @param[in] t - wskaźnik na drzewo
+ * @param[in] node - indeks węzła różnego od korzenia
+ * @return Indeks ojca.
+ */
+static size_t trieParent(Trie const *t, size_t node) {
+    return bitsSelect(&t->louds, 1, node + 1) - node - 1;
+}
+
+/** @brief Zwraca głębokość węzła drzewa, czyli długość jego numeru.
+ * @param[in] t - wskaźnik na drzewo
+ * @param[in] node - indeks węzła
+ * @return Głębokość węzła.
+ */
+static size_t trieDepth(Trie const *t, size_t node) {
+    size_t depth = 0;
+    for (; node != 0; node = trieParent(t, node)) {
+        ++depth;
+    }
+    return depth;
+}
+
+/** @brief Zapisuje numer węzła drzewa w postaci spakowanej.
+ * @param[in] t - wskaźnik na drzewo
+ * @param[in] node - indeks węzła
+ * @param[in] depth - głębokość węzła
+ * @param[out] digits - wskaźnik na tablicę co najmniej @ref packedSize(depth) bajtów
+ */
+static void triePath(Trie const *t, size_t node, size_t depth, unsigned char *digits) {
+    // Cyfry są zapisywane od końca, więc nie można użyć setPackedDigit,
+    // która przy parzystej pozycji zeruje następną cyfrę.
+    for (size_t i = depth; i > 0; --i) {
+        unsigned char code = (unsigned char)(packedDigitValue(t->labels, node) + 1);
+        if ((i - 1) % 2 == 0) {
+            digits[(i - 1) / 2] = (unsigned char)((digits[(i - 1) / 2] & 0x0F) | (code << 4));
+        }
+        else {
+            digits[(i - 1) / 2] = code;
+        }
+        node = trieParent(t, node);
+    }
+}
+
+/** @brief Porównuje numery według wartości cyfr.
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer
+ * @return Wartość ujemna, zero lub dodatnia, jak w funkcji porównującej dla qsort.
+ */
+static int compareDigits(char const *num1, char const *num2) {
+    for (; (*num1 != '\0') && (*num1 == *num2); ++num1, ++num2) {
+    }
+    if ((*num1 == '\0') || (*num2 == '\0')) {
+        return (*num1 == *num2) ? 0 : ((*num1 == '\0') ? -1 : 1);
+    }
+    return digitValue(num1) - digitValue(num2);
+}
+
+/** @brief Dopisuje cyfrę prowadzącą do kolejnego węzła drzewa.
+ * @param[in,out] t - wskaźnik na budowane drzewo
+ * @param[in] digit - wartość cyfry
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool trieAppendLabel(Trie *t, int digit) {
+    if (!reserveArray((void **)&t->labels, &t->labels_capacity, packedSize(t->nodes + 1), sizeof(unsigned char))) {
+        return false;
+    }
+    if (t->nodes % 2 == 0) {
+        t->labels[t->nodes / 2] = 0;
+    }
+    setPackedDigit(t->labels, t->nodes, digit);
+    ++t->nodes;
+    return true;
+}
+
+/** @brief Buduje drzewo trie z posortowanych, różnych numerów.
+ * Węzły na głębokości d to różne prefiksy długości d numerów nie krótszych
+ * niż d, w porządku leksykograficznym, więc drzewo jest budowane poziomami
+ * po jednym przejściu przez numery, które jeszcze się nie skończyły. Dwa
+ * kolejne takie numery mają wspólny prefiks długości d wtedy i tylko wtedy,
+ * gdy wspólny prefiks wszystkich numerów między nimi ma co najmniej d cyfr.
+ * @param[out] t - wskaźnik na wyzerowane drzewo
+ * @param[in] nums - tablica numerów posortowanych według wartości cyfr
+ * @param[in] count - liczba numerów
+ * @param[out] node_of - tablica, w której dla każdego numeru zostanie zapisany indeks jego węzła
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku lub gdy drzewo byłoby za duże.
+ */
+static bool trieBuild(Trie *t, char const *const *nums, size_t count, size_t *node_of) {
+    size_t *active = malloc((count + 1) * sizeof(size_t));
+    size_t *common = malloc((count + 1) * sizeof(size_t));
+    size_t *lengths = malloc((count + 1) * sizeof(size_t));
+    bool success = (active != NULL) && (common != NULL) && (lengths != NULL)
+                   && bitsAppend(&t->louds, true) && bitsAppend(&t->louds, false) && trieAppendLabel(t, 0);
+    for (size_t k = 0; success && (k < count); ++k) {
+        active[k] = k;
+        lengths[k] = howLong(nums[k]);
+        common[k] = (k > 0) ? commonPrefix(nums[k - 1], lengths[k - 1], nums[k], lengths[k]) : 0;
+    }
+    size_t remaining = count;
+    if (success && (remaining == 0)) {
+        success = bitsAppend(&t->marks, false) && bitsAppend(&t->louds, false);
+    }
+    size_t node = 0;
+    for (size_t depth = 0; success && (remaining > 0); ++depth) {
+        for (size_t k = 0; success && (k < remaining); ++k) {
+            size_t i = active[k];
+            bool new_node = (k == 0) || (common[k] < depth);
+            if (new_node) {
+                if (k > 0) {
+                    success = bitsAppend(&t->louds, false);
+                }
+                success = success && bitsAppend(&t->marks, lengths[i] == depth);
+                if (lengths[i] == depth) {
+                    node_of[i] = node;
+                }
+                ++node;
+            }
+            if (success && (lengths[i] > depth) && (new_node || (common[k] < depth + 1))) {
+                success = bitsAppend(&t->louds, true) && trieAppendLabel(t, digitValue(nums[i] + depth));
+            }
+        }
+        success = success && bitsAppend(&t->louds, false);
+        // Numery długości depth są już w drzewie; wspólne prefiksy pozostałych
+        // są minimami wspólnych prefiksów po drodze.
+        size_t kept = 0;
+        size_t shortest = SIZE_MAX;
+        for (size_t k = 0; k < remaining; ++k) {
+            shortest = (common[k] < shortest) ? common[k] : shortest;
+            if (lengths[active[k]] > depth) {
+                active[kept] = active[k];
+                common[kept] = shortest;
+                ++kept;
+                shortest = SIZE_MAX;
+            }
+        }
+        remaining = kept;
+    }
+    success = success && bitsFinish(&t->louds) && bitsFinish(&t->marks);
+    if (success && (packedSize(t->nodes) < t->labels_capacity)) {
+        unsigned char *help = realloc(t->labels, packedSize(t->nodes));
+        if (help != NULL) {
+            t->labels = help;
+            t->labels_capacity = packedSize(t->nodes);
+        }
+    }
+    free(active);
+    free(common);
+    free(lengths);
+    return success;
+}
+
+/** @brief Zwalnia pamięć drzewa.
+ * @param[in,out] t - wskaźnik na drzewo
+ */
+static void trieFree(Trie *t) {
+    bitsFree(&t->louds);
+    bitsFree(&t->marks);
+    free(t->labels);
+}
+
+/**
+ * To jest stan zbierania przekierowań kopiowanej struktury.
+ */
+typedef struct PairCollector {
+    char *text; ///< kolejne numery zakończone znakiem '\0'
+    size_t length; ///< liczba zajętych znaków @p text
+    size_t capacity; ///< liczba znaków, na które jest miejsce w @p text
+    size_t *offsets; ///< pozycje w @p text prefiksu przekierowywanego i docelowego kolejnych przekierowań
+    size_t count; ///< liczba przekierowań
+    size_t offsets_capacity; ///< liczba pozycji, na które jest miejsce w @p offsets
+    bool failed; ///< czy nie udało się alokować pamięci
+} PairCollector;
+
+
+/** @brief Zapisuje przekierowanie w stanie zbierania; funkcja dla @ref phfwdForEachPrefix.
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest wykonywane przekierowanie
+ * @param[in,out] data - wskaźnik na stan zbierania
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool collectPair(char const *num1, char const *num2, void *data) {
+    PairCollector *c = data;
+    size_t length1 = strlen(num1) + 1;
+    size_t length2 = strlen(num2) + 1;
+    if (!reserveArray((void **)&c->text, &c->capacity, c->length + length1 + length2, sizeof(char))
+        || !reserveArray((void **)&c->offsets, &c->offsets_capacity, 2 * c->count + 2, sizeof(size_t))) {
+        c->failed = true;
+        return false;
+    }
+    c->offsets[2 * c->count] = c->length;
+    memcpy(c->text + c->length, num1, length1);
+    c->length += length1;
+    c->offsets[2 * c->count + 1] = c->length;
+    memcpy(c->text + c->length, num2, length2);
+    c->length += length2;
+    ++c->count;
+    return true;
+}
+
+/**
+ * To jest przekierowanie sortowane według numeru docelowego.
+ */
+typedef struct TargetOrder {
+    char const *target; ///< prefiks numerów, na które jest wykonywane przekierowanie
+    size_t pair; ///< numer przekierowania w kolejności prefiksów przekierowywanych
+} TargetOrder;
+
+/** @brief Porównuje 2 przekierowania według numeru docelowego.
+ * @param[in] order1 - wskaźnik na pierwsze przekierowanie
+ * @param[in] order2 - wskaźnik na drugie przekierowanie
+ * @return Wartość ujemna, zero lub dodatnia, jak w funkcji porównującej dla qsort.
+ */
+static int compareTargets(const void *order1, const void *order2) {
+    return compareDigits(((TargetOrder const *)order1)->target, ((TargetOrder const *)order2)->target);
+}
+
+/** @brief Zapisuje powiązania między węzłami obu drzew.
+ * @param[in,out] s - wskaźnik na strukturę ze zbudowanymi drzewami
+ * @param[in] pairs - liczba przekierowań
+ * @param[in] source_node - węzeł drzewa prefiksów przekierowywanych każdego przekierowania
+ * @param[in] group_of - numer różnego numeru docelowego każdego przekierowania
+ * @param[in] target_node - węzeł drzewa numerów docelowych każdego różnego numeru docelowego
+ * @param[in] groups - liczba różnych numerów docelowych
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool linkTries(SuccinctTable *s, size_t pairs, size_t const *source_node, size_t const *group_of,
+                      size_t const *target_node, size_t groups) {
+    size_t *start = calloc(groups + 1, sizeof(size_t));
+    bool success = (start != NULL) && refInit(&s->forward, pairs, s->targets.nodes)
+                   && refInit(&s->counterimages, pairs, s->sources.nodes);
+    for (size_t k = 0; success && (k < pairs); ++k) {
+        refSet(&s->forward, bitsRank(&s->sources.marks, source_node[k]), target_node[group_of[k]]);
+        ++start[bitsRank(&s->targets.marks, target_node[group_of[k]]) + 1];
+    }
+    for (size_t r = 0; success && (r < groups); ++r) {
+        for (size_t i = start[r]; i < start[r] + start[r + 1]; ++i) {
+            success = success && bitsAppend(&s->ends, i + 1 == start[r] + start[r + 1]);
+        }
+        start[r + 1] += start[r];
+    }
+    for (size_t k = 0; success && (k < pairs); ++k) {
+        size_t r = bitsRank(&s->targets.marks, target_node[group_of[k]]);
+        refSet(&s->counterimages, start[r]++, source_node[k]);
+    }
+    free(start);
+    return success && bitsFinish(&s->ends);
+}
+
+/** @brief Tworzy zwięzłą kopię przekierowań struktury.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania w drzewie
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci lub kopia miałaby za dużo węzłów.
+ */
+SuccinctTable * succinctBuild(PhoneForward const *pf) {
+    SuccinctTable *s = calloc(1, sizeof(SuccinctTable));
+    PairCollector c;
+    memset(&c, 0, sizeof(c));
+    bool success = (s != NULL) && phfwdForEachPrefix(pf, NULL, collectPair, &c) && !c.failed;
+    size_t pairs = c.count;
+    char const **sources = success ? malloc((pairs + 1) * sizeof(char const *)) : NULL;
+    char const **targets = success ? malloc((pairs + 1) * sizeof(char const *)) : NULL;
+    TargetOrder *order = success ? malloc((pairs + 1) * sizeof(TargetOrder)) : NULL;
+    size_t *source_node = success ? malloc((pairs + 1) * sizeof(size_t)) : NULL;
+    size_t *target_node = success ? malloc((pairs + 1) * sizeof(size_t)) : NULL;
+    size_t *group_of = success ? malloc((pairs + 1) * sizeof(size_t)) : NULL;
+    success = success && (sources != NULL) && (targets != NULL) && (order != NULL)
+              && (source_node != NULL) && (target_node != NULL) && (group_of != NULL);
+    size_t groups = 0;
+    if (success) {
+        for (size_t k = 0; k < pairs; ++k) {
+            sources[k] = c.text + c.offsets[2 * k];
+            order[k] = (TargetOrder){c.text + c.offsets[2 * k + 1], k};
+        }
+        // Przeglądanie podaje prefiksy przekierowywane już posortowane.
+        qsort(order, pairs, sizeof(TargetOrder), compareTargets);
+        for (size_t k = 0; k < pairs; ++k) {
+            if ((groups == 0) || (strcmp(targets[groups - 1], order[k].target) != 0)) {
+                targets[groups++] = order[k].target;
+            }
+            group_of[order[k].pair] = groups - 1;
+        }
+        s->reversible = (pf->reverse != NULL);
+    }
+    success = success && trieBuild(&s->sources, sources, pairs, source_node)
+              && trieBuild(&s->targets, targets, groups, target_node)
+              && linkTries(s, pairs, source_node, group_of, target_node, groups);
+    free(sources);
+    free(targets);
+    free(order);
+    free(source_node);
+    free(target_node);
+    free(group_of);
+    free(c.text);
+    free(c.offsets);
+    if (!success) {
+        succinctFree(s);
+        s = NULL;
+    }
+    return s;
+}
+
+/** @brief Usuwa strukturę.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] s - wskaźnik na usuwaną strukturę
+ */
+void succinctFree(SuccinctTable *s) {
+    if (s != NULL) {
+        trieFree(&s->sources);
+        trieFree(&s->targets);
+        free(s->forward.words);
+        free(s->counterimages.words);
+        bitsFree(&s->ends);
+        free(s);
+    }
+}
+
+/** @brief Szuka najdłuższego prefiksu numeru, który ma przekierowanie.
+ * @param[in] s - wskaźnik na strukturę
+ * @param[in] source - wskaźnik na opis numeru
+ * @param[out] eaten - adres zmiennej, w której zostanie zapisana długość prefiksu
+ * @return Indeks węzła drzewa numerów docelowych przekierowania prefiksu lub
+ *         @ref NO_NODE, gdy żaden prefiks nie ma przekierowania.
+ */
+static size_t lookupForward(SuccinctTable const *s, ReverseSource const *source, size_t *eaten) {
+    size_t best = NO_NODE;
+    size_t node = 0;
+    size_t length = sourceLength(source);
+    *eaten = 0;
+    for (size_t i = 0; i < length; ++i) {
+        node = trieChild(&s->sources, node, sourceDigit(source, i));
+        if (node == NO_NODE) {
+            break;
+        }
+        if (bitsGet(&s->sources.marks, node)) {
+            best = node;
+            *eaten = i + 1;
+        }
+    }
+    return (best == NO_NODE) ? NO_NODE : refGet(&s->forward, bitsRank(&s->sources.marks, best));
+}
+
+/** @brief Wyznacza przekierowanie numeru, tak jak @ref phfwdGet.
+ * @param[in] s - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * succinctGet(SuccinctTable const *s, char const *num) {
+    PhoneNumbers *result = newPhoneNumbers();
+    if ((result == NULL) || !onlyDigitsAndNotEmpty(num)) {
+        return result;
+    }
+    size_t length = howLong(num);
+    PackedNumber query = {packNumber(num, length), length};
+    size_t eaten = 0;
+    size_t target = (query.digits == NULL) ? NO_NODE : lookupForward(s, &(ReverseSource){NULL, &query, 0}, &eaten);
+    size_t depth = (target == NO_NODE) ? 0 : trieDepth(&s->targets, target);
+    char *text = (query.digits == NULL) ? NULL : malloc(depth + length - eaten + 1);
+    if (text != NULL) {
+        for (size_t i = depth; i > 0; --i) {
+            text[i - 1] = digitCharacter(packedDigitValue(s->targets.labels, target));
+            target = trieParent(&s->targets, target);
+        }
+        memcpy(text + depth, num + eaten, length - eaten);
+        text[depth + length - eaten] = '\0';
+    }
+    if ((text == NULL) || !addElement(result->list, text, depth + length - eaten)) {
+        phnumDelete(result);
+        result = NULL;
+    }
+    free(text);
+    free(query.digits);
+    return result;
+}
+
+/** @brief Sprawdza, czy numer jest przekierowywany na numer zapytania.
+ * @param[in] s - wskaźnik na strukturę
+ * @param[in] source - wskaźnik na opis sprawdzanego numeru
+ * @return Wartość @p true, jeśli przekierowaniem numeru jest numer zapytania.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool isCounterimageOf(SuccinctTable const *s, ReverseSource const *source) {
+    size_t eaten;
+    size_t target = lookupForward(s, source, &eaten);
+    PackedNumber const *query = source->query;
+    if (target == NO_NODE) {
+        return compareSources(source, &(ReverseSource){NULL, query, 0}) == 0;
+    }
+    size_t length = sourceLength(source);
+    size_t depth = trieDepth(&s->targets, target);
+    if (depth + length - eaten != query->length) {
+        return false;
+    }
+    for (size_t i = depth; i > 0; --i) {
+        if (packedDigitValue(s->targets.labels, target) != packedDigitValue(query->digits, i - 1)) {
+            return false;
+        }
+        target = trieParent(&s->targets, target);
+    }
+    for (size_t i = eaten; i < length; ++i) {
+        if (sourceDigit(source, i) != packedDigitValue(query->digits, i - eaten + depth)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Wyznacza zakres przekierowań na numer docelowy w tablicy przeciwobrazów.
+ * @param[in] s - wskaźnik na strukturę
+ * @param[in] node - indeks zaznaczonego węzła drzewa numerów docelowych
+ * @param[out] end - adres zmiennej, w której zostanie zapisana pozycja za zakresem
+ * @return Pozycja początku zakresu.
+ */
+static size_t counterimageRange(SuccinctTable const *s, size_t node, size_t *end) {
+    size_t r = bitsRank(&s->targets.marks, node);
+    *end = bitsSelect(&s->ends, 1, r + 1) + 1;
+    return (r == 0) ? 0 : bitsSelect(&s->ends, 1, r) + 1;
+}
+
+/** @brief Wyznacza odwrócenie lub przeciwobraz, tak jak @ref phfwdReverseOrGetReverse.
+ * Kandydaci są opisani strukturami @ref ReverseSource, których numery
+ * przekierowywane są odtwarzane z drzewa do jednej tablicy spakowanych cyfr.
+ * @param[in] s - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] only_counterimage - czy wyznaczamy tylko przeciwobraz
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci lub kopiowana struktura nie miała
+ *         drzewa odwróceń.
+ */
+PhoneNumbers * succinctReverse(SuccinctTable const *s, char const *num, bool only_counterimage) {
+    if (!s->reversible) {
+        return NULL;
+    }
+    PhoneNumbers *result = newPhoneNumbers();
+    if ((result == NULL) || !onlyDigitsAndNotEmpty(num)) {
+        return result;
+    }
+    size_t length = howLong(num);
+    size_t count = 1;
+    size_t end;
+    size_t node = 0;
+    for (size_t i = 0; i < length; ++i) {
+        node = trieChild(&s->targets, node, digitValue(num + i));
+        if (node == NO_NODE) {
+            break;
+        }
+        if (bitsGet(&s->targets.marks, node)) {
+            size_t begin = counterimageRange(s, node, &end);
+            count += end - begin;
+        }
+    }
+    PackedNumber query = {packNumber(num, length), length};
+    OneNumber *elements = malloc(count * sizeof(OneNumber));
+    ReverseSource *sources = malloc(count * sizeof(ReverseSource));
+    size_t *offsets = malloc(count * sizeof(size_t));
+    bool success = (query.digits != NULL) && (elements != NULL) && (sources != NULL) && (offsets != NULL);
+    size_t digits = 0;
+    if (success) {
+        sources[0] = (ReverseSource){NULL, &query, 0};
+        size_t k = 1;
+        node = 0;
+        for (size_t i = 0; (k < count) && (i < length); ++i) {
+            node = trieChild(&s->targets, node, digitValue(num + i));
+            if (!bitsGet(&s->targets.marks, node)) {
+                continue;
+            }
+            for (size_t j = counterimageRange(s, node, &end); j < end; ++j, ++k) {
+                size_t source = refGet(&s->counterimages, j);
+                elements[k].number_length = trieDepth(&s->sources, source);
+                offsets[k] = digits;
+                digits += packedSize(elements[k].number_length);
+                sources[k] = (ReverseSource){&elements[k], &query, i + 1};
+            }
+        }
+    }
+    unsigned char *arena = success ? calloc(digits + 1, sizeof(unsigned char)) : NULL;
+    success = success && (arena != NULL);
+    char *text = NULL;
+    size_t text_capacity = 0;
+    if (success) {
+        size_t k = 1;
+        node = 0;
+        for (size_t i = 0; (k < count) && (i < length); ++i) {
+            node = trieChild(&s->targets, node, digitValue(num + i));
+            if (!bitsGet(&s->targets.marks, node)) {
+                continue;
+            }
+            for (size_t j = counterimageRange(s, node, &end); j < end; ++j, ++k) {
+                elements[k].digits = arena + offsets[k];
+                triePath(&s->sources, refGet(&s->counterimages, j), elements[k].number_length, elements[k].digits);
+            }
+        }
+        qsort(sources, count, sizeof(ReverseSource), compareSources);
+    }
+    for (size_t i = 0; success && (i < count); ++i) {
+        if ((i > 0) && (compareSources(&sources[i - 1], &sources[i]) == 0)) {
+            continue;
+        }
+        if (only_counterimage && !isCounterimageOf(s, &sources[i])) {
+            continue;
+        }
+        size_t result_length = sourceLength(&sources[i]);
+        success = reserveArray((void **)&text, &text_capacity, result_length + 1, sizeof(char));
+        for (size_t j = 0; success && (j < result_length); ++j) {
+            text[j] = digitCharacter(sourceDigit(&sources[i], j));
+        }
+        success = success && addElement(result->list, text, result_length);
+    }
+    if (!success) {
+        phnumDelete(result);
+        result = NULL;
+    }
+    free(text);
+    free(arena);
+    free(offsets);
+    free(sources);
+    free(elements);
+    free(query.digits);
+    return result;
+}
+
+/** @brief Zwraca rozmiar struktury.
+ * @param[in] s - wskaźnik na strukturę
+ * @return Liczba bajtów zajętych przez strukturę razem z jej tablicami.
+ */
+size_t succinctSize(SuccinctTable const *s) {
+    size_t size = sizeof(SuccinctTable) + s->sources.labels_capacity + s->targets.labels_capacity;
+    size += bitsSize(&s->sources.louds) + bitsSize(&s->sources.marks);
+    size += bitsSize(&s->targets.louds) + bitsSize(&s->targets.marks) + bitsSize(&s->ends);
+    size += ((s->forward.count * s->forward.width + WORD_BITS - 1) / WORD_BITS + 1) * sizeof(uint64_t);
+    size += ((s->counterimages.count * s->counterimages.width + WORD_BITS - 1) / WORD_BITS + 1) * sizeof(uint64_t);
+    return size;
+}
+
+/** @brief Zwraca liczbę węzłów obu drzew struktury.
+ * @param[in] s - wskaźnik na strukturę
+ * @return Liczba węzłów drzewa prefiksów przekierowywanych i drzewa numerów docelowych.
+ */
+size_t succinctNodes(SuccinctTable const *s) {
+    return s->sources.nodes + s->targets.nodes;
+}
+
+/** @brief Odrzuca dodanie przekierowania; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref SuccinctTable
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest wykonywane przekierowanie
+ * @return Wartość @p false, bo kopia jest niezmienna.
+ */
+static bool engineAdd(void *data, char const *num1, char const *num2) {
+    (void)data;
+    (void)num1;
+    (void)num2;
+    return false;
+}
+
+/** @brief Pomija usunięcie przekierowań; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref SuccinctTable
+ * @param[in] num - wskaźnik na napis reprezentujący prefiks numerów
+ * @return Wartość @p false.
+ */
+static bool engineRemove(void *data, char const *num) {
+    (void)data;
+    (void)num;
+    return false;
+}
+
+/** @brief Wyznacza przekierowanie numeru; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref SuccinctTable
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+static PhoneNumbers * engineGet(void *data, char const *num) {
+    return succinctGet(data, num);
+}
+
+/** @brief Wyznacza odwrócenie; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref SuccinctTable
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci lub kopiowana struktura nie miała
+ *         drzewa odwróceń.
+ */
+static PhoneNumbers * engineReverse(void *data, char const *num) {
+    return succinctReverse(data, num, false);
+}
+
+/** @brief Wyznacza przeciwobraz; funkcja silnika.
+ * @param[in,out] data - wskaźnik na strukturę @ref SuccinctTable
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci lub kopiowana struktura nie miała
+ *         drzewa odwróceń.
+ */
+static PhoneNumbers * engineGetReverse(void *data, char const *num) {
+    return succinctReverse(data, num, true);
+}
+
+/** @brief Zwalnia strukturę; funkcja silnika.
+ * @param[in] data - wskaźnik na strukturę @ref SuccinctTable
+ */
+static void engineClose(void *data) {
+    succinctFree(data);
+}
+
+/**
+ * To jest tablica funkcji silnika zwięzłej, niezmiennej kopii przekierowań.
+ */
+static PhoneForwardEngine const succinctEngine = {
+    "succinct", engineAdd, engineRemove, engineGet, engineReverse, engineGetReverse, engineClose
+};
+
+/** @brief Tworzy zwięzłą, niezmienną kopię przekierowań.
+ * Kopiuje przekierowania struktury @p pf do dwóch drzew trie zapisanych
+ * ciągami bitów LOUDS, które zajmują kilka bitów na węzeł zamiast węzłów
+ * z tablicami synów. Funkcje @ref phfwdGet, @ref phfwdReverse
+ * i @ref phfwdGetReverse dają dla kopii takie same wyniki jak dla
+ * struktury @p pf w chwili kopiowania; @ref phfwdAdd zwraca dla niej
+ * @p false, a @ref phfwdRemove nic nie robi. Jeśli @p pf nie ma drzewa
+ * odwróceń, funkcje odwracające zwracają dla kopii NULL. Kopia nie ma
+ * pamięci podręcznej, więc zapytania mogą być wykonywane współbieżnie.
+ * Funkcje paczek, migawek, dziennika, przeglądania i publikowania zwracają
+ * dla niej @p false lub NULL.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy parametr pf ma
+ *         wartość NULL, struktura nie przechowuje przekierowań w drzewie,
+ *         kopia miałaby co najmniej 2^32 - 1 bitów w jednym ciągu lub nie
+ *         udało się alokować pamięci.
+ */
+PhoneForward * phfwdFreeze(PhoneForward const *pf) {
+    if ((pf == NULL) || (pf->engine != NULL)) {
+        return NULL;
+    }
+    SuccinctTable *s = succinctBuild(pf);
+    return (s == NULL) ? NULL : phfwdNewWithEngine(&succinctEngine, s);
+}
@@ -0,0 +1,65 @@
+/** @file
+ * Interfejs klasy zwięzłej, niezmiennej kopii przekierowań
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_SUCCINCT_H__
+#define __PHFWD_SUCCINCT_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+
+/**
+ * To jest struktura zwięzłej, niezmiennej kopii przekierowań.
+ */
+typedef struct SuccinctTable SuccinctTable;
+
+/** @brief Tworzy zwięzłą kopię przekierowań struktury.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania w drzewie
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci lub kopia miałaby za dużo węzłów.
+ */
+SuccinctTable * succinctBuild(PhoneForward const *pf);
+
+/** @brief Usuwa strukturę.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] s - wskaźnik na usuwaną strukturę
+ */
+void succinctFree(SuccinctTable *s);
+
+/** @brief Wyznacza przekierowanie numeru, tak jak @ref phfwdGet.
+ * @param[in] s - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+PhoneNumbers * succinctGet(SuccinctTable const *s, char const *num);
+
+/** @brief Wyznacza odwrócenie lub przeciwobraz, tak jak @ref phfwdReverseOrGetReverse.
+ * @param[in] s - wskaźnik na strukturę
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] only_counterimage - czy wyznaczamy tylko przeciwobraz
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci lub kopiowana struktura nie miała
+ *         drzewa odwróceń.
+ */
+PhoneNumbers * succinctReverse(SuccinctTable const *s, char const *num, bool only_counterimage);
+
+/** @brief Zwraca rozmiar struktury.
+ * @param[in] s - wskaźnik na strukturę
+ * @return Liczba bajtów zajętych przez strukturę razem z jej tablicami.
+ */
+size_t succinctSize(SuccinctTable const *s);
+
+/** @brief Zwraca liczbę węzłów obu drzew struktury.
+ * @param[in] s - wskaźnik na strukturę
+ * @return Liczba węzłów drzewa prefiksów przekierowywanych i drzewa numerów docelowych.
+ */
+size_t succinctNodes(SuccinctTable const *s);
+
+#endif /* __PHFWD_SUCCINCT_H__ */
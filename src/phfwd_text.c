@@ -0,0 +1,336 @@
+/** @file
+ * Implementacja klasy funkcji wczytujących i zapisujących przekierowania w postaci tekstowej
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "phone_forward.h"
+#include "phfwd_auxiliary_functions.h"
+#include "phfwd_traversal.h"
+#include "packed_number.h"
+#include "list.h"
+
+/**
+ * To jest początkowy rozmiar bufora odczytu i rozmiar bufora zapisu.
+ */
+#define TEXT_BUFFER_SIZE (1 << 20)
+
+/**
+ * To jest liczba przekierowań dodawanych jednym wywołaniem @ref phfwdApplyBatch.
+ */
+#define IMPORT_BATCH 65536
+
+/**
+ * To jest słowo, którego każdy bajt ma wartość 1.
+ */
+#define ONES UINT64_C(0x0101010101010101)
+
+/**
+ * To jest słowo, w którego każdym bajcie ustawiony jest tylko najstarszy bit.
+ */
+#define HIGH_BITS UINT64_C(0x8080808080808080)
+
+/** @brief Sprawdza, czy znak jest cyfrą numeru.
+ * @param[in] c - znak
+ * @return Wartość @p true, jeśli znak jest cyfrą, gwiazdką lub krzyżykiem.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static inline bool isNumberCharacter(unsigned char c) {
+    return ((c >= '0') && (c <= '9')) || (c == '*') || (c == '#');
+}
+
+/** @brief Sprawdza, czy znak rozdziela numery w wierszu.
+ * @param[in] c - znak
+ * @return Wartość @p true, jeśli znak jest spacją, tabulacją, przecinkiem lub średnikiem.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static inline bool isSeparator(unsigned char c) {
+    return (c == ' ') || (c == '\t') || (c == ',') || (c == ';');
+}
+
+/** @brief Wyznacza bajty słowa równe danemu znakowi.
+ * @param[in] x - słowo, którego bajty mają wyzerowany najstarszy bit
+ * @param[in] c - znak z zakresu ASCII
+ * @return Słowo z najstarszym bitem ustawionym dokładnie w bajtach równych @p c.
+ */
+static inline uint64_t equalBytes(uint64_t x, unsigned char c) {
+    uint64_t y = x ^ (ONES * c);
+    return ~((y + ONES * 0x7F) | y) & HIGH_BITS;
+}
+
+/** @brief Wyznacza bajty słowa, które nie są cyframi numeru.
+ * Klasyfikuje osiem znaków naraz (SWAR): najpierw zeruje najstarsze bity,
+ * dzięki czemu dodawanie nie przenosi się między bajtami, a potem
+ * sprawdza przedział '0'..'9' oraz znaki '*' i '#'.
+ * @param[in] x - słowo zawierające osiem kolejnych znaków
+ * @return Słowo z najstarszym bitem ustawionym dokładnie w bajtach niebędących cyframi.
+ */
+static inline uint64_t nonDigitBytes(uint64_t x) {
+    uint64_t ascii = ~x & HIGH_BITS;
+    uint64_t low = x & ~HIGH_BITS;
+    uint64_t at_least_0 = (low + ONES * (0x80 - '0')) & HIGH_BITS;
+    uint64_t above_9 = (low + ONES * (0x80 - '9' - 1)) & HIGH_BITS;
+    uint64_t digits = (at_least_0 & ~above_9) | equalBytes(low, '*') | equalBytes(low, '#');
+    return ~(digits & ascii) & HIGH_BITS;
+}
+
+/** @brief Wyznacza długość ciągu cyfr numeru.
+ * @param[in] text - wskaźnik na początek ciągu znaków
+ * @param[in] length - liczba dostępnych znaków
+ * @return Liczba początkowych znaków, które są cyframi numeru.
+ */
+static size_t digitRun(unsigned char const *text, size_t length) {
+    size_t i = 0;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    while (i + sizeof(uint64_t) <= length) {
+        uint64_t x;
+        memcpy(&x, text + i, sizeof(x));
+        uint64_t other = nonDigitBytes(x);
+        if (other != 0) {
+            return i + ((size_t)__builtin_ctzll(other) >> 3);
+        }
+        i += sizeof(uint64_t);
+    }
+#endif
+    while ((i < length) && isNumberCharacter(text[i])) {
+        ++i;
+    }
+    return i;
+}
+
+/**
+ * To jest stan wczytywania przekierowań w postaci tekstowej.
+ * Numery są zakańczane znakiem '\0' w miejscu w buforze, więc operacje
+ * paczki wskazują na bufor i muszą zostać wykonane przed jego przesunięciem.
+ */
+typedef struct TextImport {
+    PhoneForward *pf; ///< wskaźnik na strukturę przechowującą przekierowania numerów
+    unsigned char *buffer; ///< bufor odczytu
+    size_t start; ///< pozycja początku pierwszego nieprzetworzonego wiersza
+    size_t end; ///< pozycja za ostatnim wczytanym znakiem
+    size_t capacity; ///< rozmiar bufora bez miejsca na kończący znak '\0'
+    PhoneForwardOperation *operations; ///< operacje paczki
+    size_t count; ///< liczba operacji paczki
+} TextImport;
+
+/** @brief Dodaje zgromadzone przekierowania.
+ * @param[in,out] import - wskaźnik na stan wczytywania
+ * @return Wartość @p true, jeśli przekierowania zostały dodane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool importFlush(TextImport *import) {
+    bool result = phfwdApplyBatch(import->pf, import->operations, import->count);
+    import->count = 0;
+    return result;
+}
+
+/** @brief Przetwarza pełne wiersze zgromadzone w buforze.
+ * Wiersz zawiera dwa numery rozdzielone spacjami, tabulacjami, przecinkami
+ * lub średnikami i kończy się znakiem '\n' (opcjonalnie poprzedzonym '\r').
+ * Puste wiersze są pomijane.
+ * @param[in,out] import - wskaźnik na stan wczytywania
+ * @param[in] at_end - czy plik się skończył, więc ostatni wiersz może nie mieć końca
+ * @return Wartość @p true, jeśli wszystkie pełne wiersze są poprawne, a ich
+ *         przekierowania dodano. Wartość @p false w przeciwnym przypadku.
+ */
+static bool importLines(TextImport *import, bool at_end) {
+    // Stan trzymamy w zmiennych lokalnych, bo zapisy do bufora mogłyby zmieniać pola struktury.
+    unsigned char *text = import->buffer;
+    size_t const end = import->end;
+    size_t start = import->start;
+    bool result = true;
+    while (result && (start < end)) {
+        size_t i = start;
+        while ((i < end) && (isSeparator(text[i]) || (text[i] == '\r'))) {
+            ++i;
+        }
+        if ((i < end) && (text[i] == '\n')) {
+            start = i + 1; // Pusty wiersz.
+            continue;
+        }
+        size_t num1 = i;
+        i += digitRun(text + i, end - i);
+        size_t num1_end = i;
+        while ((i < end) && isSeparator(text[i])) {
+            ++i;
+        }
+        size_t num2 = i;
+        i += digitRun(text + i, end - i);
+        size_t num2_end = i;
+        while ((i < end) && (isSeparator(text[i]) || (text[i] == '\r'))) {
+            ++i;
+        }
+        if ((i == end) && !at_end) {
+            break; // Wiersz jest niepełny.
+        }
+        if ((num1_end == num1) || (num1_end == num2) || (num2_end == num2) || ((i < end) && (text[i] != '\n'))) {
+            result = (i == end) && (num1 == end); // Błędny wiersz lub same odstępy na końcu pliku.
+            start = end;
+            break;
+        }
+        text[num1_end] = '\0';
+        text[num2_end] = '\0';
+        PhoneForwardOperation *operation = &(import->operations[import->count]);
+        operation->type = PHFWD_ADD;
+        operation->num1 = (char const *)(text + num1);
+        operation->num2 = (char const *)(text + num2);
+        start = i + 1;
+        if (++(import->count) == IMPORT_BATCH) {
+            result = importFlush(import);
+        }
+    }
+    import->start = start;
+    return result;
+}
+
+/** @brief Wczytuje przekierowania w postaci tekstowej.
+ * Czyta z deskryptora @p fd wiersze zawierające po dwa numery num1 i num2,
+ * rozdzielone spacjami, tabulacjami, przecinkami lub średnikami, np. zapisane
+ * przez @ref phfwdExportText lub w formacie CSV, i dodaje odpowiednie
+ * przekierowania tak, jak kolejne wywołania @ref phfwdAdd. Plik jest czytany
+ * dużymi blokami, granice numerów są wyznaczane po osiem znaków naraz,
+ * a przekierowania są dodawane paczkami przez @ref phfwdApplyBatch, bez
+ * alokacji pamięci dla pojedynczych wierszy. Deskryptor może wskazywać
+ * zwykły plik, potok lub gniazdo.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] fd     - deskryptor otwarty do odczytu.
+ * @return Wartość @p true, jeśli wszystkie wiersze zostały wczytane.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, wiersz jest
+ *         błędny, wystąpił błąd odczytu lub nie udało się alokować pamięci;
+ *         wtedy część przekierowań mogła zostać dodana.
+ */
+bool phfwdImportText(PhoneForward *pf, int fd) {
+    if ((pf == NULL) || (pf->engine != NULL) || (fd < 0)) {
+        return false;
+    }
+    TextImport import = {pf, NULL, 0, 0, TEXT_BUFFER_SIZE, NULL, 0};
+    import.buffer = malloc(import.capacity + 1);
+    import.operations = malloc(IMPORT_BATCH * sizeof(*(import.operations)));
+    bool result = (import.buffer != NULL) && (import.operations != NULL);
+
+    bool at_end = false;
+    while (result && !at_end) {
+        if (import.end == import.capacity) {
+            // Niepełny wiersz zajmuje cały bufor, więc przenosimy go na początek lub powiększamy bufor.
+            result = importFlush(&import);
+            if (result && (import.start > 0)) {
+                memmove(import.buffer, import.buffer + import.start, import.end - import.start);
+                import.end -= import.start;
+                import.start = 0;
+            }
+            else if (result) {
+                unsigned char *help = realloc(import.buffer, 2 * import.capacity + 1);
+                result = (help != NULL);
+                if (result) {
+                    import.buffer = help;
+                    import.capacity *= 2;
+                }
+            }
+            continue;
+        }
+        ssize_t got = read(fd, import.buffer + import.end, import.capacity - import.end);
+        if (got < 0) {
+            result = (errno == EINTR);
+            continue;
+        }
+        at_end = (got == 0);
+        import.end += (size_t)got;
+        result = importLines(&import, at_end);
+    }
+    result = result && importFlush(&import);
+
+    free(import.operations);
+    free(import.buffer);
+    return result;
+}
+
+/** @brief Zapisuje cały ciąg bajtów pod deskryptor.
+ * @param[in] fd - deskryptor otwarty do zapisu
+ * @param[in] bytes - wskaźnik na ciąg bajtów
+ * @param[in] size - długość ciągu
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool writeText(int fd, char const *bytes, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+/** @brief Zapisuje przekierowania w postaci tekstowej.
+ * Zapisuje pod deskryptor @p fd po jednym przekierowaniu w wierszu, w postaci
+ * dwóch numerów rozdzielonych spacją, w porządku leksykograficznym, tak jak
+ * @ref phfwdDumpPrefix. Numery są rozpakowywane wprost do dużego bufora
+ * zapisu, więc pamięć nie jest alokowana dla pojedynczych przekierowań.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] fd - deskryptor otwarty do zapisu.
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, wystąpił błąd
+ *         zapisu lub nie udało się alokować pamięci.
+ */
+bool phfwdExportText(PhoneForward const *pf, int fd) {
+    if ((pf == NULL) || (pf->engine != NULL) || (fd < 0)) {
+        return false;
+    }
+    TrieWalk walk;
+    if (!walkStart(&walk, pf->pool, pf->forward, NULL, 0)) {
+        return false;
+    }
+    size_t capacity = TEXT_BUFFER_SIZE;
+    char *buffer = malloc(capacity);
+    size_t used = 0;
+    bool result = (buffer != NULL);
+
+    Node *n = NULL;
+    while (result && ((n = walkNext(&walk)) != NULL)) {
+        if ((n->list == NULL) || empty(n->list)) {
+            continue;
+        }
+        OneNumber const *target = n->list->first;
+        size_t length1 = walkPathLength(&walk);
+        size_t size = length1 + target->number_length + 2;
+        if (used + size > capacity) {
+            result = writeText(fd, buffer, used);
+            used = 0;
+            if (result && (size > capacity)) {
+                char *help = realloc(buffer, size);
+                result = (help != NULL);
+                buffer = result ? help : buffer;
+                capacity = result ? size : capacity;
+            }
+            if (!result) {
+                break;
+            }
+        }
+        memcpy(buffer + used, walk.path, length1);
+        buffer[used + length1] = ' ';
+        unpackDigits(buffer + used + length1 + 1, target->digits, target->number_length);
+        buffer[used + size - 1] = '\n';
+        used += size;
+    }
+    result = result && !walk.failed && writeText(fd, buffer, used);
+
+    free(buffer);
+    walkFinish(&walk);
+    return result;
+}
@@ -0,0 +1,262 @@
+/** @file
+ * Implementacja klasy funkcji przechodzących drzewa przekierowań w porządku leksykograficznym
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phfwd_traversal.h"
+#include "phone_forward.h"
+#include "phfwd_auxiliary_functions.h"
+#include "packed_number.h"
+
+/**
+ * To jest początkowa liczba poziomów stosu przejścia.
+ */
+#define INITIAL_WALK_CAPACITY 32
+
+/** @brief Rozpoczyna przejście poddrzewa.
+ * @param[out] walk - wskaźnik na strukturę opisującą stan przejścia
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] start - wskaźnik na węzeł startowy lub NULL, gdy poddrzewo jest puste
+ * @param[in] prefix - wskaźnik na napis reprezentujący ścieżkę od korzenia do węzła startowego
+ * @param[in] prefix_length - długość tej ścieżki
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool walkStart(TrieWalk *walk, NodePool const *pool, Node *start, char const *prefix, size_t prefix_length) {
+    walk->pool = pool;
+    walk->capacity = INITIAL_WALK_CAPACITY;
+    walk->prefix_length = prefix_length;
+    walk->level = 0;
+    walk->pending = (start != NULL);
+    walk->failed = false;
+    walk->nodes = malloc(walk->capacity * sizeof(*(walk->nodes)));
+    walk->next_son = malloc(walk->capacity * sizeof(*(walk->next_son)));
+    walk->path = malloc((prefix_length + walk->capacity + 1) * sizeof(*(walk->path)));
+    if ((walk->nodes == NULL) || (walk->next_son == NULL) || (walk->path == NULL)) {
+        walkFinish(walk);
+        return false;
+    }
+    walk->nodes[0] = start;
+    walk->next_son[0] = 0;
+    if (prefix_length > 0) {
+        memcpy(walk->path, prefix, prefix_length);
+    }
+    walk->path[prefix_length] = '\0';
+    return true;
+}
+
+/** @brief Powiększa stos przejścia dwukrotnie.
+ * @param[in,out] walk - wskaźnik na strukturę opisującą stan przejścia
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool walkGrow(TrieWalk *walk) {
+    size_t capacity = 2 * walk->capacity;
+    Node **nodes = realloc(walk->nodes, capacity * sizeof(*nodes));
+    if (nodes == NULL) {
+        return false;
+    }
+    walk->nodes = nodes;
+    unsigned char *next_son = realloc(walk->next_son, capacity * sizeof(*next_son));
+    if (next_son == NULL) {
+        return false;
+    }
+    walk->next_son = next_son;
+    char *path = realloc(walk->path, (walk->prefix_length + capacity + 1) * sizeof(*path));
+    if (path == NULL) {
+        return false;
+    }
+    walk->path = path;
+    walk->capacity = capacity;
+    return true;
+}
+
+/** @brief Przechodzi do kolejnego węzła w porządku prefiksowym.
+ * Synowie są odwiedzani w kolejności wartości cyfr, więc ścieżki kolejnych
+ * węzłów są uporządkowane leksykograficznie.
+ * @param[in,out] walk - wskaźnik na strukturę opisującą stan przejścia
+ * @return Wskaźnik na kolejny węzeł lub NULL, gdy przejście się skończyło
+ *         lub nie udało się alokować pamięci (wtedy @p walk->failed ma wartość @p true).
+ */
+Node * walkNext(TrieWalk *walk) {
+    if (walk->failed || (walk->nodes[0] == NULL)) {
+        return NULL;
+    }
+    if (walk->pending) {
+        walk->pending = false;
+        return walk->nodes[0];
+    }
+    while (true) {
+        Node *top = walk->nodes[walk->level];
+        int son = walk->next_son[walk->level];
+        while ((son < SONS) && ((top->sons)[son] == 0)) {
+            ++son;
+        }
+        if (son < SONS) {
+            walk->next_son[walk->level] = (unsigned char)(son + 1);
+            if ((walk->level + 1 == walk->capacity) && !walkGrow(walk)) {
+                walk->failed = true;
+                return NULL;
+            }
+            ++(walk->level);
+            walk->nodes[walk->level] = sonOf(walk->pool, top, son);
+            walk->next_son[walk->level] = 0;
+            walk->path[walk->prefix_length + walk->level - 1] = digitCharacter(son);
+            walk->path[walk->prefix_length + walk->level] = '\0';
+            return walk->nodes[walk->level];
+        }
+        if (walk->level == 0) {
+            return NULL;
+        }
+        --(walk->level);
+        walk->path[walk->prefix_length + walk->level] = '\0';
+    }
+}
+
+/** @brief Pomija poddrzewo ostatnio zwróconego węzła.
+ * Kolejne wywołanie @ref walkNext nie schodzi do synów tego węzła.
+ * @param[in,out] walk - wskaźnik na strukturę opisującą stan przejścia
+ */
+void walkSkip(TrieWalk *walk) {
+    walk->next_son[walk->level] = SONS;
+}
+
+/** @brief Zwraca długość ścieżki od korzenia drzewa do bieżącego węzła.
+ * @param[in] walk - wskaźnik na strukturę opisującą stan przejścia
+ * @return Długość ścieżki.
+ */
+size_t walkPathLength(TrieWalk const *walk) {
+    return walk->prefix_length + walk->level;
+}
+
+/** @brief Kończy przejście i zwalnia pamięć.
+ * @param[in,out] walk - wskaźnik na strukturę opisującą stan przejścia
+ */
+void walkFinish(TrieWalk *walk) {
+    free(walk->nodes);
+    free(walk->next_son);
+    free(walk->path);
+    walk->nodes = NULL;
+    walk->next_son = NULL;
+    walk->path = NULL;
+}
+
+/** @brief Szuka węzła drzewa wyznaczanego przez daną ścieżkę, nie tworząc nowych węzłów.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa
+ * @param[in] num - wskaźnik na napis reprezentujący ścieżkę
+ * @return Wskaźnik na znaleziony węzeł lub NULL, gdy takiego węzła nie ma.
+ */
+Node * findNode(NodePool const *pool, Node *root, char const *num) {
+    Node *help = root;
+    char const *digit = num;
+    while ((help != NULL) && (*digit != '\0')) {
+        help = sonOf(pool, help, digitValue(digit));
+        ++digit;
+    }
+    return help;
+}
+
+/** @brief Przegląda przekierowania numerów o danym prefiksie.
+ * Wywołuje funkcję @p visitor dla każdego przekierowania, którego parametr
+ * @p num1 ma prefiks @p prefix, w porządku leksykograficznym parametrów @p num1.
+ * Napisy przekazywane funkcji @p visitor są ważne tylko w czasie jej wywołania.
+ * Pamięć jest alokowana tylko wtedy, gdy przejście schodzi głębiej lub napotyka
+ * dłuższy numer niż wcześniej, a nie dla każdego przekierowania.
+ * @param[in] pf      - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] prefix  - wskaźnik na napis reprezentujący prefiks; NULL lub pusty
+ *                      napis oznacza wszystkie przekierowania;
+ * @param[in] visitor - funkcja wywoływana dla każdego przekierowania; zwrócenie
+ *                      przez nią wartości @p false przerywa przeglądanie;
+ * @param[in] data    - wskaźnik przekazywany funkcji @p visitor.
+ * @return Wartość @p true, jeśli przeglądanie się powiodło.
+ *         Wartość @p false, jeśli parametr pf lub visitor ma wartość NULL,
+ *         napis nie reprezentuje numeru lub nie udało się alokować pamięci.
+ */
+bool phfwdForEachPrefix(PhoneForward const *pf, char const *prefix, PhoneForwardVisitor visitor, void *data) {
+    if ((pf == NULL) || (pf->engine != NULL) || (visitor == NULL)) {
+        return false;
+    }
+    if ((prefix == NULL) || (*prefix == '\0')) {
+        prefix = "";
+    }
+    else if (!onlyDigitsAndNotEmpty(prefix)) {
+        return false;
+    }
+
+    TrieWalk walk;
+    if (!walkStart(&walk, pf->pool, findNode(pf->pool, pf->forward, prefix), prefix, howLong(prefix))) {
+        return false;
+    }
+    size_t target_capacity = INITIAL_WALK_CAPACITY;
+    char *target = malloc(target_capacity * sizeof(*target));
+    if (target == NULL) {
+        walkFinish(&walk);
+        return false;
+    }
+
+    bool go_on = true;
+    Node *n = NULL;
+    while (go_on && ((n = walkNext(&walk)) != NULL)) {
+        if ((n->list == NULL) || empty(n->list)) {
+            continue;
+        }
+        OneNumber *forward = n->list->first;
+        if (forward->number_length + 1 > target_capacity) {
+            while (forward->number_length + 1 > target_capacity) {
+                target_capacity = more(target_capacity);
+            }
+            char *new_target = realloc(target, target_capacity * sizeof(*target));
+            if (new_target == NULL) {
+                walk.failed = true;
+                break;
+            }
+            target = new_target;
+        }
+        unpackDigits(target, forward->digits, forward->number_length);
+        target[forward->number_length] = '\0';
+        go_on = visitor(walk.path, target, data);
+    }
+
+    bool result = !walk.failed;
+    free(target);
+    walkFinish(&walk);
+    return result;
+}
+
+/** @brief Zapisuje jedno przekierowanie do pliku.
+ * @param[in] num1 - wskaźnik na napis reprezentujący numer przekierowywany
+ * @param[in] num2 - wskaźnik na napis reprezentujący numer, na który jest wykonywane przekierowanie
+ * @param[in] data - wskaźnik na plik
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool writeForward(char const *num1, char const *num2, void *data) {
+    FILE *file = data;
+    return (fputs(num1, file) != EOF) && (putc(' ', file) != EOF)
+        && (fputs(num2, file) != EOF) && (putc('\n', file) != EOF);
+}
+
+/** @brief Zapisuje do pliku przekierowania numerów o danym prefiksie.
+ * Zapisuje w pliku po jednym przekierowaniu w wierszu, w postaci dwóch
+ * numerów rozdzielonych spacją, w porządku leksykograficznym.
+ * @param[in] pf     - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] prefix - wskaźnik na napis reprezentujący prefiks; NULL lub pusty
+ *                     napis oznacza wszystkie przekierowania;
+ * @param[in] file   - wskaźnik na plik otwarty do zapisu.
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdDumpPrefix(PhoneForward const *pf, char const *prefix, FILE *file) {
+    if (file == NULL) {
+        return false;
+    }
+    return phfwdForEachPrefix(pf, prefix, writeForward, file) && !ferror(file);
+}
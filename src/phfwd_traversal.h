@@ -0,0 +1,80 @@
+/** @file
+ * Interfejs klasy funkcji przechodzących drzewa przekierowań w porządku leksykograficznym
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#ifndef __PHFWD_TRAVERSAL_H__
+#define __PHFWD_TRAVERSAL_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+#include "phfwd_auxiliary_functions.h"
+
+/**
+ * To jest struktura opisująca stan przejścia drzewa w porządku prefiksowym.
+ * Zamiast rekurencji używa jawnego stosu, który rośnie tylko wtedy, gdy
+ * przejście schodzi głębiej niż kiedykolwiek wcześniej.
+ */
+typedef struct TrieWalk {
+    NodePool const *pool; ///< pula węzłów przechodzonego drzewa
+    Node **nodes; ///< stos węzłów na ścieżce od węzła startowego
+    unsigned char *next_son; ///< indeks kolejnego syna do odwiedzenia dla każdego poziomu stosu
+    char *path; ///< napis reprezentujący ścieżkę od korzenia drzewa do bieżącego węzła
+    size_t prefix_length; ///< długość ścieżki od korzenia drzewa do węzła startowego
+    size_t level; ///< poziom bieżącego węzła na stosie
+    size_t capacity; ///< liczba poziomów, na które zaalokowano stos
+    bool pending; ///< czy węzeł startowy nie został jeszcze zwrócony
+    bool failed; ///< czy nie udało się alokować pamięci
+} TrieWalk;
+
+/** @brief Rozpoczyna przejście poddrzewa.
+ * @param[out] walk - wskaźnik na strukturę opisującą stan przejścia
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] start - wskaźnik na węzeł startowy lub NULL, gdy poddrzewo jest puste
+ * @param[in] prefix - wskaźnik na napis reprezentujący ścieżkę od korzenia do węzła startowego
+ * @param[in] prefix_length - długość tej ścieżki
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool walkStart(TrieWalk *walk, NodePool const *pool, Node *start, char const *prefix, size_t prefix_length);
+
+/** @brief Przechodzi do kolejnego węzła w porządku prefiksowym.
+ * Synowie są odwiedzani w kolejności wartości cyfr, więc ścieżki kolejnych
+ * węzłów są uporządkowane leksykograficznie.
+ * @param[in,out] walk - wskaźnik na strukturę opisującą stan przejścia
+ * @return Wskaźnik na kolejny węzeł lub NULL, gdy przejście się skończyło
+ *         lub nie udało się alokować pamięci (wtedy @p walk->failed ma wartość @p true).
+ */
+Node * walkNext(TrieWalk *walk);
+
+/** @brief Pomija poddrzewo ostatnio zwróconego węzła.
+ * Kolejne wywołanie @ref walkNext nie schodzi do synów tego węzła.
+ * @param[in,out] walk - wskaźnik na strukturę opisującą stan przejścia
+ */
+void walkSkip(TrieWalk *walk);
+
+/** @brief Zwraca długość ścieżki od korzenia drzewa do bieżącego węzła.
+ * @param[in] walk - wskaźnik na strukturę opisującą stan przejścia
+ * @return Długość ścieżki.
+ */
+size_t walkPathLength(TrieWalk const *walk);
+
+/** @brief Kończy przejście i zwalnia pamięć.
+ * @param[in,out] walk - wskaźnik na strukturę opisującą stan przejścia
+ */
+void walkFinish(TrieWalk *walk);
+
+/** @brief Szuka węzła drzewa wyznaczanego przez daną ścieżkę, nie tworząc nowych węzłów.
+ * @param[in] pool - wskaźnik na pulę węzłów drzewa
+ * @param[in] root - wskaźnik na korzeń drzewa
+ * @param[in] num - wskaźnik na napis reprezentujący ścieżkę
+ * @return Wskaźnik na znaleziony węzeł lub NULL, gdy takiego węzła nie ma.
+ */
+Node * findNode(NodePool const *pool, Node *root, char const *num);
+
+#endif /* __PHFWD_TRAVERSAL_H__ */
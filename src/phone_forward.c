@@ -9,11 +9,16 @@
  #include <stdbool.h>
  #include <stddef.h>
  #include <ctype.h>
+ #include <stdint.h>
  #include <stdlib.h>
  #include <string.h>
  #include "phone_forward.h"
  #include "phfwd_auxiliary_functions.h"
  #include "list.h"
+ #include "phfwd_iterator.h"
+ #include "phfwd_log.h"
+ #include "phfwd_engine.h"
+ #include "phfwd_direct.h"
 
 
  /** @brief Tworzy nową strukturę.
@@ -24,21 +29,26 @@
 PhoneForward * phfwdNew(void) {
     PhoneForward *result = malloc(sizeof(*result));
     if (result != NULL) {
-        Node *n = newNode(NULL);
-        if (n != NULL) {
+        NodePool *pool = newNodePool();
+        Node *n = (pool != NULL) ? newNode(pool, NULL) : NULL;
+        Node *m = (n != NULL) ? newNode(pool, NULL) : NULL;
+        if (m != NULL) {
+            result->pool = pool;
             result->forward = n;
-            Node *m = newNode(NULL);
-            if (m != NULL) {
-                result->reverse = m;
-            }
-            else {
-                free(n->sons);
-                free(n);
-                free(result);
-                result = NULL;
-            }
+            result->reverse = m;
+            result->graveyard = NULL;
+            result->removal_budget = 0;
+            result->compact_next = 0;
+            result->compact_changes = 0;
+            result->log = NULL;
+            result->save = NULL;
+            result->chain_id = 0;
+            result->direct = NULL;
+            result->engine = NULL;
+            result->engine_data = NULL;
         }
         else {
+            deleteNodePool(pool);
             free(result);
             result = NULL;
         }
@@ -46,6 +56,43 @@ PhoneForward * phfwdNew(void) {
     return result;
 }
 
+/** @brief Tworzy nową strukturę bez drzewa odwróceń.
+ * Tworzy nową strukturę niezawierającą żadnych przekierowań, która nie
+ * utrzymuje drzewa odwróceń. Funkcje @ref phfwdAdd i @ref phfwdRemove
+ * działają w niej szybciej i zajmuje ona mniej pamięci, ale funkcje
+ * @ref phfwdReverse i @ref phfwdGetReverse zwracają NULL, dopóki drzewo
+ * odwróceń nie zostanie zbudowane przez @ref phfwdBuildReverseIndex.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+PhoneForward * phfwdNewForwardOnly(void) {
+    PhoneForward *result = phfwdNew();
+    if (result != NULL) {
+        treeFree(result->pool, result->reverse);
+        result->reverse = NULL;
+    }
+    return result;
+}
+
+/** @brief Tworzy strukturę, której przekierowania przechowuje silnik.
+ * @param[in] engine - wskaźnik na tablicę funkcji silnika
+ * @param[in] data - wskaźnik na stan silnika, który przechodzi na własność
+ *                   struktury; jest zwalniany przez @p engine->close także
+ *                   wtedy, gdy nie udało się utworzyć struktury
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+PhoneForward * phfwdNewWithEngine(PhoneForwardEngine const *engine, void *data) {
+    PhoneForward *result = phfwdNewForwardOnly();
+    if (result == NULL) {
+        engine->close(data);
+        return NULL;
+    }
+    result->engine = engine;
+    result->engine_data = data;
+    return result;
+}
+
 /** @brief Usuwa strukturę.
  * Usuwa strukturę wskazywaną przez @p pf. Nic nie robi, jeśli wskaźnik ten ma
  * wartość NULL.
@@ -53,8 +100,18 @@ PhoneForward * phfwdNew(void) {
  */
 void phfwdDelete(PhoneForward *pf) {
     if (pf != NULL) {
-        treeDelete(pf->forward);
-        treeDelete(pf->reverse);
+        backgroundSaveFinish(pf);
+        phfwdCloseLog(pf);
+        while (pf->graveyard != NULL) {
+            pf->graveyard = freeStackTop(pf->pool, pf->graveyard, false);
+        }
+        if (pf->engine != NULL) {
+            pf->engine->close(pf->engine_data);
+        }
+        directIndexFree(pf->direct);
+        treeFree(pf->pool, pf->forward);
+        treeFree(pf->pool, pf->reverse);
+        deleteNodePool(pf->pool);
         free(pf);
     }
 }
@@ -77,46 +134,71 @@ void phfwdDelete(PhoneForward *pf) {
  *         lub nie udało się alokować pamięci.
  */
 bool phfwdAdd(PhoneForward *pf, char const *num1, char const *num2) {
+    if ((pf != NULL) && (pf->engine != NULL)) {
+        return pf->engine->add(pf->engine_data, num1, num2);
+    }
+    if ((pf != NULL) && (pf->graveyard != NULL)) {
+        phfwdReclaim(pf, pf->removal_budget);
+    }
     if((pf != NULL) && onlyDigitsAndNotEmpty(num1) && onlyDigitsAndNotEmpty(num2) && numbersDiffer(num1, num2)) {
         Node *first_added = NULL;
         Node *help = NULL;
-        if (lookForANode(pf->forward, num1, &first_added, &help)) {
-            if (changeForward(help, num2)) {
+        if (lookForANode(pf->pool, pf->forward, num1, &first_added, &help)) {
+            if (changeForward(pf->pool, help, num2)) {
+                if (pf->reverse == NULL) { // Struktura bez drzewa odwróceń.
+                    directIndexRefresh(pf->direct, pf->pool, pf->forward, num1, howLong(num1));
+                    if (pf->log != NULL) {
+                        logAdd(pf->log, num1, num2);
+                    }
+                    return true;
+                }
                 Node *first_added_reverse = NULL;
                 Node *help_reverse = NULL;
-                if (lookForANode(pf->reverse, num2, &first_added_reverse, &help_reverse)) {
+                if (lookForANode(pf->pool, pf->reverse, num2, &first_added_reverse, &help_reverse)) {
                     if (help_reverse->list == NULL) {
-                        help_reverse->list = newList();
+                        help_reverse->list = cachedList(&pf->pool->numbers);
                     }
                     if (help_reverse->list == NULL) {
-                        treeDelete(first_added_reverse);
-                        treeDelete(first_added);
+                        treeDelete(pf->pool, first_added_reverse);
+                        treeDelete(pf->pool, first_added);
                         return false;
                     }
                     else {
-                        if (addElement(help_reverse->list, num1, howLong(num1))) {
-                            help->infoAboutMe = help_reverse;
-                            help->imHere = help_reverse->list->last;
+                        OneNumber *entry = NULL;
+                        if (reserveSorted(help_reverse->list, 1)) {
+                            entry = cachedPackedNumber(&pf->pool->numbers, num1, howLong(num1));
+                        }
+                        if (entry != NULL) {
+                            insertSortedElement(help_reverse->list, entry);
+                            if (entry->number_length > pf->pool->longest_entry) {
+                                pf->pool->longest_entry = entry->number_length;
+                            }
+                            coldOf(pf->pool, help)->infoAboutMe = help_reverse->index;
+                            coldOf(pf->pool, help)->imHere = entry;
+                            directIndexRefresh(pf->direct, pf->pool, pf->forward, num1, howLong(num1));
+                            if (pf->log != NULL) {
+                                logAdd(pf->log, num1, num2);
+                            }
                             return true;
                         }
                         else {
                             if (empty(help_reverse->list)) {
-                                free(help_reverse->list);
+                                releaseList(&pf->pool->numbers, help_reverse->list);
                                 help_reverse->list = NULL;
                             }
-                            treeDelete(first_added_reverse);
-                            treeDelete(first_added);
+                            treeDelete(pf->pool, first_added_reverse);
+                            treeDelete(pf->pool, first_added);
                             return false;
                         }
                     }
                 }
                 else {
-                    treeDelete(first_added);
+                    treeDelete(pf->pool, first_added);
                     return false;
                 }
             }
             else {
-                treeDelete(first_added);
+                treeDelete(pf->pool, first_added);
                 return false;
             }
         }
@@ -136,10 +218,18 @@ bool phfwdAdd(PhoneForward *pf, char const *num1, char const *num2) {
  * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania
  *                     numerów;
  * @param[in] num    - wskaźnik na napis reprezentujący prefiks numerów.
+ * @return Wartość @p true, jeśli usunięto jakieś przekierowanie.
+ *         Wartość @p false w przeciwnym przypadku.
  */
-void phfwdRemove(PhoneForward *pf, char const *num) {
+bool phfwdRemove(PhoneForward *pf, char const *num) {
     if ((pf == NULL) || (num == NULL) || (*num == '\0')) {
-        return;
+        return false;
+    }
+    if (pf->engine != NULL) {
+        return pf->engine->remove(pf->engine_data, num);
+    }
+    if (pf->graveyard != NULL) {
+        phfwdReclaim(pf, pf->removal_budget);
     }
     char const *digit = num;
     Node *help = pf->forward;
@@ -148,21 +238,69 @@ void phfwdRemove(PhoneForward *pf, char const *num) {
     if (onlyDigitsAndNotEmpty(num)) {
         size_t enough = howLong(num);
         while ((help != NULL) && (i < enough)) {
-            help = (help->sons)[digitValue(digit)];
+            help = sonOf(pf->pool, help, digitValue(digit));
             ++digit;
             ++i;
         }
-        if (i == enough) {
-            if (help != NULL) {
-                father = help->parent;
+        if ((i == enough) && (help != NULL)) {
+            father = parentOf(pf->pool, help);
+            if (pf->removal_budget == 0) {
+                treeDelete(pf->pool, help);
+            }
+            else {
+                detachNode(pf->pool, help);
+                coldOf(pf->pool, help)->parent = nodeIndex(pf->graveyard);
+                pf->graveyard = help;
             }
-            treeDelete(help);
-            if (help != NULL) {
-                removeEmptyBranch(father, father->parent);
+            pruneEmptyBranch(pf->pool, father);
+            directIndexRefresh(pf->direct, pf->pool, pf->forward, num, enough);
+            if (pf->log != NULL) {
+                logRemove(pf->log, num);
             }
+            return true;
         }
 
     }
+    return false;
+}
+
+/** @brief Ustawia tryb usuwania przekierowań.
+ * Jeśli @p budget ma wartość 0 (domyślnie), funkcja @ref phfwdRemove zwalnia
+ * usuwane węzły od razu. W przeciwnym przypadku @ref phfwdRemove jedynie
+ * odłącza poddrzewo w czasie proporcjonalnym do długości prefiksu, a jego
+ * przekierowania natychmiast przestają być widoczne dla @ref phfwdGet,
+ * @ref phfwdReverse i @ref phfwdGetReverse. Odłączone węzły są zwalniane
+ * po co najwyżej @p budget przy kolejnych wywołaniach @ref phfwdAdd
+ * i @ref phfwdRemove oraz przez funkcję @ref phfwdReclaim.
+ * Nic nie robi, jeśli parametr pf ma wartość NULL.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] budget - maksymalna liczba węzłów zwalnianych w jednym wywołaniu.
+ */
+void phfwdSetRemovalBudget(PhoneForward *pf, size_t budget) {
+    if (pf != NULL) {
+        pf->removal_budget = budget;
+    }
+}
+
+/** @brief Zwalnia węzły odłączone przez usuwanie przyrostowe.
+ * Zwalnia co najwyżej @p budget węzłów czekających na zwolnienie wraz
+ * z odpowiadającymi im wpisami drzewa odwróceń. Wartość 0 oznacza zwolnienie
+ * wszystkich. Nie alokuje pamięci.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] budget - maksymalna liczba zwalnianych węzłów.
+ * @return Wartość @p true, jeśli nie ma już węzłów czekających na zwolnienie.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdReclaim(PhoneForward *pf, size_t budget) {
+    if (pf == NULL) {
+        return true;
+    }
+    size_t freed = 0;
+    while ((pf->graveyard != NULL) && ((budget == 0) || (freed < budget))) {
+        pf->graveyard = freeStackTop(pf->pool, pf->graveyard, true);
+        ++freed;
+    }
+    return pf->graveyard == NULL;
 }
 
 /** @brief Wyznacza przekierowanie numeru.
@@ -181,6 +319,9 @@ PhoneNumbers * phfwdGet(PhoneForward const *pf, char const *num) {
     if (pf == NULL) {
         return NULL;
     }
+    if (pf->engine != NULL) {
+        return pf->engine->get(pf->engine_data, num);
+    }
 
     PhoneNumbers *result = malloc(sizeof(*result));
     if (result != NULL) {
@@ -190,7 +331,8 @@ PhoneNumbers * phfwdGet(PhoneForward const *pf, char const *num) {
             if (onlyDigitsAndNotEmpty(num)) {
                 Node *last_modification = NULL;
                 size_t how_many_digits_eaten = 0;
-                lookForModification(pf->forward, &last_modification, &how_many_digits_eaten, num);
+                directLookup(pf->direct, pf->pool, pf->forward, &last_modification, &how_many_digits_eaten,
+                             num, howLong(num));
                 if (last_modification == NULL) {
                     result_number = malloc((howLong(num) + 1) * sizeof(char));
                     if (result_number == NULL) {
@@ -229,9 +371,8 @@ PhoneNumbers * phfwdGet(PhoneForward const *pf, char const *num) {
                     }
                     else {
                         size_t j = howLong(num);
-                        for (size_t i = 0; i < last_modification->list->first->number_length; ++i) {
-                            result_number[i] = (last_modification->list->first->number)[i];
-                        }
+                        unpackDigits(result_number, last_modification->list->first->digits,
+                                     last_modification->list->first->number_length);
                         size_t k = last_modification->list->first->number_length - how_many_digits_eaten;
                         for (size_t i = how_many_digits_eaten; i < j; ++i) {
                             result_number[i + k] = num[i];
@@ -271,159 +412,40 @@ PhoneNumbers * phfwdGet(PhoneForward const *pf, char const *num) {
     return result;
 }
 
-/** @brief Tworzy tablicę numerów, które są zawarte w wyniku funkcji phfwdReverse lub phfwdGetReverse.
- * Tworzy tablicę numerów, które są zawarte w wyniku funkcji phfwdReverse lub phfwdGetReverse.
- * Numery te mogą się powtarzać i nie są posortowane leksykograficznie.
+/** @brief Sprawdza, czy numer jest przekierowywany na dany numer.
+ * Sprawdza, czy wynik wywołania @ref phfwdGet z numerem @p candidate jest równy
+ * numerowi @p target. Nie alokuje pamięci.
  * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów telefonów
- * @param[in] num - wskaźnik na napis reprezentujący numer.
- * @param[in, out] how_many_elements - ilosć elementów w tablicy numerów
- * @param[in] only_counterimage - zmienna informująca czy wyznaczamy tylko przeciwobraz phfwdGet
- * @return Wskaźnik na tablicę numerów lub NULL, gdy nie
- *         udało się alokować pamięci.
+ * @param[in] candidate - spakowany numer, którego przekierowanie jest sprawdzane
+ * @param[in] target - spakowany numer, który powinien być wynikiem przekierowania
+ * @return Wartość @p true, jeśli @p candidate jest przekierowywany na @p target.
+ *         Wartość @p false w przeciwnym przypadku.
  */
-char ** createArrayOfResults(PhoneForward const *pf, char const *num, size_t *how_many_elements, bool only_counterimage) {
-    char **array = malloc(sizeof(*array));
-    size_t how_long = howLong(num);
-    if (array == NULL) {
-        return array;
+bool isCounterimage(PhoneForward const *pf, PackedNumber const *candidate, PackedNumber const *target) {
+    Node *last_modification = NULL;
+    size_t how_many_digits_eaten = 0;
+    directLookupPacked(pf->direct, pf->pool, pf->forward, &last_modification, &how_many_digits_eaten,
+                       candidate->digits, candidate->length);
+    if (last_modification == NULL) {
+        return packedCompare(candidate->digits, candidate->length, target->digits, target->length) == 0;
     }
-    size_t array_size = 1;
-    size_t number_of_elements = 0;
 
-    Node *help = pf->reverse;
-    char const *digit = num;
-    char *help_number = malloc((how_long + 1) * sizeof(*help_number));
-
-    if (help_number == NULL) {
-        for (size_t j = 0; j < number_of_elements; ++j) {
-            free(array[j]);
-        }
-        free(array);
-        array = NULL;
-        return array;
-    }
-    else {
-        PhoneNumbers *pnum = NULL;
-        pnum = phfwdGet(pf, num);
-        if (pnum == NULL) {
-            free(help_number);
-            for (size_t j = 0; j < number_of_elements; ++j) {
-                free(array[j]);
-            }
-            free(array);
-            array = NULL;
-            return array;
-        }
-        else {
-            if (!only_counterimage || (only_counterimage && (strcmp(phnumGet(pnum, 0), num) == 0))) {
-                for (size_t j = 0; j < how_long; ++j) {
-                    help_number[j] = num[j];
-                }
-                help_number[how_long] = '\0';
-
-                array[number_of_elements] = help_number;
-                ++number_of_elements;
-            }
-            else {
-                free(help_number);
-            }
-            phnumDelete(pnum);
-        }
+    OneNumber *forward = last_modification->list->first;
+    if (forward->number_length + candidate->length - how_many_digits_eaten != target->length) {
+        return false;
     }
-    size_t i = 1;
-    char **new_array = NULL;
-    while ((help != NULL) && (*digit != '\0')) {
-        help = (help->sons)[digitValue(digit)];
-           
-        OneNumber *element = NULL;
-        if ((help != NULL) && (help->list != NULL)) {
-            element = help->list->first;
-        }
-        while (element != NULL) {
-            char *helping_number = malloc((how_long - i + element->number_length + 1) * sizeof(*helping_number));
-            if (helping_number == NULL) {
-                for (size_t j = 0; j < number_of_elements; ++j) {
-                    free(array[j]);
-                }
-                free(array);
-                array = NULL;
-                return array;
-            }
-            else {
-                for (size_t j = 0; j < element->number_length; ++j) {
-                    helping_number[j] = (element->number)[j];
-                }
-                size_t index = element->number_length;
-                for (size_t j = i; j < how_long; ++j) {
-                    helping_number[index] = num[j];
-                    ++index;
-                }
-                helping_number[element->number_length + how_long - i] = '\0';
-
-                PhoneNumbers *pnum = NULL;
-                pnum = phfwdGet(pf, helping_number);
-                if (pnum == NULL) {
-                    free(helping_number);
-                    for (size_t j = 0; j < number_of_elements; ++j) {
-                        free(array[j]);
-                    }
-                    free(array);
-                    array = NULL;
-                    return array;
-                }
-                else {
-                    if (!only_counterimage || (only_counterimage && (strcmp(phnumGet(pnum, 0), num) == 0))) {
-                        if (number_of_elements == array_size) {
-                            new_array = realloc(array, more(array_size) * sizeof(*array));
-                            array_size = more(array_size);
-
-                            if (new_array == NULL) {
-                                free(helping_number);
-                                for (size_t j = 0; j < number_of_elements; ++j) {
-                                    free(array[j]);
-                                }
-                                free(array);
-                                array = NULL;
-                                phnumDelete(pnum);
-                                return array;
-                            }
-                            else {
-                                array = new_array;
-                                array[number_of_elements] = helping_number;
-                                ++number_of_elements;
-                            }
-                        }
-                        else {
-                            array[number_of_elements] = helping_number;
-                            ++number_of_elements;
-                        }
-                    }
-                    else {
-                        free(helping_number);
-                    }
-                    phnumDelete(pnum);
-                }
-            }
-            element = element->next;
+    for (size_t i = 0; i < forward->number_length; ++i) {
+        if (packedDigitValue(forward->digits, i) != packedDigitValue(target->digits, i)) {
+            return false;
         }
-        ++digit;
-        ++i;
     }
-    
-    char **result = realloc(array, number_of_elements * sizeof(*array));
-    if (result == NULL) {
-        for (size_t i = 0; i < number_of_elements; ++i) {
-            free(array[i]);
+    for (size_t i = how_many_digits_eaten; i < candidate->length; ++i) {
+        size_t j = i - how_many_digits_eaten + forward->number_length;
+        if (packedDigitValue(candidate->digits, i) != packedDigitValue(target->digits, j)) {
+            return false;
         }
-        free(array);
-        array = NULL;
     }
-    else {
-        *how_many_elements = number_of_elements;
-        array = result;
-    }
-
-    return array;
+    return true;
 }
 
 /** @brief Wyznacza wynik funkcji phfwdReverse lub phfwdGetReverse.
@@ -434,93 +456,20 @@ char ** createArrayOfResults(PhoneForward const *pf, char const *num, size_t *ho
  * @param[in] num - wskaźnik na napis reprezentujący numer;
  * @param[in] only_counterimage - zmienna informująca o tym, czy wyznaczamy tylko przeciwobraz phfwdGet
  * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
- *         udało się alokować pamięci albo parametr pf ma wartość NULL.
+ *         udało się alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
  */
 PhoneNumbers * phfwdReverseOrGetReverse(PhoneForward const *pf, char const *num, bool only_counterimage) {
-    if (pf == NULL) {
-        return NULL;
+    if ((pf != NULL) && (pf->engine != NULL)) {
+        return only_counterimage ? pf->engine->get_reverse(pf->engine_data, num)
+                                 : pf->engine->reverse(pf->engine_data, num);
     }
-
-    PhoneNumbers *result = malloc(sizeof(*result));
-    if (result != NULL) {
-        ListOfNumbers *result_list = newList();
-        if (result_list != NULL) {
-            if (onlyDigitsAndNotEmpty(num)) {
-                size_t how_many_elements = 0;
-                char **array = createArrayOfResults(pf, num, &how_many_elements, only_counterimage);
-                if (array != NULL) {
-                    qsort(array, how_many_elements, sizeof(*array), myCompare);
-                    if (how_many_elements > 0) {
-                        if (addElement(result_list, array[0], howLong(array[0]))) {
-                            bool go_on = true;
-                            size_t i = 1;
-                            while (go_on && (i < how_many_elements)) {
-                                if (numbersDiffer(array[i], array[i-1])) {
-                                    go_on = addElement(result_list, array[i], howLong(array[i]));
-                                }
-                                ++i;
-                            }
-
-                            for (size_t i = 0; i < how_many_elements; ++i) {
-                                free(array[i]);
-                            }
-                            free(array);
-
-                            if (!go_on) {
-                                freeList(result_list);
-                                free(result_list);
-                                free(result);
-                                result = NULL;
-                            }
-                            else {
-                                result->list = result_list;
-                            }
-                        }
-                        else {
-                            for (size_t i = 0; i < how_many_elements; ++i) {
-                                free(array[i]);
-                            }
-                            free(array);
-                            free(result_list);
-                            free(result);
-                            result = NULL;
-                        }
-                    }
-                    else {
-                        if (addElement(result_list, NULL, 0)) {
-                            result->list = result_list;
-                        }
-                        else {
-                            free(result_list);
-                            free(result);
-                            result = NULL;
-                            return result;
-                        }
-                    }
-                }
-                else {
-                    free(result_list);
-                    free(result);
-                    result = NULL;
-                }
-            }
-            else {
-                if (addElement(result_list, NULL, 0)) {
-                    result->list = result_list;
-                }
-                else {
-                    free(result_list);
-                    free(result);
-                    result = NULL;
-                    return result;
-                }
-            }
-        }
-        else {
-            free(result);
-            result = NULL;
-        }
+    PhoneNumbersIter *it = phfwdReverseOrGetReverseIter(pf, num, only_counterimage);
+    if (it == NULL) {
+        return NULL;
     }
+    PhoneNumbers *result = phnumFromIter(it, SIZE_MAX);
+    phfwdIterDelete(it);
     return result;
 }
 
@@ -537,7 +486,8 @@ PhoneNumbers * phfwdReverseOrGetReverse(PhoneForward const *pf, char const *num,
  * @param[in] pf  - wskaźnik na strukturę przechowującą przekierowania numerów;
  * @param[in] num - wskaźnik na napis reprezentujący numer.
  * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
- *         udało się alokować pamięci albo parametr pf ma wartość NULL.
+ *         udało się alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
  */
 PhoneNumbers * phfwdReverse(PhoneForward const *pf, char const *num) {
     return phfwdReverseOrGetReverse(pf, num, 0);
@@ -553,7 +503,8 @@ PhoneNumbers * phfwdReverse(PhoneForward const *pf, char const *num) {
  * @param[in] pf  - wskaźnik na strukturę przechowującą przekierowania numerów;
  * @param[in] num - wskaźnik na napis reprezentujący numer.
  * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
- *         udało się alokować pamięci albo parametr pf ma wartość NULL.
+ *         udało się alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
  */
 PhoneNumbers * phfwdGetReverse(PhoneForward const *pf, char const *num) {
     return phfwdReverseOrGetReverse(pf, num, 1);
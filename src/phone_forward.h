@@ -14,20 +14,76 @@
 #include <stddef.h>
 #include <ctype.h>
 #include <stdlib.h>
-#include "phfwd_auxiliary_functions.h"
-#include "list.h"
+#include <stdint.h>
 
 /**
  * To jest stała o wartości równej ilości cyfr, z których składa się alfabet cyfr, nad którym są numery
  */
 #define SONS 12
 
+// Węzeł drzewa w pliku poniżej ma tablicę synów o rozmiarze SONS.
+#include "phfwd_auxiliary_functions.h"
+#include "list.h"
+#include "packed_number.h"
+
+/**
+ * To jest struktura dziennika operacji dołączanego przez @ref phfwdOpenLog.
+ */
+typedef struct PhoneForwardLog PhoneForwardLog;
+
+/**
+ * To jest struktura procesu czytającego przekierowania opublikowane przez @ref phfwdPublish.
+ */
+typedef struct PhoneForwardShared PhoneForwardShared;
+
+/**
+ * To jest struktura opisująca zapis migawki w tle rozpoczęty przez @ref phfwdBackgroundSave.
+ */
+struct PhoneForwardSave;
+
+/**
+ * To jest tablica funkcji silnika przechowującego przekierowania zamiast drzewa.
+ */
+struct PhoneForwardEngine;
+
+/**
+ * To jest struktura tablicy bezpośredniego dostępu budowanej przez @ref phfwdBuildDirectIndex.
+ */
+struct DirectIndex;
+
+/**
+ * To jest typ stanu zapisu migawki w tle.
+ */
+typedef enum PhoneForwardSaveStatus {
+    PHFWD_SAVE_NONE, ///< żaden zapis nie został rozpoczęty
+    PHFWD_SAVE_RUNNING, ///< zapis się toczy
+    PHFWD_SAVE_DONE, ///< zapis się powiódł
+    PHFWD_SAVE_FAILED ///< zapis się nie powiódł
+} PhoneForwardSaveStatus;
+
+/**
+ * To jest typ funkcji wywoływanej po zakończeniu zapisu migawki w tle.
+ * Otrzymuje informację, czy zapis się powiódł, i wskaźnik przekazany przez użytkownika.
+ */
+typedef void (*PhoneForwardSaveCallback)(bool success, void *data);
+
 /**
  * To jest struktura przechowująca przekierowania numerów telefonów.
  */
 typedef struct PhoneForward {
+    struct NodePool *pool; ///< pula węzłów drzewa przekierowań i drzewa odwróceń
     struct Node *forward; ///< wskaźnik na węzeł będący korzeniem drzewa przekierowań
-    struct Node *reverse; ///< wskaźnik na węzeł będący korzeniem drzewa odwróceń
+    struct Node *reverse; ///< wskaźnik na węzeł będący korzeniem drzewa odwróceń lub NULL, gdy struktura go nie utrzymuje
+    struct Node *graveyard; ///< stos odłączonych węzłów czekających na zwolnienie, połączony przez pola parent
+    size_t removal_budget; ///< maksymalna liczba węzłów zwalnianych w jednym wywołaniu; 0 oznacza usuwanie natychmiastowe
+    uint32_t compact_next; ///< indeks w puli, pod który trafi kolejny węzeł porządkowany przez @ref phfwdCompact; 0, gdy porządkowanie się nie zaczęło
+    uint64_t compact_changes; ///< liczba zmian puli węzłów po ostatnim kroku porządkowania
+    PhoneForwardLog *log; ///< dziennik operacji lub NULL, gdy operacje nie są zapisywane
+    struct PhoneForwardSave *save; ///< stan zapisu migawki w tle lub NULL, gdy żaden nie został rozpoczęty
+    uint64_t chain_id; ///< identyfikator ostatniego pliku zapisanego lub wczytanego przyrostowo; 0, gdy go nie ma
+    struct DirectIndex *direct; ///< tablica bezpośredniego dostępu do początku drzewa przekierowań lub NULL, gdy jej nie ma
+    struct PhoneForwardEngine const *engine; ///< silnik przechowujący przekierowania lub NULL, gdy są w drzewie
+    void *engine_data; ///< stan silnika lub NULL, gdy przekierowania są w drzewie
 } PhoneForward;
 
 /**
@@ -37,6 +93,51 @@ typedef struct PhoneNumbers {
     struct ListOfNumbers *list; ///< lista numerów
 } PhoneNumbers;
 
+/**
+ * To jest struktura iteratora po wynikach funkcji phfwdReverse i phfwdGetReverse.
+ */
+typedef struct PhoneNumbersIter PhoneNumbersIter;
+
+/**
+ * To jest typ funkcji wywoływanej dla każdego przekierowania przez @ref phfwdForEachPrefix.
+ * Otrzymuje numer przekierowywany, numer, na który jest wykonywane przekierowanie,
+ * i wskaźnik przekazany przez użytkownika. Zwraca @p false, aby przerwać przeglądanie.
+ */
+typedef bool (*PhoneForwardVisitor)(char const *num1, char const *num2, void *data);
+
+/**
+ * To jest typ funkcji wywoływanej dla każdego numeru przez @ref phfwdGetBatch.
+ * Otrzymuje pozycję numeru w tablicy zapytań, jego przekierowanie, ważne
+ * tylko do powrotu z funkcji, lub NULL, gdy napis nie reprezentuje numeru,
+ * i wskaźnik przekazany przez użytkownika. Zwraca @p false, aby przerwać wyznaczanie.
+ */
+typedef bool (*PhoneForwardBatchVisitor)(size_t idx, char const *num, void *data);
+
+/**
+ * To jest typ operacji wykonywanej przez @ref phfwdApplyBatch.
+ */
+typedef enum PhoneForwardOperationType {
+    PHFWD_ADD, ///< dodanie przekierowania, jak w @ref phfwdAdd
+    PHFWD_REMOVE ///< usunięcie przekierowań, jak w @ref phfwdRemove
+} PhoneForwardOperationType;
+
+/**
+ * To jest struktura opisująca jedną operację paczki wykonywanej przez @ref phfwdApplyBatch.
+ */
+typedef struct PhoneForwardOperation {
+    PhoneForwardOperationType type; ///< rodzaj operacji
+    char const *num1; ///< prefiks numerów przekierowywanych lub usuwanych
+    char const *num2; ///< prefiks numerów, na które jest wykonywane przekierowanie; nieużywany przy usuwaniu
+} PhoneForwardOperation;
+
+/**
+ * To jest typ funkcji zwracającej kolejne pary numerów dla @ref phfwdBulkLoad.
+ * Zapisuje pod adresami @p num1 i @p num2 wskaźniki na kolejną parę, ważne
+ * do następnego wywołania, i zwraca @p true albo zwraca @p false, gdy par
+ * już nie ma.
+ */
+typedef bool (*PhoneForwardPairIterator)(char const **num1, char const **num2, void *data);
+
 /** @brief Tworzy nową strukturę.
  * Tworzy nową strukturę niezawierającą żadnych przekierowań.
  * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
@@ -44,6 +145,17 @@ typedef struct PhoneNumbers {
  */
 PhoneForward * phfwdNew(void);
 
+/** @brief Tworzy nową strukturę bez drzewa odwróceń.
+ * Tworzy nową strukturę niezawierającą żadnych przekierowań, która nie
+ * utrzymuje drzewa odwróceń. Funkcje @ref phfwdAdd i @ref phfwdRemove
+ * działają w niej szybciej i zajmuje ona mniej pamięci, ale funkcje
+ * @ref phfwdReverse i @ref phfwdGetReverse zwracają NULL, dopóki drzewo
+ * odwróceń nie zostanie zbudowane przez @ref phfwdBuildReverseIndex.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+PhoneForward * phfwdNewForwardOnly(void);
+
 /** @brief Usuwa strukturę.
  * Usuwa strukturę wskazywaną przez @p pf. Nic nie robi, jeśli wskaźnik ten ma
  * wartość NULL.
@@ -77,8 +189,10 @@ bool phfwdAdd(PhoneForward *pf, char const *num1, char const *num2);
  * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania
  *                     numerów;
  * @param[in] num    - wskaźnik na napis reprezentujący prefiks numerów.
+ * @return Wartość @p true, jeśli usunięto jakieś przekierowanie.
+ *         Wartość @p false w przeciwnym przypadku.
  */
-void phfwdRemove(PhoneForward *pf, char const *num);
+bool phfwdRemove(PhoneForward *pf, char const *num);
 
 /** @brief Wyznacza przekierowanie numeru.
  * Wyznacza przekierowanie podanego numeru. Szuka najdłuższego pasującego
@@ -94,17 +208,16 @@ void phfwdRemove(PhoneForward *pf, char const *num);
  */
 PhoneNumbers * phfwdGet(PhoneForward const *pf, char const *num);
 
-/** @brief Tworzy tablicę numerów, które są zawarte w wyniku funkcji phfwdReverse lub phfwdGetReverse.
- * Tworzy tablicę numerów, które są zawarte w wyniku funkcji phfwdReverse lub phfwdGetReverse.
- * Numery te mogą się powtarzać i nie są posortowane leksykograficznie.
+/** @brief Sprawdza, czy numer jest przekierowywany na dany numer.
+ * Sprawdza, czy wynik wywołania @ref phfwdGet z numerem @p candidate jest równy
+ * numerowi @p target. Nie alokuje pamięci.
  * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów telefonów
- * @param[in] num - wskaźnik na napis reprezentujący numer
- * @param[in, out] how_many_elements - ilosć elementów w tablicy numerów
- * @param[in] only_counterimage - zmienna informująca czy wyznaczamy tylko przeciwobraz phfwdGet
- * @return Wskaźnik na tablicę numerów lub NULL, gdy nie
- *         udało się alokować pamięci.
+ * @param[in] candidate - spakowany numer, którego przekierowanie jest sprawdzane
+ * @param[in] target - spakowany numer, który powinien być wynikiem przekierowania
+ * @return Wartość @p true, jeśli @p candidate jest przekierowywany na @p target.
+ *         Wartość @p false w przeciwnym przypadku.
  */
-char ** createArrayOfResults(PhoneForward const *pf, char const *num, size_t *how_many_elements, bool only_counterimage);
+bool isCounterimage(PhoneForward const *pf, PackedNumber const *candidate, PackedNumber const *target);
 
 /** @brief Wyznacza wynik funkcji phfwdReverse lub phfwdGetReverse.
  * Wyznacza wynik funkcji phfwdReverse lub phfwdGetReverse w zależności
@@ -114,7 +227,8 @@ char ** createArrayOfResults(PhoneForward const *pf, char const *num, size_t *ho
  * @param[in] num - wskaźnik na napis reprezentujący numer;
  * @param[in] only_counterimage - zmienna informująca o tym, czy wyznaczamy tylko przeciwobraz phfwdGet
  * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
- *         udało się alokować pamięci albo parametr pf ma wartość NULL.
+ *         udało się alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
  */
 PhoneNumbers * phfwdReverseOrGetReverse(PhoneForward const *pf, char const *num, bool only_counterimage);
 
@@ -131,7 +245,8 @@ PhoneNumbers * phfwdReverseOrGetReverse(PhoneForward const *pf, char const *num,
  * @param[in] pf  - wskaźnik na strukturę przechowującą przekierowania numerów;
  * @param[in] num - wskaźnik na napis reprezentujący numer.
  * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
- *         udało się alokować pamięci albo parametr pf ma wartość NULL.
+ *         udało się alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
  */
 PhoneNumbers * phfwdReverse(PhoneForward const *pf, char const *num);
 
@@ -145,7 +260,8 @@ PhoneNumbers * phfwdReverse(PhoneForward const *pf, char const *num);
  * @param[in] pf  - wskaźnik na strukturę przechowującą przekierowania numerów;
  * @param[in] num - wskaźnik na napis reprezentujący numer.
  * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
- *         udało się alokować pamięci albo parametr pf ma wartość NULL.
+ *         udało się alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
  */
 PhoneNumbers * phfwdGetReverse(PhoneForward const *pf, char const *num);
 
@@ -166,4 +282,629 @@ void phnumDelete(PhoneNumbers *pnum);
  */
 char const * phnumGet(PhoneNumbers const *pnum, size_t idx);
 
+/** @brief Tworzy iterator po wynikach funkcji phfwdReverse.
+ * Kolejne numery są zwracane przez funkcję @ref phfwdIterNext w porządku
+ * leksykograficznym, bez powtórzeń. Iterator nie kopiuje ani nie sortuje
+ * wyników z góry. Listy węzłów drzewa odwróceń są posortowane, więc iterator
+ * scala je na bieżąco, a pierwszy wynik jest dostępny po przejściu ścieżki
+ * numeru @p num. Pamięć iteratora nie zależy od liczby wyników. Do pobierania
+ * wyników stronami służy funkcja @ref phfwdIterPage. Iterator musi zostać usunięty
+ * za pomocą funkcji @ref phfwdIterDelete przed modyfikacją struktury @p pf.
+ * @param[in] pf  - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num - wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na utworzony iterator lub NULL, gdy nie udało się
+ *         alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
+ */
+PhoneNumbersIter * phfwdReverseIter(PhoneForward const *pf, char const *num);
+
+/** @brief Tworzy iterator po wynikach funkcji phfwdGetReverse.
+ * Działa tak jak @ref phfwdReverseIter, ale zwraca tylko numery, które są
+ * przekierowywane na numer @p num.
+ * @param[in] pf  - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num - wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na utworzony iterator lub NULL, gdy nie udało się
+ *         alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
+ */
+PhoneNumbersIter * phfwdGetReverseIter(PhoneForward const *pf, char const *num);
+
+/** @brief Udostępnia kolejny numer.
+ * Nie alokuje pamięci.
+ * @param[in,out] it - wskaźnik na iterator.
+ * @return Wskaźnik na napis reprezentujący kolejny numer, ważny do następnego
+ *         wywołania funkcji na tym iteratorze. Wartość NULL, gdy nie ma więcej
+ *         numerów lub wskaźnik @p it ma wartość NULL.
+ */
+char const * phfwdIterNext(PhoneNumbersIter *it);
+
+/** @brief Przesuwa iterator za podany numer.
+ * Ustawia iterator tak, aby kolejnym zwróconym numerem był najmniejszy numer
+ * większy od @p after. Jeśli @p after ma wartość NULL, iterator wraca na
+ * początek. Jeśli napis @p after nie reprezentuje numeru, iterator zostaje
+ * ustawiony na koniec. Przesunięcie do przodu pomija wyniki bez ich
+ * tworzenia, a przesunięcie do tyłu zaczyna przeglądanie od początku.
+ * Nie alokuje pamięci.
+ * @param[in,out] it - wskaźnik na iterator;
+ * @param[in] after - wskaźnik na napis reprezentujący ostatni odczytany numer.
+ */
+void phfwdIterSeek(PhoneNumbersIter *it, char const *after);
+
+/** @brief Wyznacza kolejną stronę wyników iteratora.
+ * Wyznacza co najwyżej @p limit kolejnych numerów iteratora. Kolejne
+ * wywołanie zaczyna się tam, gdzie skończyło się poprzednie, bez ponownego
+ * przeglądania wcześniejszych wyników, więc przejście wszystkich stron kosztuje
+ * tyle, co jedno przejście iteratora. Alokuje strukturę @p PhoneNumbers, która
+ * musi być zwolniona za pomocą funkcji @ref phnumDelete.
+ * @param[in,out] it - wskaźnik na iterator;
+ * @param[in] limit  - maksymalna liczba numerów na stronie.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci albo wskaźnik @p it ma wartość NULL.
+ */
+PhoneNumbers * phfwdIterPage(PhoneNumbersIter *it, size_t limit);
+
+/** @brief Usuwa iterator.
+ * Nic nie robi, jeśli wskaźnik @p it ma wartość NULL.
+ * @param[in] it - wskaźnik na usuwany iterator.
+ */
+void phfwdIterDelete(PhoneNumbersIter *it);
+
+/** @brief Wyznacza stronę wyników funkcji phfwdReverse.
+ * Wyznacza co najwyżej @p limit kolejnych numerów z wyniku funkcji
+ * @ref phfwdReverse, większych od numeru @p after. Jeśli @p after ma wartość
+ * NULL, strona zaczyna się od pierwszego numeru. Ostatni numer strony służy
+ * jako wartość @p after przy pobieraniu kolejnej strony. Każde wywołanie
+ * pomija od nowa wyniki nie większe od @p after, więc do przeglądania wielu
+ * kolejnych stron służy iterator i funkcja @ref phfwdIterPage. Alokuje
+ * strukturę @p PhoneNumbers, która musi być zwolniona za pomocą funkcji
+ * @ref phnumDelete.
+ * @param[in] pf    - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num   - wskaźnik na napis reprezentujący numer;
+ * @param[in] after - wskaźnik na napis reprezentujący ostatni numer poprzedniej strony;
+ * @param[in] limit - maksymalna liczba numerów na stronie.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci albo parametr pf ma wartość NULL
+ *         lub struktura nie ma drzewa odwróceń.
+ */
+PhoneNumbers * phfwdReversePage(PhoneForward const *pf, char const *num, char const *after, size_t limit);
+
+/** @brief Przegląda przekierowania numerów o danym prefiksie.
+ * Wywołuje funkcję @p visitor dla każdego przekierowania, którego parametr
+ * @p num1 ma prefiks @p prefix, w porządku leksykograficznym parametrów @p num1.
+ * Napisy przekazywane funkcji @p visitor są ważne tylko w czasie jej wywołania.
+ * Pamięć jest alokowana tylko wtedy, gdy przejście schodzi głębiej lub napotyka
+ * dłuższy numer niż wcześniej, a nie dla każdego przekierowania.
+ * @param[in] pf      - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] prefix  - wskaźnik na napis reprezentujący prefiks; NULL lub pusty
+ *                      napis oznacza wszystkie przekierowania;
+ * @param[in] visitor - funkcja wywoływana dla każdego przekierowania; zwrócenie
+ *                      przez nią wartości @p false przerywa przeglądanie;
+ * @param[in] data    - wskaźnik przekazywany funkcji @p visitor.
+ * @return Wartość @p true, jeśli przeglądanie się powiodło.
+ *         Wartość @p false, jeśli parametr pf lub visitor ma wartość NULL,
+ *         napis nie reprezentuje numeru lub nie udało się alokować pamięci.
+ */
+bool phfwdForEachPrefix(PhoneForward const *pf, char const *prefix, PhoneForwardVisitor visitor, void *data);
+
+/** @brief Zapisuje do pliku przekierowania numerów o danym prefiksie.
+ * Zapisuje w pliku po jednym przekierowaniu w wierszu, w postaci dwóch
+ * numerów rozdzielonych spacją, w porządku leksykograficznym.
+ * @param[in] pf     - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] prefix - wskaźnik na napis reprezentujący prefiks; NULL lub pusty
+ *                     napis oznacza wszystkie przekierowania;
+ * @param[in] file   - wskaźnik na plik otwarty do zapisu.
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdDumpPrefix(PhoneForward const *pf, char const *prefix, FILE *file);
+
+/** @brief Ustawia tryb usuwania przekierowań.
+ * Jeśli @p budget ma wartość 0 (domyślnie), funkcja @ref phfwdRemove zwalnia
+ * usuwane węzły od razu. W przeciwnym przypadku @ref phfwdRemove jedynie
+ * odłącza poddrzewo w czasie proporcjonalnym do długości prefiksu, a jego
+ * przekierowania natychmiast przestają być widoczne dla @ref phfwdGet,
+ * @ref phfwdReverse i @ref phfwdGetReverse. Odłączone węzły są zwalniane
+ * po co najwyżej @p budget przy kolejnych wywołaniach @ref phfwdAdd
+ * i @ref phfwdRemove oraz przez funkcję @ref phfwdReclaim.
+ * Nic nie robi, jeśli parametr pf ma wartość NULL.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] budget - maksymalna liczba węzłów zwalnianych w jednym wywołaniu.
+ */
+void phfwdSetRemovalBudget(PhoneForward *pf, size_t budget);
+
+/** @brief Zwalnia węzły odłączone przez usuwanie przyrostowe.
+ * Zwalnia co najwyżej @p budget węzłów czekających na zwolnienie wraz
+ * z odpowiadającymi im wpisami drzewa odwróceń. Wartość 0 oznacza zwolnienie
+ * wszystkich. Nie alokuje pamięci.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] budget - maksymalna liczba zwalnianych węzłów.
+ * @return Wartość @p true, jeśli nie ma już węzłów czekających na zwolnienie.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdReclaim(PhoneForward *pf, size_t budget);
+
+/** @brief Wykonuje paczkę operacji dodawania i usuwania przekierowań.
+ * Wynik jest taki sam jak wykonanie kolejno operacji z tablicy @p operations
+ * funkcjami @ref phfwdAdd i @ref phfwdRemove, ale operacje są porządkowane
+ * według prefiksów i wykonywane jednym przejściem po drzewie przekierowań
+ * i jednym po drzewie odwróceń. Paczka jest niepodzielna: jeśli któreś
+ * dodanie ma niepoprawne parametry lub nie uda się alokować pamięci, struktura
+ * pozostaje niezmieniona. Usunięcia z niepoprawnym parametrem są pomijane.
+ * @param[in,out] pf     - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] operations - wskaźnik na tablicę operacji;
+ * @param[in] count      - liczba operacji.
+ * @return Wartość @p true, jeśli wszystkie operacje zostały wykonane.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, któreś dodanie
+ *         ma niepoprawne parametry lub nie udało się alokować pamięci.
+ */
+bool phfwdApplyBatch(PhoneForward *pf, PhoneForwardOperation const *operations, size_t count);
+
+/** @brief Wyznacza przekierowania wielu numerów naraz.
+ * Wyznacza przekierowania numerów z tablicy @p nums, tak jak @ref phfwdGet,
+ * i przekazuje je funkcji @p visitor. Zapytania są porządkowane według
+ * numerów, a zejście w drzewie przekierowań zaczyna się od węzła wspólnego
+ * prefiksu z poprzednim numerem, więc funkcja @p visitor jest wywoływana
+ * w porządku numerów, a nie pozycji. Wyniki nie są alokowane osobno.
+ * @param[in] pf      - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] nums    - wskaźnik na tablicę napisów reprezentujących numery;
+ * @param[in] count   - liczba numerów;
+ * @param[in] visitor - funkcja wywoływana dla każdego numeru;
+ * @param[in] data    - wskaźnik przekazywany funkcji @p visitor.
+ * @return Wartość @p true, jeśli wyznaczono przekierowania wszystkich numerów.
+ *         Wartość @p false, jeśli parametr pf lub visitor ma wartość NULL,
+ *         funkcja @p visitor przerwała wyznaczanie lub nie udało się
+ *         alokować pamięci.
+ */
+bool phfwdGetBatch(PhoneForward const *pf, char const * const *nums, size_t count,
+                   PhoneForwardBatchVisitor visitor, void *data);
+
+/** @brief Wczytuje przekierowania do pustej struktury.
+ * Dodaje przekierowania z par numerów (num1, num2) zwracanych przez
+ * @p iterator, tak jak @ref phfwdAdd. Pary muszą być posortowane rosnąco
+ * według num1 w porządku leksykograficznym, w którym cyfra * następuje po 9,
+ * a cyfra # po *, i nie mogą powtarzać num1. Obydwa drzewa są budowane
+ * w jednym przejściu każde, bez ponownego schodzenia od korzenia dla
+ * każdej pary. Jeśli funkcja zwróci @p false, struktura pozostaje pusta.
+ * @param[in,out] pf   - wskaźnik na pustą strukturę przechowującą przekierowania numerów;
+ * @param[in] iterator - funkcja zwracająca kolejne pary numerów;
+ * @param[in] data     - wskaźnik przekazywany funkcji @p iterator.
+ * @return Wartość @p true, jeśli wszystkie przekierowania zostały dodane.
+ *         Wartość @p false, jeśli struktura nie była pusta, któraś para
+ *         jest niepoprawna, pary nie są posortowane lub nie udało się
+ *         alokować pamięci.
+ */
+bool phfwdBulkLoad(PhoneForward *pf, PhoneForwardPairIterator iterator, void *data);
+
+/** @brief Buduje drzewo odwróceń dla struktury utworzonej bez niego.
+ * Buduje drzewo odwróceń dla struktury utworzonej przez
+ * @ref phfwdNewForwardOnly, równolegle w kilku wątkach. Po udanym wywołaniu
+ * struktura działa tak jak utworzona przez @ref phfwdNew. Nic nie robi, jeśli
+ * struktura ma już drzewo odwróceń.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli struktura ma drzewo odwróceń.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL lub nie udało
+ *         się alokować pamięci; wtedy struktura pozostaje bez zmian.
+ */
+bool phfwdBuildReverseIndex(PhoneForward *pf);
+
+/** @brief Buduje tablicę bezpośredniego dostępu do początku drzewa przekierowań.
+ * Tablica ma 12^k pozycji, po jednej dla każdego ciągu k pierwszych cyfr.
+ * Pozycja przechowuje najdłuższe przekierowanie z prefiksem tych cyfr i węzeł
+ * drzewa, od którego wyszukiwanie jest kontynuowane, więc @ref phfwdGet oraz
+ * @ref phfwdGetReverse dla numerów o co najmniej k cyfrach pomijają k kroków
+ * w drzewie. Tablica jest uaktualniana przez wszystkie funkcje zmieniające
+ * przekierowania. Jeśli @p depth ma wartość 0, k jest wybierane na podstawie
+ * rozkładu długości przekierowywanych prefiksów i liczby węzłów drzewa.
+ * Zastępuje wcześniej zbudowaną tablicę.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] depth  - liczba cyfr k od 1 do 5 lub 0, aby wybrać ją automatycznie.
+ * @return Wartość @p true, jeśli tablica została zbudowana.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, struktura jest
+ *         przechowywana w pliku, @p depth jest większe niż 5 lub nie udało się
+ *         alokować pamięci; wtedy struktura pozostaje bez zmian.
+ */
+bool phfwdBuildDirectIndex(PhoneForward *pf, size_t depth);
+
+/** @brief Zwraca głębokość tablicy bezpośredniego dostępu.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Liczba cyfr indeksujących tablicę lub 0, gdy struktura jej nie ma
+ *         albo parametr pf ma wartość NULL.
+ */
+size_t phfwdDirectIndexDepth(PhoneForward const *pf);
+
+/** @brief Zapisuje do pliku migawkę przekierowań.
+ * Migawka zawiera rekordy dodania wszystkich przekierowań w porządku
+ * leksykograficznym parametrów num1, więc może być wczytana przez
+ * @ref phfwdBulkLoad. Plik jest najpierw zapisywany pod nazwą z dodanym
+ * sufiksem ".tmp", synchronizowany z dyskiem, a następnie atomowo
+ * przemianowywany, więc po awarii pozostaje poprzednia lub nowa migawka.
+ * Taka migawka nie może być podstawą zapisu przyrostowego
+ * (zob. @ref phfwdSaveIncremental).
+ * @param[in] pf   - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path - wskaźnik na napis reprezentujący ścieżkę pliku.
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdSaveSnapshot(PhoneForward const *pf, char const *path);
+
+/** @brief Wczytuje migawkę przekierowań do pustej struktury.
+ * Wczytuje plik zapisany przez @ref phfwdSaveSnapshot za pomocą
+ * @ref phfwdBulkLoad. Wczytane przekierowania nie są zapisywane do
+ * dziennika operacji. Jeśli funkcja zwróci @p false, struktura pozostaje pusta.
+ * Migawka zapisana przez @ref phfwdSaveIncremental może być następnie
+ * uzupełniona plikami zmian za pomocą @ref phfwdLoadIncremental.
+ * @param[in,out] pf - wskaźnik na pustą strukturę przechowującą przekierowania numerów;
+ * @param[in] path   - wskaźnik na napis reprezentujący ścieżkę pliku.
+ * @return Wartość @p true, jeśli migawka została wczytana.
+ *         Wartość @p false, jeśli struktura nie była pusta, nie udało się
+ *         odczytać pliku, plik jest uszkodzony lub nie udało się alokować pamięci.
+ */
+bool phfwdLoadSnapshot(PhoneForward *pf, char const *path);
+
+/** @brief Dołącza do struktury dziennik operacji.
+ * Od tej chwili każde udane wywołanie @ref phfwdAdd, @ref phfwdRemove,
+ * @ref phfwdApplyBatch i @ref phfwdBulkLoad dopisuje do pliku dziennika
+ * rekordy w zwartej postaci binarnej. Rekordy są zapisywane do pliku
+ * grupami przez bufor, a plik jest synchronizowany z dyskiem co
+ * @p sync_every rekordów (0 oznacza synchronizację tylko przez
+ * @ref phfwdSyncLog i @ref phfwdCloseLog). Jeśli plik istnieje, jego
+ * uszkodzony koniec, pozostały po awarii, jest obcinany, a nowe rekordy
+ * są dopisywane za poprawnymi.
+ * @param[in,out] pf     - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path       - wskaźnik na napis reprezentujący ścieżkę pliku dziennika;
+ * @param[in] sync_every - co ile rekordów synchronizować plik z dyskiem.
+ * @return Wartość @p true, jeśli dziennik został dołączony.
+ *         Wartość @p false, jeśli struktura ma już dziennik, plik nie jest
+ *         dziennikiem, nie udało się go otworzyć lub alokować pamięci.
+ */
+bool phfwdOpenLog(PhoneForward *pf, char const *path, size_t sync_every);
+
+/** @brief Zapisuje zgromadzone rekordy dziennika i synchronizuje go z dyskiem.
+ * Po udanym wywołaniu wszystkie wcześniejsze operacje są trwałe.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli zapis się powiódł lub struktura nie ma dziennika.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL lub zapis
+ *         któregoś rekordu dziennika się nie powiódł.
+ */
+bool phfwdSyncLog(PhoneForward *pf);
+
+/** @brief Odłącza i zamyka dziennik operacji.
+ * Zapisuje zgromadzone rekordy i synchronizuje plik z dyskiem.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli zapis się powiódł lub struktura nie miała dziennika.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdCloseLog(PhoneForward *pf);
+
+/** @brief Odtwarza operacje zapisane w dzienniku.
+ * Wykonuje kolejno operacje z pliku dziennika paczkami za pomocą
+ * @ref phfwdApplyBatch. Niepełny lub uszkodzony rekord na końcu pliku,
+ * pozostały po awarii, kończy odtwarzanie. Odtworzone operacje nie są
+ * zapisywane do dziennika dołączonego do struktury. Odtworzenie dziennika
+ * na strukturze, która zawiera już skutki części jego operacji (np. po
+ * wczytaniu nowszej migawki), daje ten sam wynik, bo wartość każdego
+ * przekierowania zależy tylko od ostatniej dotyczącej go operacji.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path   - wskaźnik na napis reprezentujący ścieżkę pliku dziennika.
+ * @return Wartość @p true, jeśli dziennik został odtworzony.
+ *         Wartość @p false, jeśli nie udało się odczytać pliku, nie jest on
+ *         dziennikiem lub nie udało się alokować pamięci; wtedy część
+ *         operacji mogła zostać wykonana.
+ */
+bool phfwdReplay(PhoneForward *pf, char const *path);
+
+/** @brief Zastępuje dziennik migawką.
+ * Zapisuje migawkę bieżącego stanu za pomocą @ref phfwdSaveSnapshot,
+ * a następnie obcina dziennik. Jeśli awaria nastąpi między tymi krokami,
+ * odtworzenie starego dziennika na nowej migawce daje ten sam stan.
+ * @param[in,out] pf        - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] snapshot_path - wskaźnik na napis reprezentujący ścieżkę pliku migawki.
+ * @return Wartość @p true, jeśli migawka została zapisana, a dziennik obcięty.
+ *         Wartość @p false, jeśli struktura nie ma dziennika lub zapis się nie powiódł.
+ */
+bool phfwdCompactLog(PhoneForward *pf, char const *snapshot_path);
+
+/** @brief Zapisuje migawkę w tle.
+ * Tworzy proces potomny funkcją fork(), który zapisuje migawkę za pomocą
+ * @ref phfwdSaveSnapshot ze swojej kopii pamięci, współdzielonej z procesem
+ * macierzystym aż do pierwszego zapisu strony (kopiowanie przy zapisie).
+ * Proces macierzysty może w tym czasie dalej modyfikować strukturę,
+ * a migawka odpowiada stanowi z chwili wywołania. Zakończenie zapisu
+ * sprawdza funkcja @ref phfwdBackgroundSaveStatus, która wywołuje też
+ * funkcję @p callback. Dziennik operacji nie jest zmieniany; odtworzenie go
+ * na zapisanej migawce daje bieżący stan.
+ * @param[in,out] pf   - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path     - wskaźnik na napis reprezentujący ścieżkę pliku migawki;
+ * @param[in] callback - funkcja wywoływana po zakończeniu zapisu lub NULL;
+ * @param[in] data     - wskaźnik przekazywany funkcji @p callback.
+ * @return Wartość @p true, jeśli zapis został rozpoczęty.
+ *         Wartość @p false, jeśli poprzedni zapis jeszcze się toczy, nie
+ *         udało się utworzyć procesu lub alokować pamięci.
+ */
+bool phfwdBackgroundSave(PhoneForward *pf, char const *path, PhoneForwardSaveCallback callback, void *data);
+
+/** @brief Sprawdza stan zapisu migawki w tle.
+ * Jeśli zapis się zakończył, wywołuje funkcję przekazaną do
+ * @ref phfwdBackgroundSave (dokładnie raz) i zwraca jego wynik, aż do
+ * rozpoczęcia kolejnego zapisu.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] wait   - czy czekać na zakończenie zapisu.
+ * @return Stan ostatniego zapisu lub @p PHFWD_SAVE_NONE, jeśli żaden zapis
+ *         nie został rozpoczęty albo parametr pf ma wartość NULL.
+ */
+PhoneForwardSaveStatus phfwdBackgroundSaveStatus(PhoneForward *pf, bool wait);
+
+/** @brief Zapisuje przyrostowo zmiany przekierowań.
+ * Struktura oznacza zmienione poddrzewa drzew przekierowań i odwróceń.
+ * Jeśli @p base ma wartość NULL, zapisuje pełną migawkę, od której zaczyna
+ * się ciąg zapisów przyrostowych. W przeciwnym przypadku @p base musi być
+ * plikiem zapisanym ostatnio tą funkcją lub wczytanym ostatnio przez
+ * @ref phfwdLoadSnapshot lub @ref phfwdLoadIncremental, a do pliku @p path
+ * trafiają tylko zmienione poddrzewa, więc czas i rozmiar zapisu zależą od
+ * liczby zmian, a nie od liczby przekierowań. Plik jest zapisywany atomowo
+ * tak jak przez @ref phfwdSaveSnapshot. Po udanym zapisie oznaczenia zmian
+ * są usuwane.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] base   - wskaźnik na napis reprezentujący ścieżkę poprzedniego pliku lub NULL;
+ * @param[in] path   - wskaźnik na napis reprezentujący ścieżkę zapisywanego pliku.
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false, jeśli plik @p base nie jest ostatnim plikiem ciągu
+ *         zapisów struktury, zapis się nie powiódł lub nie udało się alokować
+ *         pamięci; wtedy oznaczenia zmian pozostają bez zmian.
+ */
+bool phfwdSaveIncremental(PhoneForward *pf, char const *base, char const *path);
+
+/** @brief Nakłada na strukturę zmiany zapisane przyrostowo.
+ * Wykonuje rekordy pliku zapisanego przez @ref phfwdSaveIncremental
+ * paczkami za pomocą @ref phfwdApplyBatch. Struktura musi być w stanie
+ * z chwili zapisu pliku, względem którego zapisano zmiany, tzn. ostatnio
+ * wczytanym plikiem musi być migawka lub plik zmian będący jego podstawą.
+ * Wykonane operacje nie są zapisywane do dziennika operacji.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path   - wskaźnik na napis reprezentujący ścieżkę pliku zmian.
+ * @return Wartość @p true, jeśli zmiany zostały nałożone.
+ *         Wartość @p false, jeśli plik nie jest plikiem zmian, jego podstawa
+ *         nie jest ostatnio wczytanym plikiem, plik jest uszkodzony lub nie
+ *         udało się alokować pamięci; jeśli część zmian została już
+ *         nałożona, nie można nakładać kolejnych plików zmian.
+ */
+bool phfwdLoadIncremental(PhoneForward *pf, char const *path);
+
+/** @brief Wczytuje przekierowania w postaci tekstowej.
+ * Czyta z deskryptora @p fd wiersze zawierające po dwa numery num1 i num2,
+ * rozdzielone spacjami, tabulacjami, przecinkami lub średnikami, np. zapisane
+ * przez @ref phfwdExportText lub w formacie CSV, i dodaje odpowiednie
+ * przekierowania tak, jak kolejne wywołania @ref phfwdAdd. Plik jest czytany
+ * dużymi blokami, granice numerów są wyznaczane po osiem znaków naraz,
+ * a przekierowania są dodawane paczkami przez @ref phfwdApplyBatch, bez
+ * alokacji pamięci dla pojedynczych wierszy. Deskryptor może wskazywać
+ * zwykły plik, potok lub gniazdo.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] fd     - deskryptor otwarty do odczytu.
+ * @return Wartość @p true, jeśli wszystkie wiersze zostały wczytane.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, wiersz jest
+ *         błędny, wystąpił błąd odczytu lub nie udało się alokować pamięci;
+ *         wtedy część przekierowań mogła zostać dodana.
+ */
+bool phfwdImportText(PhoneForward *pf, int fd);
+
+/** @brief Zapisuje przekierowania w postaci tekstowej.
+ * Zapisuje pod deskryptor @p fd po jednym przekierowaniu w wierszu, w postaci
+ * dwóch numerów rozdzielonych spacją, w porządku leksykograficznym, tak jak
+ * @ref phfwdDumpPrefix. Numery są rozpakowywane wprost do dużego bufora
+ * zapisu, więc pamięć nie jest alokowana dla pojedynczych przekierowań.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] fd - deskryptor otwarty do zapisu.
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, wystąpił błąd
+ *         zapisu lub nie udało się alokować pamięci.
+ */
+bool phfwdExportText(PhoneForward const *pf, int fd);
+
+/** @brief Publikuje przekierowania dla innych procesów.
+ * Zapisuje niezmienny obraz przekierowań jako nową wersję i niepodzielnie
+ * czyni ją bieżącą. Procesy, które dołączyły się przez @ref phfwdAttach,
+ * przechodzą na nową wersję przy kolejnym zapytaniu; poprzednia wersja
+ * jest usuwana, ale pozostaje dostępna dla procesów, które ją zmapowały.
+ * Nazwa zaczynająca się znakiem '/' i niezawierająca innych znaków '/'
+ * oznacza obiekt pamięci dzielonej POSIX, a każda inna – zwykły plik.
+ * Równoczesne publikacje pod tą samą nazwą są szeregowane blokadą pliku.
+ * @param[in] pf   - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] name - wskaźnik na napis reprezentujący nazwę.
+ * @return Wartość @p true, jeśli przekierowania zostały opublikowane.
+ *         Wartość @p false, jeśli parametr pf lub name ma wartość NULL,
+ *         struktura ma więcej niż 2^32 - 1 węzłów, nie udało się utworzyć
+ *         obiektu lub alokować pamięci.
+ */
+bool phfwdPublish(PhoneForward const *pf, char const *name);
+
+/** @brief Dołącza się do opublikowanych przekierowań.
+ * Mapuje bieżącą wersję przekierowań opublikowanych przez @ref phfwdPublish
+ * pod nazwą @p name. Zapytania nie kopiują obrazu; gdy zostanie opublikowana
+ * nowa wersja, kolejne zapytanie ją zmapuje. Struktura nie może być używana
+ * równocześnie przez kilka wątków; każdy wątek może mieć własną.
+ * @param[in] name - wskaźnik na napis reprezentujący nazwę.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nic nie opublikowano
+ *         pod tą nazwą, nie udało się zmapować obrazu lub alokować pamięci.
+ */
+PhoneForwardShared * phfwdAttach(char const *name);
+
+/** @brief Odłącza się od opublikowanych przekierowań.
+ * Usuwa strukturę wskazywaną przez @p shared. Nic nie robi, jeśli wskaźnik
+ * ten ma wartość NULL.
+ * @param[in] shared - wskaźnik na usuwaną strukturę.
+ */
+void phfwdDetach(PhoneForwardShared *shared);
+
+/** @brief Usuwa opublikowane przekierowania.
+ * Usuwa obiekt sterujący i bieżącą wersję. Procesy, które je zmapowały,
+ * mogą z nich dalej korzystać.
+ * @param[in] name - wskaźnik na napis reprezentujący nazwę.
+ * @return Wartość @p true, jeśli obiekty zostały usunięte.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdUnpublish(char const *name);
+
+/** @brief Wyznacza przekierowanie numeru w opublikowanych przekierowaniach.
+ * Działa tak jak @ref phfwdGet. Przechodzi na bieżącą wersję, jeśli
+ * opublikowano nową.
+ * @param[in,out] shared - wskaźnik na strukturę procesu czytającego;
+ * @param[in] num        - wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci albo parametr shared ma wartość NULL.
+ */
+PhoneNumbers * phfwdSharedGet(PhoneForwardShared *shared, char const *num);
+
+/** @brief Wyznacza odwrócenie w opublikowanych przekierowaniach.
+ * Działa tak jak @ref phfwdReverse. Przechodzi na bieżącą wersję, jeśli
+ * opublikowano nową.
+ * @param[in,out] shared - wskaźnik na strukturę procesu czytającego;
+ * @param[in] num        - wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci, parametr shared ma wartość NULL lub
+ *         opublikowano strukturę bez drzewa odwróceń.
+ */
+PhoneNumbers * phfwdSharedReverse(PhoneForwardShared *shared, char const *num);
+
+/** @brief Wyznacza przeciwobraz w opublikowanych przekierowaniach.
+ * Działa tak jak @ref phfwdGetReverse. Przechodzi na bieżącą wersję, jeśli
+ * opublikowano nową.
+ * @param[in,out] shared - wskaźnik na strukturę procesu czytającego;
+ * @param[in] num        - wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci, parametr shared ma wartość NULL lub
+ *         opublikowano strukturę bez drzewa odwróceń.
+ */
+PhoneNumbers * phfwdSharedGetReverse(PhoneForwardShared *shared, char const *num);
+
+/** @brief Otwiera przekierowania przechowywane w zmapowanym pliku.
+ * Tworzy strukturę, której przekierowania są przechowywane w pliku @p path
+ * zmapowanym do pamięci, tworząc go, jeśli nie istnieje. Otwarcie nie
+ * wczytuje przekierowań, więc trwa tyle samo niezależnie od ich liczby,
+ * a plik może być większy niż pamięć operacyjna. Funkcje @ref phfwdAdd
+ * i @ref phfwdRemove zmieniają plik w miejscu; przerwanie procesu w dowolnym
+ * momencie pozostawia w pliku stan sprzed albo po ostatniej operacji.
+ * Jeśli @p durable ma wartość @p true, każda zmiana jest zapisywana na dysk
+ * przed powrotem, więc przetrwa też awarię systemu. Plik może być otwarty
+ * tylko przez jeden proces naraz. Funkcje paczek, migawek, dziennika,
+ * przeglądania i publikowania zwracają dla takiej struktury @p false lub NULL.
+ * Struktura musi być usunięta przez @ref phfwdDelete, które zamyka plik.
+ * @param[in] path    - wskaźnik na napis reprezentujący ścieżkę pliku;
+ * @param[in] durable - czy każda zmiana ma być zapisywana na dysk przed powrotem.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy plik nie jest plikiem
+ *         przekierowań, jest otwarty przez inny proces, nie udało się go
+ *         otworzyć lub alokować pamięci.
+ */
+PhoneForward * phfwdOpenMapped(char const *path, bool durable);
+
+/** @brief Zapisuje na dysk plik przekierowań.
+ * Zapisuje na dysk zmiany pliku otwartego przez @ref phfwdOpenMapped.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli zmiany zostały zapisane.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, struktura nie
+ *         jest przechowywana w pliku lub zapis się nie powiódł.
+ */
+bool phfwdSyncMapped(PhoneForward *pf);
+
+/** @brief Tworzy strukturę przechowującą przekierowania w tablicach haszujących.
+ * Tworzy nową strukturę niezawierającą żadnych przekierowań, która zamiast
+ * drzewa trzyma je w tablicy haszującej indeksowanej długością i cyframi
+ * prefiksu. Funkcja @ref phfwdGet szuka najdłuższego prefiksu binarnie po
+ * długościach, a filtr Blooma każdej długości odrzuca większość prefiksów
+ * bez przekierowań bez odczytu tablicy, więc numery bez przekierowania są
+ * obsługiwane najszybciej. Wyniki wszystkich funkcji są takie same jak dla
+ * struktury utworzonej przez @ref phfwdNew, a @ref phfwdRemove przegląda
+ * tylko przekierowania o tych samych czterech początkowych cyfrach prefiksu
+ * (dla krótszego numeru wszystkie, które się od niego zaczynają). Funkcje @ref phfwdGet i @ref phfwdReverse
+ * zmieniają pamięć podręczną struktury, więc nie mogą być wywoływane
+ * współbieżnie. Funkcje paczek, migawek, dziennika, przeglądania
+ * i publikowania zwracają dla takiej struktury @p false lub NULL.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+PhoneForward * phfwdNewHashed(void);
+
+/** @brief Tworzy zwięzłą, niezmienną kopię przekierowań.
+ * Kopiuje przekierowania struktury @p pf do dwóch drzew trie zapisanych
+ * ciągami bitów LOUDS, które zajmują kilka bitów na węzeł zamiast węzłów
+ * z tablicami synów. Funkcje @ref phfwdGet, @ref phfwdReverse
+ * i @ref phfwdGetReverse dają dla kopii takie same wyniki jak dla
+ * struktury @p pf w chwili kopiowania; @ref phfwdAdd zwraca dla niej
+ * @p false, a @ref phfwdRemove nic nie robi. Jeśli @p pf nie ma drzewa
+ * odwróceń, funkcje odwracające zwracają dla kopii NULL. Kopia nie ma
+ * pamięci podręcznej, więc zapytania mogą być wykonywane współbieżnie.
+ * Funkcje paczek, migawek, dziennika, przeglądania i publikowania zwracają
+ * dla niej @p false lub NULL.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy parametr pf ma
+ *         wartość NULL, struktura nie przechowuje przekierowań w drzewie,
+ *         kopia miałaby co najmniej 2^32 - 1 bitów w jednym ciągu lub nie
+ *         udało się alokować pamięci.
+ */
+PhoneForward * phfwdFreeze(PhoneForward const *pf);
+
+/** @brief Układa węzły drzew w pamięci w kolejności przechodzenia.
+ * Przenosi węzły drzewa przekierowań, a po nich węzły drzewa odwróceń, tak
+ * aby zajmowały kolejne miejsca w pamięci w porządku prefiksowym, w jakim
+ * przechodzą je wyszukiwania i przeglądanie. Po wielu dodaniach i usunięciach
+ * węzły sąsiednie w drzewie leżą wtedy znowu obok siebie, jak po wczytaniu
+ * struktury od nowa. Porządkowanie może być wykonywane po kawałku: każde
+ * wywołanie przenosi co najwyżej @p budget węzłów i kontynuuje od miejsca,
+ * w którym skończyło poprzednie. Jeśli drzewa zmieniły się między wywołaniami,
+ * porządkowanie zaczyna się od początku, ale węzły leżące już na swoich
+ * miejscach nie są przenoszone. Najpierw zwalnia, tak jak @ref phfwdReclaim,
+ * co najwyżej @p budget węzłów odłączonych przez usuwanie przyrostowe
+ * i porządkuje dopiero wtedy, gdy nie ma już takich węzłów. Nie alokuje pamięci.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] budget - maksymalna liczba przenoszonych węzłów; 0 oznacza wszystkie.
+ * @return Wartość @p true, jeśli wszystkie węzły leżą w kolejności przechodzenia.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdCompact(PhoneForward *pf, size_t budget);
+
+/** @brief Prosi system o trzymanie węzłów drzew w dużych stronach pamięci.
+ * Włącza przezroczyste duże strony dla pamięci węzłów drzew struktury, także
+ * przydzielanej później. Węzły ułożone przez @ref phfwdCompact mieszczą się
+ * wtedy w mniejszej liczbie stron, co zmniejsza liczbę chybień w buforze TLB.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli system przyjął prośbę.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, struktura nie
+ *         przechowuje przekierowań w drzewie lub system nie obsługuje dużych stron.
+ */
+bool phfwdUseHugePages(PhoneForward *pf);
+
+/** @brief Przydziela z góry pamięć na węzły drzew i wpisy list.
+ * Tworzy segmenty puli mieszczące co najmniej @p nodes nowych węzłów drzew
+ * oraz przydziela węzły list na wpisy przekierowań i odwróceń zajmujące
+ * łącznie około @p bytes bajtów, tak aby późniejsze dodawanie przekierowań
+ * rzadziej alokowało pamięć. Węzły drzew i wpisy list zwolnione przez
+ * @ref phfwdRemove są używane ponownie przez @ref phfwdAdd, więc usuwanie
+ * i ponowne dodawanie przekierowań też rzadko alokuje i zwalnia pamięć.
+ * Zwolnionych wpisów list czeka na ponowne użycie ograniczona liczba; pozostałe
+ * są od razu oddawane alokatorowi.
+ * Dla struktury, która nie przechowuje przekierowań w drzewie, nic nie robi.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] nodes - liczba węzłów drzew;
+ * @param[in] bytes - liczba bajtów na wpisy list.
+ * @return Wartość @p true, jeśli pamięć została przydzielona.
+ *         Wartość @p false, jeśli parametr pf ma wartość NULL, struktura nie
+ *         przechowuje przekierowań w drzewie lub nie udało się alokować
+ *         pamięci; pamięć przydzielona przed niepowodzeniem zostaje w strukturze.
+ */
+bool phfwdReserve(PhoneForward *pf, size_t nodes, size_t bytes);
+
+/** @brief Oddaje systemowi nieużywaną pamięć struktury.
+ * Najpierw zwalnia, tak jak @ref phfwdReclaim, wszystkie węzły odłączone
+ * przez usuwanie przyrostowe. Potem zwalnia wpisy list czekające na ponowne
+ * użycie, segmenty puli węzłów, w których nie ma już żadnego węzła, i strony
+ * za ostatnim używanym węzłem. Najwięcej pamięci oddaje po pełnym
+ * uporządkowaniu drzew przez @ref phfwdCompact, które zbiera używane węzły
+ * na początku puli. Nie alokuje pamięci.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Liczba bajtów oddanych systemowi lub alokatorowi albo 0, gdy
+ *         parametr pf ma wartość NULL lub struktura nie przechowuje
+ *         przekierowań w drzewie.
+ */
+size_t phfwdTrim(PhoneForward *pf);
+
 #endif /* __PHONE_FORWARD_H__ */
\ No newline at end of file
@@ -0,0 +1,483 @@
+/** @file
+ * Pomiar szybkości funkcji wektorowych
+ *
+ * Porównuje funkcje z @ref phfwd_simd.h dla każdego zestawu instrukcji
+ * obsługiwanego przez procesor z wcześniejszymi implementacjami
+ * przetwarzającymi numery znak po znaku. Mierzy długie numery (jak w teście
+ * very_long) i wiele krótkich. Porównania dotyczą par numerów o wspólnym
+ * prefiksie obejmującym cały krótszy numer lub wszystkie cyfry oprócz
+ * ostatniej. Przed pomiarem sprawdza, czy wszystkie implementacje dają te
+ * same wyniki.
+ *
+ * Użycie: phone_forward_bench [-r powtórzenia] [-l długość] [-c liczba krótkich numerów]
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include "phfwd_simd.h"
+#include "packed_number.h"
+
+/**
+ * To jest liczba długich numerów.
+ */
+#define LONG_NUMBERS 8
+
+/**
+ * To jest liczba cyfr krótkiego numeru.
+ */
+#define SHORT_DIGITS 12
+
+/**
+ * To jest zestaw numerów, na których wykonywany jest pomiar.
+ */
+typedef struct Workload {
+    char const *name; ///< nazwa zestawu
+    char **numbers; ///< numery
+    char **others; ///< numery porównywane z numerami o tym samym indeksie
+    size_t count; ///< liczba numerów
+    size_t length; ///< liczba cyfr każdego numeru
+    unsigned char *packed; ///< bufor na spakowany numer
+} Workload;
+
+/**
+ * To jest mierzona funkcja. Przetwarza wszystkie numery zestawu i zwraca
+ * sumę kontrolną wyników; pełną tylko wtedy, gdy drugi argument ma wartość
+ * @p true, aby jej liczenie nie wpływało na pomiar.
+ */
+typedef uint64_t (*BenchFunction)(Workload const *w, bool verify);
+
+/** @brief Zwraca bieżący czas.
+ * @return Czas monotoniczny w nanosekundach.
+ */
+static uint64_t now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+/** @brief Sprawdza, czy napis reprezentuje numer, tak jak wcześniejsza implementacja.
+ * @param[in] num - wskaźnik na napis
+ * @return Wartość @p true, jeśli napis reprezentuje numer.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool baselineOnlyDigits(char const *num) {
+    char const *help = num;
+    if (*help == '\0') {
+        return false;
+    }
+    while (isdigit((int)(*help)) || (*help == '*') || (*help == '#')) {
+        ++help;
+    }
+    return *help == '\0';
+}
+
+/** @brief Wyznacza długość napisu, tak jak wcześniejsza implementacja.
+ * @param[in] num - wskaźnik na napis
+ * @return Liczba znaków napisu.
+ */
+static size_t baselineHowLong(char const *num) {
+    size_t i = 0;
+    while (num[i] != '\0') {
+        ++i;
+    }
+    return i;
+}
+
+/** @brief Zwraca wartość cyfry, tak jak wcześniejsza implementacja.
+ * @param[in] c - znak reprezentujący cyfrę
+ * @return Liczba całkowita z zakresu od 0 do 11.
+ */
+static int baselineCharValue(char c) {
+    if (c == '*') {
+        return 10;
+    }
+    else if (c == '#') {
+        return 11;
+    }
+    else {
+        return (int)c - (int)'0';
+    }
+}
+
+/** @brief Pakuje numer, tak jak wcześniejsza implementacja.
+ * @param[out] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] num - wskaźnik na napis reprezentujący numer
+ * @param[in] length - liczba pakowanych cyfr
+ */
+static void baselinePack(unsigned char *digits, char const *num, size_t length) {
+    size_t i = 0;
+    while (i + 1 < length) {
+        digits[i / 2] = (unsigned char)(((baselineCharValue(num[i]) + 1) << 4) | (baselineCharValue(num[i + 1]) + 1));
+        i += 2;
+    }
+    if (i < length) {
+        digits[i / 2] = (unsigned char)((baselineCharValue(num[i]) + 1) << 4);
+    }
+}
+
+/** @brief Wyznacza sumę kontrolną spakowanego numeru.
+ * @param[in] digits - wskaźnik na tablicę spakowanych cyfr
+ * @param[in] size - liczba bajtów
+ * @return Suma kontrolna FNV-1a.
+ */
+static uint64_t packedChecksum(unsigned char const *digits, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ digits[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/** @brief Porównuje numery, tak jak wcześniejsza implementacja.
+ * @param[in] num1 - wskaźnik na napis reprezentujący pierwszy numer
+ * @param[in] num2 - wskaźnik na napis reprezentujący drugi numer
+ * @return Wartość @p 0, gdy numery są równe, wartość @p 1, gdy pierwszy numer jest większy, a @p -1, gdy mniejszy.
+ */
+static int baselineCompare(char const *num1, char const *num2) {
+    while ((*num1 != '\0') && (*num2 != '\0') && (*num1 == *num2)) {
+        ++num1;
+        ++num2;
+    }
+    if ((*num1 == '\0') && (*num2 == '\0')) {
+        return 0;
+    }
+    else if (*num1 == '\0') {
+        return -1;
+    }
+    else if (*num2 == '\0') {
+        return 1;
+    }
+    return (baselineCharValue(*num1) > baselineCharValue(*num2)) ? 1 : -1;
+}
+
+/** @brief Sprawdza, czy napisy są różne, tak jak wcześniejsza implementacja.
+ * @param[in] num1 - wskaźnik na pierwszy napis
+ * @param[in] num2 - wskaźnik na drugi napis
+ * @return Wartość @p true, jeśli napisy są różne.
+ *         Wartość @p false, jeśli napisy są równe.
+ */
+static bool baselineDiffer(char const *num1, char const *num2) {
+    while ((*num1 == *num2) && (*num1 != '\0') && (*num2 != '\0')) {
+        ++num1;
+        ++num2;
+    }
+    return (*num1 != '\0') || (*num2 != '\0');
+}
+
+/** @brief Sprawdza numery i wyznacza ich długość wcześniejszymi funkcjami.
+ * @param[in] w - wskaźnik na zestaw numerów
+ * @param[in] verify - nieużywany
+ * @return Suma długości poprawnych numerów.
+ */
+static uint64_t baselineValidate(Workload const *w, bool verify) {
+    (void)verify;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < w->count; ++i) {
+        if (baselineOnlyDigits(w->numbers[i])) {
+            sum += baselineHowLong(w->numbers[i]);
+        }
+    }
+    return sum;
+}
+
+/** @brief Sprawdza numery i wyznacza ich długość funkcją @ref validNumberLength.
+ * @param[in] w - wskaźnik na zestaw numerów
+ * @param[in] verify - nieużywany
+ * @return Suma długości poprawnych numerów.
+ */
+static uint64_t simdValidate(Workload const *w, bool verify) {
+    (void)verify;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < w->count; ++i) {
+        sum += validNumberLength(w->numbers[i]);
+    }
+    return sum;
+}
+
+/** @brief Pakuje numery wcześniejszą funkcją.
+ * @param[in] w - wskaźnik na zestaw numerów
+ * @param[in] verify - czy liczyć sumę kontrolną wszystkich bajtów
+ * @return Suma kontrolna spakowanych numerów.
+ */
+static uint64_t baselineEncode(Workload const *w, bool verify) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < w->count; ++i) {
+        baselinePack(w->packed, w->numbers[i], w->length);
+        sum += verify ? packedChecksum(w->packed, packedSize(w->length)) : w->packed[0];
+    }
+    return sum;
+}
+
+/** @brief Pakuje numery funkcją @ref encodePacked.
+ * @param[in] w - wskaźnik na zestaw numerów
+ * @param[in] verify - czy liczyć sumę kontrolną wszystkich bajtów
+ * @return Suma kontrolna spakowanych numerów.
+ */
+static uint64_t simdEncode(Workload const *w, bool verify) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < w->count; ++i) {
+        if (encodePacked(w->packed, w->numbers[i], w->length)) {
+            sum += verify ? packedChecksum(w->packed, packedSize(w->length)) : w->packed[0];
+        }
+    }
+    return sum;
+}
+
+/** @brief Porównuje pary numerów wcześniejszą funkcją.
+ * @param[in] w - wskaźnik na zestaw numerów
+ * @param[in] verify - nieużywany
+ * @return Suma kontrolna wyników porównań.
+ */
+static uint64_t baselineOrder(Workload const *w, bool verify) {
+    (void)verify;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < w->count; ++i) {
+        sum = sum * 3 + (uint64_t)(baselineCompare(w->numbers[i], w->others[i]) + 1);
+    }
+    return sum;
+}
+
+/** @brief Porównuje pary numerów funkcją @ref compareNumberStrings.
+ * @param[in] w - wskaźnik na zestaw numerów
+ * @param[in] verify - nieużywany
+ * @return Suma kontrolna wyników porównań.
+ */
+static uint64_t simdOrder(Workload const *w, bool verify) {
+    (void)verify;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < w->count; ++i) {
+        sum = sum * 3 + (uint64_t)(compareNumberStrings(w->numbers[i], w->others[i]) + 1);
+    }
+    return sum;
+}
+
+/** @brief Sprawdza wcześniejszą funkcją, czy numery w parach są różne.
+ * @param[in] w - wskaźnik na zestaw numerów
+ * @param[in] verify - nieużywany
+ * @return Suma kontrolna wyników.
+ */
+static uint64_t baselineDifferent(Workload const *w, bool verify) {
+    (void)verify;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < w->count; ++i) {
+        sum = sum * 2 + baselineDiffer(w->numbers[i], w->others[i]);
+    }
+    return sum;
+}
+
+/** @brief Sprawdza funkcją @ref firstDifference, czy numery w parach są różne.
+ * @param[in] w - wskaźnik na zestaw numerów
+ * @param[in] verify - nieużywany
+ * @return Suma kontrolna wyników.
+ */
+static uint64_t simdDifferent(Workload const *w, bool verify) {
+    (void)verify;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < w->count; ++i) {
+        size_t d = firstDifference(w->numbers[i], w->others[i]);
+        sum = sum * 2 + (w->numbers[i][d] != w->others[i][d]);
+    }
+    return sum;
+}
+
+/**
+ * To jest mierzona operacja: wcześniejsza implementacja i funkcja wektorowa.
+ */
+typedef struct BenchOperation {
+    char const *name; ///< nazwa operacji
+    BenchFunction baseline; ///< wcześniejsza implementacja
+    BenchFunction simd; ///< implementacja korzystająca z funkcji wektorowych
+} BenchOperation;
+
+/**
+ * To są mierzone operacje.
+ */
+static BenchOperation const operations[] = {
+    {"validate", baselineValidate, simdValidate},
+    {"encode", baselineEncode, simdEncode},
+    {"compare", baselineOrder, simdOrder},
+    {"differ", baselineDifferent, simdDifferent}
+};
+
+/** @brief Zwraca przesunięcie drugiego numeru pary względem wyrównania.
+ * @param[in] i - indeks pary
+ * @return Liczba z zakresu od 0 do 31.
+ */
+static size_t otherOffset(size_t i) {
+    return (i * 7 + 3) % 32;
+}
+
+/** @brief Tworzy zestaw numerów.
+ * @param[out] w - wskaźnik na zestaw
+ * @param[in] name - nazwa zestawu
+ * @param[in] count - liczba numerów
+ * @param[in] length - liczba cyfr każdego numeru
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool makeWorkload(Workload *w, char const *name, size_t count, size_t length) {
+    static char const alphabet[] = "0123456789*#";
+    w->name = name;
+    w->count = count;
+    w->length = length;
+    w->numbers = calloc(count, sizeof(char *));
+    w->others = calloc(count, sizeof(char *));
+    w->packed = malloc(packedSize(length) + 1);
+    if ((w->numbers == NULL) || (w->others == NULL) || (w->packed == NULL)) {
+        return false;
+    }
+    uint64_t random = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < count; ++i) {
+        // Numery zaczynają się w różnych miejscach względem wyrównania.
+        size_t offset = i % 32;
+        char *number = malloc(length + offset + 1);
+        if (number == NULL) {
+            return false;
+        }
+        w->numbers[i] = number + offset;
+        for (size_t j = 0; j < length; ++j) {
+            random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+            w->numbers[i][j] = alphabet[(random >> 33) % 12];
+        }
+        w->numbers[i][length] = '\0';
+
+        // Drugi numer pary ma inne wyrównanie. Jest równy pierwszemu, jest
+        // jego prefiksem krótszym o jedną cyfrę albo różni się ostatnią cyfrą.
+        char *other = malloc(length + otherOffset(i) + 1);
+        if (other == NULL) {
+            return false;
+        }
+        w->others[i] = other + otherOffset(i);
+        memcpy(w->others[i], w->numbers[i], length + 1);
+        if (i % 3 == 1) {
+            w->others[i][length - 1] = '\0';
+        }
+        else if (i % 3 == 2) {
+            char last = w->others[i][length - 1];
+            w->others[i][length - 1] = alphabet[(strchr(alphabet, last) - alphabet + 1 + i % 11) % 12];
+        }
+    }
+    return true;
+}
+
+/** @brief Zwalnia zestaw numerów.
+ * @param[in] w - wskaźnik na zestaw
+ */
+static void freeWorkload(Workload *w) {
+    for (size_t i = 0; (w->numbers != NULL) && (i < w->count); ++i) {
+        if (w->numbers[i] != NULL) {
+            free(w->numbers[i] - i % 32);
+        }
+        if ((w->others != NULL) && (w->others[i] != NULL)) {
+            free(w->others[i] - otherOffset(i));
+        }
+    }
+    free(w->numbers);
+    free(w->others);
+    free(w->packed);
+}
+
+/** @brief Mierzy funkcję.
+ * @param[in] f - mierzona funkcja
+ * @param[in] w - wskaźnik na zestaw numerów
+ * @param[in] rounds - liczba powtórzeń
+ * @param[out] checksum - pełna suma kontrolna wyników
+ * @return Najkrótszy czas jednego powtórzenia w nanosekundach.
+ */
+static uint64_t measure(BenchFunction f, Workload const *w, size_t rounds, uint64_t *checksum) {
+    uint64_t best = UINT64_MAX;
+    *checksum = f(w, true);
+    for (size_t r = 0; r < rounds; ++r) {
+        uint64_t start = now();
+        f(w, false);
+        uint64_t elapsed = now() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+/** @brief Wypisuje wynik pomiaru.
+ * @param[in] operation - nazwa operacji
+ * @param[in] w - wskaźnik na zestaw numerów
+ * @param[in] variant - nazwa implementacji
+ * @param[in] elapsed - czas jednego powtórzenia w nanosekundach
+ * @param[in] baseline - czas jednego powtórzenia wcześniejszej implementacji
+ */
+static void report(char const *operation, Workload const *w, char const *variant, uint64_t elapsed, uint64_t baseline) {
+    double bytes = (double)w->count * (double)w->length;
+    printf("%-9s %-6s %-9s %10.1f ns/number %8.2f GB/s %6.2fx\n", operation, w->name, variant,
+           (double)elapsed / (double)w->count, bytes / (double)(elapsed ? elapsed : 1),
+           (double)baseline / (double)(elapsed ? elapsed : 1));
+}
+
+int main(int argc, char *argv[]) {
+    size_t rounds = 20;
+    size_t long_length = 250000;
+    size_t short_count = 200000;
+    int option;
+    bool usage = false;
+    while ((option = getopt(argc, argv, "r:l:c:")) != -1) {
+        switch (option) {
+            case 'r':
+                rounds = strtoull(optarg, NULL, 10);
+                break;
+            case 'l':
+                long_length = strtoull(optarg, NULL, 10);
+                break;
+            case 'c':
+                short_count = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                usage = true;
+                break;
+        }
+    }
+    if (usage || (optind != argc) || (rounds == 0) || (long_length == 0) || (short_count == 0)) {
+        fprintf(stderr, "usage: %s [-r rounds] [-l long length] [-c short count]\n", argv[0]);
+        return 2;
+    }
+
+    Workload workloads[2];
+    memset(workloads, 0, sizeof(workloads));
+    bool result = makeWorkload(&workloads[0], "long", LONG_NUMBERS, long_length)
+                  && makeWorkload(&workloads[1], "short", short_count, SHORT_DIGITS);
+    SimdLevel best = simdLevel();
+    for (size_t o = 0; result && (o < sizeof(operations) / sizeof(operations[0])); ++o) {
+        for (size_t k = 0; result && (k < sizeof(workloads) / sizeof(workloads[0])); ++k) {
+            Workload const *w = &workloads[k];
+            uint64_t expected, checksum;
+            uint64_t baseline = measure(operations[o].baseline, w, rounds, &expected);
+            report(operations[o].name, w, "baseline", baseline, baseline);
+            for (int level = SIMD_SCALAR; level < SIMD_LEVELS; ++level) {
+                if (!simdSetLevel((SimdLevel)level)) {
+                    continue;
+                }
+                uint64_t elapsed = measure(operations[o].simd, w, rounds, &checksum);
+                if (checksum != expected) {
+                    fprintf(stderr, "%s %s %s: results differ from baseline\n",
+                            operations[o].name, w->name, simdLevelName((SimdLevel)level));
+                    result = false;
+                }
+                report(operations[o].name, w, simdLevelName((SimdLevel)level), elapsed, baseline);
+            }
+            simdSetLevel(best);
+        }
+    }
+    freeWorkload(&workloads[0]);
+    freeWorkload(&workloads[1]);
+    return result ? 0 : 1;
+}
@@ -0,0 +1,552 @@
+/** @file
+ * Porównanie silników przechowujących przekierowania
+ *
+ * Wykonuje ten sam losowy ciąg operacji na każdym silniku: dodaje
+ * przekierowania, wyznacza przekierowania numerów, które mają przekierowany
+ * prefiks i które go nie mają, wyznacza odwrócenia i przeciwobrazy, a na
+ * końcu usuwa część prefiksów. Dla każdej fazy sprawdza, czy wszystkie
+ * silniki dały te same wyniki, i wypisuje czas operacji względem drzewa oraz
+ * pamięć zajętą po dodaniu przekierowań. Pamięć silnika w zmapowanym pliku
+ * to rozmiar pliku. Zwięzła kopia jest tworzona z drzewa po dodaniu
+ * przekierowań, a drzewo jest od razu usuwane; kopii nie można zmieniać,
+ * więc jej faza usuwania nie jest mierzona. Jeśli system udostępnia liczniki
+ * sprzętowe, dla każdej fazy wypisywana jest też liczba chybień w pamięci
+ * podręcznej ostatniego poziomu na operację. Drzewo jest mierzone także
+ * z dodaniami i usunięciami wykonywanymi jedną paczką przez
+ * @ref phfwdApplyBatch, co porównuje paczkę z pętlą pojedynczych wywołań.
+ * Na końcu mierzy dodawanie i usuwanie coraz większej liczby przekierowań na
+ * jeden numer i, dla porównania, na 1000 różnych numerów; czas na operację
+ * w obu przypadkach powinien rosnąć z liczbą przekierowań tak samo.
+ *
+ * Użycie: phone_forward_engines [-n przekierowania] [-q zapytania] [-s ziarno]
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "phone_forward.h"
+
+/**
+ * To jest największa liczba cyfr numeru w zestawie.
+ */
+#define MAX_DIGITS 24
+
+/**
+ * To jest liczba faz pomiaru.
+ */
+#define PHASES 6
+
+/**
+ * To jest silnik, na którym wykonywany jest pomiar.
+ */
+typedef struct Engine {
+    char const *name; ///< nazwa silnika
+    PhoneForward * (*create)(char const *path); ///< funkcja tworząca pustą strukturę
+    bool frozen; ///< czy po dodaniu przekierowań struktura jest zastępowana zwięzłą kopią
+    bool batched; ///< czy dodania i usunięcia są wykonywane jedną paczką
+} Engine;
+
+/**
+ * To jest zestaw operacji wykonywanych na każdym silniku.
+ */
+typedef struct Workload {
+    char (*sources)[MAX_DIGITS + 1]; ///< prefiksy przekierowywane
+    char (*targets)[MAX_DIGITS + 1]; ///< prefiksy, na które są przekierowania
+    size_t forwards; ///< liczba przekierowań
+    char (*hits)[MAX_DIGITS + 1]; ///< numery z przekierowanym prefiksem
+    char (*misses)[MAX_DIGITS + 1]; ///< numery bez przekierowanego prefiksu
+    size_t queries; ///< liczba numerów każdego rodzaju
+    size_t reverses; ///< liczba zapytań o odwrócenia i przeciwobrazy
+    size_t removes; ///< liczba usuwanych prefiksów
+} Workload;
+
+/**
+ * To jest wynik pomiaru jednego silnika.
+ */
+typedef struct Result {
+    uint64_t elapsed[PHASES]; ///< czas każdej fazy w nanosekundach
+    uint64_t checksum[PHASES]; ///< suma kontrolna wyników każdej fazy
+    uint64_t misses[PHASES]; ///< liczba chybień w pamięci podręcznej w każdej fazie lub UINT64_MAX, gdy licznik jest niedostępny
+    size_t memory; ///< liczba bajtów zajętych po dodaniu przekierowań
+} Result;
+
+/**
+ * To są nazwy faz pomiaru.
+ */
+static char const *const phase_names[PHASES] = {
+    "add", "get hit", "get miss", "reverse", "getReverse", "remove"
+};
+
+/**
+ * To jest stan generatora liczb losowych.
+ */
+static uint64_t random_state = 1;
+
+/** @brief Zwraca kolejną liczbę losową.
+ * @return Liczba losowa generatora xorshift64*.
+ */
+static uint64_t nextRandom(void) {
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return random_state * 0x2545F4914F6CDD1DULL;
+}
+
+/** @brief Zapisuje losowe cyfry.
+ * @param[out] num - wskaźnik na tablicę znaków
+ * @param[in] length - liczba cyfr
+ * @param[in] alphabet - napis zawierający dozwolone cyfry
+ */
+static void randomDigits(char *num, size_t length, char const *alphabet) {
+    size_t size = strlen(alphabet);
+    for (size_t i = 0; i < length; ++i) {
+        num[i] = alphabet[nextRandom() % size];
+    }
+    num[length] = '\0';
+}
+
+/** @brief Zwraca bieżący czas.
+ * @return Czas monotoniczny w nanosekundach.
+ */
+static uint64_t now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+/**
+ * To jest deskryptor licznika chybień w pamięci podręcznej lub -1, gdy licznik jest niedostępny.
+ */
+static int miss_counter = -1;
+
+/** @brief Otwiera licznik chybień w pamięci podręcznej bieżącego procesu.
+ * Licznik jest wyłączony do pierwszego wywołania @ref startMisses.
+ */
+static void openMisses(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    miss_counter = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/** @brief Zeruje i włącza licznik chybień w pamięci podręcznej.
+ */
+static void startMisses(void) {
+    if (miss_counter >= 0) {
+        ioctl(miss_counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(miss_counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+/** @brief Wyłącza licznik chybień w pamięci podręcznej i odczytuje jego wartość.
+ * @return Liczba chybień od wywołania @ref startMisses lub UINT64_MAX, gdy
+ *         licznik jest niedostępny.
+ */
+static uint64_t stopMisses(void) {
+    uint64_t count;
+    if ((miss_counter < 0) || (ioctl(miss_counter, PERF_EVENT_IOC_DISABLE, 0) != 0)
+        || (read(miss_counter, &count, sizeof(count)) != (ssize_t)sizeof(count))) {
+        return UINT64_MAX;
+    }
+    return count;
+}
+
+/** @brief Zwraca liczbę bajtów zajętych na stercie.
+ * @return Liczba bajtów przydzielonych przez malloc.
+ */
+static size_t heapInUse(void) {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+/** @brief Dopisuje ciąg numerów do sumy kontrolnej i go usuwa.
+ * @param[in] hash - suma kontrolna
+ * @param[in] pnum - wskaźnik na ciąg numerów lub NULL
+ * @return Suma kontrolna FNV-1a po dopisaniu numerów.
+ */
+static uint64_t addNumbers(uint64_t hash, PhoneNumbers *pnum) {
+    char const *num;
+    for (size_t i = 0; (num = phnumGet(pnum, i)) != NULL; ++i) {
+        for (; *num != '\0'; ++num) {
+            hash = (hash ^ (unsigned char)*num) * 1099511628211ULL;
+        }
+        hash = (hash ^ ',') * 1099511628211ULL;
+    }
+    hash = (hash ^ (pnum == NULL ? '!' : ';')) * 1099511628211ULL;
+    phnumDelete(pnum);
+    return hash;
+}
+
+/** @brief Tworzy zestaw operacji.
+ * Prefiksy przekierowywane zaczynają się od cyfr od 1 do 4, a numery bez
+ * przekierowania od cyfr od 5 do 9.
+ * @param[out] w - wskaźnik na zestaw
+ * @param[in] forwards - liczba przekierowań
+ * @param[in] queries - liczba zapytań każdego rodzaju
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool makeWorkload(Workload *w, size_t forwards, size_t queries) {
+    w->forwards = forwards;
+    w->queries = queries;
+    w->reverses = queries / 10;
+    w->removes = forwards / 10;
+    w->sources = malloc(forwards * sizeof(*w->sources));
+    w->targets = malloc(forwards * sizeof(*w->targets));
+    w->hits = malloc(queries * sizeof(*w->hits));
+    w->misses = malloc(queries * sizeof(*w->misses));
+    if ((w->sources == NULL) || (w->targets == NULL) || (w->hits == NULL) || (w->misses == NULL)) {
+        return false;
+    }
+    for (size_t i = 0; i < forwards; ++i) {
+        randomDigits(w->sources[i], 4 + nextRandom() % 6, "0123456789");
+        w->sources[i][0] = (char)('1' + nextRandom() % 4);
+        randomDigits(w->targets[i], 3 + nextRandom() % 5, "0123456789*#");
+    }
+    for (size_t i = 0; i < queries; ++i) {
+        char const *source = w->sources[nextRandom() % forwards];
+        size_t length = strlen(source);
+        memcpy(w->hits[i], source, length);
+        randomDigits(w->hits[i] + length, 12 - (length < 12 ? length : 11), "0123456789");
+        randomDigits(w->misses[i], 12, "0123456789");
+        w->misses[i][0] = (char)('5' + nextRandom() % 5);
+    }
+    return true;
+}
+
+/** @brief Zwalnia zestaw operacji.
+ * @param[in,out] w - wskaźnik na zestaw
+ */
+static void freeWorkload(Workload *w) {
+    free(w->sources);
+    free(w->targets);
+    free(w->hits);
+    free(w->misses);
+}
+
+/** @brief Tworzy strukturę przechowującą przekierowania w drzewie.
+ * @param[in] path - nieużywana ścieżka pliku
+ * @return Wskaźnik na utworzoną strukturę lub NULL.
+ */
+static PhoneForward * createTree(char const *path) {
+    (void)path;
+    return phfwdNew();
+}
+
+/** @brief Tworzy strukturę bez drzewa odwróceń, które jest budowane przed zapytaniami.
+ * @param[in] path - nieużywana ścieżka pliku
+ * @return Wskaźnik na utworzoną strukturę lub NULL.
+ */
+static PhoneForward * createForwardOnly(char const *path) {
+    (void)path;
+    return phfwdNewForwardOnly();
+}
+
+/** @brief Tworzy strukturę przechowującą przekierowania w tablicach haszujących.
+ * @param[in] path - nieużywana ścieżka pliku
+ * @return Wskaźnik na utworzoną strukturę lub NULL.
+ */
+static PhoneForward * createHashed(char const *path) {
+    (void)path;
+    return phfwdNewHashed();
+}
+
+/** @brief Tworzy strukturę przechowującą przekierowania w zmapowanym pliku.
+ * @param[in] path - ścieżka pliku
+ * @return Wskaźnik na utworzoną strukturę lub NULL.
+ */
+static PhoneForward * createMapped(char const *path) {
+    unlink(path);
+    return phfwdOpenMapped(path, false);
+}
+
+/**
+ * To są porównywane silniki; pierwszy jest punktem odniesienia.
+ */
+static Engine const engines[] = {
+    {"tree", createTree, false, false},
+    {"tree_batch", createTree, false, true},
+    {"forward_only", createForwardOnly, false, false},
+    {"hashed", createHashed, false, false},
+    {"mapped", createMapped, false, false},
+    {"succinct", createTree, true, false},
+};
+
+/** @brief Wykonuje jedną paczką dodania lub usunięcia przekierowań z zestawu.
+ * Dopisuje do sumy kontrolnej wynik paczki raz dla każdej operacji, tak jak
+ * pętla wywołań @ref phfwdAdd dopisuje wynik każdego wywołania.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in] w - wskaźnik na zestaw
+ * @param[in,out] operations - tablica na operacje o rozmiarze co najmniej liczby przekierowań
+ * @param[in] type - rodzaj operacji
+ * @param[in] count - liczba operacji
+ * @param[in] hash - suma kontrolna
+ * @return Suma kontrolna po dopisaniu wyników operacji.
+ */
+static uint64_t applyBatch(PhoneForward *pf, Workload const *w, PhoneForwardOperation *operations,
+                           PhoneForwardOperationType type, size_t count, uint64_t hash) {
+    for (size_t i = 0; i < count; ++i) {
+        operations[i].type = type;
+        operations[i].num1 = w->sources[i];
+        operations[i].num2 = w->targets[i];
+    }
+    uint64_t result = (uint64_t)phfwdApplyBatch(pf, operations, count);
+    for (size_t i = 0; i < count; ++i) {
+        hash = (hash ^ result) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/** @brief Wykonuje zestaw operacji na jednym silniku.
+ * @param[in] engine - wskaźnik na silnik
+ * @param[in] w - wskaźnik na zestaw
+ * @param[in] path - ścieżka pliku dla silnika w zmapowanym pliku
+ * @param[out] r - wskaźnik na wynik
+ * @return Wartość @p true, jeśli udało się utworzyć strukturę.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool runEngine(Engine const *engine, Workload const *w, char const *path, Result *r) {
+    size_t heap = heapInUse();
+    PhoneForward *pf = engine->create(path);
+    if (pf == NULL) {
+        return false;
+    }
+    PhoneForwardOperation *operations = NULL;
+    if (engine->batched && ((operations = malloc(w->forwards * sizeof(*operations))) == NULL)) {
+        phfwdDelete(pf);
+        return false;
+    }
+    uint64_t hash = 14695981039346656037ULL;
+    startMisses();
+    uint64_t start = now();
+    if (engine->batched) {
+        hash = applyBatch(pf, w, operations, PHFWD_ADD, w->forwards, hash);
+    }
+    else {
+        for (size_t i = 0; i < w->forwards; ++i) {
+            hash = (hash ^ (uint64_t)phfwdAdd(pf, w->sources[i], w->targets[i])) * 1099511628211ULL;
+        }
+    }
+    if (engine->create == createForwardOnly) {
+        phfwdBuildReverseIndex(pf);
+    }
+    if (engine->frozen) {
+        PhoneForward *copy = phfwdFreeze(pf);
+        phfwdDelete(pf);
+        if (copy == NULL) {
+            free(operations);
+            return false;
+        }
+        pf = copy;
+    }
+    r->elapsed[0] = now() - start;
+    r->misses[0] = stopMisses();
+    r->checksum[0] = hash;
+    r->memory = heapInUse() - heap;
+    struct stat st;
+    if ((engine->create == createMapped) && (stat(path, &st) == 0)) {
+        r->memory += (size_t)st.st_size;
+    }
+
+    char (*const numbers[2])[MAX_DIGITS + 1] = {w->hits, w->misses};
+    for (int k = 0; k < 2; ++k) {
+        hash = 14695981039346656037ULL;
+        startMisses();
+        start = now();
+        for (size_t i = 0; i < w->queries; ++i) {
+            hash = addNumbers(hash, phfwdGet(pf, numbers[k][i]));
+        }
+        r->elapsed[1 + k] = now() - start;
+        r->misses[1 + k] = stopMisses();
+        r->checksum[1 + k] = hash;
+    }
+    for (int k = 0; k < 2; ++k) {
+        hash = 14695981039346656037ULL;
+        startMisses();
+        start = now();
+        for (size_t i = 0; i < w->reverses; ++i) {
+            char const *num = w->hits[i];
+            hash = addNumbers(hash, k == 0 ? phfwdReverse(pf, num) : phfwdGetReverse(pf, num));
+        }
+        r->elapsed[3 + k] = now() - start;
+        r->misses[3 + k] = stopMisses();
+        r->checksum[3 + k] = hash;
+    }
+    hash = 14695981039346656037ULL;
+    startMisses();
+    start = now();
+    if (engine->batched) {
+        applyBatch(pf, w, operations, PHFWD_REMOVE, w->removes, hash);
+    }
+    else {
+        for (size_t i = 0; i < w->removes; ++i) {
+            phfwdRemove(pf, w->sources[i]);
+        }
+    }
+    r->elapsed[5] = now() - start;
+    r->misses[5] = stopMisses();
+    for (size_t i = 0; i < w->reverses; ++i) {
+        hash = addNumbers(hash, phfwdGet(pf, w->hits[i]));
+    }
+    r->checksum[5] = hash;
+    free(operations);
+    phfwdDelete(pf);
+    unlink(path);
+    return true;
+}
+
+/** @brief Zapisuje i-ty z różnych 10-cyfrowych numerów przekierowywanych na jeden numer.
+ * Kolejne numery nie są uporządkowane, więc trafiają w różne miejsca listy odwróceń.
+ * @param[out] num - wskaźnik na tablicę znaków
+ * @param[in] i - indeks numeru, mniejszy niż 1000000000
+ */
+static void oneTargetSource(char *num, size_t i) {
+    snprintf(num, MAX_DIGITS + 1, "1%09zu", (i * 7919u) % 1000000000u);
+}
+
+/** @brief Mierzy dodawanie i usuwanie przekierowań na kilka numerów.
+ * Dodaje przekierowania różnych numerów na numery od 0 do @p targets - 1
+ * z zerem na początku, po co trzecim usuwając jedno z wcześniejszych, a potem
+ * usuwa wszystkie przekierowania.
+ * @param[in] count - liczba przekierowań
+ * @param[in] targets - liczba numerów, na które są przekierowania
+ * @param[out] operations - adres zmiennej, na której zostaje zapisana liczba operacji
+ * @return Czas wszystkich operacji w nanosekundach lub 0, gdy nie udało się utworzyć struktury.
+ */
+static uint64_t runOneTarget(size_t count, size_t targets, size_t *operations) {
+    PhoneForward *pf = phfwdNew();
+    if (pf == NULL) {
+        return 0;
+    }
+    char num[MAX_DIGITS + 1];
+    char target[MAX_DIGITS + 1];
+    uint64_t start = now();
+    for (size_t i = 0; i < count; ++i) {
+        oneTargetSource(num, i);
+        snprintf(target, sizeof(target), "0%zu", i % targets);
+        phfwdAdd(pf, num, target);
+        if (i % 3 == 2) {
+            oneTargetSource(num, i / 2);
+            phfwdRemove(pf, num);
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        oneTargetSource(num, i);
+        phfwdRemove(pf, num);
+    }
+    uint64_t elapsed = now() - start;
+    *operations = 2 * count + count / 3;
+    phfwdDelete(pf);
+    return elapsed;
+}
+
+int main(int argc, char *argv[]) {
+    size_t forwards = 200000;
+    size_t queries = 1000000;
+    int option;
+    bool usage = false;
+    while ((option = getopt(argc, argv, "n:q:s:")) != -1) {
+        switch (option) {
+            case 'n':
+                forwards = strtoull(optarg, NULL, 10);
+                break;
+            case 'q':
+                queries = strtoull(optarg, NULL, 10);
+                break;
+            case 's':
+                random_state = strtoull(optarg, NULL, 10) | 1;
+                break;
+            default:
+                usage = true;
+                break;
+        }
+    }
+    if (usage || (optind != argc) || (forwards < 10) || (queries < 10)) {
+        fprintf(stderr, "usage: %s [-n forwards] [-q queries] [-s seed]\n", argv[0]);
+        return 2;
+    }
+
+    Workload w;
+    memset(&w, 0, sizeof(w));
+    if (!makeWorkload(&w, forwards, queries)) {
+        fprintf(stderr, "out of memory\n");
+        freeWorkload(&w);
+        return 1;
+    }
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/phone_forward_engines_%d.mapped", (int)getpid());
+    size_t const count[PHASES] = {w.forwards, w.queries, w.queries, w.reverses, w.reverses, w.removes};
+    Result results[sizeof(engines) / sizeof(engines[0])];
+    bool result = true;
+    openMisses();
+    printf("%-12s %-10s %12s %8s %10s %12s\n", "engine", "phase", "ns/op", "vs tree", "memory MB", "misses/op");
+    for (size_t e = 0; result && (e < sizeof(engines) / sizeof(engines[0])); ++e) {
+        Result *r = &results[e];
+        if (!runEngine(&engines[e], &w, path, r)) {
+            fprintf(stderr, "%s: cannot create structure\n", engines[e].name);
+            result = false;
+            break;
+        }
+        for (int p = 0; p < PHASES; ++p) {
+            if (engines[e].frozen && (p == PHASES - 1)) {
+                printf("%-12s %-10s %12s\n", engines[e].name, phase_names[p], "n/a");
+                continue;
+            }
+            if (r->checksum[p] != results[0].checksum[p]) {
+                fprintf(stderr, "%s %s: results differ from %s\n", engines[e].name, phase_names[p], engines[0].name);
+                result = false;
+            }
+            printf("%-12s %-10s %12.1f %7.2fx %10.1f", engines[e].name, phase_names[p],
+                   (double)r->elapsed[p] / (double)count[p],
+                   (double)results[0].elapsed[p] / (double)(r->elapsed[p] ? r->elapsed[p] : 1),
+                   (double)r->memory / (1024.0 * 1024.0));
+            if (r->misses[p] == UINT64_MAX) {
+                printf(" %12s\n", "n/a");
+            }
+            else {
+                printf(" %12.2f\n", (double)r->misses[p] / (double)count[p]);
+            }
+        }
+    }
+    printf("\n%-12s %10s %12s %8s %12s\n", "one target", "forwards", "ns/op", "vs 1/4", "1000 targets");
+    double quarter = 0.0;
+    for (size_t part = 4; result && (part >= 1); part /= 2) {
+        size_t operations;
+        uint64_t one = runOneTarget(w.forwards / part, 1, &operations);
+        uint64_t many = runOneTarget(w.forwards / part, 1000, &operations);
+        if ((one == 0) || (many == 0)) {
+            fprintf(stderr, "one target: cannot create structure\n");
+            result = false;
+            break;
+        }
+        double per_operation = (double)one / (double)operations;
+        quarter = (part == 4) ? per_operation : quarter;
+        printf("%-12s %10zu %12.1f %7.2fx %12.1f\n", "tree", w.forwards / part, per_operation,
+               per_operation / quarter, (double)many / (double)operations);
+    }
+    if (miss_counter >= 0) {
+        close(miss_counter);
+    }
+    freeWorkload(&w);
+    return result ? 0 : 1;
+}
@@ -0,0 +1,424 @@
+/** @file
+ * Generator obciążenia serwera przekierowań
+ *
+ * Otwiera kilka połączeń z serwerem @ref phone_forward_server.c, utrzymuje
+ * w każdym z nich zadaną liczbę żądań w drodze i mierzy przepustowość oraz
+ * rozkład czasu od wysłania żądania do odebrania odpowiedzi.
+ *
+ * Użycie: phone_forward_loadgen [-c połączenia] [-n żądania] [-d głębokość]
+ *         [-k klucze] [-a dodania] [-m get|reverse|getreverse|mixed] gniazdo
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "phfwd_protocol.h"
+
+/**
+ * To jest liczba cyfr generowanych numerów.
+ */
+#define NUMBER_DIGITS 9
+
+/**
+ * To jest największy rozmiar żądania wysyłanego przez generator.
+ */
+#define MAX_REQUEST (1 + 2 * (PHFWD_PROTO_NUMBER_HEADER + NUMBER_DIGITS))
+
+/**
+ * To jest rozmiar bufora odbieranych odpowiedzi.
+ */
+#define INPUT_SIZE (1 << 20)
+
+/**
+ * To jest rodzaj generowanego obciążenia.
+ */
+typedef enum LoadMix {
+    MIX_GET, ///< same zapytania o przekierowanie
+    MIX_REVERSE, ///< same zapytania o odwrócenie
+    MIX_GETREVERSE, ///< same zapytania o przeciwobraz
+    MIX_MIXED, ///< 90% zapytań o przekierowanie, 8% o odwrócenie, po 1% dodań i usunięć
+    MIX_LOAD ///< dodania przekierowań z kolejnych numerów
+} LoadMix;
+
+/**
+ * To jest stan jednego połączenia generatora.
+ */
+typedef struct Client {
+    int fd; ///< deskryptor gniazda
+    uint64_t *sent_at; ///< czasy wysłania żądań w drodze, w buforze cyklicznym
+    size_t first; ///< pozycja najstarszego żądania w drodze
+    size_t in_flight; ///< liczba żądań w drodze
+    unsigned char *output; ///< bufor żądań do wysłania
+    size_t output_start; ///< pozycja pierwszego niewysłanego bajtu
+    size_t output_used; ///< pozycja za ostatnim bajtem żądań
+    unsigned char *input; ///< bufor odbieranych odpowiedzi
+    size_t input_used; ///< liczba bajtów w buforze odpowiedzi
+} Client;
+
+/**
+ * To jest stan generatora.
+ */
+typedef struct Generator {
+    size_t depth; ///< liczba żądań w drodze w jednym połączeniu
+    size_t keys; ///< liczba różnych numerów
+    LoadMix mix; ///< rodzaj obciążenia
+    size_t to_send; ///< liczba żądań pozostałych do wysłania
+    size_t received; ///< liczba odebranych odpowiedzi
+    size_t failed; ///< liczba odpowiedzi ze stanem innym niż @ref PHFWD_PROTO_OK
+    uint64_t *latencies; ///< czasy obsługi odebranych żądań w nanosekundach
+    uint64_t random; ///< stan generatora liczb losowych
+    uint64_t next_key; ///< indeks numeru następnego dodania przy wypełnianiu tablicy
+} Generator;
+
+/** @brief Zwraca bieżący czas w nanosekundach.
+ * @return Czas monotoniczny w nanosekundach.
+ */
+static uint64_t now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+/** @brief Zwraca kolejną liczbę pseudolosową.
+ * @param[in,out] g - wskaźnik na stan generatora
+ * @return Liczba pseudolosowa.
+ */
+static uint64_t nextRandom(Generator *g) {
+    // splitmix64
+    uint64_t z = (g->random += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+/** @brief Zapisuje numer o danym indeksie.
+ * @param[out] out - wskaźnik na miejsce na żądanie
+ * @param[in] key - indeks numeru
+ * @param[in] first - pierwsza cyfra numeru
+ * @return Wskaźnik na pierwszy bajt za zapisanym numerem.
+ */
+static unsigned char * putKey(unsigned char *out, uint64_t key, char first) {
+    char num[NUMBER_DIGITS];
+    num[0] = first;
+    for (size_t i = NUMBER_DIGITS - 1; i > 0; --i) {
+        num[i] = (char)('0' + key % 10);
+        key /= 10;
+    }
+    return protoPutNumber(out, num, NUMBER_DIGITS);
+}
+
+/** @brief Zapisuje losowe żądanie.
+ * Przekierowania prowadzą z numerów zaczynających się cyfrą 1 na numery
+ * zaczynające się cyfrą 2.
+ * @param[in,out] g - wskaźnik na stan generatora
+ * @param[out] out - wskaźnik na miejsce o rozmiarze co najmniej @ref MAX_REQUEST
+ * @return Wskaźnik na pierwszy bajt za żądaniem.
+ */
+static unsigned char * putRequest(Generator *g, unsigned char *out) {
+    if (g->mix == MIX_LOAD) {
+        *out++ = PHFWD_PROTO_ADD;
+        out = putKey(out, g->next_key, '1');
+        return putKey(out, g->next_key++, '2');
+    }
+    uint64_t r = nextRandom(g);
+    uint64_t key = (r >> 8) % g->keys;
+    unsigned kind = (unsigned)(r & 0xFF) % 100;
+    PhoneForwardRequestType type = PHFWD_PROTO_GET;
+    switch (g->mix) {
+        case MIX_REVERSE:
+            type = PHFWD_PROTO_REVERSE;
+            break;
+        case MIX_GETREVERSE:
+            type = PHFWD_PROTO_GETREVERSE;
+            break;
+        case MIX_MIXED:
+            type = (kind < 90) ? PHFWD_PROTO_GET : (kind < 98) ? PHFWD_PROTO_REVERSE
+                 : (kind < 99) ? PHFWD_PROTO_ADD : PHFWD_PROTO_REMOVE;
+            break;
+        default:
+            break;
+    }
+    *out++ = (unsigned char)type;
+    if ((type == PHFWD_PROTO_GET) || (type == PHFWD_PROTO_ADD) || (type == PHFWD_PROTO_REMOVE)) {
+        out = putKey(out, key, '1');
+    }
+    else {
+        out = putKey(out, key, '2');
+    }
+    if (type == PHFWD_PROTO_ADD) {
+        out = putKey(out, key, '2');
+    }
+    return out;
+}
+
+/** @brief Wysyła żądania, aż połączenie będzie miało ich zadaną liczbę w drodze.
+ * @param[in,out] g - wskaźnik na stan generatora
+ * @param[in,out] c - wskaźnik na połączenie
+ * @return Wartość @p true, jeśli zapis się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool clientSend(Generator *g, Client *c) {
+    if (c->output_start == c->output_used) {
+        c->output_start = 0;
+        c->output_used = 0;
+        uint64_t time = now();
+        while ((c->in_flight < g->depth) && (g->to_send > 0)) {
+            unsigned char *end = putRequest(g, c->output + c->output_used);
+            c->output_used = (size_t)(end - c->output);
+            c->sent_at[(c->first + c->in_flight) % g->depth] = time;
+            ++(c->in_flight);
+            --(g->to_send);
+        }
+    }
+    while (c->output_start < c->output_used) {
+        ssize_t written = write(c->fd, c->output + c->output_start, c->output_used - c->output_start);
+        if (written < 0) {
+            return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+        }
+        c->output_start += (size_t)written;
+    }
+    return true;
+}
+
+/** @brief Odbiera odpowiedzi i zapisuje czasy obsługi żądań.
+ * @param[in,out] g - wskaźnik na stan generatora
+ * @param[in,out] c - wskaźnik na połączenie
+ * @return Wartość @p true, jeśli odczyt się powiódł.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool clientReceive(Generator *g, Client *c) {
+    ssize_t got = read(c->fd, c->input + c->input_used, INPUT_SIZE - c->input_used);
+    if (got <= 0) {
+        return (got < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR));
+    }
+    c->input_used += (size_t)got;
+    uint64_t time = now();
+    size_t position = 0;
+    size_t size;
+    while ((size = protoResponseSize(c->input + position, c->input_used - position)) != 0) {
+        if (c->in_flight == 0) {
+            return false;
+        }
+        g->failed += (c->input[position] != PHFWD_PROTO_OK);
+        g->latencies[g->received++] = time - c->sent_at[c->first];
+        c->first = (c->first + 1) % g->depth;
+        --(c->in_flight);
+        position += size;
+    }
+    if ((position == 0) && (c->input_used == INPUT_SIZE)) {
+        return false; // Odpowiedź nie mieści się w buforze.
+    }
+    memmove(c->input, c->input + position, c->input_used - position);
+    c->input_used -= position;
+    return true;
+}
+
+/** @brief Łączy się z serwerem.
+ * @param[in] path - ścieżka gniazda
+ * @return Deskryptor gniazda lub -1, gdy się nie udało.
+ */
+static int connectTo(char const *path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if ((connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) || (fcntl(fd, F_SETFL, O_NONBLOCK) != 0)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/** @brief Porównuje 2 czasy obsługi.
+ * @param[in] a - wskaźnik na pierwszy czas
+ * @param[in] b - wskaźnik na drugi czas
+ * @return Wartość ujemna, zero lub dodatnia, jak w funkcji porównującej dla qsort.
+ */
+static int compareLatencies(const void *a, const void *b) {
+    uint64_t x = *(uint64_t const *)a;
+    uint64_t y = *(uint64_t const *)b;
+    return (x > y) - (x < y);
+}
+
+/** @brief Wykonuje żądania przez wszystkie połączenia.
+ * @param[in,out] g - wskaźnik na stan generatora
+ * @param[in,out] clients - wskaźnik na tablicę połączeń
+ * @param[in] count - liczba połączeń
+ * @param[in] total - liczba żądań do odebrania
+ * @return Wartość @p true, jeśli odebrano wszystkie odpowiedzi.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool run(Generator *g, Client *clients, size_t count, size_t total) {
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        return false;
+    }
+    bool result = true;
+    for (size_t i = 0; result && (i < count); ++i) {
+        struct epoll_event event = {.events = EPOLLIN | EPOLLOUT, .data.ptr = &(clients[i])};
+        result = (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, clients[i].fd, &event) == 0);
+    }
+    struct epoll_event events[64];
+    while (result && (g->received < total)) {
+        int ready = epoll_wait(epoll_fd, events, 64, -1);
+        if (ready < 0) {
+            result = (errno == EINTR);
+            continue;
+        }
+        for (int i = 0; result && (i < ready); ++i) {
+            Client *c = events[i].data.ptr;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                result = clientReceive(g, c);
+            }
+            if (result) {
+                result = clientSend(g, c);
+            }
+            if (result) {
+                bool waiting = (c->output_start < c->output_used);
+                struct epoll_event event = {.events = EPOLLIN | (waiting ? EPOLLOUT : 0), .data.ptr = c};
+                result = (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->fd, &event) == 0);
+            }
+        }
+    }
+    close(epoll_fd);
+    return result;
+}
+
+/** @brief Uruchamia generator obciążenia.
+ * @param[in] argc - liczba argumentów
+ * @param[in] argv - argumenty
+ * @return Kod wyjścia.
+ */
+int main(int argc, char *argv[]) {
+    size_t connections = 4;
+    size_t requests = 1000000;
+    size_t adds = 0;
+    Generator g;
+    memset(&g, 0, sizeof(g));
+    g.depth = 64;
+    g.keys = 100000;
+    g.mix = MIX_GET;
+    g.random = (uint64_t)getpid();
+    int option;
+    bool usage = false;
+    while ((option = getopt(argc, argv, "c:n:d:k:a:m:")) != -1) {
+        switch (option) {
+            case 'c':
+                connections = strtoull(optarg, NULL, 10);
+                break;
+            case 'n':
+                requests = strtoull(optarg, NULL, 10);
+                break;
+            case 'd':
+                g.depth = strtoull(optarg, NULL, 10);
+                break;
+            case 'k':
+                g.keys = strtoull(optarg, NULL, 10);
+                break;
+            case 'a':
+                adds = strtoull(optarg, NULL, 10);
+                break;
+            case 'm':
+                g.mix = (strcmp(optarg, "reverse") == 0) ? MIX_REVERSE
+                      : (strcmp(optarg, "getreverse") == 0) ? MIX_GETREVERSE
+                      : (strcmp(optarg, "mixed") == 0) ? MIX_MIXED : MIX_GET;
+                usage |= (g.mix == MIX_GET) && (strcmp(optarg, "get") != 0);
+                break;
+            default:
+                usage = true;
+                break;
+        }
+    }
+    if (usage || (optind != argc - 1) || (connections == 0) || (g.depth == 0) || (g.keys == 0)) {
+        fprintf(stderr, "usage: %s [-c connections] [-n requests] [-d depth] [-k keys] [-a adds]"
+                        " [-m get|reverse|getreverse|mixed] socket\n", argv[0]);
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    Client *clients = calloc(connections, sizeof(*clients));
+    size_t most = (adds > requests) ? adds : requests;
+    g.latencies = malloc((most + 1) * sizeof(*(g.latencies)));
+    bool result = (clients != NULL) && (g.latencies != NULL);
+    for (size_t i = 0; result && (i < connections); ++i) {
+        clients[i].fd = connectTo(argv[optind]);
+        clients[i].sent_at = malloc(g.depth * sizeof(*(clients[i].sent_at)));
+        clients[i].output = malloc(g.depth * MAX_REQUEST);
+        clients[i].input = malloc(INPUT_SIZE);
+        result = (clients[i].fd >= 0) && (clients[i].sent_at != NULL) && (clients[i].output != NULL)
+                 && (clients[i].input != NULL);
+    }
+    if (!result) {
+        fprintf(stderr, "phone_forward_loadgen: cannot connect to %s\n", argv[optind]);
+    }
+
+    if (result && (adds > 0)) {
+        // Wypełniamy tablicę przekierowaniami z kolejnych numerów, nie mierząc czasu.
+        LoadMix mix = g.mix;
+        g.mix = MIX_LOAD;
+        g.to_send = adds;
+        result = run(&g, clients, connections, adds);
+        g.mix = mix;
+        if (result) {
+            printf("loaded %zu forwards, %zu failed\n", adds, g.failed);
+        }
+        g.failed = 0;
+    }
+
+    if (result) {
+        g.to_send = requests;
+        g.received = 0;
+        uint64_t start = now();
+        result = run(&g, clients, connections, requests);
+        double seconds = (double)(now() - start) / 1e9;
+        if (result && (requests > 0)) {
+            qsort(g.latencies, g.received, sizeof(*(g.latencies)), compareLatencies);
+            printf("%zu requests over %zu connections, depth %zu: %.3f s, %.0f req/s, %zu failed\n",
+                   g.received, connections, g.depth, seconds, (double)g.received / seconds, g.failed);
+            double const quantiles[] = {0.5, 0.9, 0.99, 0.999};
+            for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); ++i) {
+                size_t idx = (size_t)(quantiles[i] * (double)(g.received - 1));
+                printf("p%g %.1f us\n", quantiles[i] * 100, (double)g.latencies[idx] / 1e3);
+            }
+            printf("max %.1f us\n", (double)g.latencies[g.received - 1] / 1e3);
+        }
+        else if (!result) {
+            fprintf(stderr, "phone_forward_loadgen: connection failed\n");
+        }
+    }
+
+    for (size_t i = 0; (clients != NULL) && (i < connections); ++i) {
+        if (clients[i].fd > 0) {
+            close(clients[i].fd);
+        }
+        free(clients[i].sent_at);
+        free(clients[i].output);
+        free(clients[i].input);
+    }
+    free(clients);
+    free(g.latencies);
+    return result ? 0 : 1;
+}
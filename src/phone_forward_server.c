@@ -0,0 +1,643 @@
+/** @file
+ * Serwer udostępniający przekierowania numerów przez gniazdo uniksowe
+ *
+ * Serwer wczytuje przekierowania raz i obsługuje wiele połączeń jednym
+ * wątkiem za pomocą epoll. Żądania i odpowiedzi mają postać opisaną
+ * w @ref phfwd_protocol.h. Kolejne żądania @ref PHFWD_PROTO_GET odebrane
+ * jednym odczytem są wykonywane razem przez @ref phfwdGetBatch.
+ *
+ * Użycie: phone_forward_server [-t plik_tekstowy] [-s migawka] [-l dziennik] gniazdo
+ *
+ * @author Magdalena Czapiewska <mc427863@students.mimuw.edu.pl>
+ * @date 2022
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "phone_forward.h"
+#include "phfwd_batch.h"
+#include "phfwd_protocol.h"
+
+/**
+ * To jest najmniejsza liczba wolnych bajtów bufora wejściowego przed odczytem.
+ */
+#define READ_CHUNK (1 << 16)
+
+/**
+ * To jest liczba bajtów oczekujących na wysłanie, powyżej której serwer
+ * przestaje czytać żądania połączenia.
+ */
+#define OUTPUT_LIMIT (1 << 22)
+
+/**
+ * To jest największa liczba zdarzeń odbieranych jednym wywołaniem epoll_wait.
+ */
+#define MAX_EVENTS 64
+
+/**
+ * To jest stan jednego połączenia.
+ */
+typedef struct Connection {
+    int fd; ///< deskryptor gniazda
+    unsigned char *input; ///< bufor odebranych bajtów
+    size_t input_used; ///< liczba bajtów w buforze wejściowym
+    size_t input_capacity; ///< rozmiar bufora wejściowego
+    unsigned char *output; ///< bufor odpowiedzi
+    size_t output_start; ///< pozycja pierwszego niewysłanego bajtu odpowiedzi
+    size_t output_used; ///< pozycja za ostatnim bajtem odpowiedzi
+    size_t output_capacity; ///< rozmiar bufora odpowiedzi
+    uint32_t events; ///< zdarzenia, na które połączenie czeka
+    bool closing; ///< czy połączenie ma zostać zamknięte po wysłaniu odpowiedzi
+} Connection;
+
+/**
+ * To jest wynik jednego zapytania paczki.
+ */
+typedef struct GetAnswer {
+    size_t offset; ///< pozycja wyniku w buforze wyników
+    size_t length; ///< długość wyniku
+    bool valid; ///< czy zapytanie było poprawnym numerem
+} GetAnswer;
+
+/**
+ * To jest stan serwera.
+ */
+typedef struct Server {
+    PhoneForward *pf; ///< wskaźnik na strukturę przechowującą przekierowania numerów
+    int epoll_fd; ///< deskryptor epoll
+    int listen_fd; ///< deskryptor gniazda nasłuchującego
+    bool logging; ///< czy do struktury jest dołączony dziennik
+    bool modified; ///< czy od ostatniej synchronizacji dziennika wykonano zmianę
+    char *numbers; ///< bufor odczytanych numerów zapytań
+    size_t numbers_used; ///< liczba zajętych znaków bufora numerów
+    size_t numbers_capacity; ///< rozmiar bufora numerów
+    size_t *offsets; ///< pozycje numerów zapytań paczki w buforze numerów
+    char const **nums; ///< numery zapytań paczki
+    GetAnswer *answers; ///< wyniki zapytań paczki
+    size_t queries; ///< liczba zapytań paczki
+    size_t queries_capacity; ///< liczba zapytań, na które jest miejsce
+    size_t offsets_capacity; ///< liczba pozycji, na które jest miejsce
+    size_t answers_capacity; ///< liczba wyników, na które jest miejsce
+    char *results; ///< bufor wyników zapytań paczki
+    size_t results_used; ///< liczba zajętych znaków bufora wyników
+    size_t results_capacity; ///< rozmiar bufora wyników
+} Server;
+
+/**
+ * To jest flaga ustawiana przez sygnał kończący pracę serwera.
+ */
+static volatile sig_atomic_t stop_requested = 0;
+
+/** @brief Zapamiętuje, że serwer ma zakończyć pracę.
+ * @param[in] signal_number - numer sygnału
+ */
+static void requestStop(int signal_number) {
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+/** @brief Rezerwuje miejsce na odpowiedź w buforze połączenia.
+ * @param[in,out] c - wskaźnik na połączenie
+ * @param[in] size - rozmiar odpowiedzi
+ * @return Wskaźnik na miejsce na odpowiedź lub NULL, gdy nie udało się alokować pamięci.
+ */
+static unsigned char * outputReserve(Connection *c, size_t size) {
+    if ((c->output_start > 0) && (c->output_used + size > c->output_capacity)) {
+        memmove(c->output, c->output + c->output_start, c->output_used - c->output_start);
+        c->output_used -= c->output_start;
+        c->output_start = 0;
+    }
+    if (!reserveArray((void **)&(c->output), &(c->output_capacity), c->output_used + size, 1)) {
+        return NULL;
+    }
+    unsigned char *result = c->output + c->output_used;
+    c->output_used += size;
+    return result;
+}
+
+/** @brief Dopisuje odpowiedź bez numerów.
+ * @param[in,out] c - wskaźnik na połączenie
+ * @param[in] status - stan odpowiedzi
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool respondEmpty(Connection *c, PhoneForwardResponseStatus status) {
+    unsigned char *out = outputReserve(c, PHFWD_PROTO_RESPONSE_HEADER);
+    if (out == NULL) {
+        return false;
+    }
+    protoPutResponseHeader(out, status, 0);
+    return true;
+}
+
+/** @brief Dopisuje odpowiedź zawierającą ciąg numerów.
+ * @param[in,out] c - wskaźnik na połączenie
+ * @param[in] pnum - wskaźnik na ciąg numerów lub NULL, gdy operacja się nie powiodła
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool respondNumbers(Connection *c, PhoneNumbers const *pnum) {
+    if (pnum == NULL) {
+        return respondEmpty(c, PHFWD_PROTO_FAILED);
+    }
+    size_t count = 0;
+    size_t size = PHFWD_PROTO_RESPONSE_HEADER;
+    char const *num;
+    while ((num = phnumGet(pnum, count)) != NULL) {
+        size_t length = strlen(num);
+        if ((length > PHFWD_PROTO_MAX_DIGITS) || (count == UINT32_MAX)) {
+            return respondEmpty(c, PHFWD_PROTO_FAILED);
+        }
+        size += protoNumberSize(length);
+        ++count;
+    }
+    unsigned char *out = outputReserve(c, size);
+    if (out == NULL) {
+        return false;
+    }
+    out = protoPutResponseHeader(out, PHFWD_PROTO_OK, (uint32_t)count);
+    for (size_t i = 0; i < count; ++i) {
+        num = phnumGet(pnum, i);
+        out = protoPutNumber(out, num, strlen(num));
+    }
+    return true;
+}
+
+/** @brief Odczytuje numer do bufora numerów serwera.
+ * Napis z niepoprawnymi cyframi jest zastępowany pustym, który nie reprezentuje numeru.
+ * @param[in,out] s - wskaźnik na stan serwera
+ * @param[in] in - wskaźnik na początek zapisanego numeru
+ * @param[out] offset - adres zmiennej, w której zostanie zapisana pozycja numeru w buforze
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool readNumber(Server *s, unsigned char const *in, size_t *offset) {
+    size_t length = protoNumberLength(in);
+    if (!reserveArray((void **)&(s->numbers), &(s->numbers_capacity), s->numbers_used + length + 1, 1)) {
+        return false;
+    }
+    *offset = s->numbers_used;
+    protoGetNumber(s->numbers + s->numbers_used, in);
+    s->numbers_used += length + 1;
+    return true;
+}
+
+/** @brief Zapamiętuje wynik zapytania paczki.
+ * @param[in] idx - pozycja zapytania w paczce
+ * @param[in] num - przekierowanie numeru lub NULL, gdy napis nie reprezentuje numeru
+ * @param[in,out] data - wskaźnik na stan serwera
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool storeAnswer(size_t idx, char const *num, void *data) {
+    Server *s = data;
+    GetAnswer *answer = &(s->answers[idx]);
+    answer->valid = (num != NULL);
+    if (num == NULL) {
+        return true;
+    }
+    answer->length = strlen(num);
+    if (!reserveArray((void **)&(s->results), &(s->results_capacity), s->results_used + answer->length, 1)) {
+        return false;
+    }
+    answer->offset = s->results_used;
+    memcpy(s->results + s->results_used, num, answer->length);
+    s->results_used += answer->length;
+    return true;
+}
+
+/** @brief Dodaje zapytanie o przekierowanie do paczki.
+ * @param[in,out] s - wskaźnik na stan serwera
+ * @param[in] in - wskaźnik na numer żądania
+ * @return Wartość @p true, jeśli udało się alokować pamięć.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool queueGet(Server *s, unsigned char const *in) {
+    if (!reserveArray((void **)&(s->offsets), &(s->offsets_capacity), s->queries + 1, sizeof(*(s->offsets)))) {
+        return false;
+    }
+    if (!readNumber(s, in, &(s->offsets[s->queries]))) {
+        return false;
+    }
+    ++(s->queries);
+    return true;
+}
+
+/** @brief Wykonuje zgromadzone zapytania o przekierowanie i dopisuje odpowiedzi.
+ * @param[in,out] s - wskaźnik na stan serwera
+ * @param[in,out] c - wskaźnik na połączenie
+ * @return Wartość @p true, jeśli udało się alokować pamięć na odpowiedzi.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool flushGets(Server *s, Connection *c) {
+    size_t count = s->queries;
+    if (count == 0) {
+        return true;
+    }
+    s->queries = 0;
+    if (!reserveArray((void **)&(s->nums), &(s->queries_capacity), count, sizeof(*(s->nums)))
+        || !reserveArray((void **)&(s->answers), &(s->answers_capacity), count, sizeof(*(s->answers)))) {
+        s->numbers_used = 0;
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        s->nums[i] = s->numbers + s->offsets[i];
+    }
+    s->results_used = 0;
+    bool answered = phfwdGetBatch(s->pf, s->nums, count, storeAnswer, s);
+    s->numbers_used = 0;
+    for (size_t i = 0; i < count; ++i) {
+        GetAnswer const *answer = &(s->answers[i]);
+        if (!answered || (answer->valid && (answer->length > PHFWD_PROTO_MAX_DIGITS))) {
+            if (!respondEmpty(c, PHFWD_PROTO_FAILED)) {
+                return false;
+            }
+            continue;
+        }
+        size_t size = PHFWD_PROTO_RESPONSE_HEADER + (answer->valid ? protoNumberSize(answer->length) : 0);
+        unsigned char *out = outputReserve(c, size);
+        if (out == NULL) {
+            return false;
+        }
+        out = protoPutResponseHeader(out, PHFWD_PROTO_OK, answer->valid ? 1 : 0);
+        if (answer->valid) {
+            protoPutNumber(out, s->results + answer->offset, answer->length);
+        }
+    }
+    return true;
+}
+
+/** @brief Wykonuje żądanie inne niż zapytanie o przekierowanie i dopisuje odpowiedź.
+ * @param[in,out] s - wskaźnik na stan serwera
+ * @param[in,out] c - wskaźnik na połączenie
+ * @param[in] in - wskaźnik na początek żądania
+ * @return Wartość @p true, jeśli udało się alokować pamięć na odpowiedź.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool handleRequest(Server *s, Connection *c, unsigned char const *in) {
+    size_t num1, num2;
+    s->numbers_used = 0;
+    if (!readNumber(s, in + 1, &num1)) {
+        return false;
+    }
+    if (in[0] == PHFWD_PROTO_ADD) {
+        unsigned char const *second = in + 1 + protoNumberSize(protoNumberLength(in + 1));
+        if (!readNumber(s, second, &num2)) {
+            return false;
+        }
+    }
+    char const *number = s->numbers + num1;
+    bool result = true;
+    switch (in[0]) {
+        case PHFWD_PROTO_REVERSE:
+        case PHFWD_PROTO_GETREVERSE: {
+            PhoneNumbers *pnum = (in[0] == PHFWD_PROTO_REVERSE) ? phfwdReverse(s->pf, number)
+                                                                : phfwdGetReverse(s->pf, number);
+            result = respondNumbers(c, pnum);
+            phnumDelete(pnum);
+            break;
+        }
+        case PHFWD_PROTO_ADD: {
+            bool added = phfwdAdd(s->pf, number, s->numbers + num2);
+            s->modified |= added;
+            result = respondEmpty(c, added ? PHFWD_PROTO_OK : PHFWD_PROTO_FAILED);
+            break;
+        }
+        default:
+            s->modified |= phfwdRemove(s->pf, number);
+            result = respondEmpty(c, PHFWD_PROTO_OK);
+            break;
+    }
+    s->numbers_used = 0;
+    return result;
+}
+
+/** @brief Wykonuje wszystkie pełne żądania z bufora wejściowego połączenia.
+ * Kolejne zapytania o przekierowanie są wykonywane jedną paczką, a inne
+ * żądania kończą paczkę, dzięki czemu odpowiedzi zachowują kolejność żądań.
+ * @param[in,out] s - wskaźnik na stan serwera
+ * @param[in,out] c - wskaźnik na połączenie
+ * @return Wartość @p true, jeśli udało się alokować pamięć na odpowiedzi.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool processRequests(Server *s, Connection *c) {
+    size_t position = 0;
+    bool result = true;
+    while (result && !c->closing) {
+        unsigned char const *in = c->input + position;
+        size_t size = protoRequestSize(in, c->input_used - position);
+        if (size == 0) {
+            break;
+        }
+        if (size == SIZE_MAX) {
+            result = flushGets(s, c) && respondEmpty(c, PHFWD_PROTO_BAD_REQUEST);
+            c->closing = true;
+            break;
+        }
+        if (in[0] == PHFWD_PROTO_GET) {
+            result = queueGet(s, in + 1);
+        }
+        else {
+            result = flushGets(s, c) && handleRequest(s, c, in);
+        }
+        position += size;
+    }
+    result = flushGets(s, c) && result;
+    s->queries = 0;
+    s->numbers_used = 0;
+    memmove(c->input, c->input + position, c->input_used - position);
+    c->input_used -= position;
+    if (result && s->modified) {
+        // Odpowiedzi na zmiany są wysyłane dopiero po zapisaniu ich w dzienniku.
+        s->modified = false;
+        if (s->logging && !phfwdSyncLog(s->pf)) {
+            fprintf(stderr, "phone_forward_server: cannot sync the log\n");
+            return false;
+        }
+    }
+    return result;
+}
+
+/** @brief Wysyła oczekujące odpowiedzi i ustala zdarzenia, na które czeka połączenie.
+ * @param[in,out] s - wskaźnik na stan serwera
+ * @param[in,out] c - wskaźnik na połączenie
+ * @return Wartość @p true, jeśli połączenie pozostaje otwarte.
+ *         Wartość @p false, jeśli należy je zamknąć.
+ */
+static bool connectionWrite(Server *s, Connection *c) {
+    while (c->output_start < c->output_used) {
+        ssize_t written = write(c->fd, c->output + c->output_start, c->output_used - c->output_start);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                break;
+            }
+            return false;
+        }
+        c->output_start += (size_t)written;
+    }
+    size_t pending = c->output_used - c->output_start;
+    if (pending == 0) {
+        c->output_start = 0;
+        c->output_used = 0;
+        if (c->closing) {
+            return false;
+        }
+    }
+    uint32_t events = ((!c->closing && (pending < OUTPUT_LIMIT)) ? EPOLLIN : 0) | ((pending > 0) ? EPOLLOUT : 0);
+    if (events != c->events) {
+        struct epoll_event event = {.events = events, .data.ptr = c};
+        if (epoll_ctl(s->epoll_fd, EPOLL_CTL_MOD, c->fd, &event) != 0) {
+            return false;
+        }
+        c->events = events;
+    }
+    return true;
+}
+
+/** @brief Odczytuje żądania z połączenia i wykonuje je.
+ * Wykonuje jeden odczyt, więc paczkę tworzą żądania, które nadeszły razem.
+ * @param[in,out] s - wskaźnik na stan serwera
+ * @param[in,out] c - wskaźnik na połączenie
+ * @return Wartość @p true, jeśli połączenie pozostaje otwarte.
+ *         Wartość @p false, jeśli należy je zamknąć.
+ */
+static bool connectionRead(Server *s, Connection *c) {
+    if (!reserveArray((void **)&(c->input), &(c->input_capacity), c->input_used + READ_CHUNK, 1)) {
+        return false;
+    }
+    ssize_t got = read(c->fd, c->input + c->input_used, c->input_capacity - c->input_used);
+    if (got < 0) {
+        return (errno == EINTR) || (errno == EAGAIN) || (errno == EWOULDBLOCK);
+    }
+    if (got == 0) {
+        return false;
+    }
+    c->input_used += (size_t)got;
+    return processRequests(s, c);
+}
+
+/** @brief Zamyka połączenie i zwalnia jego pamięć.
+ * @param[in] s - wskaźnik na stan serwera
+ * @param[in] c - wskaźnik na połączenie
+ */
+static void connectionClose(Server const *s, Connection *c) {
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free(c->input);
+    free(c->output);
+    free(c);
+}
+
+/** @brief Przyjmuje oczekujące połączenia.
+ * @param[in] s - wskaźnik na stan serwera
+ */
+static void acceptConnections(Server const *s) {
+    while (true) {
+        int fd = accept(s->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+                perror("phone_forward_server: accept");
+            }
+            return;
+        }
+        Connection *c = calloc(1, sizeof(*c));
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = c};
+        if ((c == NULL) || (fcntl(fd, F_SETFL, O_NONBLOCK) != 0)
+            || (epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)) {
+            close(fd);
+            free(c);
+            continue;
+        }
+        c->fd = fd;
+        c->events = EPOLLIN;
+    }
+}
+
+/** @brief Wczytuje przekierowania i dołącza dziennik.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów
+ * @param[in] text - ścieżka pliku tekstowego lub NULL
+ * @param[in] snapshot - ścieżka migawki lub NULL
+ * @param[in] log - ścieżka dziennika lub NULL
+ * @return Wartość @p true, jeśli wszystko się powiodło.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool loadTable(PhoneForward *pf, char const *text, char const *snapshot, char const *log) {
+    if ((snapshot != NULL) && !phfwdLoadSnapshot(pf, snapshot)) {
+        fprintf(stderr, "phone_forward_server: cannot load snapshot %s\n", snapshot);
+        return false;
+    }
+    if (text != NULL) {
+        int fd = open(text, O_RDONLY);
+        bool imported = (fd >= 0) && phfwdImportText(pf, fd);
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (!imported) {
+            fprintf(stderr, "phone_forward_server: cannot import %s\n", text);
+            return false;
+        }
+    }
+    if (log != NULL) {
+        if ((access(log, F_OK) == 0) && !phfwdReplay(pf, log)) {
+            fprintf(stderr, "phone_forward_server: cannot replay log %s\n", log);
+            return false;
+        }
+        if (!phfwdOpenLog(pf, log, 0)) {
+            fprintf(stderr, "phone_forward_server: cannot open log %s\n", log);
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Tworzy gniazdo nasłuchujące.
+ * @param[in] path - ścieżka gniazda
+ * @return Deskryptor gniazda lub -1, gdy się nie udało.
+ */
+static int listenOn(char const *path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "phone_forward_server: socket path too long\n");
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("phone_forward_server: socket");
+        return -1;
+    }
+    unlink(path);
+    if ((bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0) || (listen(fd, SOMAXCONN) != 0)
+        || (fcntl(fd, F_SETFL, O_NONBLOCK) != 0)) {
+        perror("phone_forward_server: bind");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/** @brief Obsługuje połączenia do otrzymania sygnału SIGINT lub SIGTERM.
+ * @param[in,out] s - wskaźnik na stan serwera
+ * @return Wartość @p true, jeśli serwer zakończył pracę na żądanie.
+ *         Wartość @p false, jeśli wystąpił błąd.
+ */
+static bool serve(Server *s) {
+    struct epoll_event events[MAX_EVENTS];
+    while (!stop_requested) {
+        int ready = epoll_wait(s->epoll_fd, events, MAX_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("phone_forward_server: epoll_wait");
+            return false;
+        }
+        for (int i = 0; i < ready; ++i) {
+            Connection *c = events[i].data.ptr;
+            if (c == NULL) {
+                acceptConnections(s);
+                continue;
+            }
+            bool open = true;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                open = connectionRead(s, c);
+            }
+            if (open) {
+                open = connectionWrite(s, c);
+            }
+            if (!open) {
+                connectionClose(s, c);
+            }
+        }
+    }
+    return true;
+}
+
+/** @brief Uruchamia serwer.
+ * @param[in] argc - liczba argumentów
+ * @param[in] argv - argumenty
+ * @return Kod wyjścia.
+ */
+int main(int argc, char *argv[]) {
+    char const *text = NULL;
+    char const *snapshot = NULL;
+    char const *log = NULL;
+    int option;
+    while ((option = getopt(argc, argv, "t:s:l:")) != -1) {
+        switch (option) {
+            case 't':
+                text = optarg;
+                break;
+            case 's':
+                snapshot = optarg;
+                break;
+            case 'l':
+                log = optarg;
+                break;
+            default:
+                optind = argc + 1;
+                break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-t text_file] [-s snapshot] [-l log] socket\n", argv[0]);
+        return 2;
+    }
+    char const *path = argv[optind];
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    Server s;
+    memset(&s, 0, sizeof(s));
+    s.pf = phfwdNew();
+    s.logging = (log != NULL);
+    if ((s.pf == NULL) || !loadTable(s.pf, text, snapshot, log)) {
+        phfwdDelete(s.pf);
+        return 1;
+    }
+    s.listen_fd = listenOn(path);
+    s.epoll_fd = epoll_create1(0);
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    bool result = (s.listen_fd >= 0) && (s.epoll_fd >= 0)
+                  && (epoll_ctl(s.epoll_fd, EPOLL_CTL_ADD, s.listen_fd, &event) == 0) && serve(&s);
+
+    // Połączenia są zamykane razem z procesem; zwalniamy tylko zasoby serwera.
+    if (s.listen_fd >= 0) {
+        close(s.listen_fd);
+        unlink(path);
+    }
+    if (s.epoll_fd >= 0) {
+        close(s.epoll_fd);
+    }
+    free(s.numbers);
+    free(s.offsets);
+    free(s.nums);
+    free(s.answers);
+    free(s.results);
+    phfwdDelete(s.pf);
+    return result ? 0 : 1;
+}
@@ -16,6 +16,10 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
 
 // Gdzieś musi być zdefiniowany magiczny napis służący do spawdzania, czy
 // program w całości wykonał‚ się poprawnie.
@@ -31,16 +35,20 @@ char quite_long_magic_string[] = "MAGIC";
 // Liczba elementów tablicy x
 #define SIZE(x) (sizeof(x) / sizeof(x)[0])
 
+// Funkcja tworząca bazy przekierowań w testach; wybiera silnik, na którym
+// są uruchamiane scenariusze testów
+static PhoneForward * (*new_struct)(void) = phfwdNew;
+
 // Początek testu
-#define INIT(p)                 \
-  PhoneForward *p = phfwdNew(); \
-  if (p == NULL)                \
+#define INIT(p)                   \
+  PhoneForward *p = new_struct(); \
+  if (p == NULL)                  \
     return FAIL
 
 // Utworzenie nowej bazy przekierowań
-#define REINIT(p)    \
-  phfwdDelete(pf);   \
-  N(p = phfwdNew());
+#define REINIT(p)     \
+  phfwdDelete(pf);    \
+  N(p = new_struct());
 
 // Koniec testu
 #define CLEAN(p)  \
@@ -528,8 +536,12 @@ static int remove_forward(void) {
     T(phfwdAdd(pf, "0", "5"));
     CHECK(pf, "000", "500");
 
-    phfwdRemove(pf, "0");
+    F(phfwdRemove(pf, "1"));
+    F(phfwdRemove(pf, "00"));
+    F(phfwdRemove(pf, "0a"));
+    T(phfwdRemove(pf, "0"));
     CHECK(pf, "000", "000");
+    F(phfwdRemove(pf, "0"));
 
     CLEAN(pf);
 }
@@ -887,6 +899,1682 @@ static int get_reverse(void) {
     CLEAN(pf);
 }
 
+// Testy iteratora i stronicowania wyników phfwdReverse
+static int reverse_iterator(void) {
+    PhoneNumbersIter *it;
+    PhoneNumbers *pn;
+
+    INIT(pf);
+
+    T(phfwdAdd(pf, "027", "07"));
+    T(phfwdAdd(pf, "0*7", "07"));
+    T(phfwdAdd(pf, "097", "07"));
+    T(phfwdAdd(pf, "007", "07"));
+    T(phfwdAdd(pf, "0#7", "07"));
+
+    N(it = phfwdReverseIter(pf, "071"));
+    C(phfwdIterNext(it), "0071");
+    C(phfwdIterNext(it), "0271");
+    C(phfwdIterNext(it), "071");
+    C(phfwdIterNext(it), "0971");
+    C(phfwdIterNext(it), "0*71");
+    C(phfwdIterNext(it), "0#71");
+    Z(phfwdIterNext(it));
+    Z(phfwdIterNext(it));
+    phfwdIterSeek(it, "071");
+    C(phfwdIterNext(it), "0971");
+    phfwdIterSeek(it, "A");
+    Z(phfwdIterNext(it));
+    phfwdIterDelete(it);
+
+    N(it = phfwdGetReverseIter(pf, "07"));
+    C(phfwdIterNext(it), "007");
+    C(phfwdIterNext(it), "027");
+    C(phfwdIterNext(it), "07");
+    phfwdIterDelete(it);
+
+    N(pn = phfwdReversePage(pf, "07", NULL, 2));
+    R(pn, 0, "007");
+    R(pn, 1, "027");
+    Q(pn, 2);
+    phnumDelete(pn);
+    N(pn = phfwdReversePage(pf, "07", "027", 2));
+    R(pn, 0, "07");
+    R(pn, 1, "097");
+    Q(pn, 2);
+    phnumDelete(pn);
+    N(pn = phfwdReversePage(pf, "07", "0*7", 2));
+    R(pn, 0, "0#7");
+    Q(pn, 1);
+    phnumDelete(pn);
+    E(phfwdReversePage(pf, "07", "0#7", 2));
+    E(phfwdReversePage(pf, "A", NULL, 2));
+
+    N(it = phfwdReverseIter(pf, "A"));
+    Z(phfwdIterNext(it));
+    phfwdIterDelete(it);
+    Z(phfwdReverseIter(NULL, "07"));
+    phfwdIterDelete(NULL);
+
+    CLEAN(pf);
+}
+
+// Porównuje napisy w postaci wymaganej przez qsort
+static int compare_strings(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+// Sprawdza, czy ciąg numerów jest równy początkowi posortowanej tablicy.
+static bool same_prefix(PhoneNumbers const *pn, char * const *sorted, size_t how_many, size_t *position) {
+    size_t i = 0;
+    for (; phnumGet(pn, i) != NULL; ++i, ++(*position)) {
+        if ((*position >= how_many) || (strcmp(phnumGet(pn, i), sorted[*position]) != 0))
+            return false;
+    }
+    return true;
+}
+
+// Sprawdza, czy odwrócenie numeru to posortowane obecne numery z tablicy i on sam.
+static bool reverse_is(PhoneForward *pf, char const *num, char (*keys)[24], bool const *present,
+                       size_t count, char **sorted) {
+    size_t how_many = 0;
+    for (size_t i = 0; i < count; ++i)
+        if (present[i])
+            sorted[how_many++] = keys[i];
+    sorted[how_many++] = (char *)num;
+    qsort(sorted, how_many, sizeof(*sorted), compare_strings);
+    PhoneNumbers *pn = phfwdReverse(pf, num);
+    size_t position = 0;
+    bool result = (pn != NULL) && same_prefix(pn, sorted, how_many, &position) && (position == how_many);
+    phnumDelete(pn);
+    return result;
+}
+
+// Testy długiej listy numerów przekierowanych na jeden numer
+static int large_reverse(void) {
+#define LARGE_REVERSE 6000
+    static char keys[LARGE_REVERSE][24];
+    static char *sorted[LARGE_REVERSE + 1];
+    static bool present[LARGE_REVERSE];
+
+    INIT(pf);
+    // Numery nieparzyste mają 16 wspólnych cyfr, więc ich porównanie nie kończy się na początku numeru.
+    for (unsigned i = 0; i < LARGE_REVERSE; ++i)
+        sprintf(keys[i], i % 2 == 0 ? "1%06u" : "3000000000000000%06u", (i * 7919u) % 1000000u);
+
+    srand(427863);
+    for (size_t i = 0; i < LARGE_REVERSE; ++i) {
+        T(phfwdAdd(pf, keys[i], "2"));
+        present[i] = true;
+        if (i % 3 == 2) {
+            size_t j = (size_t)rand() % (i + 1);
+            phfwdRemove(pf, keys[j]);
+            present[j] = false;
+        }
+    }
+    T(reverse_is(pf, "2", keys, present, LARGE_REVERSE, sorted));
+    CHECK(pf, keys[LARGE_REVERSE - 1], "2");
+
+    // Usuwamy większość numerów, a część przekierowujemy gdzie indziej.
+    for (size_t i = 0; i < LARGE_REVERSE; ++i) {
+        if (present[i] && (rand() % 8 != 0)) {
+            if (i % 4 == 0)
+                T(phfwdAdd(pf, keys[i], "4"));
+            else
+                phfwdRemove(pf, keys[i]);
+            present[i] = false;
+        }
+    }
+    T(reverse_is(pf, "2", keys, present, LARGE_REVERSE, sorted));
+
+    // Lista po zmniejszeniu znów rośnie.
+    for (size_t i = 0; i < LARGE_REVERSE; i += 2) {
+        T(phfwdAdd(pf, keys[i], "2"));
+        present[i] = true;
+    }
+    T(reverse_is(pf, "2", keys, present, LARGE_REVERSE, sorted));
+
+    CLEAN(pf);
+}
+
+// Testy scalania posortowanych list drzewa odwróceń i stronicowania iteratorem
+static int reverse_merge(void) {
+#define MERGE_KEYS 120
+    static char keys[MERGE_KEYS][8];
+    static char expected[MERGE_KEYS + 1][16];
+    static PhoneForwardOperation ops[MERGE_KEYS];
+    char const *targets[] = {"4", "45", "456", "46"};
+    char const *queries[] = {"4", "45", "456", "4567", "459", "46", "461"};
+    char *sorted[MERGE_KEYS + 1];
+    bool present[MERGE_KEYS];
+    PhoneNumbersIter *it;
+    PhoneNumbers *pn;
+
+    INIT(pf);
+
+    // Wynik z wpisu, którego prefiksem jest inny wpis, może być mniejszy.
+    T(phfwdAdd(pf, "1", "5"));
+    T(phfwdAdd(pf, "123", "5"));
+    T(phfwdAdd(pf, "13", "5"));
+    T(phfwdAdd(pf, "12", "5"));
+    T(phfwdAdd(pf, "19", "59"));
+    RCHCK(pf, "59", "1239", "129", "139", "19", "59");
+    RCHCK(pf, "50", "10", "120", "1230", "130", "50");
+    GRCHK(pf, "5", "1", "12", "123", "13", "5");
+
+    N(it = phfwdReverseIter(pf, "59"));
+    N(pn = phfwdIterPage(it, 2));
+    R(pn, 0, "1239");
+    R(pn, 1, "129");
+    Q(pn, 2);
+    phnumDelete(pn);
+    N(pn = phfwdIterPage(it, 2));
+    R(pn, 0, "139");
+    R(pn, 1, "19");
+    Q(pn, 2);
+    phnumDelete(pn);
+    N(pn = phfwdIterPage(it, 2));
+    R(pn, 0, "59");
+    Q(pn, 1);
+    phnumDelete(pn);
+    E(phfwdIterPage(it, 2));
+    phfwdIterSeek(it, "19");
+    C(phfwdIterNext(it), "59");
+    phfwdIterSeek(it, "129");
+    C(phfwdIterNext(it), "139");
+    phfwdIterSeek(it, "13");
+    C(phfwdIterNext(it), "139");
+    phfwdIterDelete(it);
+    Z(phfwdIterPage(NULL, 2));
+
+    // Te same przekierowania dodane pojedynczo od końca i paczką.
+    REINIT(pf);
+    PhoneForward *pq;
+    N(pq = phfwdNew());
+    srand(427863);
+    size_t count = 0;
+    for (unsigned length = 1, values = 3; length <= 4; ++length, values *= 3) {
+        for (unsigned value = 0; value < values; ++value, ++count) {
+            for (unsigned k = 0, rest = value; k < length; ++k, rest /= 3)
+                keys[count][length - k - 1] = (char)('1' + rest % 3);
+            keys[count][length] = '\0';
+            ops[count] = (PhoneForwardOperation){PHFWD_ADD, keys[count], targets[(unsigned)rand() % SIZE(targets)]};
+        }
+    }
+    for (size_t i = count; i > 0; --i)
+        T(phfwdAdd(pf, ops[i - 1].num1, ops[i - 1].num2));
+    T(phfwdApplyBatch(pq, ops, count));
+    phfwdSetRemovalBudget(pf, 1);
+    for (size_t i = 0; i < count; ++i) {
+        present[i] = (strlen(keys[i]) < 4) || (rand() % 4 != 0); // Usuwamy tylko najdłuższe numery.
+        if (!present[i]) {
+            phfwdRemove(pf, keys[i]);
+            phfwdRemove(pq, keys[i]);
+        }
+    }
+
+    for (size_t q = 0; q < SIZE(queries); ++q) {
+        size_t length = strlen(queries[q]);
+        size_t how_many = 1;
+        strcpy(expected[0], queries[q]);
+        for (size_t i = 0; i < count; ++i) {
+            size_t prefix = strlen(ops[i].num2);
+            if (present[i] && (prefix <= length) && (strncmp(ops[i].num2, queries[q], prefix) == 0))
+                sprintf(expected[how_many++], "%s%s", keys[i], queries[q] + prefix);
+        }
+        for (size_t i = 0; i < how_many; ++i)
+            sorted[i] = expected[i];
+        qsort(sorted, how_many, sizeof(*sorted), compare_strings);
+        size_t unique = 1;
+        for (size_t i = 1; i < how_many; ++i) {
+            if (strcmp(sorted[i], sorted[unique - 1]) != 0)
+                sorted[unique++] = sorted[i];
+        }
+
+        size_t position = 0;
+        N(it = phfwdReverseIter(pf, queries[q]));
+        do {
+            N(pn = phfwdIterPage(it, 7));
+            T(same_prefix(pn, sorted, unique, &position));
+            phnumDelete(pn);
+        } while (position % 7 == 0 && position < unique);
+        phfwdIterDelete(it);
+        T(position == unique);
+
+        position = 0;
+        N(pn = phfwdReverse(pq, queries[q]));
+        T(same_prefix(pn, sorted, unique, &position));
+        phnumDelete(pn);
+        T(position == unique);
+    }
+
+    phfwdDelete(pq);
+    CLEAN(pf);
+}
+
+// Zapisuje kolejne przekierowania w buforze
+static bool collect_forward(char const *num1, char const *num2, void *data) {
+    char *buffer = data;
+    strcat(buffer, num1);
+    strcat(buffer, ">");
+    strcat(buffer, num2);
+    strcat(buffer, ";");
+    return strlen(buffer) < 30;
+}
+
+// Testy przeglądania przekierowań o danym prefiksie
+static int for_each_prefix(void) {
+    char buffer[256];
+
+    INIT(pf);
+
+    T(phfwdAdd(pf, "48#", "1"));
+    T(phfwdAdd(pf, "481", "2"));
+    T(phfwdAdd(pf, "48", "3"));
+    T(phfwdAdd(pf, "4812", "45"));
+    T(phfwdAdd(pf, "49", "6"));
+    T(phfwdAdd(pf, "4*", "7"));
+    T(phfwdAdd(pf, "3", "8"));
+
+    buffer[0] = '\0';
+    T(phfwdForEachPrefix(pf, "48", collect_forward, buffer));
+    C(buffer, "48>3;481>2;4812>45;48#>1;");
+    buffer[0] = '\0';
+    T(phfwdForEachPrefix(pf, "481", collect_forward, buffer));
+    C(buffer, "481>2;4812>45;");
+    buffer[0] = '\0';
+    T(phfwdForEachPrefix(pf, "5", collect_forward, buffer));
+    C(buffer, "");
+    buffer[0] = '\0';
+    T(phfwdForEachPrefix(pf, NULL, collect_forward, buffer));
+    C(buffer, "3>8;48>3;481>2;4812>45;48#>1;49>6;");
+    F(phfwdForEachPrefix(pf, "4A", collect_forward, buffer));
+    F(phfwdForEachPrefix(NULL, "4", collect_forward, buffer));
+    F(phfwdForEachPrefix(pf, "4", NULL, buffer));
+
+    phfwdRemove(pf, "481");
+    buffer[0] = '\0';
+    T(phfwdForEachPrefix(pf, "", collect_forward, buffer));
+    C(buffer, "3>8;48>3;48#>1;49>6;4*>7;");
+
+    CLEAN(pf);
+}
+
+// Testy przyrostowego usuwania przekierowań
+static int incremental_remove(void) {
+    char b1[8], b2[8];
+
+    INIT(pf);
+
+    phfwdSetRemovalBudget(pf, 3);
+    for (unsigned i = 0; i < 100; ++i) {
+        sprintf(b1, "1%02u", i);
+        sprintf(b2, "5%02u", i % 10);
+        T(phfwdAdd(pf, b1, b2));
+    }
+    T(phfwdAdd(pf, "2", "500"));
+    phfwdRemove(pf, "1");
+    CHECK(pf, "123", "123");
+    RCHCK(pf, "500", "2", "500");
+    GRCHK(pf, "500", "2", "500");
+    T(phfwdAdd(pf, "100", "500"));
+    RCHCK(pf, "500", "100", "2", "500");
+    GRCHK(pf, "500", "100", "2", "500");
+    phfwdRemove(pf, "10");
+    F(phfwdReclaim(pf, 1));
+    T(phfwdReclaim(pf, 0));
+    T(phfwdReclaim(pf, 0));
+    RCHCK(pf, "500", "2", "500");
+
+    for (unsigned i = 0; i < 100; ++i) {
+        sprintf(b1, "1%02u", i);
+        sprintf(b2, "5%02u", i % 10);
+        T(phfwdAdd(pf, b1, b2));
+    }
+    phfwdRemove(pf, "1");
+    phfwdSetRemovalBudget(pf, 0);
+    phfwdRemove(pf, "2");
+    RCHCK(pf, "500", "500");
+
+    CLEAN(pf);
+}
+
+// Testy wykonywania paczek operacji
+static int batch_operations(void) {
+#define BATCH_COUNT 600
+    static PhoneForwardOperation ops[BATCH_COUNT];
+    static char nums[BATCH_COUNT][2][8];
+    char b[8];
+
+    INIT(pf);
+    PhoneForward *pq;
+    N(pq = phfwdNew());
+
+    T(phfwdAdd(pf, "12", "7"));
+    T(phfwdAdd(pq, "12", "7"));
+    srand(427863);
+    for (unsigned i = 0; i < BATCH_COUNT; ++i) {
+        sprintf(nums[i][0], "%u", (unsigned)rand() % 1000);
+        sprintf(nums[i][1], "%u", (unsigned)rand() % 100);
+        ops[i].type = (rand() % 5 == 0) ? PHFWD_REMOVE : PHFWD_ADD;
+        ops[i].num1 = nums[i][0];
+        ops[i].num2 = nums[i][1];
+        if (ops[i].type == PHFWD_REMOVE) {
+            phfwdRemove(pq, ops[i].num1);
+        }
+        else if (!phfwdAdd(pq, ops[i].num1, ops[i].num2)) {
+            ops[i].type = PHFWD_REMOVE; // Numery równe, zamieniamy na usunięcie.
+            phfwdRemove(pq, ops[i].num1);
+        }
+    }
+    T(phfwdApplyBatch(pf, ops, BATCH_COUNT));
+    for (unsigned i = 0; i < 1000; ++i) {
+        PhoneNumbers *p1, *p2;
+        sprintf(b, "%u5", i);
+        N(p1 = phfwdGet(pf, b));
+        N(p2 = phfwdGet(pq, b));
+        C(phnumGet(p1, 0), phnumGet(p2, 0));
+        phnumDelete(p1);
+        phnumDelete(p2);
+    }
+    for (unsigned i = 0; i < 100; ++i) {
+        PhoneNumbers *p1, *p2;
+        sprintf(b, "%u", i);
+        N(p1 = phfwdReverse(pf, b));
+        N(p2 = phfwdReverse(pq, b));
+        for (size_t k = 0; phnumGet(p2, k) != NULL; ++k) {
+            C(phnumGet(p1, k), phnumGet(p2, k));
+        }
+        phnumDelete(p1);
+        phnumDelete(p2);
+    }
+
+    // Paczka z niepoprawnym dodaniem nie zmienia struktury.
+    REINIT(pf);
+    T(phfwdAdd(pf, "1", "2"));
+    PhoneForwardOperation wrong[] = {
+        {PHFWD_REMOVE, "1", NULL}, {PHFWD_ADD, "3", "4"}, {PHFWD_ADD, "5", "5"}
+    };
+    F(phfwdApplyBatch(pf, wrong, SIZE(wrong)));
+    CHECK(pf, "13", "23");
+    CHECK(pf, "3", "3");
+    F(phfwdApplyBatch(NULL, wrong, 1));
+    T(phfwdApplyBatch(pf, NULL, 0));
+
+    PhoneForwardOperation ordered[] = {
+        {PHFWD_ADD, "12", "3"}, {PHFWD_REMOVE, "1", NULL}, {PHFWD_ADD, "123", "4"},
+        {PHFWD_ADD, "123", "5"}, {PHFWD_REMOVE, "abc", NULL}, {PHFWD_ADD, "6", "3"}
+    };
+    T(phfwdApplyBatch(pf, ordered, SIZE(ordered)));
+    CHECK(pf, "129", "129");
+    CHECK(pf, "1239", "59");
+    CHECK(pf, "69", "39");
+    RCHCK(pf, "3", "3", "6");
+    RCHCK(pf, "2", "2");
+
+    // Numery dłuższe niż słowo z początkiem numeru (16 cyfr) i krótsze od niego.
+    REINIT(pf);
+    PhoneForwardOperation long_numbers[] = {
+        {PHFWD_ADD, "12345678901234567", "98765432109876543210"},
+        {PHFWD_ADD, "1234567890123456", "9876543210987654"},
+        {PHFWD_ADD, "123456789012345", "98765432109876543210"},
+        {PHFWD_ADD, "123456789012345678", "9876543210987654"},
+        {PHFWD_ADD, "12345678901234568", "987654321098765432"},
+        {PHFWD_ADD, "123456789012345679", "98765432109876543"},
+        {PHFWD_REMOVE, "123456789012345678", NULL},
+        {PHFWD_ADD, "12345678901234567", "9876543210987654321"},
+        {PHFWD_ADD, "1234567890123457", "98765432109876543210"}
+    };
+    T(phfwdApplyBatch(pf, long_numbers, SIZE(long_numbers)));
+    CHECK(pf, "123456789012345", "98765432109876543210");
+    CHECK(pf, "1234567890123456", "9876543210987654");
+    CHECK(pf, "12345678901234567", "9876543210987654321");
+    CHECK(pf, "123456789012345678", "98765432109876543218");
+    CHECK(pf, "123456789012345679", "98765432109876543");
+    CHECK(pf, "12345678901234568", "987654321098765432");
+    CHECK(pf, "1234567890123457", "98765432109876543210");
+    CHECK(pf, "12345678901234589", "9876543210987654321089");
+    RCHCK(pf, "98765432109876543210", "123456789012345", "12345678901234563210", "123456789012345670",
+          "123456789012345679210", "1234567890123456810", "1234567890123457", "98765432109876543210");
+    RCHCK(pf, "9876543210987654", "1234567890123456", "9876543210987654");
+
+    phfwdDelete(pq);
+    CLEAN(pf);
+}
+
+// Kolejne pary numerów dla phfwdBulkLoad
+typedef struct {
+    char const *(*pairs)[2];
+    size_t count;
+    size_t position;
+} pair_source;
+
+static bool next_pair(char const **num1, char const **num2, void *data) {
+    pair_source *source = data;
+    if (source->position == source->count)
+        return false;
+    *num1 = source->pairs[source->position][0];
+    *num2 = source->pairs[source->position][1];
+    ++source->position;
+    return true;
+}
+
+// Testy wczytywania posortowanych przekierowań
+static int bulk_load(void) {
+#define BULK_COUNT 2000
+    static char nums[BULK_COUNT][2][8];
+    static char const *pairs[BULK_COUNT][2];
+    char b[8];
+
+    INIT(pf);
+    PhoneForward *pq;
+    N(pq = phfwdNew());
+
+    for (unsigned i = 0; i < BULK_COUNT; ++i) {
+        sprintf(nums[i][0], "%u", i * 7 + 1);
+        sprintf(nums[i][1], "%u", (i * 37) % 500);
+        T(phfwdAdd(pq, nums[i][0], nums[i][1]));
+    }
+    // Sortujemy napisy w porządku leksykograficznym.
+    size_t count = 0;
+    for (unsigned i = 0; i < BULK_COUNT; ++i) {
+        size_t j = count;
+        while (j > 0 && strcmp(pairs[j - 1][0], nums[i][0]) > 0) {
+            pairs[j][0] = pairs[j - 1][0];
+            pairs[j][1] = pairs[j - 1][1];
+            --j;
+        }
+        pairs[j][0] = nums[i][0];
+        pairs[j][1] = nums[i][1];
+        ++count;
+    }
+    pair_source source = {pairs, count, 0};
+    T(phfwdBulkLoad(pf, next_pair, &source));
+    for (unsigned i = 0; i < BULK_COUNT * 7 + 10; i += 3) {
+        PhoneNumbers *p1, *p2;
+        sprintf(b, "%u", i);
+        N(p1 = phfwdGet(pf, b));
+        N(p2 = phfwdGet(pq, b));
+        C(phnumGet(p1, 0), phnumGet(p2, 0));
+        phnumDelete(p1);
+        phnumDelete(p2);
+    }
+    for (unsigned i = 0; i < 500; ++i) {
+        PhoneNumbers *p1, *p2;
+        sprintf(b, "%u", i);
+        N(p1 = phfwdReverse(pf, b));
+        N(p2 = phfwdReverse(pq, b));
+        size_t k = 0;
+        for (; phnumGet(p2, k) != NULL; ++k)
+            C(phnumGet(p1, k), phnumGet(p2, k));
+        Q(p1, k);
+        phnumDelete(p1);
+        phnumDelete(p2);
+    }
+    source.position = 0;
+    F(phfwdBulkLoad(pf, next_pair, &source));
+
+    // Nieposortowane dane nie zmieniają pustej struktury.
+    REINIT(pf);
+    char const *unsorted[][2] = {{"1", "2"}, {"12", "3"}, {"11", "4"}};
+    pair_source wrong = {unsorted, SIZE(unsorted), 0};
+    F(phfwdBulkLoad(pf, next_pair, &wrong));
+    CHECK(pf, "12", "12");
+    RCHCK(pf, "2", "2");
+    char const *sorted[][2] = {{"1", "2"}, {"11", "4"}, {"12", "2"}, {"9*", "2"}, {"9#", "3"}};
+    pair_source right = {sorted, SIZE(sorted), 0};
+    T(phfwdBulkLoad(pf, next_pair, &right));
+    CHECK(pf, "123", "23");
+    CHECK(pf, "9#1", "31");
+    RCHCK(pf, "23", "123", "13", "23", "9*3");
+
+    phfwdDelete(pq);
+    CLEAN(pf);
+}
+
+// Testy struktury bez drzewa odwróceń
+static int forward_only(void) {
+    char b1[8], b2[8];
+
+    PhoneForward *pf;
+    N(pf = phfwdNewForwardOnly());
+    PhoneForward *pq;
+    N(pq = phfwdNew());
+
+    for (unsigned i = 0; i < 3000; ++i) {
+        sprintf(b1, "%u", (i * 7919) % 20000);
+        sprintf(b2, "%u", (i * 31) % 700);
+        T(phfwdAdd(pf, b1, b2) == phfwdAdd(pq, b1, b2));
+        if (i % 11 == 0) {
+            sprintf(b1, "%u", i % 100);
+            phfwdRemove(pf, b1);
+            phfwdRemove(pq, b1);
+        }
+    }
+    CHECK(pf, "12345", "12345");
+    T(phfwdAdd(pf, "1234", "0"));
+    T(phfwdAdd(pq, "1234", "0"));
+    CHECK(pf, "12345", "05");
+    Z(phfwdReverse(pf, "1"));
+    Z(phfwdGetReverse(pf, "1"));
+    Z(phfwdReverseIter(pf, "1"));
+
+    T(phfwdBuildReverseIndex(pf));
+    T(phfwdBuildReverseIndex(pf));
+    for (unsigned i = 0; i < 700; ++i) {
+        PhoneNumbers *p1, *p2;
+        sprintf(b1, "%u", i);
+        N(p1 = phfwdReverse(pf, b1));
+        N(p2 = phfwdReverse(pq, b1));
+        size_t k = 0;
+        for (; phnumGet(p2, k) != NULL; ++k)
+            C(phnumGet(p1, k), phnumGet(p2, k));
+        Q(p1, k);
+        phnumDelete(p1);
+        phnumDelete(p2);
+    }
+    // Po zbudowaniu drzewo odwróceń jest utrzymywane.
+    T(phfwdAdd(pf, "77", "0"));
+    phfwdRemove(pf, "1234");
+    T(phfwdAdd(pq, "77", "0"));
+    phfwdRemove(pq, "1234");
+    for (unsigned i = 0; i < 700; i += 7) {
+        PhoneNumbers *p1, *p2;
+        sprintf(b1, "0%u", i);
+        N(p1 = phfwdGetReverse(pf, b1));
+        N(p2 = phfwdGetReverse(pq, b1));
+        size_t k = 0;
+        for (; phnumGet(p2, k) != NULL; ++k)
+            C(phnumGet(p1, k), phnumGet(p2, k));
+        Q(p1, k);
+        phnumDelete(p1);
+        phnumDelete(p2);
+    }
+    F(phfwdBuildReverseIndex(NULL));
+
+    phfwdDelete(pq);
+    CLEAN(pf);
+}
+
+// Zapisuje wszystkie przekierowania do napisu.
+static char *dump_all(PhoneForward const *pf) {
+    char *text = NULL;
+    size_t size = 0;
+    FILE *file = open_memstream(&text, &size);
+    if (file == NULL)
+        return NULL;
+    bool ok = phfwdDumpPrefix(pf, NULL, file);
+    fclose(file);
+    if (!ok) {
+        free(text);
+        return NULL;
+    }
+    return text;
+}
+
+// Oczekiwane jednakowe przekierowania w dwóch strukturach
+#define SAME(p, q)                  \
+  do {                              \
+    char *_a = dump_all(p);         \
+    char *_b = dump_all(q);         \
+    bool _same = _a != NULL && _b != NULL && strcmp(_a, _b) == 0; \
+    free(_a);                       \
+    free(_b);                       \
+    T(_same);                       \
+  } while (0)
+
+// Testy dziennika operacji i migawek
+static int operation_log(void) {
+    char log_path[64], snapshot_path[64], b1[8], b2[8];
+    sprintf(log_path, "/tmp/phfwd_test_%d.log", (int)getpid());
+    sprintf(snapshot_path, "/tmp/phfwd_test_%d.snap", (int)getpid());
+    unlink(log_path);
+
+    INIT(pf);
+    PhoneForward *pq;
+    T(phfwdOpenLog(pf, log_path, 3));
+    F(phfwdOpenLog(pf, log_path, 3));
+    for (unsigned i = 0; i < 500; ++i) {
+        sprintf(b1, "%u", (i * 37) % 1000);
+        sprintf(b2, "%u*", i % 50);
+        T(phfwdAdd(pf, b1, b2));
+        if (i % 13 == 0) {
+            sprintf(b1, "%u", i % 20);
+            phfwdRemove(pf, b1);
+        }
+    }
+    F(phfwdAdd(pf, "12", "12"));
+    PhoneForwardOperation ops[] = {
+        {PHFWD_ADD, "#1", "2"}, {PHFWD_REMOVE, "3", NULL}, {PHFWD_ADD, "31", "4"}
+    };
+    T(phfwdApplyBatch(pf, ops, SIZE(ops)));
+    T(phfwdSyncLog(pf));
+
+    N(pq = phfwdNew());
+    T(phfwdReplay(pq, log_path));
+    SAME(pf, pq);
+    phfwdDelete(pq);
+
+    // Niepełny rekord na końcu dziennika jest pomijany i obcinany.
+    T(phfwdCloseLog(pf));
+    FILE *file = fopen(log_path, "a");
+    N(file);
+    fputs("\1\5", file);
+    fclose(file);
+    N(pq = phfwdNew());
+    T(phfwdReplay(pq, log_path));
+    SAME(pf, pq);
+    phfwdDelete(pq);
+    T(phfwdOpenLog(pf, log_path, 0));
+    T(phfwdAdd(pf, "5", "6"));
+
+    // Po zapisaniu migawki dziennik zawiera tylko nowe operacje.
+    T(phfwdCompactLog(pf, snapshot_path));
+    phfwdRemove(pf, "1");
+    T(phfwdAdd(pf, "123", "0"));
+    T(phfwdSyncLog(pf));
+    N(pq = phfwdNew());
+    T(phfwdLoadSnapshot(pq, snapshot_path));
+    F(phfwdLoadSnapshot(pq, snapshot_path));
+    T(phfwdReplay(pq, log_path));
+    SAME(pf, pq);
+    CHECK(pq, "1234", "04");
+    phfwdDelete(pq);
+
+    F(phfwdReplay(pf, snapshot_path));
+    F(phfwdLoadSnapshot(pf, log_path));
+    unlink(log_path);
+    unlink(snapshot_path);
+    CLEAN(pf);
+}
+
+// Licznik zakończonych zapisów migawki w tle
+static void count_saves(bool success, void *data) {
+    if (success)
+        ++*(int *)data;
+}
+
+// Testy zapisu migawki w tle
+static int background_save(void) {
+    char path[64], b1[8], b2[8];
+    sprintf(path, "/tmp/phfwd_test_%d.bgsnap", (int)getpid());
+    int saved = 0;
+
+    INIT(pf);
+    PhoneForward *pq, *pr;
+    N(pq = phfwdNew());
+    for (unsigned i = 0; i < 300; ++i) {
+        sprintf(b1, "%u", (i * 7) % 500);
+        sprintf(b2, "%u#", i % 30);
+        T(phfwdAdd(pf, b1, b2));
+        T(phfwdAdd(pq, b1, b2));
+    }
+    T(phfwdBackgroundSaveStatus(pf, false) == PHFWD_SAVE_NONE);
+    T(phfwdBackgroundSave(pf, path, count_saves, &saved));
+    F(phfwdBackgroundSave(pf, path, NULL, NULL));
+    // Zmiany po rozpoczęciu zapisu nie trafiają do migawki.
+    phfwdRemove(pf, "1");
+    T(phfwdAdd(pf, "2", "9"));
+    T(phfwdBackgroundSaveStatus(pf, true) == PHFWD_SAVE_DONE);
+    T(phfwdBackgroundSaveStatus(pf, false) == PHFWD_SAVE_DONE);
+    T(saved == 1);
+    N(pr = phfwdNew());
+    T(phfwdLoadSnapshot(pr, path));
+    SAME(pq, pr);
+    CHECK(pf, "2#", "9#");
+
+    // Zapis do niedostępnego pliku kończy się niepowodzeniem.
+    T(phfwdBackgroundSave(pf, "/nonexistent/phfwd.snap", count_saves, &saved));
+    T(phfwdBackgroundSaveStatus(pf, true) == PHFWD_SAVE_FAILED);
+    T(saved == 1);
+    F(phfwdBackgroundSave(NULL, path, NULL, NULL));
+    T(phfwdBackgroundSaveStatus(NULL, true) == PHFWD_SAVE_NONE);
+
+    // Usunięcie struktury czeka na zakończenie zapisu.
+    T(phfwdBackgroundSave(pq, path, NULL, NULL));
+    phfwdDelete(pq);
+    phfwdDelete(pr);
+    N(pr = phfwdNew());
+    T(phfwdLoadSnapshot(pr, path));
+    phfwdDelete(pr);
+    unlink(path);
+    CLEAN(pf);
+}
+
+// Testy zapisu przyrostowego
+static int incremental_save(void) {
+    char base[64], delta1[64], delta2[64], delta3[64], b1[8], b2[8];
+    sprintf(base, "/tmp/phfwd_test_%d.base", (int)getpid());
+    sprintf(delta1, "/tmp/phfwd_test_%d.d1", (int)getpid());
+    sprintf(delta2, "/tmp/phfwd_test_%d.d2", (int)getpid());
+    sprintf(delta3, "/tmp/phfwd_test_%d.d3", (int)getpid());
+
+    INIT(pf);
+    PhoneForward *pq;
+    for (unsigned i = 0; i < 2000; ++i) {
+        sprintf(b1, "%u", (i * 7919) % 100000);
+        sprintf(b2, "%u*", i % 97);
+        T(phfwdAdd(pf, b1, b2));
+    }
+    F(phfwdSaveIncremental(pf, base, delta1));
+    T(phfwdSaveIncremental(pf, NULL, base));
+
+    // Zmiany: zastąpienie, dodanie, usunięcie i ponowne dodanie pod usuniętym prefiksem.
+    T(phfwdAdd(pf, "7919", "1"));
+    T(phfwdAdd(pf, "555555", "2"));
+    phfwdRemove(pf, "12");
+    T(phfwdAdd(pf, "1234", "3"));
+    phfwdRemove(pf, "9");
+    phfwdSetRemovalBudget(pf, 1);
+    phfwdRemove(pf, "88");
+    PhoneForwardOperation ops[] = {
+        {PHFWD_ADD, "881", "4"}, {PHFWD_REMOVE, "5", NULL}, {PHFWD_ADD, "56", "5"}
+    };
+    T(phfwdApplyBatch(pf, ops, SIZE(ops)));
+    T(phfwdSaveIncremental(pf, base, delta1));
+    F(phfwdSaveIncremental(pf, base, delta2));
+
+    phfwdRemove(pf, "1234");
+    T(phfwdAdd(pf, "0", "6"));
+    T(phfwdSaveIncremental(pf, delta1, delta2));
+
+    // Zmiany zajmują mniej miejsca niż pełna migawka.
+    struct stat full, part;
+    Z(stat(base, &full));
+    Z(stat(delta1, &part));
+    T(part.st_size * 10 < full.st_size);
+
+    N(pq = phfwdNew());
+    F(phfwdLoadIncremental(pq, delta1));
+    T(phfwdLoadSnapshot(pq, base));
+    F(phfwdLoadIncremental(pq, delta2));
+    T(phfwdLoadIncremental(pq, delta1));
+    F(phfwdLoadIncremental(pq, delta1));
+    T(phfwdLoadIncremental(pq, delta2));
+    SAME(pf, pq);
+    CHECK(pq, "12345", "12345");
+    CHECK(pq, "881", "4");
+
+    // Wczytana struktura może kontynuować ciąg zapisów.
+    T(phfwdAdd(pq, "77", "8"));
+    T(phfwdSaveIncremental(pq, delta2, delta3));
+    phfwdDelete(pq);
+    N(pq = phfwdNew());
+    T(phfwdLoadSnapshot(pq, base));
+    T(phfwdLoadIncremental(pq, delta1));
+    T(phfwdLoadIncremental(pq, delta2));
+    T(phfwdLoadIncremental(pq, delta3));
+    CHECK(pq, "77#", "8#");
+    phfwdDelete(pq);
+
+    // Zwykła migawka nie może być podstawą zapisu przyrostowego.
+    N(pq = phfwdNew());
+    T(phfwdSaveSnapshot(pf, base));
+    T(phfwdLoadSnapshot(pq, base));
+    F(phfwdSaveIncremental(pq, base, delta2));
+    phfwdDelete(pq);
+
+    unlink(base);
+    unlink(delta1);
+    unlink(delta2);
+    unlink(delta3);
+    CLEAN(pf);
+}
+
+// Testy wczytywania i zapisu w postaci tekstowej
+static int text_import_export(void) {
+    char path[64], b1[16], b2[16];
+    sprintf(path, "/tmp/phfwd_test_%d.txt", (int)getpid());
+
+    INIT(pf);
+    PhoneForward *pq;
+    FILE *file = fopen(path, "w");
+    N(file);
+    fputs("\n  12 34\r\n*5,6\n*7;\t8  \n\n", file);
+    // Tyle wierszy, że zajmą kilka bloków odczytu.
+    for (unsigned i = 0; i < 150000; ++i)
+        fprintf(file, "%u %u*\n", (i * 7919u) % 1000000u, i % 1000);
+    fputs("12 99\n9#* 0", file);
+    fclose(file);
+    int fd = open(path, O_RDONLY);
+    T(fd >= 0);
+    T(phfwdImportText(pf, fd));
+    close(fd);
+    CHECK(pf, "12#", "99#");
+    CHECK(pf, "*55", "65");
+    CHECK(pf, "*7", "8");
+    CHECK(pf, "9#*", "0");
+    N(pq = phfwdNew());
+    T(phfwdAdd(pq, "*5", "6"));
+    T(phfwdAdd(pq, "*7", "8"));
+    for (unsigned i = 0; i < 150000; ++i) {
+        sprintf(b1, "%u", (i * 7919u) % 1000000u);
+        sprintf(b2, "%u*", i % 1000);
+        T(phfwdAdd(pq, b1, b2));
+    }
+    T(phfwdAdd(pq, "12", "99"));
+    T(phfwdAdd(pq, "9#*", "0"));
+    SAME(pf, pq);
+    phfwdDelete(pq);
+
+    // Zapis i ponowne wczytanie dają te same przekierowania.
+    fd = open(path, O_WRONLY | O_TRUNC);
+    T(fd >= 0);
+    T(phfwdExportText(pf, fd));
+    close(fd);
+    N(pq = phfwdNew());
+    fd = open(path, O_RDONLY);
+    T(phfwdImportText(pq, fd));
+    close(fd);
+    SAME(pf, pq);
+    phfwdDelete(pq);
+
+    // Błędne wiersze.
+    char const *wrong[] = {"1 2\n3\n", "1 2 3\n", "1a 2\n", "12 12\n", "1 2\n  x"};
+    for (size_t i = 0; i < SIZE(wrong); ++i) {
+        file = fopen(path, "w");
+        N(file);
+        fputs(wrong[i], file);
+        fclose(file);
+        N(pq = phfwdNew());
+        fd = open(path, O_RDONLY);
+        F(phfwdImportText(pq, fd));
+        close(fd);
+        phfwdDelete(pq);
+    }
+    F(phfwdImportText(NULL, 0));
+    F(phfwdExportText(pf, -1));
+
+    unlink(path);
+    CLEAN(pf);
+}
+
+// Zapamiętuje wyniki zapytań paczki.
+typedef struct {
+    char **results;
+    size_t calls;
+    size_t limit;
+} batch_results_t;
+
+static bool collect_result(size_t idx, char const *num, void *data) {
+    batch_results_t *r = data;
+    ++r->calls;
+    free(r->results[idx]);
+    r->results[idx] = (num == NULL) ? NULL : strdup(num);
+    return r->calls != r->limit;
+}
+
+static int get_batch(void) {
+    char const *nums[300];
+    char buffer[300][16];
+    char *results[SIZE(nums)] = {NULL};
+    batch_results_t r = {results, 0, 0};
+
+    INIT(pf);
+    T(phfwdAdd(pf, "1", "9"));
+    T(phfwdAdd(pf, "12", "8*"));
+    T(phfwdAdd(pf, "123", "7"));
+    T(phfwdAdd(pf, "2", "#"));
+    T(phfwdAdd(pf, "3456", "0"));
+    T(phfwdAdd(pf, "34", "6"));
+    for (size_t i = 0; i < SIZE(nums); ++i) {
+        sprintf(buffer[i], "%zu", (i * 7919) % 4000);
+        nums[i] = buffer[i];
+    }
+    nums[5] = "";
+    nums[17] = "12a";
+    nums[18] = NULL;
+    nums[40] = "1234";
+    nums[41] = "1234";
+    nums[42] = "12";
+    nums[43] = "123456789012345678901234567890";
+    T(phfwdGetBatch(pf, nums, SIZE(nums), collect_result, &r));
+    T(r.calls == SIZE(nums));
+    for (size_t i = 0; i < SIZE(nums); ++i) {
+        if (onlyDigitsAndNotEmpty(nums[i])) {
+            CHECK(pf, nums[i], results[i]);
+        }
+        else {
+            Z(results[i]);
+        }
+    }
+    C(results[40], "74");
+    C(results[41], "74");
+    C(results[42], "8*");
+    C(results[43], "7456789012345678901234567890");
+
+    // Przerwanie wyznaczania.
+    r.calls = 0;
+    r.limit = 7;
+    F(phfwdGetBatch(pf, nums, SIZE(nums), collect_result, &r));
+    T(r.calls == 7);
+    T(phfwdGetBatch(pf, nums, 0, collect_result, &r));
+    F(phfwdGetBatch(NULL, nums, 1, collect_result, &r));
+    F(phfwdGetBatch(pf, nums, 1, NULL, &r));
+
+    for (size_t i = 0; i < SIZE(nums); ++i)
+        free(results[i]);
+    CLEAN(pf);
+}
+
+// Sprawdza, czy ciągi numerów są równe.
+static bool same_numbers(PhoneNumbers const *a, PhoneNumbers const *b) {
+    if ((a == NULL) || (b == NULL))
+        return false;
+    for (size_t i = 0;; ++i) {
+        char const *x = phnumGet(a, i);
+        char const *y = phnumGet(b, i);
+        if ((x == NULL) || (y == NULL))
+            return x == y;
+        if (strcmp(x, y) != 0)
+            return false;
+    }
+}
+
+// Porównuje wyniki zapytań do struktury i do opublikowanych przekierowań.
+static bool same_as_shared(PhoneForward *pf, PhoneForwardShared *shared, char const *num) {
+    PhoneNumbers *a, *b;
+    bool result = true;
+    a = phfwdGet(pf, num);
+    b = phfwdSharedGet(shared, num);
+    result = result && same_numbers(a, b);
+    phnumDelete(a);
+    phnumDelete(b);
+    a = phfwdReverse(pf, num);
+    b = phfwdSharedReverse(shared, num);
+    result = result && same_numbers(a, b);
+    phnumDelete(a);
+    phnumDelete(b);
+    a = phfwdGetReverse(pf, num);
+    b = phfwdSharedGetReverse(shared, num);
+    result = result && same_numbers(a, b);
+    phnumDelete(a);
+    phnumDelete(b);
+    return result;
+}
+
+static int shared_table(void) {
+    char names[2][64], b1[16], b2[16];
+    sprintf(names[0], "/tmp/phfwd_test_%d.shared", (int)getpid());
+    sprintf(names[1], "/phfwd_test_%d", (int)getpid());
+
+    for (size_t k = 0; k < SIZE(names); ++k) {
+        char const *name = names[k];
+        INIT(pf);
+        Z(phfwdAttach(name));
+        F(phfwdUnpublish(name));
+        phfwdSetRemovalBudget(pf, 3);
+        for (unsigned i = 0; i < 3000; ++i) {
+            sprintf(b1, "%u", (i * 7919u) % 10000u);
+            sprintf(b2, "%u#", (i * 104729u) % 300u);
+            T(phfwdAdd(pf, b1, b2));
+        }
+        T(phfwdAdd(pf, "*", "1"));
+        phfwdRemove(pf, "55");
+        T(phfwdPublish(pf, name));
+
+        PhoneForwardShared *shared, *other;
+        N(shared = phfwdAttach(name));
+        for (unsigned i = 0; i < 400; ++i) {
+            sprintf(b1, "%u", (i * 31u) % 1000u);
+            T(same_as_shared(pf, shared, b1));
+            sprintf(b1, "%u#%u", i % 300u, i);
+            T(same_as_shared(pf, shared, b1));
+        }
+        T(same_as_shared(pf, shared, "*12"));
+        T(same_as_shared(pf, shared, "55123"));
+        T(same_as_shared(pf, shared, "12a"));
+        T(same_as_shared(pf, shared, ""));
+
+        // Nowa wersja jest widoczna przy kolejnym zapytaniu, a nowo dołączony
+        // proces widzi ją od razu.
+        PhoneNumbers *pnum;
+        N(pnum = phfwdSharedGet(shared, "*2"));
+        R(pnum, 0, "12");
+        phnumDelete(pnum);
+        T(phfwdAdd(pf, "*", "77"));
+        phfwdRemove(pf, "1");
+        T(phfwdPublish(pf, name));
+        N(other = phfwdAttach(name));
+        N(pnum = phfwdSharedGet(shared, "*2"));
+        R(pnum, 0, "772");
+        phnumDelete(pnum);
+        for (unsigned i = 0; i < 300; ++i) {
+            sprintf(b1, "%u#%u", i, i);
+            T(same_as_shared(pf, shared, b1));
+            T(same_as_shared(pf, other, b1));
+        }
+        phfwdDetach(other);
+        phfwdDetach(shared);
+        T(phfwdUnpublish(name));
+        Z(phfwdAttach(name));
+        phfwdDelete(pf);
+
+        // Struktura bez drzewa odwróceń odpowiada tylko na zapytania o przekierowanie.
+        N(pf = phfwdNewForwardOnly());
+        T(phfwdAdd(pf, "12", "3"));
+        T(phfwdPublish(pf, name));
+        N(shared = phfwdAttach(name));
+        CHECK(pf, "129", "39");
+        N(pnum = phfwdSharedGet(shared, "129"));
+        R(pnum, 0, "39");
+        phnumDelete(pnum);
+        Z(phfwdSharedReverse(shared, "3"));
+        phfwdDetach(shared);
+        T(phfwdUnpublish(name));
+        phfwdDelete(pf);
+    }
+    F(phfwdPublish(NULL, names[0]));
+    Z(phfwdAttach(NULL));
+    Z(phfwdSharedGet(NULL, "1"));
+    phfwdDetach(NULL);
+    return PASS;
+}
+
+// Porównuje wyniki zapytań do dwóch struktur.
+static bool same_results(PhoneForward *pf, PhoneForward *other, char const *num) {
+    PhoneNumbers *a, *b;
+    bool result = true;
+    a = phfwdGet(pf, num);
+    b = phfwdGet(other, num);
+    result = result && same_numbers(a, b);
+    phnumDelete(a);
+    phnumDelete(b);
+    a = phfwdReverse(pf, num);
+    b = phfwdReverse(other, num);
+    result = result && same_numbers(a, b);
+    phnumDelete(a);
+    phnumDelete(b);
+    a = phfwdGetReverse(pf, num);
+    b = phfwdGetReverse(other, num);
+    result = result && same_numbers(a, b);
+    phnumDelete(a);
+    phnumDelete(b);
+    return result;
+}
+
+// Sprawdza, czy każdy numer należy do przeciwobrazu swojego przekierowania.
+static bool consistent_mapped(PhoneForward *pf, unsigned keys) {
+    char b1[16];
+    bool result = true;
+    for (unsigned i = 0; result && (i < keys); ++i) {
+        sprintf(b1, "%u", i);
+        PhoneNumbers *a = phfwdGet(pf, b1);
+        PhoneNumbers *b = (a == NULL) ? NULL : phfwdGetReverse(pf, phnumGet(a, 0));
+        bool found = false;
+        for (size_t j = 0; (b != NULL) && (phnumGet(b, j) != NULL); ++j)
+            found = found || (strcmp(phnumGet(b, j), b1) == 0);
+        result = found;
+        phnumDelete(a);
+        phnumDelete(b);
+    }
+    return result;
+}
+
+static int mapped_table(void) {
+    char path[64], b1[16], b2[16];
+    sprintf(path, "/tmp/phfwd_test_%d.mapped", (int)getpid());
+    unlink(path);
+
+    INIT(pf);
+    PhoneForward *mapped;
+    N(mapped = phfwdOpenMapped(path, false));
+    Z(phfwdOpenMapped(path, false));
+    for (unsigned i = 0; i < 6000; ++i) {
+        sprintf(b1, "%u", (i * 7919u) % 3000u);
+        sprintf(b2, "%u#", (i * 104729u) % 200u);
+        if (i % 97 == 96) {
+            sprintf(b1, "%u", i % 30u);
+            phfwdRemove(pf, b1);
+            phfwdRemove(mapped, b1);
+        }
+        else {
+            T(phfwdAdd(pf, b1, b2));
+            T(phfwdAdd(mapped, b1, b2));
+        }
+        if (i % 500 == 0) {
+            for (unsigned j = 0; j < 200; ++j) {
+                sprintf(b1, "%u#%u", j, i);
+                T(same_results(pf, mapped, b1));
+            }
+        }
+    }
+    for (unsigned i = 0; i < 3000; i += 7) {
+        sprintf(b1, "%u5", i);
+        T(same_results(pf, mapped, b1));
+    }
+    T(same_results(pf, mapped, "12a"));
+    T(same_results(pf, mapped, ""));
+    T(phfwdSyncMapped(mapped));
+
+    // Operacje, które wymagają przekierowań w pamięci, są niedostępne.
+    F(phfwdSaveSnapshot(mapped, path));
+    F(phfwdOpenLog(mapped, path, 0));
+    F(phfwdBuildReverseIndex(mapped));
+    F(phfwdPublish(mapped, path));
+    F(phfwdDumpPrefix(mapped, "", stdout));
+    phfwdDelete(mapped);
+
+    // Ponowne otwarcie nie wczytuje przekierowań, a widzi wszystkie.
+    N(mapped = phfwdOpenMapped(path, true));
+    for (unsigned i = 0; i < 3000; i += 3) {
+        sprintf(b1, "%u", i);
+        T(same_results(pf, mapped, b1));
+    }
+    phfwdRemove(pf, "1");
+    phfwdRemove(mapped, "1");
+    T(phfwdAdd(pf, "2", "1#"));
+    T(phfwdAdd(mapped, "2", "1#"));
+    F(phfwdAdd(mapped, "2", "2"));
+    for (unsigned i = 0; i < 200; ++i) {
+        sprintf(b1, "%u#1", i);
+        T(same_results(pf, mapped, b1));
+    }
+    phfwdDelete(mapped);
+    phfwdDelete(pf);
+
+    // Przerwanie procesu w trakcie zmian pozostawia spójny stan.
+    pid_t child = fork();
+    if (child == 0) {
+        PhoneForward *writer = phfwdOpenMapped(path, false);
+        for (unsigned i = 0; writer != NULL; ++i) {
+            sprintf(b1, "%u", (i * 7919u) % 3000u);
+            sprintf(b2, "%u*", i % 500u);
+            if (i % 13 == 0)
+                phfwdRemove(writer, b1);
+            else
+                phfwdAdd(writer, b1, b2);
+        }
+        _exit(1);
+    }
+    T(child > 0);
+    usleep(100000);
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    N(mapped = phfwdOpenMapped(path, false));
+    T(consistent_mapped(mapped, 3000));
+    phfwdDelete(mapped);
+
+    // Plik, który nie jest plikiem przekierowań, nie jest otwierany.
+    int fd = open(path, O_WRONLY | O_TRUNC);
+    T(fd >= 0);
+    T(write(fd, "PFWDMAP0", 8) == 8);
+    close(fd);
+    Z(phfwdOpenMapped(path, false));
+    unlink(path);
+    Z(phfwdOpenMapped(NULL, false));
+    F(phfwdSyncMapped(NULL));
+    return PASS;
+}
+
+// Numery kończące się tuż przed niedostępną stroną pamięci, o różnych
+// długościach i dowolnym wyrównaniu początku.
+static int number_edges(void) {
+    long page = sysconf(_SC_PAGESIZE);
+    char *area = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED)
+        return FAIL;
+    if (mprotect(area + page, page, PROT_NONE) != 0) {
+        munmap(area, 2 * page);
+        return FAIL;
+    }
+    static char const alphabet[] = "0123456789*#";
+    int result = PASS;
+    for (size_t length = 1; length <= 100 && result == PASS; ++length) {
+        char *num = area + page - length - 1;
+        for (size_t i = 0; i < length; ++i)
+            num[i] = alphabet[(i * 7 + length) % 12];
+        num[length] = '\0';
+
+        PhoneForward *pf = phfwdNew();
+        PhoneNumbers *pn = phfwdGet(pf, num);
+        if (pf == NULL || pn == NULL || phnumGet(pn, 0) == NULL ||
+            strcmp(phnumGet(pn, 0), num) != 0 || !phfwdAdd(pf, num, "7"))
+            result = FAIL;
+        phnumDelete(pn);
+        pn = phfwdGet(pf, num);
+        if (result == PASS && (pn == NULL || phnumGet(pn, 0) == NULL ||
+                               strcmp(phnumGet(pn, 0), "7") != 0))
+            result = FAIL;
+        phnumDelete(pn);
+        pn = phfwdGetReverse(pf, "7");
+        char const *first = phnumGet(pn, 0);
+        char const *second = phnumGet(pn, 1);
+        if (result == PASS && (first == NULL || second == NULL || phnumGet(pn, 2) != NULL ||
+                               (strcmp(first, num) != 0 && strcmp(second, num) != 0)))
+            result = FAIL;
+        phnumDelete(pn);
+
+        // Numer nie może być przekierowany na siebie, ale na numer różniący
+        // się ostatnią cyfrą już tak.
+        char *copy = area + page / 2 - length - 1;
+        memcpy(copy, num, length + 1);
+        if (result == PASS && (phfwdAdd(pf, num, copy) || phfwdAdd(pf, copy, num)))
+            result = FAIL;
+        copy[length - 1] = (copy[length - 1] == '#') ? '*' : '#';
+        if (result == PASS && (!phfwdAdd(pf, copy, num) || !phfwdAdd(pf, num, copy)))
+            result = FAIL;
+
+        // Błędny znak na dowolnej pozycji unieważnia cały numer.
+        for (size_t i = 0; i < length && result == PASS; ++i) {
+            char saved = num[i];
+            num[i] = (i % 2 == 0) ? 'a' : '/';
+            if (phfwdAdd(pf, num, "8") || phfwdAdd(pf, "8", num))
+                result = FAIL;
+            num[i] = saved;
+        }
+        phfwdDelete(pf);
+    }
+    munmap(area, 2 * page);
+    return result;
+}
+
+// Losowy numer długości od 1 do max nad alfabetem z kilku cyfr, aby prefiksy
+// często się powtarzały.
+static void random_number(char *num, int max) {
+    static char const alphabet[] = "0129*#";
+    int length = 1 + rand() % max;
+    for (int i = 0; i < length; ++i)
+        num[i] = alphabet[rand() % 6];
+    num[length] = '\0';
+}
+
+// Tablica bezpośredniego dostępu nie zmienia wyników żadnej operacji.
+static int direct_index(void) {
+    static size_t const depths[] = {3, 1, 2, 5, 0};
+    char b1[16], b2[16], b3[16], b4[16];
+    INIT(pf);
+    PhoneForward *other;
+    N(other = phfwdNew());
+
+    Z(phfwdDirectIndexDepth(pf));
+    Z(phfwdDirectIndexDepth(NULL));
+    F(phfwdBuildDirectIndex(NULL, 0));
+    F(phfwdBuildDirectIndex(pf, 6));
+    srand(43);
+    for (size_t round = 0; round < SIZE(depths); ++round) {
+        T(phfwdBuildDirectIndex(pf, depths[round]));
+        if (depths[round] != 0 && phfwdDirectIndexDepth(pf) != depths[round])
+            return FAIL;
+        if (phfwdDirectIndexDepth(pf) < 1 || phfwdDirectIndexDepth(pf) > 5)
+            return FAIL;
+        phfwdSetRemovalBudget(pf, round % 2);
+        phfwdSetRemovalBudget(other, round % 2);
+        for (int i = 0; i < 2000; ++i) {
+            random_number(b1, 7);
+            random_number(b2, 4);
+            int op = rand() % 20;
+            if (op < 15) {
+                if (phfwdAdd(pf, b1, b2) != phfwdAdd(other, b1, b2))
+                    return FAIL;
+            }
+            else if (op < 19) {
+                phfwdRemove(pf, b1);
+                phfwdRemove(other, b1);
+            }
+            else {
+                random_number(b3, 3);
+                random_number(b4, 5);
+                PhoneForwardOperation ops[] = {
+                    {PHFWD_ADD, b1, b2}, {PHFWD_REMOVE, b3, NULL}, {PHFWD_ADD, b4, b1}
+                };
+                if (phfwdApplyBatch(pf, ops, SIZE(ops)) != phfwdApplyBatch(other, ops, SIZE(ops)))
+                    return FAIL;
+            }
+        }
+        for (int i = 0; i < 1000; ++i) {
+            random_number(b1, 9);
+            T(same_results(pf, other, b1));
+        }
+    }
+
+    phfwdDelete(other);
+    CLEAN(pf);
+}
+
+// Losowy numer, który co jakiś czas jest długi, aby powiększać zakres długości.
+static void random_long_number(char *num, int max) {
+    random_number(num, max);
+    if (rand() % 50 == 0) {
+        int length = 20 + rand() % 100;
+        for (int i = (int)strlen(num); i < length; ++i)
+            num[i] = "0129*#"[rand() % 6];
+        num[length] = '\0';
+    }
+}
+
+// Tablice haszujące dają takie same wyniki jak drzewo.
+static int hashed_table(void) {
+    char b1[128], b2[128], b3[128];
+    PhoneForward *pf, *other;
+    N(pf = phfwdNewHashed());
+    N(other = phfwdNew());
+
+    T(same_results(pf, other, "123"));
+    F(phfwdAdd(pf, "12", "12"));
+    F(phfwdAdd(pf, "1a", "2"));
+    F(phfwdAdd(pf, "", "2"));
+    PhoneForwardOperation ops[] = {{PHFWD_ADD, "1", "2"}};
+    F(phfwdApplyBatch(pf, ops, SIZE(ops)));
+    F(phfwdBuildDirectIndex(pf, 0));
+    F(phfwdBuildReverseIndex(pf));
+    srand(44);
+    for (int round = 0; round < 6; ++round) {
+        for (int i = 0; i < 3000; ++i) {
+            random_long_number(b1, 7);
+            random_long_number(b2, 4);
+            int op = rand() % 20;
+            if (op < 16) {
+                if (phfwdAdd(pf, b1, b2) != phfwdAdd(other, b1, b2))
+                    return FAIL;
+            }
+            else {
+                b1[rand() % 3 + 1] = '\0';
+                phfwdRemove(pf, b1);
+                phfwdRemove(other, b1);
+            }
+            if (i % 4 == 0) {
+                random_long_number(b3, 10);
+                T(same_results(pf, other, b3));
+            }
+        }
+        for (int i = 0; i < 1500; ++i) {
+            random_long_number(b3, 10);
+            T(same_results(pf, other, b3));
+        }
+    }
+    phfwdRemove(pf, "0");
+    phfwdRemove(other, "0");
+    T(same_results(pf, other, "0129"));
+
+    phfwdDelete(other);
+    CLEAN(pf);
+}
+
+// Zwięzła kopia daje takie same wyniki jak drzewo w chwili kopiowania.
+static int succinct_table(void) {
+    char b1[128], b2[128], b3[128];
+    INIT(pf);
+    PhoneForward *frozen, *other;
+
+    Z(phfwdFreeze(NULL));
+    N(frozen = phfwdFreeze(pf));
+    T(same_results(frozen, pf, "123"));
+    T(same_results(frozen, pf, "1a"));
+    F(phfwdAdd(frozen, "1", "2"));
+    PhoneForwardOperation ops[] = {{PHFWD_ADD, "1", "2"}};
+    F(phfwdApplyBatch(frozen, ops, SIZE(ops)));
+    Z(phfwdFreeze(frozen));
+    phfwdDelete(frozen);
+
+    srand(46);
+    for (int round = 0; round < 6; ++round) {
+        for (int i = 0; i < 3000; ++i) {
+            random_long_number(b1, 7);
+            random_long_number(b2, 4);
+            if (rand() % 20 < 17)
+                phfwdAdd(pf, b1, b2);
+            else {
+                b1[rand() % 3 + 1] = '\0';
+                phfwdRemove(pf, b1);
+            }
+        }
+        N(frozen = phfwdFreeze(pf));
+        phfwdRemove(frozen, "0");
+        for (int i = 0; i < 3000; ++i) {
+            random_long_number(b3, 10);
+            T(same_results(frozen, pf, b3));
+        }
+        F(phfwdAdd(frozen, b1, b2));
+        phfwdDelete(frozen);
+    }
+
+    // Bez drzewa odwróceń kopia nie wyznacza odwróceń.
+    N(other = phfwdNewForwardOnly());
+    T(phfwdAdd(other, "12", "3*"));
+    T(phfwdAdd(other, "1#", "3"));
+    N(frozen = phfwdFreeze(other));
+    PhoneNumbers *pnum;
+    N(pnum = phfwdGet(frozen, "12#"));
+    C(phnumGet(pnum, 0), "3*#");
+    phnumDelete(pnum);
+    N(pnum = phfwdGet(frozen, "1#2"));
+    C(phnumGet(pnum, 0), "32");
+    phnumDelete(pnum);
+    Z(phfwdReverse(frozen, "3"));
+    Z(phfwdGetReverse(frozen, "3"));
+    phfwdDelete(frozen);
+    phfwdDelete(other);
+    CLEAN(pf);
+}
+
+// Porządkowanie węzłów po kawałku nie zmienia wyników, także gdy przeplata
+// się je ze zmianami przekierowań.
+static int compact(void) {
+    static size_t const budgets[] = {1, 7, 100, 0};
+    char b1[128], b2[128], b3[128];
+    INIT(pf);
+    PhoneForward *other, *forward_only;
+    N(other = phfwdNew());
+    N(forward_only = phfwdNewForwardOnly());
+
+    T(phfwdCompact(NULL, 0));
+    F(phfwdUseHugePages(NULL));
+    T(phfwdCompact(pf, 0));
+    phfwdUseHugePages(pf);
+    T(phfwdBuildDirectIndex(pf, 2));
+    srand(47);
+    for (size_t round = 0; round < SIZE(budgets); ++round) {
+        phfwdSetRemovalBudget(pf, round % 2);
+        for (int i = 0; i < 4000; ++i) {
+            random_long_number(b1, 7);
+            random_long_number(b2, 4);
+            int op = rand() % 20;
+            if (op < 15) {
+                if (phfwdAdd(pf, b1, b2) != phfwdAdd(other, b1, b2))
+                    return FAIL;
+                phfwdAdd(forward_only, b1, b2);
+            }
+            else if (op < 19) {
+                b1[rand() % 3 + 1] = '\0';
+                phfwdRemove(pf, b1);
+                phfwdRemove(other, b1);
+                phfwdRemove(forward_only, b1);
+            }
+            else {
+                random_number(b3, 3);
+                PhoneForwardOperation ops[] = {{PHFWD_ADD, b1, b2}, {PHFWD_REMOVE, b3, NULL}};
+                if (phfwdApplyBatch(pf, ops, SIZE(ops)) != phfwdApplyBatch(other, ops, SIZE(ops)))
+                    return FAIL;
+                phfwdApplyBatch(forward_only, ops, SIZE(ops));
+            }
+            if (i % 50 == 0) {
+                phfwdCompact(pf, budgets[round]);
+                phfwdCompact(forward_only, budgets[round]);
+                random_long_number(b3, 10);
+                T(same_results(pf, other, b3));
+            }
+        }
+        while (!phfwdCompact(pf, budgets[round])) {
+            random_long_number(b3, 10);
+            T(same_results(pf, other, b3));
+        }
+        T(phfwdCompact(pf, 1));
+        T(phfwdCompact(forward_only, 0));
+        for (int i = 0; i < 2000; ++i) {
+            random_long_number(b3, 10);
+            T(same_results(pf, other, b3));
+            PhoneNumbers *a = phfwdGet(forward_only, b3);
+            PhoneNumbers *b = phfwdGet(other, b3);
+            T(same_numbers(a, b));
+            phnumDelete(a);
+            phnumDelete(b);
+        }
+    }
+
+    T(phfwdBuildReverseIndex(forward_only));
+    T(phfwdCompact(forward_only, 0));
+    for (int i = 0; i < 2000; ++i) {
+        random_long_number(b3, 10);
+        T(same_results(forward_only, other, b3));
+    }
+    phfwdDelete(forward_only);
+    phfwdDelete(other);
+    CLEAN(pf);
+}
+
+// Przydzielanie pamięci z góry, ponowne używanie zwolnionych węzłów i wpisów
+// oraz oddawanie nieużywanej pamięci
+static int reserve_trim(void) {
+    char b1[128], b2[128], b3[128];
+    INIT(pf);
+    PhoneForward *other, *hashed;
+    N(other = phfwdNew());
+    N(hashed = phfwdNewHashed());
+
+    F(phfwdReserve(NULL, 1, 1));
+    Z(phfwdTrim(NULL));
+    F(phfwdReserve(hashed, 1, 1));
+    Z(phfwdTrim(hashed));
+    T(phfwdReserve(pf, 0, 0));
+    T(phfwdReserve(pf, 100000, 4096));
+    N(phfwdTrim(pf));
+    T(phfwdReserve(pf, 50000, 1 << 16));
+
+    srand(50);
+    for (int round = 0; round < 4; ++round) {
+        phfwdSetRemovalBudget(pf, round % 2);
+        for (int i = 0; i < 5000; ++i) {
+            random_long_number(b1, 6);
+            random_long_number(b2, (i % 3 == 0) ? 40 : 5);
+            if (rand() % 4 != 0) {
+                if (phfwdAdd(pf, b1, b2) != phfwdAdd(other, b1, b2))
+                    return FAIL;
+            }
+            else {
+                b1[rand() % 3 + 1] = '\0';
+                phfwdRemove(pf, b1);
+                phfwdRemove(other, b1);
+            }
+            if (i % 100 == 0) {
+                random_long_number(b3, 10);
+                T(same_results(pf, other, b3));
+            }
+        }
+        if (round % 2 == 0) {
+            T(phfwdCompact(pf, 0));
+        }
+        phfwdTrim(pf);
+        for (int i = 0; i < 2000; ++i) {
+            random_long_number(b3, 10);
+            T(same_results(pf, other, b3));
+        }
+    }
+
+    phfwdRemove(pf, "1");
+    phfwdRemove(other, "1");
+    T(phfwdCompact(pf, 0));
+    N(phfwdTrim(pf));
+    for (int i = 0; i < 2000; ++i) {
+        random_long_number(b3, 10);
+        T(same_results(pf, other, b3));
+    }
+    phfwdDelete(hashed);
+    phfwdDelete(other);
+
+    // Po usunięciu wielu przekierowań zwolnione wpisy ponad limit pamięci
+    // podręcznej wracają do alokatora bez wywoływania phfwdTrim.
+    PhoneForward *big;
+    N(big = phfwdNew());
+    for (int i = 0; i < 100000; ++i) {
+        sprintf(b1, "1%08d", i);
+        sprintf(b2, "2%08d", i);
+        T(phfwdAdd(big, b1, b2));
+    }
+    struct mallinfo2 before = mallinfo2();
+    phfwdRemove(big, "1");
+    struct mallinfo2 after = mallinfo2();
+    // Pod sanitizerem adresów mallinfo2 zwraca zera.
+    if (before.uordblks + before.hblkhd != 0)
+        T(before.uordblks + before.hblkhd >= after.uordblks + after.hblkhd + 100000 * 32);
+    CHECK(big, "100000001", "100000001");
+    phfwdDelete(big);
+    CLEAN(pf);
+}
+
+// Tworzy bazę w zmapowanym pliku, który od razu jest usuwany z katalogu.
+static PhoneForward * new_mapped(void) {
+    static unsigned counter = 0;
+    char path[64];
+    sprintf(path, "/tmp/phfwd_test_%d_%u.engine", (int)getpid(), counter++);
+    PhoneForward *pf = phfwdOpenMapped(path, false);
+    unlink(path);
+    return pf;
+}
+
+// Baza bez drzewa odwróceń, które jest budowane od razu.
+static PhoneForward * new_forward_only(void) {
+    PhoneForward *pf = phfwdNewForwardOnly();
+    if (pf != NULL && !phfwdBuildReverseIndex(pf)) {
+        phfwdDelete(pf);
+        pf = NULL;
+    }
+    return pf;
+}
+
+typedef struct {
+    char const *name;
+    PhoneForward * (*create)(void);
+} engine_list_t;
+
+// Silniki, na których można uruchamiać scenariusze testów.
+static const engine_list_t engine_list[] = {
+        {"tree", phfwdNew},
+        {"forward_only", new_forward_only},
+        {"hashed", phfwdNewHashed},
+        {"mapped", new_mapped},
+};
+
+// Wszystkie silniki dają takie same wyniki dla losowych ciągów operacji.
+static int engine_streams(void) {
+    char b1[128], b2[128], b3[256];
+    static char pool[64][128];
+    PhoneForward *pf[SIZE(engine_list)];
+    for (size_t k = 0; k < SIZE(engine_list); ++k) {
+        pf[k] = engine_list[k].create();
+        if (pf[k] == NULL)
+            return FAIL;
+    }
+    srand(45);
+    for (int i = 0; i < 20000; ++i) {
+        random_long_number(b1, 8);
+        int op = rand() % 20;
+        if (op < 12) {
+            random_long_number(b2, 5);
+            strcpy(pool[rand() % 64], rand() % 2 ? b1 : b2);
+            bool added = phfwdAdd(pf[0], b1, b2);
+            for (size_t k = 1; k < SIZE(engine_list); ++k)
+                if (phfwdAdd(pf[k], b1, b2) != added)
+                    return FAIL;
+        }
+        else if (op < 14) {
+            b1[rand() % 4 + 1] = '\0';
+            for (size_t k = 0; k < SIZE(engine_list); ++k)
+                phfwdRemove(pf[k], b1);
+        }
+        else {
+            // Zapytania często przedłużają wcześniej dodane numery.
+            random_number(b2, 4);
+            sprintf(b3, "%s%s", op < 17 ? pool[rand() % 64] : "", b2);
+            for (size_t k = 1; k < SIZE(engine_list); ++k)
+                T(same_results(pf[k], pf[0], b3));
+        }
+    }
+    for (size_t k = 0; k < SIZE(engine_list); ++k)
+        phfwdDelete(pf[k]);
+    return PASS;
+}
+
 /** TESTY ALOKACJI PAMIĘCI
     Te testy muszą być linkowane z opcjami
     -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc
@@ -1338,34 +3026,60 @@ static int alloc_fail_3(void) {
 typedef struct {
     char const *name;
     int (*function)(void);
+    bool any_engine;
 } test_list_t;
 
-#define TEST(t) {#t, t}
+// Test korzystający tylko z podstawowych funkcji, więc może być uruchomiony
+// na każdym silniku
+#define ENGINE_TEST(t) {#t, t, true}
+#define TEST(t) {#t, t, false}
 
 static const test_list_t test_list[] = {
-        TEST(empty_struct),
-        TEST(no_forward),
-        TEST(wrong_arguments),
-        TEST(malicious_arguments),
-        TEST(breaking_struct),
-        TEST(long_numbers),
-        TEST(many_numbers),
-        TEST(copy_arguments),
-        TEST(two_structs),
-        TEST(delete_null),
-        TEST(persistent_results),
-        TEST(forward_overwrite),
-        TEST(remove_forward),
-        TEST(simple_reverse),
-        TEST(various_ops),
-        TEST(many_ops),
-        TEST(very_long),
-        TEST(many_remove),
-        TEST(add_remove),
-        TEST(twelve_digits),
-        TEST(cycle),
-        TEST(sort),
-        TEST(get_reverse),
+        ENGINE_TEST(empty_struct),
+        ENGINE_TEST(no_forward),
+        ENGINE_TEST(wrong_arguments),
+        ENGINE_TEST(malicious_arguments),
+        ENGINE_TEST(breaking_struct),
+        ENGINE_TEST(long_numbers),
+        ENGINE_TEST(many_numbers),
+        ENGINE_TEST(copy_arguments),
+        ENGINE_TEST(two_structs),
+        ENGINE_TEST(delete_null),
+        ENGINE_TEST(persistent_results),
+        ENGINE_TEST(forward_overwrite),
+        ENGINE_TEST(remove_forward),
+        ENGINE_TEST(simple_reverse),
+        ENGINE_TEST(various_ops),
+        ENGINE_TEST(many_ops),
+        ENGINE_TEST(very_long),
+        ENGINE_TEST(many_remove),
+        ENGINE_TEST(add_remove),
+        ENGINE_TEST(twelve_digits),
+        ENGINE_TEST(cycle),
+        ENGINE_TEST(sort),
+        ENGINE_TEST(get_reverse),
+        ENGINE_TEST(large_reverse),
+        TEST(reverse_iterator),
+        TEST(reverse_merge),
+        TEST(for_each_prefix),
+        TEST(incremental_remove),
+        TEST(batch_operations),
+        TEST(bulk_load),
+        TEST(forward_only),
+        TEST(operation_log),
+        TEST(background_save),
+        TEST(incremental_save),
+        TEST(text_import_export),
+        TEST(get_batch),
+        TEST(shared_table),
+        TEST(mapped_table),
+        ENGINE_TEST(number_edges),
+        TEST(direct_index),
+        TEST(hashed_table),
+        TEST(succinct_table),
+        TEST(compact),
+        TEST(reserve_trim),
+        TEST(engine_streams),
         TEST(alloc_fail_1),
         TEST(alloc_fail_2),
         TEST(alloc_fail_3),
@@ -1377,12 +3091,22 @@ static int do_test(int (*function)(void)) {
     return result;
 }
 
+// Wybiera silnik, na którym są uruchamiane scenariusze testów.
+static bool select_engine(char const *name) {
+    for (size_t k = 0; k < SIZE(engine_list); ++k)
+        if (strcmp(name, engine_list[k].name) == 0) {
+            new_struct = engine_list[k].create;
+            return true;
+        }
+    return false;
+}
+
 int main(int argc, char *argv[]) {
-    if (argc == 2)
+    if (argc == 2 || (argc == 3 && select_engine(argv[2])))
         for (size_t i = 0; i < SIZE(test_list); ++i)
-    if (strcmp(argv[1], test_list[i].name) == 0)
+    if (strcmp(argv[1], test_list[i].name) == 0 && (argc == 2 || test_list[i].any_engine))
         return do_test(test_list[i].function);
 
-    fprintf(stderr, "Użycie:\n%s nazwa_testu\n", argv[0]);
+    fprintf(stderr, "Użycie:\n%s nazwa_testu [silnik]\n", argv[0]);
     return WRONG_TEST;
 }
\ No newline at end of file